@@ -1,3 +1,5 @@
+#include <atomic>
+#include <chrono>
 #include <csignal>
 #include <iomanip>
 #include <iostream>
@@ -9,38 +11,69 @@
 #include <zcm/zcm-cpp.hpp>
 
 #include <common/messages/MsgChannels.hpp>
+#include <common/messages/estimator_latency_t.hpp>
+#include <common/messages/estimator_noise_t.hpp>
 #include <common/messages/global_update_t.hpp>
+#include <common/messages/gnc_metrics_t.hpp>
 #include <common/messages/imu_t.hpp>
 #include <common/messages/lidar_t.hpp>
 #include <common/messages/plane_fit_t.hpp>
+#include <common/messages/state_lite_t.hpp>
 #include <common/messages/state_t.hpp>
+#include <common/messages/state_trajectory_t.hpp>
+#include <common/messages/visual_odometry_t.hpp>
 #include <common/utils/GetOpt.hpp>
-#include <common/utils/ZCMHandler.hpp>
+#include <common/utils/ZCMEncodeBuffer.hpp>
 #include <gnc/Constants.hpp>
 #include <gnc/Estimator.hpp>
+#include <gnc/EstimatorBank.hpp>
 #include <gnc/measurements/ImuMeasurement.hpp>
 #include <gnc/measurements/Measurement.hpp>
+#include <gnc/utils/LatencyHistogram.hpp>
+#include <gnc/utils/MagnetometerCalibrator.hpp>
+#include <gnc/utils/Metrics.hpp>
 #include <gnc/utils/ZcmConversion.hpp>
 
+using maav::ESTIMATOR_LATENCY_CHANNEL;
+using maav::ESTIMATOR_NOISE_CHANNEL;
+using maav::GNC_METRICS_CHANNEL;
 using maav::GLOBAL_UPDATE_CHANNEL;
 using maav::HEIGHT_LIDAR_CHANNEL;
 using maav::IMU_CHANNEL;
 using maav::PLANE_FIT_CHANNEL;
 using maav::SIM_GLOBAL_UPDATE_CHANNEL;
 using maav::SIM_PLANE_FIT_CHANNEL;
+using maav::SIM_VISUAL_ODOMETRY_CHANNEL;
+using maav::SMOOTHED_STATE_CHANNEL;
 using maav::STATE_CHANNEL;
+using maav::STATE_COVARIANCE_REQUEST_CHANNEL;
+using maav::STATE_LITE_CHANNEL;
+using maav::VISUAL_ODOMETRY_CHANNEL;
 using maav::gnc::convertGlobalUpdate;
 using maav::gnc::convertImu;
 using maav::gnc::convertLidar;
 using maav::gnc::convertPlaneFit;
+using maav::gnc::convertVector1d;
+using maav::gnc::convertVector2d;
+using maav::gnc::convertVector3d;
+using maav::gnc::convertVisualOdometry;
 using maav::gnc::ConvertState;
 using maav::gnc::Estimator;
+using maav::gnc::EstimatorBankT;
+using maav::gnc::EstimatorT;
+using maav::gnc::LatencyHistogram;
+using maav::gnc::MagnetometerCalibrator;
+using maav::gnc::Metrics;
 using maav::gnc::State;
+using maav::gnc::StateT;
+using maav::gnc::kalman::FixedLagSmootherT;
+using maav::gnc::kalman::MeasurementQueue;
 using maav::gnc::measurements::GlobalUpdateMeasurement;
 using maav::gnc::measurements::ImuMeasurement;
 using maav::gnc::measurements::LidarMeasurement;
 using maav::gnc::measurements::MeasurementSet;
 using maav::gnc::measurements::PlaneFitMeasurement;
+using maav::gnc::measurements::VisualOdometryMeasurement;
 
 using namespace std;
 
@@ -49,6 +82,420 @@ sig_atomic_t KILL = 0;
 void sighandler(int sig) { KILL = sig; }
 void applyMagnetometerCalibration(imu_t &msg, const Eigen::Vector3d &offset,
     const Eigen::Vector3d &scale, const Eigen::Matrix3d &rotM);
+
+namespace
+{
+// How often the latency histograms are published and emptied, along with the noise covariances
+// when they are adaptive [us]
+constexpr int64_t REPORT_PERIOD_USEC = 1000000;
+
+// Built with GNC_FLOAT_ESTIMATOR, the filter runs in single precision
+#ifdef MAAV_FLOAT_ESTIMATOR
+using FlightEstimator = EstimatorT<float>;
+#else
+using FlightEstimator = Estimator;
+#endif
+using FlightState = FlightEstimator::State;
+using FlightBank = EstimatorBankT<FlightState::Scalar>;
+using Smoother = FixedLagSmootherT<FlightState::Scalar>;
+
+/**
+ * @brief The state in the precision the messages are built from
+ */
+const State &toDouble(const State &state) { return state; }
+State toDouble(const StateT<float> &state) { return state.cast<double>(); }
+
+int64_t nowUSec()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief Runs the estimator straight from the ZCM callbacks
+ *
+ * ZCM dispatches every subscription of one instance on the same thread, so the filter runs as
+ * soon as an IMU message is dispatched. Readings from the other sensors are queued through
+ * queue_measurement_set as they arrive, without any locking, and the estimator places every one
+ * of them from its per sensor queues in time order. A reading that cannot be placed, or that is
+ * replaced by a newer reading of its sensor on the same snapshot, is counted as dropped.
+ *
+ * Latency is measured on the system clock, which is what the IMU driver stamps its messages with
+ * and what ZCM stamps their arrival with. In simulation the IMU stamps are sim time, so only the
+ * arrival to publish histogram is meaningful there.
+ *
+ * With the bank enabled, the states come from whichever estimator hypothesis the bank follows,
+ * as do the stats and noise printed and published (see EstimatorBankT).
+ *
+ * Smoothed states are published from the smoother's own thread, and only over ipc for the
+ * octomap builder.
+ *
+ * Each state is encoded once and the same bytes go out on every transport. Unless the telemetry
+ * config asks for the full state, udp only gets the compact STATE_LITE, with the covariance on
+ * every covariance_period-th state and on the next state after a STATE_COVARIANCE_REQUEST.
+ */
+class EstimatorNode
+{
+public:
+    EstimatorNode(const YAML::Node &config, zcm::ZCM &zcm, zcm::ZCM &zcm_udp, bool verbose)
+        : estimators_(config),
+          zcm_(zcm),
+          zcm_udp_(zcm_udp),
+          verbose_(verbose),
+          lite_state_(config["telemetry"]["lite_state"].as<bool>()),
+          covariance_period_(config["telemetry"]["covariance_period"].as<uint64_t>()),
+          calibrate_gyro_bias_(config["calibration"]["gyro_bias"].as<bool>()),
+          calibrate_accel_bias_(config["calibration"]["accel_bias"].as<bool>()),
+          mag_calibrator_(config["calibration"]["magnetometer"])
+    {
+        latency_msg_.num_buckets = LatencyHistogram::NUM_BUCKETS;
+        latency_msg_.bucket_upper_usec.resize(LatencyHistogram::NUM_BUCKETS);
+        latency_msg_.sensor_to_publish.resize(LatencyHistogram::NUM_BUCKETS);
+        latency_msg_.receive_to_publish.resize(LatencyHistogram::NUM_BUCKETS);
+        for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++)
+        {
+            latency_msg_.bucket_upper_usec[i] = LatencyHistogram::bucketUpper(i);
+        }
+
+        estimators_.setSmootherCallback(
+            [this](const Smoother::Trajectory &trajectory) { publishSmoothed(trajectory); });
+    }
+
+    void setMagnetometerCalibration(
+        const Eigen::Vector3d &offset, const Eigen::Vector3d &scale, const Eigen::Matrix3d &rotM)
+    {
+        mag_calibrator_.setCalibration({offset, scale, rotM});
+    }
+
+    bool magnetometerCalibration() const { return mag_calibrator_.enabled(); }
+
+    void imuCallback(const zcm::ReceiveBuffer *rbuf, const string &, const imu_t *imu_msg)
+    {
+        mag_calibrator_.add(Eigen::Vector3d(imu_msg->magnetometer.data[0],
+            imu_msg->magnetometer.data[1], imu_msg->magnetometer.data[2]));
+
+        if (calibration_samples_ < NUM_CALIBRATION_SAMPLES)
+        {
+            calibrate(*imu_msg);
+            return;
+        }
+
+        imu_t msg = *imu_msg;
+        const std::shared_ptr<const MagParams> mag = mag_calibrator_.calibration();
+        applyMagnetometerCalibration(msg, mag->offset, mag->scale, mag->rotM);
+        MeasurementSet set;
+        set.imu = convertImu(msg, estimators_.measurementPool());
+
+        const FlightState &state = estimators_.add_measurement_set(set);
+
+        publishState(toDouble(state));
+
+        const int64_t published = nowUSec();
+        sensor_to_publish_.add(published - msg.utime);
+        receive_to_publish_.add(published - rbuf->recv_utime);
+
+        if (verbose_) print(*set.imu, state);
+
+        if (published - last_report_usec_ >= REPORT_PERIOD_USEC)
+        {
+            if (estimators_.selected().adaptiveNoise()) publishNoise(published);
+            publishMetrics(published);
+            publishLatency(published);
+        }
+    }
+
+    /**
+     * @brief Sends the covariance with the next compact state. The message itself is ignored.
+     */
+    void covarianceRequestCallback(const zcm::ReceiveBuffer *, const string &)
+    {
+        covariance_requested_ = true;
+    }
+
+    bool liteState() const { return lite_state_; }
+    uint64_t covariancePeriod() const { return covariance_period_; }
+
+    void lidarCallback(const zcm::ReceiveBuffer *, const string &, const lidar_t *msg)
+    {
+        if (!calibrated()) return;
+        MeasurementSet set;
+        set.lidar = convertLidar(*msg, estimators_.measurementPool());
+        estimators_.queue_measurement_set(set);
+    }
+
+    void planeFitCallback(const zcm::ReceiveBuffer *, const string &, const plane_fit_t *msg)
+    {
+        if (!calibrated()) return;
+        MeasurementSet set;
+        set.plane_fit = convertPlaneFit(*msg, estimators_.measurementPool());
+        estimators_.queue_measurement_set(set);
+    }
+
+    void globalUpdateCallback(
+        const zcm::ReceiveBuffer *, const string &, const global_update_t *msg)
+    {
+        if (!calibrated()) return;
+        MeasurementSet set;
+        set.global_update = convertGlobalUpdate(*msg, estimators_.measurementPool());
+        estimators_.queue_measurement_set(set);
+    }
+
+    /**
+     * Each reading is the motion since the previous message, whose time becomes its base
+     */
+    void visualOdometryCallback(
+        const zcm::ReceiveBuffer *, const string &, const visual_odometry_t *msg)
+    {
+        const uint64_t base_usec = last_odometry_usec_;
+        last_odometry_usec_ = static_cast<uint64_t>(msg->utime);
+        if (!calibrated()) return;
+
+        std::shared_ptr<VisualOdometryMeasurement> odometry =
+            convertVisualOdometry(*msg, estimators_.measurementPool());
+        odometry->setBaseTime(base_usec);
+        MeasurementSet set;
+        set.visual_odometry = odometry;
+        estimators_.queue_measurement_set(set);
+    }
+
+private:
+    constexpr static int NUM_CALIBRATION_SAMPLES = 50;
+
+    bool calibrated() const { return calibration_samples_ >= NUM_CALIBRATION_SAMPLES; }
+
+    /**
+     * @brief Averages the first IMU messages before the estimator starts
+     */
+    void calibrate(const imu_t &msg)
+    {
+        if (calibration_samples_ == 0) cout << "Calibrating IMU..." << endl;
+
+        ImuMeasurement imu;
+        convertImu(msg, imu);
+        avg_acceleration_ += imu.acceleration;
+        avg_angular_rate_ += imu.angular_rates;
+        if (++calibration_samples_ < NUM_CALIBRATION_SAMPLES) return;
+
+        avg_acceleration_ /= static_cast<double>(NUM_CALIBRATION_SAMPLES);
+        avg_angular_rate_ /= static_cast<double>(NUM_CALIBRATION_SAMPLES);
+
+        // At rest the gyro only measures its bias. The accelerometer measures gravity along an
+        // attitude that is not known yet, so only the error in its magnitude is taken as bias.
+        Eigen::Vector3d gyro_bias = Eigen::Vector3d::Zero();
+        if (calibrate_gyro_bias_) gyro_bias = avg_angular_rate_;
+        Eigen::Vector3d accel_bias = Eigen::Vector3d::Zero();
+        if (calibrate_accel_bias_)
+        {
+            accel_bias = avg_acceleration_ -
+                         maav::gnc::constants::STANDARD_GRAVITY * avg_acceleration_.normalized();
+        }
+
+        cout << "Calibrated. Starting biases:\n";
+        cout << "Gyro: " << gyro_bias.transpose() << std::endl;
+        cout << "Accel: " << accel_bias.transpose() << std::endl;
+        estimators_.setBiases(gyro_bias, accel_bias);
+
+        cout << "Starting estimator loop" << endl;
+        last_report_usec_ = nowUSec();
+    }
+
+    void print(const ImuMeasurement &imu, const FlightState &state) const
+    {
+        std::cout << imu;
+        std::cout << state;
+
+        const FlightEstimator::ReplayStats &stats = estimators_.selected().replayStats();
+        std::cout << "Replay - Depth: " << stats.last_depth_usec
+                  << " us Steps: " << stats.last_steps << " Backlog: " << stats.backlog_steps
+                  << '\n';
+
+        const MeasurementQueue::Stats queue = estimators_.selected().queueStats();
+        std::cout << "Dropped - Lidar: " << queue.lidar.dropped()
+                  << " Plane fit: " << queue.plane_fit.dropped()
+                  << " Global update: " << queue.global_update.dropped()
+                  << " Visual odometry: " << queue.visual_odometry.dropped() << '\n';
+    }
+
+    /**
+     * @brief Publishes the full state over ipc, and over udp either it or the compact state
+     */
+    void publishState(const State &state)
+    {
+        ConvertState(state, state_msg_);
+        if (state_buffer_.encode(state_msg_))
+        {
+            state_buffer_.publish(zcm_, STATE_CHANNEL);
+            if (!lite_state_) state_buffer_.publish(zcm_udp_, STATE_CHANNEL);
+        }
+        if (!lite_state_) return;
+
+        states_since_covariance_++;
+        const bool periodic =
+            covariance_period_ > 0 && states_since_covariance_ >= covariance_period_;
+        const bool with_covariance = covariance_requested_.exchange(false) || periodic;
+        if (with_covariance) states_since_covariance_ = 0;
+
+        ConvertState(state, lite_msg_, with_covariance);
+        if (lite_buffer_.encode(lite_msg_)) lite_buffer_.publish(zcm_udp_, STATE_LITE_CHANNEL);
+    }
+
+    /**
+     * @brief Publishes the histograms of the last period and starts new ones
+     */
+    void publishLatency(int64_t now_usec)
+    {
+        latency_msg_.utime = now_usec;
+        latency_msg_.count = static_cast<int64_t>(sensor_to_publish_.count());
+        for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++)
+        {
+            latency_msg_.sensor_to_publish[i] =
+                static_cast<int64_t>(sensor_to_publish_.bucketCount(i));
+            latency_msg_.receive_to_publish[i] =
+                static_cast<int64_t>(receive_to_publish_.bucketCount(i));
+        }
+        latency_msg_.sensor_to_publish_p50 = sensor_to_publish_.percentile(0.5);
+        latency_msg_.sensor_to_publish_p99 = sensor_to_publish_.percentile(0.99);
+        latency_msg_.sensor_to_publish_max = static_cast<double>(sensor_to_publish_.max());
+        latency_msg_.receive_to_publish_p50 = receive_to_publish_.percentile(0.5);
+        latency_msg_.receive_to_publish_p99 = receive_to_publish_.percentile(0.99);
+        latency_msg_.receive_to_publish_max = static_cast<double>(receive_to_publish_.max());
+
+        zcm_.publish(ESTIMATOR_LATENCY_CHANNEL, &latency_msg_);
+        zcm_udp_.publish(ESTIMATOR_LATENCY_CHANNEL, &latency_msg_);
+
+        sensor_to_publish_.reset();
+        receive_to_publish_.reset();
+        last_report_usec_ = now_usec;
+    }
+
+    /**
+     * @brief Publishes the noise covariances the estimator is running with
+     */
+    void publishNoise(int64_t now_usec)
+    {
+        const FlightEstimator::Noise noise = estimators_.selected().noise();
+        noise_msg_.utime = now_usec;
+        noise_msg_.Q_gyro = convertVector3d(noise.Q.segment<3>(0));
+        noise_msg_.Q_accel = convertVector3d(noise.Q.segment<3>(6));
+        noise_msg_.Q_gyro_bias = convertVector3d(noise.Q.segment<3>(9));
+        noise_msg_.Q_accel_bias = convertVector3d(noise.Q.segment<3>(12));
+        noise_msg_.lidar_R = convertVector1d(noise.lidar_R(0));
+        noise_msg_.plane_fit_attitude_R = convertVector2d(noise.plane_fit_R.head<2>());
+        noise_msg_.plane_fit_height_R = convertVector2d(noise.plane_fit_R.tail<2>());
+        noise_msg_.global_update_position_R = convertVector3d(noise.global_update_R.head<3>());
+        noise_msg_.global_update_attitude_R = convertVector3d(noise.global_update_R.tail<3>());
+        noise_msg_.visual_odometry_translation_R =
+            convertVector3d(noise.visual_odometry_R.head<3>());
+        noise_msg_.visual_odometry_rotation_R = convertVector3d(noise.visual_odometry_R.tail<3>());
+
+        zcm_.publish(ESTIMATOR_NOISE_CHANNEL, &noise_msg_);
+        zcm_udp_.publish(ESTIMATOR_NOISE_CHANNEL, &noise_msg_);
+    }
+
+    /**
+     * @brief Publishes every metric of the GNC stack. Histograms start over for the next period.
+     */
+    void publishMetrics(int64_t now_usec)
+    {
+        const Metrics::Report report = Metrics::instance().report();
+        metrics_msg_.utime = now_usec;
+
+        metrics_msg_.num_counters = static_cast<int32_t>(report.counters.size());
+        metrics_msg_.counter_names.resize(report.counters.size());
+        metrics_msg_.counters.resize(report.counters.size());
+        for (size_t i = 0; i < report.counters.size(); i++)
+        {
+            metrics_msg_.counter_names[i] = report.counters[i].first;
+            metrics_msg_.counters[i] = static_cast<int64_t>(report.counters[i].second);
+        }
+
+        metrics_msg_.num_gauges = static_cast<int32_t>(report.gauges.size());
+        metrics_msg_.gauge_names.resize(report.gauges.size());
+        metrics_msg_.gauges.resize(report.gauges.size());
+        for (size_t i = 0; i < report.gauges.size(); i++)
+        {
+            metrics_msg_.gauge_names[i] = report.gauges[i].first;
+            metrics_msg_.gauges[i] = report.gauges[i].second;
+        }
+
+        const size_t num_histograms = report.histograms.size();
+        metrics_msg_.num_histograms = static_cast<int32_t>(num_histograms);
+        metrics_msg_.histogram_names.resize(num_histograms);
+        metrics_msg_.histogram_count.resize(num_histograms);
+        metrics_msg_.histogram_mean.resize(num_histograms);
+        metrics_msg_.histogram_p50.resize(num_histograms);
+        metrics_msg_.histogram_p99.resize(num_histograms);
+        metrics_msg_.histogram_max.resize(num_histograms);
+        for (size_t i = 0; i < num_histograms; i++)
+        {
+            const Metrics::Report::Summary &summary = report.histograms[i];
+            metrics_msg_.histogram_names[i] = summary.name;
+            metrics_msg_.histogram_count[i] = static_cast<int64_t>(summary.count);
+            metrics_msg_.histogram_mean[i] = summary.mean;
+            metrics_msg_.histogram_p50[i] = summary.p50;
+            metrics_msg_.histogram_p99[i] = summary.p99;
+            metrics_msg_.histogram_max[i] = static_cast<double>(summary.max);
+        }
+
+        zcm_.publish(GNC_METRICS_CHANNEL, &metrics_msg_);
+        zcm_udp_.publish(GNC_METRICS_CHANNEL, &metrics_msg_);
+    }
+
+    /**
+     * @brief Publishes a smoothed window. Runs on the smoother thread.
+     */
+    void publishSmoothed(const Smoother::Trajectory &trajectory)
+    {
+        trajectory_msg_.utime = static_cast<int64_t>(trajectory.back().timeUSec());
+        trajectory_msg_.num_states = static_cast<int32_t>(trajectory.size());
+        trajectory_msg_.states.resize(trajectory.size());
+        for (size_t i = 0; i < trajectory.size(); i++)
+        {
+            ConvertState(toDouble(trajectory[i]), trajectory_msg_.states[i]);
+        }
+        zcm_.publish(SMOOTHED_STATE_CHANNEL, &trajectory_msg_);
+    }
+
+    // Only touched by the smoother thread, which the estimator stops before this is destroyed
+    state_trajectory_t trajectory_msg_;
+
+    // A single estimator unless the bank config enables competing hypotheses
+    FlightBank estimators_;
+    zcm::ZCM &zcm_;
+    zcm::ZCM &zcm_udp_;
+    const bool verbose_;
+
+    // Kept between states so neither the messages nor their encoding allocate once warmed up
+    const bool lite_state_;
+    const uint64_t covariance_period_;
+    state_t state_msg_;
+    state_lite_t lite_msg_;
+    ZCMEncodeBuffer state_buffer_;
+    ZCMEncodeBuffer lite_buffer_;
+    uint64_t states_since_covariance_ = 0;
+    // Set from the udp thread as well. The first compact state carries the covariance.
+    std::atomic<bool> covariance_requested_{true};
+
+    int calibration_samples_ = 0;
+
+    uint64_t last_odometry_usec_ = 0;
+    Eigen::Vector3d avg_acceleration_ = Eigen::Vector3d::Zero();
+    Eigen::Vector3d avg_angular_rate_ = Eigen::Vector3d::Zero();
+
+    const bool calibrate_gyro_bias_;
+    const bool calibrate_accel_bias_;
+    MagnetometerCalibrator mag_calibrator_;
+
+    LatencyHistogram sensor_to_publish_;
+    LatencyHistogram receive_to_publish_;
+    estimator_latency_t latency_msg_;
+    estimator_noise_t noise_msg_;
+    gnc_metrics_t metrics_msg_;
+    int64_t last_report_usec_ = 0;
+};
+}  // namespace
+
 int main(int argc, char **argv)
 {
     signal(SIGINT, sighandler);
@@ -92,188 +539,117 @@ int main(int argc, char **argv)
 
     YAML::Node config = YAML::LoadFile(gopt.getString("config"));
 
-    ZCMHandler<imu_t> imu_handler;
-    ZCMHandler<lidar_t> lidar_handler;
-    ZCMHandler<plane_fit_t> plane_fit_handler;
-    ZCMHandler<global_update_t> global_update_handler;
-
     std::cout << "==========================" << std::endl;
 
+    EstimatorNode node(config, zcm, zcm_udp, verbose);
+
+    std::cout << "--------------------------" << std::endl;
+
     std::cout << "IMU:              ";
     if (config["sim_imu"].as<bool>())
     {
-        zcm.subscribe(maav::SIM_IMU_CHANNEL, &ZCMHandler<imu_t>::recv, &imu_handler);
+        zcm.subscribe(maav::SIM_IMU_CHANNEL, &EstimatorNode::imuCallback, &node);
         std::cout << "SIM" << std::endl;
     }
     else
     {
-        zcm.subscribe(maav::IMU_CHANNEL, &ZCMHandler<imu_t>::recv, &imu_handler);
+        zcm.subscribe(maav::IMU_CHANNEL, &EstimatorNode::imuCallback, &node);
         std::cout << "REGULAR" << std::endl;
     }
 
     std::cout << "Lidar:            ";
     if (config["sim_lidar"].as<bool>())
     {
-        zcm.subscribe(maav::SIM_HEIGHT_LIDAR_CHANNEL, &ZCMHandler<lidar_t>::recv, &lidar_handler);
+        zcm.subscribe(maav::SIM_HEIGHT_LIDAR_CHANNEL, &EstimatorNode::lidarCallback, &node);
         std::cout << "SIM" << std::endl;
     }
     else
     {
-        zcm.subscribe(maav::HEIGHT_LIDAR_CHANNEL, &ZCMHandler<lidar_t>::recv, &lidar_handler);
+        zcm.subscribe(maav::HEIGHT_LIDAR_CHANNEL, &EstimatorNode::lidarCallback, &node);
         std::cout << "REGULAR" << std::endl;
     }
 
     std::cout << "Plane Fit:        ";
     if (config["sim_planefit"].as<bool>())
     {
-        zcm.subscribe(
-            maav::SIM_PLANE_FIT_CHANNEL, &ZCMHandler<plane_fit_t>::recv, &plane_fit_handler);
+        zcm.subscribe(maav::SIM_PLANE_FIT_CHANNEL, &EstimatorNode::planeFitCallback, &node);
         std::cout << "SIM" << std::endl;
     }
     else
     {
-        zcm.subscribe(maav::PLANE_FIT_CHANNEL, &ZCMHandler<plane_fit_t>::recv, &plane_fit_handler);
+        zcm.subscribe(maav::PLANE_FIT_CHANNEL, &EstimatorNode::planeFitCallback, &node);
         std::cout << "REGULAR" << std::endl;
     }
 
     std::cout << "Global Update:    ";
     if (config["sim_global_update"].as<bool>())
     {
-        zcm.subscribe(maav::SIM_GLOBAL_UPDATE_CHANNEL, &ZCMHandler<global_update_t>::recv,
-            &global_update_handler);
+        zcm.subscribe(
+            maav::SIM_GLOBAL_UPDATE_CHANNEL, &EstimatorNode::globalUpdateCallback, &node);
         std::cout << "SIM" << std::endl;
     }
     else
     {
-        zcm.subscribe(maav::GLOBAL_UPDATE_CHANNEL, &ZCMHandler<global_update_t>::recv,
-            &global_update_handler);
+        zcm.subscribe(maav::GLOBAL_UPDATE_CHANNEL, &EstimatorNode::globalUpdateCallback, &node);
         std::cout << "REGULAR" << std::endl;
     }
 
-    std::cout << "--------------------------" << std::endl;
-
-    Estimator estimator(config);
-
-    std::cout << "==========================" << std::endl;
-
-    // Main Loop
-    KILL = false;
-    zcm.start();
-
-    cout << "Calibrating IMU..." << endl;
-
-    Eigen::Vector3d avg_acceleration = Eigen::Vector3d::Zero();
-    Eigen::Vector3d avg_angular_rate = Eigen::Vector3d::Zero();
-    int num_samples = 50;
-    for (int count = 0; count < num_samples && !KILL;)
+    std::cout << "Visual Odometry:  ";
+    if (config["sim_visual_odometry"].as<bool>())
     {
-        if (imu_handler.ready())
-        {
-            const imu_t msg = imu_handler.msg();
-            imu_handler.pop();
-            auto msg_ptr = convertImu(msg);
-            avg_acceleration += msg_ptr->acceleration;
-            avg_angular_rate += msg_ptr->angular_rates;
-            count++;
-        }
-        this_thread::sleep_for(2ms);
+        zcm.subscribe(
+            SIM_VISUAL_ODOMETRY_CHANNEL, &EstimatorNode::visualOdometryCallback, &node);
+        std::cout << "SIM" << std::endl;
+    }
+    else
+    {
+        zcm.subscribe(VISUAL_ODOMETRY_CHANNEL, &EstimatorNode::visualOdometryCallback, &node);
+        std::cout << "REGULAR" << std::endl;
     }
-    avg_acceleration /= static_cast<double>(num_samples);
-    avg_angular_rate /= static_cast<double>(num_samples);
 
-    Eigen::Vector3d true_accel = {0, 0, -maav::gnc::constants::STANDARD_GRAVITY};
-    Eigen::Vector3d accel_bias = avg_acceleration - true_accel;
-    accel_bias = Eigen::Vector3d::Zero();
-    Eigen::Vector3d true_ang_rate = Eigen::Vector3d::Zero();
-    Eigen::Vector3d gyro_bias = avg_angular_rate - true_ang_rate;
-    gyro_bias = Eigen::Vector3d::Zero();
+    std::cout << "Mag Calibration:  " << (node.magnetometerCalibration() ? "ONLINE" : "FILE")
+              << std::endl;
 
-    cout << "Calibrated. Starting biases:\n";
-    cout << "Gyro: " << gyro_bias.transpose() << std::endl;
-    cout << "Accel: " << accel_bias.transpose() << std::endl;
-    estimator.setBiases(gyro_bias, accel_bias);
+    std::cout << "State Telemetry:  ";
+    if (node.liteState())
+    {
+        zcm.subscribe(
+            STATE_COVARIANCE_REQUEST_CHANNEL, &EstimatorNode::covarianceRequestCallback, &node);
+        zcm_udp.subscribe(
+            STATE_COVARIANCE_REQUEST_CHANNEL, &EstimatorNode::covarianceRequestCallback, &node);
+        std::cout << "LITE (covariance every " << node.covariancePeriod() << " states)"
+                  << std::endl;
+    }
+    else
+    {
+        std::cout << "FULL" << std::endl;
+    }
 
-    Eigen::Vector3d offset;
-    Eigen::Vector3d scale;
-    Eigen::Matrix3d rotM;
+    std::cout << "==========================" << std::endl;
 
     try
     {
         YAML::Node mag_calib = YAML::LoadFile(gopt.getString("imucalibfile"));
-        offset = mag_calib["offset"].as<Eigen::Vector3d>();
-        scale = mag_calib["scale"].as<Eigen::Vector3d>();
-        rotM = mag_calib["rotM"].as<Eigen::Matrix3d>();
+        node.setMagnetometerCalibration(mag_calib["offset"].as<Eigen::Vector3d>(),
+            mag_calib["scale"].as<Eigen::Vector3d>(), mag_calib["rotM"].as<Eigen::Matrix3d>());
     }
     catch (std::exception e)
     {
         std::cout << "No mag calibration found. Using defaults" << std::endl;
-        offset = Eigen::Vector3d::Zero();
-        scale = Eigen::Vector3d{1, 1, 1};
-        rotM = Eigen::Matrix3d::Identity();
     }
 
-    cout << "Starting estimator loop" << endl;
+    // Main Loop. The estimator runs on the ZCM dispatch thread, this one only waits for a signal.
+    KILL = false;
+    zcm.start();
+    // Only dispatches the covariance requests from the ground station
+    if (node.liteState()) zcm_udp.start();
 
     while (!KILL)
     {
-        std::this_thread::sleep_for(1ms);
-
-        // Kalman Update Rate = IMU's Update rate,
-        // so we ONLY update the Kalman Filter when the IMU Updates.
-        if (!imu_handler.ready()) continue;
-
-        MeasurementSet set;
-
-        imu_t msg = imu_handler.msg();
-        imu_handler.pop();
-
-        applyMagnetometerCalibration(msg, offset, scale, rotM);
-
-        set.imu = convertImu(msg);
-
-        if (lidar_handler.ready())
-        {
-            const lidar_t msg = lidar_handler.msg();
-            lidar_handler.pop();
-
-            set.lidar = convertLidar(msg);
-        }
-
-        if (plane_fit_handler.ready())
-        {
-            const plane_fit_t msg = plane_fit_handler.msg();
-            plane_fit_handler.pop();
-
-            set.plane_fit = convertPlaneFit(msg);
-        }
-
-        if (global_update_handler.ready())
-        {
-            const global_update_t msg = global_update_handler.msg();
-            global_update_handler.pop();
-
-            set.global_update = convertGlobalUpdate(msg);
-        }
-
-        const State &state = estimator.add_measurement_set(set);
-
-        state_t zcm_state = ConvertState(state);
-
-        if (verbose)
-        {
-            std::cout << *(set.imu);
-            if (set.lidar) std::cout << *(set.lidar);
-            if (set.plane_fit) std::cout << *(set.plane_fit);
-            if (set.global_update) std::cout << *(set.global_update);
-            std::cout << state;
-        }
-
-        zcm.publish(STATE_CHANNEL, &zcm_state);
-        zcm_udp.publish(STATE_CHANNEL, &zcm_state);
-
-        this_thread::sleep_for(2ms);
+        this_thread::sleep_for(100ms);
     }
 
+    if (node.liteState()) zcm_udp.stop();
     zcm.stop();
 
     return 0;
@@ -13,6 +13,7 @@
 
 #include <atomic>
 #include <common/messages/MsgChannels.hpp>
+#include <common/messages/octomap_delta_t.hpp>
 #include <common/messages/octomap_t.hpp>
 #include <common/messages/path_t.hpp>
 #include <common/messages/point_cloud_t.hpp>
@@ -33,18 +34,20 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <thread>
+#include <vision/core/OctomapReceiver.hpp>
 #include <vision/core/utilities.hpp>
 #include <yaml-cpp/yaml.h>
 #include <zcm/zcm-cpp.hpp>
 
 using maav::OCCUPANCY_MAP_CHANNEL;
+using maav::OCCUPANCY_MAP_DELTA_CHANNEL;
 using maav::STATE_CHANNEL;
 using maav::PATH_CHANNEL;
 using maav::GOAL_WAYPOINT_CHANNEL;
 using maav::FORWARD_CAMERA_POINT_CLOUD_CHANNEL;
 using maav::GT_INERTIAL_CHANNEL;
 using maav::gnc::Planner;
-using maav::vision::zcmTypeToOctomap;
+using maav::vision::OctomapReceiver;
 using maav::vision::zcmTypeToPCLPointCloud;
 using maav::gnc::State;
 using maav::gnc::ConvertState;
@@ -126,8 +129,8 @@ private:
     StateHandler* state_handler_ = nullptr;
 };
 
-// Receives new octomaps, replaces the old and tries to start a new
-// compuation of a*
+// Receives full octomaps and the voxels changed in between, updates the
+// map and tries to start a new compuation of a*
 class MapHandler
 {
 public:
@@ -136,21 +139,29 @@ public:
         const octomap_t* message)
     {
         unique_lock<mutex> lck(mtx_);
+        if (!receiver_.receive(message)) return;
         run_ = true;
-        octree_ = zcmTypeToOctomap(message);
+        lck.unlock();
+        astar_manager_.try_compute();
+    }
+    void handleDelta(const zcm::ReceiveBuffer*, const std::string&,
+        const octomap_delta_t* message)
+    {
+        unique_lock<mutex> lck(mtx_);
+        if (!receiver_.receive(message)) return;
         lck.unlock();
         astar_manager_.try_compute();
     }
     shared_ptr<octomap::OcTree> getMap()
     {
         unique_lock<mutex> lck(mtx_);
-        return octree_;
+        return receiver_.map();
     }
     bool run_ = false;
 private:
     AStarManager& astar_manager_;
     mutex mtx_;
-    shared_ptr<octomap::OcTree> octree_;
+    OctomapReceiver receiver_;
 };
 
 class StateHandler
@@ -329,6 +340,7 @@ int main(int argc, char** argv)
     astar_manager.setHandlers(&goal_handler, &map_handler, &state_handler);
 
     zcm.subscribe(OCCUPANCY_MAP_CHANNEL, &MapHandler::handle, &map_handler);
+    zcm.subscribe(OCCUPANCY_MAP_DELTA_CHANNEL, &MapHandler::handleDelta, &map_handler);
     // TODO Use when not testing with sim
     // zcm.subscribe(STATE_CHANNEL, &StateHandler::handle, &state_handler);
     zcm.subscribe(GT_INERTIAL_CHANNEL, &StateHandler::handleGTState, &state_handler);
@@ -24,6 +24,7 @@
 #include <common/messages/point_cloud_t.hpp>
 #include <common/messages/heartbeat_t.hpp>
 #include <common/messages/octomap_t.hpp>
+#include <common/messages/octomap_delta_t.hpp>
 #include <common/utils/GetOpt.hpp>
 #include <gnc/OccupancyMap.hpp>
 #include <vision/core/utilities.hpp>
@@ -38,16 +39,14 @@ using std::vector;
 using std::stringstream;
 using zcm::ZCM;
 using std::shared_ptr;
-using pcl::PointCloud;
-using pcl::PointXYZ;
 using std::chrono::milliseconds;
 using std::thread;
 using std::string;
 
 using maav::gnc::OccupancyMap;
 using maav::gnc::PointMapper;
-using maav::vision::zcmTypeToPCLPointCloud;
 using maav::vision::octomapToZcmType;
+using maav::vision::octomapChangesToZcmType;
 
 // Used for synchronization with the kill signal
 mutex mtx;
@@ -58,7 +57,7 @@ class Handler
 public:
     Handler(YAML::Node& config, YAML::Node& camera_config,
         zcm::ZCM &zcm) : occupancyMap_(config, camera_config, zcm),
-        zcm_ {zcm} {}
+        zcm_ {zcm}, keyframe_period_ {std::max(1u, config["keyframe_period"].as<unsigned>())} {}
     // Updates job dispatcher with new task data
     void handle(const zcm::ReceiveBuffer*, const std::string&,
         const point_cloud_t* message)
@@ -70,32 +69,47 @@ public:
         if (!currently_working_)
         {
                 currently_working_ = true;
-                PointCloud<PointXYZ>::Ptr cloud = zcmTypeToPCLPointCloud(*message);
-                thread processing(process_cloud, cloud, message->utime, this);
+                auto cloud = std::make_shared<point_cloud_t>(*message);
+                thread processing(process_cloud, cloud, this);
                 processing.detach();
         }
     }
     // Runs in a detached thread so that messages that can't be processed
     // can be discarded rather than back up
-    static void process_cloud(PointCloud<PointXYZ>::Ptr cloud, uint64_t utime,
+    static void process_cloud(shared_ptr<const point_cloud_t> cloud,
         Handler* handler)
     {
         // Update occupancy map with cloud measurements
-        handler->occupancyMap_.update(cloud, utime);
-        handler->last_update_ = utime;
+        handler->occupancyMap_.update(*cloud);
+        handler->last_update_ = cloud->utime;
         handler->sendMap();
         unique_lock<mutex> lck(handler->mtx_);
         handler->currently_working_ = false;
     }
     shared_ptr<const octomap::OcTree> getMap() {return occupancyMap_.map();}
-    // Serialize the octomap and send it over zcm
+    // Send the voxels changed since the last map over zcm, and every
+    // keyframe_period maps serialize the whole octomap so receivers that
+    // missed a delta can catch up
     void sendMap()
     {
-        octomap_t message;
-        auto octmap = getMap();
-        message.utime = last_update_;
-        octomapToZcmType(octmap, &message);
-        zcm_.publish(maav::OCCUPANCY_MAP_CHANNEL, &message);
+        if (maps_sent_ % keyframe_period_ == 0)
+        {
+            octomap_t message;
+            message.utime = last_update_;
+            octomapToZcmType(getMap(), &message);
+            zcm_.publish(maav::OCCUPANCY_MAP_CHANNEL, &message);
+        }
+        else
+        {
+            octomap_delta_t message;
+            message.utime = last_update_;
+            message.base_utime = last_sent_;
+            octomapChangesToZcmType(*getMap(), &message);
+            zcm_.publish(maav::OCCUPANCY_MAP_DELTA_CHANNEL, &message);
+        }
+        occupancyMap_.resetChanges();
+        last_sent_ = last_update_;
+        maps_sent_++;
     }
     void kill() {occupancyMap_.kill();}
 private:
@@ -104,6 +118,9 @@ private:
     OccupancyMap occupancyMap_;
     zcm::ZCM& zcm_;
     long long last_update_ = 0;
+    long long last_sent_ = 0;
+    unsigned keyframe_period_;
+    unsigned maps_sent_ = 0;
 };
 
 // Keeps track of whether the kill signal has been received
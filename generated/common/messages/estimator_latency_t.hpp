@@ -0,0 +1,273 @@
+/** THIS IS AN AUTOMATICALLY GENERATED FILE.
+ *  DO NOT MODIFY BY HAND!!
+ *
+ *  Generated by zcm-gen
+ **/
+
+#include <zcm/zcm_coretypes.h>
+
+#ifndef __estimator_latency_t_hpp__
+#define __estimator_latency_t_hpp__
+
+#include <vector>
+
+
+/**
+ * ZCM type for the latency of the estimator over one reporting period
+ * Histograms share the buckets in bucket_upper_usec
+ *
+ */
+class estimator_latency_t
+{
+    public:
+        int64_t    utime;
+
+        int64_t    count;
+
+        int32_t    num_buckets;
+
+        std::vector< double > bucket_upper_usec;
+
+        std::vector< int64_t > sensor_to_publish;
+
+        double     sensor_to_publish_p50;
+
+        double     sensor_to_publish_p99;
+
+        double     sensor_to_publish_max;
+
+        std::vector< int64_t > receive_to_publish;
+
+        double     receive_to_publish_p50;
+
+        double     receive_to_publish_p99;
+
+        double     receive_to_publish_max;
+
+    public:
+        /**
+         * Destructs a message properly if anything inherits from it
+        */
+        virtual ~estimator_latency_t() {}
+
+        /**
+         * Encode a message into binary form.
+         *
+         * @param buf The output buffer.
+         * @param offset Encoding starts at thie byte offset into @p buf.
+         * @param maxlen Maximum number of bytes to write.  This should generally be
+         *  equal to getEncodedSize().
+         * @return The number of bytes encoded, or <0 on error.
+         */
+        inline int encode(void* buf, uint32_t offset, uint32_t maxlen) const;
+
+        /**
+         * Check how many bytes are required to encode this message.
+         */
+        inline uint32_t getEncodedSize() const;
+
+        /**
+         * Decode a message from binary form into this instance.
+         *
+         * @param buf The buffer containing the encoded message.
+         * @param offset The byte offset into @p buf where the encoded message starts.
+         * @param maxlen The maximum number of bytes to reqad while decoding.
+         * @return The number of bytes decoded, or <0 if an error occured.
+         */
+        inline int decode(const void* buf, uint32_t offset, uint32_t maxlen);
+
+        /**
+         * Retrieve the 64-bit fingerprint identifying the structure of the message.
+         * Note that the fingerprint is the same for all instances of the same
+         * message type, and is a fingerprint on the message type definition, not on
+         * the message contents.
+         */
+        inline static int64_t getHash();
+
+        /**
+         * Returns "estimator_latency_t"
+         */
+        inline static const char* getTypeName();
+
+        // ZCM support functions. Users should not call these
+        inline int      _encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const;
+        inline uint32_t _getEncodedSizeNoHash() const;
+        inline int      _decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen);
+        inline static uint64_t _computeHash(const __zcm_hash_ptr* p);
+};
+
+int estimator_latency_t::encode(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+    int64_t hash = (int64_t)getHash();
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &hash, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->_encodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int estimator_latency_t::decode(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    int64_t msg_hash;
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &msg_hash, 1);
+    if (thislen < 0) return thislen; else pos += thislen;
+    if (msg_hash != getHash()) return -1;
+
+    thislen = this->_decodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t estimator_latency_t::getEncodedSize() const
+{
+    return 8 + _getEncodedSizeNoHash();
+}
+
+int64_t estimator_latency_t::getHash()
+{
+    static int64_t hash = _computeHash(NULL);
+    return hash;
+}
+
+const char* estimator_latency_t::getTypeName()
+{
+    return "estimator_latency_t";
+}
+
+int estimator_latency_t::_encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->count, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->num_buckets, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->num_buckets > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->bucket_upper_usec[0], this->num_buckets);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_buckets > 0) {
+        thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish[0], this->num_buckets);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish_p50, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish_p99, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish_max, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->num_buckets > 0) {
+        thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish[0], this->num_buckets);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish_p50, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish_p99, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish_max, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int estimator_latency_t::_decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->count, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->num_buckets, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->num_buckets > 0) {
+        this->bucket_upper_usec.resize(this->num_buckets);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->bucket_upper_usec[0], this->num_buckets);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_buckets > 0) {
+        this->sensor_to_publish.resize(this->num_buckets);
+        thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish[0], this->num_buckets);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish_p50, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish_p99, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->sensor_to_publish_max, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->num_buckets > 0) {
+        this->receive_to_publish.resize(this->num_buckets);
+        thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish[0], this->num_buckets);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish_p50, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish_p99, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->receive_to_publish_max, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t estimator_latency_t::_getEncodedSizeNoHash() const
+{
+    uint32_t enc_size = 0;
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    enc_size += __double_encoded_array_size(NULL, this->num_buckets);
+    enc_size += __int64_t_encoded_array_size(NULL, this->num_buckets);
+    enc_size += __double_encoded_array_size(NULL, 1);
+    enc_size += __double_encoded_array_size(NULL, 1);
+    enc_size += __double_encoded_array_size(NULL, 1);
+    enc_size += __int64_t_encoded_array_size(NULL, this->num_buckets);
+    enc_size += __double_encoded_array_size(NULL, 1);
+    enc_size += __double_encoded_array_size(NULL, 1);
+    enc_size += __double_encoded_array_size(NULL, 1);
+    return enc_size;
+}
+
+uint64_t estimator_latency_t::_computeHash(const __zcm_hash_ptr*)
+{
+    uint64_t hash = (uint64_t)0x6d2e9a74014cd11cLL;
+    return (hash<<1) + ((hash>>63)&1);
+}
+
+#endif
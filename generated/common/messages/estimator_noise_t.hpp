@@ -0,0 +1,287 @@
+/** THIS IS AN AUTOMATICALLY GENERATED FILE.
+ *  DO NOT MODIFY BY HAND!!
+ *
+ *  Generated by zcm-gen
+ **/
+
+#include <zcm/zcm_coretypes.h>
+
+#ifndef __estimator_noise_t_hpp__
+#define __estimator_noise_t_hpp__
+
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector1_t.hpp"
+#include "vector2_t.hpp"
+#include "vector2_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+
+
+/**
+ * ZCM type for the noise covariances the estimator is running with
+ * Each field is the diagonal of a covariance. With adaptive noise estimation enabled they follow
+ * the innovations, otherwise they stay at their configured values.
+ *
+ */
+class estimator_noise_t
+{
+    public:
+        int64_t    utime;
+
+        vector3_t  Q_gyro;
+
+        vector3_t  Q_accel;
+
+        vector3_t  Q_gyro_bias;
+
+        vector3_t  Q_accel_bias;
+
+        vector1_t  lidar_R;
+
+        vector2_t  plane_fit_attitude_R;
+
+        vector2_t  plane_fit_height_R;
+
+        vector3_t  global_update_position_R;
+
+        vector3_t  global_update_attitude_R;
+
+        vector3_t  visual_odometry_translation_R;
+
+        vector3_t  visual_odometry_rotation_R;
+
+    public:
+        /**
+         * Destructs a message properly if anything inherits from it
+        */
+        virtual ~estimator_noise_t() {}
+
+        /**
+         * Encode a message into binary form.
+         *
+         * @param buf The output buffer.
+         * @param offset Encoding starts at thie byte offset into @p buf.
+         * @param maxlen Maximum number of bytes to write.  This should generally be
+         *  equal to getEncodedSize().
+         * @return The number of bytes encoded, or <0 on error.
+         */
+        inline int encode(void* buf, uint32_t offset, uint32_t maxlen) const;
+
+        /**
+         * Check how many bytes are required to encode this message.
+         */
+        inline uint32_t getEncodedSize() const;
+
+        /**
+         * Decode a message from binary form into this instance.
+         *
+         * @param buf The buffer containing the encoded message.
+         * @param offset The byte offset into @p buf where the encoded message starts.
+         * @param maxlen The maximum number of bytes to reqad while decoding.
+         * @return The number of bytes decoded, or <0 if an error occured.
+         */
+        inline int decode(const void* buf, uint32_t offset, uint32_t maxlen);
+
+        /**
+         * Retrieve the 64-bit fingerprint identifying the structure of the message.
+         * Note that the fingerprint is the same for all instances of the same
+         * message type, and is a fingerprint on the message type definition, not on
+         * the message contents.
+         */
+        inline static int64_t getHash();
+
+        /**
+         * Returns "estimator_noise_t"
+         */
+        inline static const char* getTypeName();
+
+        // ZCM support functions. Users should not call these
+        inline int      _encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const;
+        inline uint32_t _getEncodedSizeNoHash() const;
+        inline int      _decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen);
+        inline static uint64_t _computeHash(const __zcm_hash_ptr* p);
+};
+
+int estimator_noise_t::encode(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+    int64_t hash = (int64_t)getHash();
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &hash, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->_encodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int estimator_noise_t::decode(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    int64_t msg_hash;
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &msg_hash, 1);
+    if (thislen < 0) return thislen; else pos += thislen;
+    if (msg_hash != getHash()) return -1;
+
+    thislen = this->_decodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t estimator_noise_t::getEncodedSize() const
+{
+    return 8 + _getEncodedSizeNoHash();
+}
+
+int64_t estimator_noise_t::getHash()
+{
+    static int64_t hash = _computeHash(NULL);
+    return hash;
+}
+
+const char* estimator_noise_t::getTypeName()
+{
+    return "estimator_noise_t";
+}
+
+int estimator_noise_t::_encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_gyro._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_accel._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_gyro_bias._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_accel_bias._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->lidar_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->plane_fit_attitude_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->plane_fit_height_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->global_update_position_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->global_update_attitude_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->visual_odometry_translation_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->visual_odometry_rotation_R._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int estimator_noise_t::_decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_gyro._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_accel._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_gyro_bias._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->Q_accel_bias._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->lidar_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->plane_fit_attitude_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->plane_fit_height_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->global_update_position_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->global_update_attitude_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->visual_odometry_translation_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->visual_odometry_rotation_R._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t estimator_noise_t::_getEncodedSizeNoHash() const
+{
+    uint32_t enc_size = 0;
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += this->Q_gyro._getEncodedSizeNoHash();
+    enc_size += this->Q_accel._getEncodedSizeNoHash();
+    enc_size += this->Q_gyro_bias._getEncodedSizeNoHash();
+    enc_size += this->Q_accel_bias._getEncodedSizeNoHash();
+    enc_size += this->lidar_R._getEncodedSizeNoHash();
+    enc_size += this->plane_fit_attitude_R._getEncodedSizeNoHash();
+    enc_size += this->plane_fit_height_R._getEncodedSizeNoHash();
+    enc_size += this->global_update_position_R._getEncodedSizeNoHash();
+    enc_size += this->global_update_attitude_R._getEncodedSizeNoHash();
+    enc_size += this->visual_odometry_translation_R._getEncodedSizeNoHash();
+    enc_size += this->visual_odometry_rotation_R._getEncodedSizeNoHash();
+    return enc_size;
+}
+
+uint64_t estimator_noise_t::_computeHash(const __zcm_hash_ptr* p)
+{
+    const __zcm_hash_ptr* fp;
+    for(fp = p; fp != NULL; fp = fp->parent)
+        if(fp->v == estimator_noise_t::getHash)
+            return 0;
+    const __zcm_hash_ptr cp = { p, (void*)estimator_noise_t::getHash };
+
+    uint64_t hash = (uint64_t)0xde14e04b96ae225dLL +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector1_t::_computeHash(&cp) +
+         vector2_t::_computeHash(&cp) +
+         vector2_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp);
+
+    return (hash<<1) + ((hash>>63)&1);
+}
+
+#endif
@@ -0,0 +1,348 @@
+/** THIS IS AN AUTOMATICALLY GENERATED FILE.
+ *  DO NOT MODIFY BY HAND!!
+ *
+ *  Generated by zcm-gen
+ **/
+
+#include <zcm/zcm_coretypes.h>
+
+#ifndef __gnc_metrics_t_hpp__
+#define __gnc_metrics_t_hpp__
+
+#include <vector>
+#include <string>
+
+
+/**
+ * ZCM type for the metrics of the GNC stack over one reporting period
+ * Metrics are named, e.g. "update.lidar.rejected", and sorted by name
+ *
+ */
+class gnc_metrics_t
+{
+    public:
+        int64_t    utime;
+
+        int32_t    num_counters;
+
+        std::vector< std::string > counter_names;
+
+        std::vector< int64_t > counters;
+
+        int32_t    num_gauges;
+
+        std::vector< std::string > gauge_names;
+
+        std::vector< double > gauges;
+
+        int32_t    num_histograms;
+
+        std::vector< std::string > histogram_names;
+
+        std::vector< int64_t > histogram_count;
+
+        std::vector< double > histogram_mean;
+
+        std::vector< double > histogram_p50;
+
+        std::vector< double > histogram_p99;
+
+        std::vector< double > histogram_max;
+
+    public:
+        /**
+         * Destructs a message properly if anything inherits from it
+        */
+        virtual ~gnc_metrics_t() {}
+
+        /**
+         * Encode a message into binary form.
+         *
+         * @param buf The output buffer.
+         * @param offset Encoding starts at thie byte offset into @p buf.
+         * @param maxlen Maximum number of bytes to write.  This should generally be
+         *  equal to getEncodedSize().
+         * @return The number of bytes encoded, or <0 on error.
+         */
+        inline int encode(void* buf, uint32_t offset, uint32_t maxlen) const;
+
+        /**
+         * Check how many bytes are required to encode this message.
+         */
+        inline uint32_t getEncodedSize() const;
+
+        /**
+         * Decode a message from binary form into this instance.
+         *
+         * @param buf The buffer containing the encoded message.
+         * @param offset The byte offset into @p buf where the encoded message starts.
+         * @param maxlen The maximum number of bytes to reqad while decoding.
+         * @return The number of bytes decoded, or <0 if an error occured.
+         */
+        inline int decode(const void* buf, uint32_t offset, uint32_t maxlen);
+
+        /**
+         * Retrieve the 64-bit fingerprint identifying the structure of the message.
+         * Note that the fingerprint is the same for all instances of the same
+         * message type, and is a fingerprint on the message type definition, not on
+         * the message contents.
+         */
+        inline static int64_t getHash();
+
+        /**
+         * Returns "gnc_metrics_t"
+         */
+        inline static const char* getTypeName();
+
+        // ZCM support functions. Users should not call these
+        inline int      _encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const;
+        inline uint32_t _getEncodedSizeNoHash() const;
+        inline int      _decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen);
+        inline static uint64_t _computeHash(const __zcm_hash_ptr* p);
+};
+
+int gnc_metrics_t::encode(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+    int64_t hash = (int64_t)getHash();
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &hash, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->_encodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int gnc_metrics_t::decode(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    int64_t msg_hash;
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &msg_hash, 1);
+    if (thislen < 0) return thislen; else pos += thislen;
+    if (msg_hash != getHash()) return -1;
+
+    thislen = this->_decodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t gnc_metrics_t::getEncodedSize() const
+{
+    return 8 + _getEncodedSizeNoHash();
+}
+
+int64_t gnc_metrics_t::getHash()
+{
+    static int64_t hash = _computeHash(NULL);
+    return hash;
+}
+
+const char* gnc_metrics_t::getTypeName()
+{
+    return "gnc_metrics_t";
+}
+
+int gnc_metrics_t::_encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->num_counters, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    for (int a0 = 0; a0 < this->num_counters; ++a0) {
+        char* __cstr = (char*) this->counter_names[a0].c_str();
+        thislen = __string_encode_array(buf, offset + pos, maxlen - pos, &__cstr, 1);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_counters > 0) {
+        thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->counters[0], this->num_counters);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->num_gauges, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    for (int a0 = 0; a0 < this->num_gauges; ++a0) {
+        char* __cstr = (char*) this->gauge_names[a0].c_str();
+        thislen = __string_encode_array(buf, offset + pos, maxlen - pos, &__cstr, 1);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_gauges > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->gauges[0], this->num_gauges);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->num_histograms, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    for (int a0 = 0; a0 < this->num_histograms; ++a0) {
+        char* __cstr = (char*) this->histogram_names[a0].c_str();
+        thislen = __string_encode_array(buf, offset + pos, maxlen - pos, &__cstr, 1);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->histogram_count[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->histogram_mean[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->histogram_p50[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->histogram_p99[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->histogram_max[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+int gnc_metrics_t::_decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->num_counters, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    this->counter_names.resize(this->num_counters);
+    for (int a0 = 0; a0 < this->num_counters; ++a0) {
+        int32_t __elem_len;
+        thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &__elem_len, 1);
+        if(thislen < 0) return thislen; else pos += thislen;
+        if((uint32_t)__elem_len > maxlen - pos) return -1;
+        this->counter_names[a0].assign(((const char*)buf) + offset + pos, __elem_len -  1);
+        pos += __elem_len;
+    }
+
+    if(this->num_counters > 0) {
+        this->counters.resize(this->num_counters);
+        thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->counters[0], this->num_counters);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->num_gauges, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    this->gauge_names.resize(this->num_gauges);
+    for (int a0 = 0; a0 < this->num_gauges; ++a0) {
+        int32_t __elem_len;
+        thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &__elem_len, 1);
+        if(thislen < 0) return thislen; else pos += thislen;
+        if((uint32_t)__elem_len > maxlen - pos) return -1;
+        this->gauge_names[a0].assign(((const char*)buf) + offset + pos, __elem_len -  1);
+        pos += __elem_len;
+    }
+
+    if(this->num_gauges > 0) {
+        this->gauges.resize(this->num_gauges);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->gauges[0], this->num_gauges);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->num_histograms, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    this->histogram_names.resize(this->num_histograms);
+    for (int a0 = 0; a0 < this->num_histograms; ++a0) {
+        int32_t __elem_len;
+        thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &__elem_len, 1);
+        if(thislen < 0) return thislen; else pos += thislen;
+        if((uint32_t)__elem_len > maxlen - pos) return -1;
+        this->histogram_names[a0].assign(((const char*)buf) + offset + pos, __elem_len -  1);
+        pos += __elem_len;
+    }
+
+    if(this->num_histograms > 0) {
+        this->histogram_count.resize(this->num_histograms);
+        thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->histogram_count[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        this->histogram_mean.resize(this->num_histograms);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->histogram_mean[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        this->histogram_p50.resize(this->num_histograms);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->histogram_p50[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        this->histogram_p99.resize(this->num_histograms);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->histogram_p99[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_histograms > 0) {
+        this->histogram_max.resize(this->num_histograms);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->histogram_max[0], this->num_histograms);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+uint32_t gnc_metrics_t::_getEncodedSizeNoHash() const
+{
+    uint32_t enc_size = 0;
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    for (int a0 = 0; a0 < this->num_counters; ++a0) {
+        enc_size += this->counter_names[a0].size() + 4 + 1;
+    }
+    enc_size += __int64_t_encoded_array_size(NULL, this->num_counters);
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    for (int a0 = 0; a0 < this->num_gauges; ++a0) {
+        enc_size += this->gauge_names[a0].size() + 4 + 1;
+    }
+    enc_size += __double_encoded_array_size(NULL, this->num_gauges);
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    for (int a0 = 0; a0 < this->num_histograms; ++a0) {
+        enc_size += this->histogram_names[a0].size() + 4 + 1;
+    }
+    enc_size += __int64_t_encoded_array_size(NULL, this->num_histograms);
+    enc_size += __double_encoded_array_size(NULL, this->num_histograms);
+    enc_size += __double_encoded_array_size(NULL, this->num_histograms);
+    enc_size += __double_encoded_array_size(NULL, this->num_histograms);
+    enc_size += __double_encoded_array_size(NULL, this->num_histograms);
+    return enc_size;
+}
+
+uint64_t gnc_metrics_t::_computeHash(const __zcm_hash_ptr*)
+{
+    uint64_t hash = (uint64_t)0x91e07a4c36fd83caLL;
+    return (hash<<1) + ((hash>>63)&1);
+}
+
+#endif
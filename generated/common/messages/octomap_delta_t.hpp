@@ -0,0 +1,233 @@
+/** THIS IS AN AUTOMATICALLY GENERATED FILE.
+ *  DO NOT MODIFY BY HAND!!
+ *
+ *  Generated by zcm-gen
+ **/
+
+#include <zcm/zcm_coretypes.h>
+
+#ifndef __octomap_delta_t_hpp__
+#define __octomap_delta_t_hpp__
+
+#include <vector>
+
+
+/**
+ * ZCM type for the voxels of an octomap whose occupancy changed since the previous map
+ * It applies on top of the map published at base_utime, either a full octomap_t or a delta
+ *
+ */
+class octomap_delta_t
+{
+    public:
+        int64_t    utime;
+
+        int64_t    base_utime;
+
+        int32_t    num_voxels;
+
+        std::vector< int16_t > key_x;
+
+        std::vector< int16_t > key_y;
+
+        std::vector< int16_t > key_z;
+
+        std::vector< float > log_odds;
+
+    public:
+        /**
+         * Destructs a message properly if anything inherits from it
+        */
+        virtual ~octomap_delta_t() {}
+
+        /**
+         * Encode a message into binary form.
+         *
+         * @param buf The output buffer.
+         * @param offset Encoding starts at thie byte offset into @p buf.
+         * @param maxlen Maximum number of bytes to write.  This should generally be
+         *  equal to getEncodedSize().
+         * @return The number of bytes encoded, or <0 on error.
+         */
+        inline int encode(void* buf, uint32_t offset, uint32_t maxlen) const;
+
+        /**
+         * Check how many bytes are required to encode this message.
+         */
+        inline uint32_t getEncodedSize() const;
+
+        /**
+         * Decode a message from binary form into this instance.
+         *
+         * @param buf The buffer containing the encoded message.
+         * @param offset The byte offset into @p buf where the encoded message starts.
+         * @param maxlen The maximum number of bytes to reqad while decoding.
+         * @return The number of bytes decoded, or <0 if an error occured.
+         */
+        inline int decode(const void* buf, uint32_t offset, uint32_t maxlen);
+
+        /**
+         * Retrieve the 64-bit fingerprint identifying the structure of the message.
+         * Note that the fingerprint is the same for all instances of the same
+         * message type, and is a fingerprint on the message type definition, not on
+         * the message contents.
+         */
+        inline static int64_t getHash();
+
+        /**
+         * Returns "octomap_delta_t"
+         */
+        inline static const char* getTypeName();
+
+        // ZCM support functions. Users should not call these
+        inline int      _encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const;
+        inline uint32_t _getEncodedSizeNoHash() const;
+        inline int      _decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen);
+        inline static uint64_t _computeHash(const __zcm_hash_ptr* p);
+};
+
+int octomap_delta_t::encode(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+    int64_t hash = (int64_t)getHash();
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &hash, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->_encodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int octomap_delta_t::decode(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    int64_t msg_hash;
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &msg_hash, 1);
+    if (thislen < 0) return thislen; else pos += thislen;
+    if (msg_hash != getHash()) return -1;
+
+    thislen = this->_decodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t octomap_delta_t::getEncodedSize() const
+{
+    return 8 + _getEncodedSizeNoHash();
+}
+
+int64_t octomap_delta_t::getHash()
+{
+    static int64_t hash = _computeHash(NULL);
+    return hash;
+}
+
+const char* octomap_delta_t::getTypeName()
+{
+    return "octomap_delta_t";
+}
+
+int octomap_delta_t::_encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->base_utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->num_voxels, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->num_voxels > 0) {
+        thislen = __int16_t_encode_array(buf, offset + pos, maxlen - pos, &this->key_x[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_voxels > 0) {
+        thislen = __int16_t_encode_array(buf, offset + pos, maxlen - pos, &this->key_y[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_voxels > 0) {
+        thislen = __int16_t_encode_array(buf, offset + pos, maxlen - pos, &this->key_z[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_voxels > 0) {
+        thislen = __float_encode_array(buf, offset + pos, maxlen - pos, &this->log_odds[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+int octomap_delta_t::_decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->base_utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->num_voxels, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->num_voxels > 0) {
+        this->key_x.resize(this->num_voxels);
+        thislen = __int16_t_decode_array(buf, offset + pos, maxlen - pos, &this->key_x[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_voxels > 0) {
+        this->key_y.resize(this->num_voxels);
+        thislen = __int16_t_decode_array(buf, offset + pos, maxlen - pos, &this->key_y[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_voxels > 0) {
+        this->key_z.resize(this->num_voxels);
+        thislen = __int16_t_decode_array(buf, offset + pos, maxlen - pos, &this->key_z[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    if(this->num_voxels > 0) {
+        this->log_odds.resize(this->num_voxels);
+        thislen = __float_decode_array(buf, offset + pos, maxlen - pos, &this->log_odds[0], this->num_voxels);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+uint32_t octomap_delta_t::_getEncodedSizeNoHash() const
+{
+    uint32_t enc_size = 0;
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    enc_size += __int16_t_encoded_array_size(NULL, this->num_voxels);
+    enc_size += __int16_t_encoded_array_size(NULL, this->num_voxels);
+    enc_size += __int16_t_encoded_array_size(NULL, this->num_voxels);
+    enc_size += __float_encoded_array_size(NULL, this->num_voxels);
+    return enc_size;
+}
+
+uint64_t octomap_delta_t::_computeHash(const __zcm_hash_ptr*)
+{
+    uint64_t hash = (uint64_t)0xa5e46f3fb2ec4d12LL;
+    return (hash<<1) + ((hash>>63)&1);
+}
+
+#endif
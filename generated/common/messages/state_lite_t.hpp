@@ -0,0 +1,244 @@
+/** THIS IS AN AUTOMATICALLY GENERATED FILE.
+ *  DO NOT MODIFY BY HAND!!
+ *
+ *  Generated by zcm-gen
+ **/
+
+#include <zcm/zcm_coretypes.h>
+
+#ifndef __state_lite_t_hpp__
+#define __state_lite_t_hpp__
+
+#include <vector>
+#include "quaternion_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+#include "vector3_t.hpp"
+
+
+/**
+ * ZCM type for a compact GNC state, sent to the ground station instead of state_t
+ * The covariance is only carried by some messages
+ *
+ */
+class state_lite_t
+{
+    public:
+        int64_t    utime;
+
+        quaternion_t attitude;
+
+        vector3_t  position;
+
+        vector3_t  velocity;
+
+        vector3_t  gyro_biases;
+
+        vector3_t  accel_biases;
+
+        int32_t    covariance_size;
+
+        std::vector< double > covariance;
+
+    public:
+        /**
+         * Destructs a message properly if anything inherits from it
+        */
+        virtual ~state_lite_t() {}
+
+        /**
+         * Encode a message into binary form.
+         *
+         * @param buf The output buffer.
+         * @param offset Encoding starts at thie byte offset into @p buf.
+         * @param maxlen Maximum number of bytes to write.  This should generally be
+         *  equal to getEncodedSize().
+         * @return The number of bytes encoded, or <0 on error.
+         */
+        inline int encode(void* buf, uint32_t offset, uint32_t maxlen) const;
+
+        /**
+         * Check how many bytes are required to encode this message.
+         */
+        inline uint32_t getEncodedSize() const;
+
+        /**
+         * Decode a message from binary form into this instance.
+         *
+         * @param buf The buffer containing the encoded message.
+         * @param offset The byte offset into @p buf where the encoded message starts.
+         * @param maxlen The maximum number of bytes to reqad while decoding.
+         * @return The number of bytes decoded, or <0 if an error occured.
+         */
+        inline int decode(const void* buf, uint32_t offset, uint32_t maxlen);
+
+        /**
+         * Retrieve the 64-bit fingerprint identifying the structure of the message.
+         * Note that the fingerprint is the same for all instances of the same
+         * message type, and is a fingerprint on the message type definition, not on
+         * the message contents.
+         */
+        inline static int64_t getHash();
+
+        /**
+         * Returns "state_lite_t"
+         */
+        inline static const char* getTypeName();
+
+        // ZCM support functions. Users should not call these
+        inline int      _encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const;
+        inline uint32_t _getEncodedSizeNoHash() const;
+        inline int      _decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen);
+        inline static uint64_t _computeHash(const __zcm_hash_ptr* p);
+};
+
+int state_lite_t::encode(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+    int64_t hash = (int64_t)getHash();
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &hash, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->_encodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int state_lite_t::decode(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    int64_t msg_hash;
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &msg_hash, 1);
+    if (thislen < 0) return thislen; else pos += thislen;
+    if (msg_hash != getHash()) return -1;
+
+    thislen = this->_decodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t state_lite_t::getEncodedSize() const
+{
+    return 8 + _getEncodedSizeNoHash();
+}
+
+int64_t state_lite_t::getHash()
+{
+    static int64_t hash = _computeHash(NULL);
+    return hash;
+}
+
+const char* state_lite_t::getTypeName()
+{
+    return "state_lite_t";
+}
+
+int state_lite_t::_encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->attitude._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->position._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->velocity._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->gyro_biases._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->accel_biases._encodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->covariance_size, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->covariance_size > 0) {
+        thislen = __double_encode_array(buf, offset + pos, maxlen - pos, &this->covariance[0], this->covariance_size);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+int state_lite_t::_decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->attitude._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->position._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->velocity._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->gyro_biases._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->accel_biases._decodeNoHash(buf, offset + pos, maxlen - pos);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->covariance_size, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    if(this->covariance_size > 0) {
+        this->covariance.resize(this->covariance_size);
+        thislen = __double_decode_array(buf, offset + pos, maxlen - pos, &this->covariance[0], this->covariance_size);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+uint32_t state_lite_t::_getEncodedSizeNoHash() const
+{
+    uint32_t enc_size = 0;
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += this->attitude._getEncodedSizeNoHash();
+    enc_size += this->position._getEncodedSizeNoHash();
+    enc_size += this->velocity._getEncodedSizeNoHash();
+    enc_size += this->gyro_biases._getEncodedSizeNoHash();
+    enc_size += this->accel_biases._getEncodedSizeNoHash();
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    enc_size += __double_encoded_array_size(NULL, this->covariance_size);
+    return enc_size;
+}
+
+uint64_t state_lite_t::_computeHash(const __zcm_hash_ptr* p)
+{
+    const __zcm_hash_ptr* fp;
+    for(fp = p; fp != NULL; fp = fp->parent)
+        if(fp->v == state_lite_t::getHash)
+            return 0;
+    const __zcm_hash_ptr cp = { p, (void*)state_lite_t::getHash };
+
+    uint64_t hash = (uint64_t)0xe0d3c58a02646534LL +
+         quaternion_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp) +
+         vector3_t::_computeHash(&cp);
+
+    return (hash<<1) + ((hash>>63)&1);
+}
+
+#endif
@@ -0,0 +1,193 @@
+/** THIS IS AN AUTOMATICALLY GENERATED FILE.
+ *  DO NOT MODIFY BY HAND!!
+ *
+ *  Generated by zcm-gen
+ **/
+
+#include <zcm/zcm_coretypes.h>
+
+#ifndef __state_trajectory_t_hpp__
+#define __state_trajectory_t_hpp__
+
+#include <vector>
+#include "state_t.hpp"
+
+
+/**
+ * ZCM type for a window of smoothed GNC states, oldest first
+ * The newest state is the filtered state the window was smoothed against
+ *
+ */
+class state_trajectory_t
+{
+    public:
+        int64_t    utime;
+
+        int32_t    num_states;
+
+        std::vector< state_t > states;
+
+    public:
+        /**
+         * Destructs a message properly if anything inherits from it
+        */
+        virtual ~state_trajectory_t() {}
+
+        /**
+         * Encode a message into binary form.
+         *
+         * @param buf The output buffer.
+         * @param offset Encoding starts at thie byte offset into @p buf.
+         * @param maxlen Maximum number of bytes to write.  This should generally be
+         *  equal to getEncodedSize().
+         * @return The number of bytes encoded, or <0 on error.
+         */
+        inline int encode(void* buf, uint32_t offset, uint32_t maxlen) const;
+
+        /**
+         * Check how many bytes are required to encode this message.
+         */
+        inline uint32_t getEncodedSize() const;
+
+        /**
+         * Decode a message from binary form into this instance.
+         *
+         * @param buf The buffer containing the encoded message.
+         * @param offset The byte offset into @p buf where the encoded message starts.
+         * @param maxlen The maximum number of bytes to reqad while decoding.
+         * @return The number of bytes decoded, or <0 if an error occured.
+         */
+        inline int decode(const void* buf, uint32_t offset, uint32_t maxlen);
+
+        /**
+         * Retrieve the 64-bit fingerprint identifying the structure of the message.
+         * Note that the fingerprint is the same for all instances of the same
+         * message type, and is a fingerprint on the message type definition, not on
+         * the message contents.
+         */
+        inline static int64_t getHash();
+
+        /**
+         * Returns "state_trajectory_t"
+         */
+        inline static const char* getTypeName();
+
+        // ZCM support functions. Users should not call these
+        inline int      _encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const;
+        inline uint32_t _getEncodedSizeNoHash() const;
+        inline int      _decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen);
+        inline static uint64_t _computeHash(const __zcm_hash_ptr* p);
+};
+
+int state_trajectory_t::encode(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+    int64_t hash = (int64_t)getHash();
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &hash, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = this->_encodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+int state_trajectory_t::decode(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    int64_t msg_hash;
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &msg_hash, 1);
+    if (thislen < 0) return thislen; else pos += thislen;
+    if (msg_hash != getHash()) return -1;
+
+    thislen = this->_decodeNoHash(buf, offset + pos, maxlen - pos);
+    if (thislen < 0) return thislen; else pos += thislen;
+
+    return pos;
+}
+
+uint32_t state_trajectory_t::getEncodedSize() const
+{
+    return 8 + _getEncodedSizeNoHash();
+}
+
+int64_t state_trajectory_t::getHash()
+{
+    static int64_t hash = _computeHash(NULL);
+    return hash;
+}
+
+const char* state_trajectory_t::getTypeName()
+{
+    return "state_trajectory_t";
+}
+
+int state_trajectory_t::_encodeNoHash(void* buf, uint32_t offset, uint32_t maxlen) const
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_encode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_encode_array(buf, offset + pos, maxlen - pos, &this->num_states, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    for (int a0 = 0; a0 < this->num_states; ++a0) {
+        thislen = this->states[a0]._encodeNoHash(buf, offset + pos, maxlen - pos);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+int state_trajectory_t::_decodeNoHash(const void* buf, uint32_t offset, uint32_t maxlen)
+{
+    uint32_t pos = 0;
+    int thislen;
+
+    thislen = __int64_t_decode_array(buf, offset + pos, maxlen - pos, &this->utime, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    thislen = __int32_t_decode_array(buf, offset + pos, maxlen - pos, &this->num_states, 1);
+    if(thislen < 0) return thislen; else pos += thislen;
+
+    this->states.resize(this->num_states);
+    for (int a0 = 0; a0 < this->num_states; ++a0) {
+        thislen = this->states[a0]._decodeNoHash(buf, offset + pos, maxlen - pos);
+        if(thislen < 0) return thislen; else pos += thislen;
+    }
+
+    return pos;
+}
+
+uint32_t state_trajectory_t::_getEncodedSizeNoHash() const
+{
+    uint32_t enc_size = 0;
+    enc_size += __int64_t_encoded_array_size(NULL, 1);
+    enc_size += __int32_t_encoded_array_size(NULL, 1);
+    for (int a0 = 0; a0 < this->num_states; ++a0) {
+        enc_size += this->states[a0]._getEncodedSizeNoHash();
+    }
+    return enc_size;
+}
+
+uint64_t state_trajectory_t::_computeHash(const __zcm_hash_ptr* p)
+{
+    const __zcm_hash_ptr* fp;
+    for(fp = p; fp != NULL; fp = fp->parent)
+        if(fp->v == state_trajectory_t::getHash)
+            return 0;
+    const __zcm_hash_ptr cp = { p, (void*)state_trajectory_t::getHash };
+
+    uint64_t hash = (uint64_t)0x97ec066aa17cc3c6LL +
+         state_t::_computeHash(&cp);
+
+    return (hash<<1) + ((hash>>63)&1);
+}
+
+#endif
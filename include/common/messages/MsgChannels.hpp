@@ -13,11 +13,17 @@ extern const char* const DOWNWARD_CAMERA_POINT_CLOUD_CHANNEL; ///< Downward came
 
 // GNC messages
 extern const char* const STATE_CHANNEL;                     ///< Kalman filter state estimate
+extern const char* const STATE_LITE_CHANNEL;                ///< Compact state estimate for the ground station
+extern const char* const STATE_COVARIANCE_REQUEST_CHANNEL;  ///< Asks for the covariance on STATE_LITE
 extern const char* const IMU_CHANNEL;                       ///< IMU sensor readings
 extern const char* const HEIGHT_LIDAR_CHANNEL;              ///< Height lidar distance measurements
 extern const char* const PLANE_FIT_CHANNEL;                 ///< Plane fitting measurements
 extern const char* const GLOBAL_UPDATE_CHANNEL;             ///< Pose measurement from SLAM
 extern const char* const VISUAL_ODOMETRY_CHANNEL;           ///< Visual odometry measurement
+extern const char* const ESTIMATOR_LATENCY_CHANNEL;         ///< Latency histograms of the estimator
+extern const char* const ESTIMATOR_NOISE_CHANNEL;           ///< Noise covariances of the estimator
+extern const char* const GNC_METRICS_CHANNEL;               ///< Counters, gauges and histograms of GNC
+extern const char* const SMOOTHED_STATE_CHANNEL;            ///< Fixed lag smoothed states, oldest first
 
 // Sim perfect sensor channels
 extern const char* const SIM_IMU_CHANNEL;                   ///< Simulated IMU sensor readings
@@ -59,6 +65,7 @@ extern const char* const ATTITUDE_TARGET_CHANNEL;           ///< current command
 extern const char* const CAMERA_POS_CHANNEL;           ///< current pos of tracking camera
 extern const char* const OCCUPANCY_MAP_HEARTBEAT_CHANNEL;   ///< Heart beat for occupancy map
 extern const char* const OCCUPANCY_MAP_CHANNEL;             ///< Map generated by octomap
+extern const char* const OCCUPANCY_MAP_DELTA_CHANNEL;       ///< Voxels changed since the last map
 extern const char* const STATE_FORWARD_HEARTBEAT_CHANNEL;
 // clang-format on
 }  // namespace maav
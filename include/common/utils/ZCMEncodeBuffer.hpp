@@ -0,0 +1,48 @@
+#ifndef ZCMENCODEBUFFER_HPP
+#define ZCMENCODEBUFFER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <zcm/zcm-cpp.hpp>
+
+/**
+ * @brief Encodes ZCM messages into a buffer kept between messages
+ * @details ZCM::publish(channel, msg) allocates and encodes a new buffer on every call, once per
+ *			transport the message goes out on. Encoding here once and publishing the bytes
+ *			skips both, and the buffer only grows to the largest message encoded.
+ */
+class ZCMEncodeBuffer
+{
+public:
+    /**
+     * @brief Encodes msg, replacing the previous message
+     * @return False if the message could not be encoded, in which case nothing is published
+     */
+    template <typename T>
+    bool encode(const T& msg)
+    {
+        const uint32_t size = msg.getEncodedSize();
+        if (buffer_.size() < size) buffer_.resize(size);
+        size_ = msg.encode(buffer_.data(), 0, size) < 0 ? 0 : size;
+        return size_ > 0;
+    }
+
+    /**
+     * @brief Publishes the last message encoded
+     */
+    int publish(zcm::ZCM& zcm, const std::string& channel) const
+    {
+        if (size_ == 0) return -1;
+        return zcm.publish(channel, buffer_.data(), size_);
+    }
+
+    uint32_t size() const { return size_; }
+
+private:
+    std::vector<uint8_t> buffer_;  ///< grows to the largest message, never shrinks
+    uint32_t size_ = 0;            ///< bytes of the last message, 0 if it failed to encode
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "common/messages/ctrl_params_t.hpp"
 #include "common/messages/idle_t.hpp"
 #include "common/messages/nav_runstate_t.hpp"
+#include "common/messages/state_lite_t.hpp"
 #include "common/messages/state_t.hpp"
 #include "common/messages/waypoint_t.hpp"
 
@@ -78,6 +78,7 @@ class StatusFrame : public Gtk::Frame
         // a connection which is used to control the timer callback
         sigc::connection timer_connection;
 
+    protected:
         // upates the current status and resets the timer if needed
         virtual void update_status(Status new_status)
         {
@@ -113,6 +114,24 @@ class StatusFrame : public Gtk::Frame
         }
     };
 
+    // the estimator sends either the full or the compact state to the ground station, so
+    // localization is online when either comes in
+    class LocalizationDisplay : public StatusDisplay<state_t>
+    {
+    public:
+        LocalizationDisplay(GlibZCM& zcm, const GCSConsts& consts_in)
+            : StatusDisplay<state_t>(zcm, STATE_CHANNEL, "Localization:", consts_in),
+              lite_handler{zcm, STATE_LITE_CHANNEL}
+        {
+            lite_handler.signal_message().connect(
+                [this](const state_lite_t&) { update_status(Status::online); });
+        }
+
+        virtual ~LocalizationDisplay() {}
+    private:
+        GlibZCM::Handler<state_lite_t> lite_handler;
+    };
+
     class PlannerDisplay : public StatusDisplay<waypoint_t>
     {
     public:
@@ -248,7 +267,7 @@ class StatusFrame : public Gtk::Frame
 
     // the set of status displays to show
     StatusDisplay<nav_runstate_t> path_planner;
-    StatusDisplay<state_t> localization;
+    LocalizationDisplay localization;
     StatusDisplay<nav_runstate_t> line_det;
     StatusDisplay<nav_runstate_t> roomba_det;
     StatusDisplay<obstacle_list_t> obstacle_det;
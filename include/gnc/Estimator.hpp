@@ -3,43 +3,236 @@
 #include <yaml-cpp/yaml.h>
 
 #include <gnc/State.hpp>
+#include <gnc/kalman/AdaptiveNoise.hpp>
+#include <gnc/kalman/FilterType.hpp>
+#include <gnc/kalman/FixedLagSmoother.hpp>
 #include <gnc/kalman/History.hpp>
+#include <gnc/kalman/ImuPreintegration.hpp>
 #include <gnc/kalman/Prediction.hpp>
 #include <gnc/kalman/updates/GlobalUpdate.hpp>
+#include <gnc/kalman/updates/JointUpdate.hpp>
 #include <gnc/kalman/updates/LidarUpdate.hpp>
 #include <gnc/kalman/updates/PlanefitUpdate.hpp>
+#include <gnc/kalman/updates/VisualOdometryUpdate.hpp>
 #include <gnc/measurements/Measurement.hpp>
+#include <gnc/measurements/MeasurementPool.hpp>
+#include <gnc/utils/Metrics.hpp>
 
 namespace maav
 {
 namespace gnc
 {
-class Estimator
+/**
+ * Scalar is the precision the filter runs in. Sensor measurements are double either way, and so
+ * are IMU preintegrations, whose increments are summed over many samples. Estimator (double) is
+ * the default; EstimatorT<float> is the single precision variant (see GNC_FLOAT_ESTIMATOR).
+ */
+template <class Scalar>
+class EstimatorT
 {
 public:
+    using State = StateT<Scalar>;
+
+    /**
+     * Counters describing how much re-filtering delayed measurements cause
+     */
+    struct ReplayStats
+    {
+        // How far back in time the newest correction reached [us]
+        uint64_t last_depth_usec = 0;
+        uint64_t max_depth_usec = 0;
+
+        // Filter steps run on the last tick, including catch-up steps
+        size_t last_steps = 0;
+        size_t max_steps = 0;
+        uint64_t total_steps = 0;
+
+        // Steps still waiting to be replayed on later ticks
+        size_t backlog_steps = 0;
+
+        // Ticks that hit max_replay_steps and deferred part of the replay
+        uint64_t deferred_ticks = 0;
+    };
+
+    /**
+     * Diagonals of the noise covariances the filter is running with
+     */
+    struct Noise
+    {
+        // Process noise added per IMU interval, in error state order
+        gnc::State::ErrorStateVector Q;
+
+        Eigen::Matrix<double, measurements::LidarMeasurement::DoF, 1> lidar_R;
+        Eigen::Matrix<double, kalman::PFSensorMeasurement::DoF, 1> plane_fit_R;
+        Eigen::Matrix<double, measurements::GlobalUpdateMeasurement::DoF, 1> global_update_R;
+        Eigen::Matrix<double, measurements::VisualOdometryMeasurement::DoF, 1> visual_odometry_R;
+    };
+
     /**
      * @param config This yaml node requires at leas 4 keys: 'history', 'state', 'prediction',
-     * and 'updates'
+     * and 'updates'. The optional 'max_replay_steps' key bounds the number of filter steps run per
+     * call to add_measurement_set, and must be 0 (unbounded) or at least 3. The optional 'filter'
+     * key picks the backend, 'ukf' (default) or 'eskf'. The optional 'filter_rate' key [Hz] runs
+     * the filter slower than the IMU, with the samples in between preintegrated. 0 (default)
+     * steps the filter on every IMU sample. With the UKF, 'updates: joint' corrects each snapshot
+     * with all of its measurements at once.
+     * The optional 'updates: visual_odometry' key fuses the camera's relative motion, after the
+     * other updates.
+     * The optional 'smoother' key runs a FixedLagSmoother over the newest snapshots.
+     * The optional 'prediction: adaptive' key estimates Q from the state corrections (see
+     * kalman::AdaptiveNoise), bounded by its 'min_scale' and 'max_scale' times the configured Q.
+     * Each update can adapt its R the same way.
      */
-    Estimator(YAML::Node config);
+    EstimatorT(YAML::Node config);
 
     /**
      * TODO: Update style
      * @bried Runs the kalman filter on a new set of measurements
      * @param meas A set of measurements. Imu must be populated
+     *
+     * With a filter rate set, the filter only steps once per filter period, taking in every IMU
+     * sample and every other reading since the last step. In between, the
+     * returned state is the last filtered state carried forward by the IMU samples so far, with
+     * the covariance of the last filtered state.
+     *
+     * When a delayed measurement requires re-filtering more than max_replay_steps snapshots, only
+     * part of the history is replayed and the rest is picked up on the following calls. The newest
+     * state is always carried forward from the last one returned, so it is valid but may not
+     * include the delayed correction yet.
      */
     const State& add_measurement_set(const measurements::MeasurementSet& meas);
 
+    /**
+     * @brief Queues measurements to be fused on the next call to add_measurement_set
+     * @param meas A set of measurements. The IMU, if any, is ignored
+     *
+     * Sensors may report any number of times between IMU samples. Their readings are fused in
+     * time order, subject to the 'queue_size' and 'latency_budget' keys of the history config.
+     */
+    void queue_measurement_set(const measurements::MeasurementSet& meas);
+
     void setBiases(const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias);
 
+    /**
+     * Measurements for add_measurement_set should come from here. They are recycled once the
+     * history drops them, so the estimator runs without allocating once its history is full.
+     */
+    measurements::MeasurementPool& measurementPool();
+
+    const ReplayStats& replayStats() const;
+
+    /**
+     * @return Counters of the readings fused and dropped, per sensor
+     */
+    kalman::MeasurementQueue::Stats queueStats() const;
+
+    kalman::FilterType filter() const;
+
+    /**
+     * @return True if Q or any sensor's R is estimated online
+     */
+    bool adaptiveNoise() const;
+
+    Noise noise() const;
+
+    /**
+     * Smooths the newest snapshots on its own thread. Set its callback before the first
+     * measurement set to receive the smoothed states.
+     */
+    kalman::FixedLagSmootherT<Scalar>& smoother();
+
+    /**
+     * @brief Adds the log likelihood of the innovations of every reading gated since the last
+     * call. Each reading is scored once, when its snapshot is first corrected.
+     * @return Number of readings it covers
+     */
+    size_t takeLogLikelihood(double& log_likelihood);
+
+    /**
+     * @brief Takes over the filtered states of an estimator fed the same measurements
+     *
+     * Every snapshot of the history gets the state of other's snapshot at the same time, so
+     * replays continue from other's estimate, and so do the bases of visual odometry readings.
+     * Noise estimates and queued readings are kept.
+     *
+     * @return False, changing nothing, if the histories do not line up
+     */
+    bool adopt(EstimatorT& other);
+
 private:
+    /**
+     * Adds a set to the history and re-filters whatever it changed
+     */
+    const State& filter(const measurements::MeasurementSet& meas);
+
+    /**
+     * Starts preintegrating IMU samples from imu, at the biases of the newest snapshot
+     */
+    void startPreintegration(const measurements::ImuMeasurement& imu);
+
+    /**
+     * Runs the prediction and all updates from prev to next
+     */
+    using History = kalman::HistoryT<Scalar>;
+
+    void step(const typename History::Iterator prev, const typename History::Iterator next);
+
+    /**
+     * Feeds the correction the updates made to a snapshot to the adaptive estimate of Q
+     */
+    void adaptProcessNoise(const typename History::Snapshot& snapshot);
+
     State empty_state_;
-    kalman::History history_;
-    kalman::UkfPrediction prediction_;
-    kalman::LidarUpdate lidar_update_;
-    kalman::PlaneFitUpdate planefit_update_;
-    kalman::GlobalUpdate global_update_;
+    kalman::FilterType filter_;
+    History history_;
+    kalman::UkfPredictionT<Scalar> prediction_;
+    kalman::EskfPredictionT<Scalar> eskf_prediction_;
+    kalman::LidarUpdateT<Scalar> lidar_update_;
+    kalman::PlaneFitUpdateT<Scalar> planefit_update_;
+    kalman::GlobalUpdateT<Scalar> global_update_;
+    kalman::JointUpdateT<Scalar> joint_update_;
+    kalman::VisualOdometryUpdateT<Scalar> visual_odometry_update_;
+
+    // 0 means unlimited
+    size_t max_replay_steps_;
+
+    // Time of the last snapshot known to be up to date, if a replay is still in progress
+    bool replay_pending_;
+    uint64_t replay_from_;
+
+    ReplayStats replay_stats_;
+
+    // 0 steps the filter on every IMU sample
+    uint64_t filter_period_usec_;
+    // Preintegrations accumulate in double
+    gnc::State::CovarianceMatrix process_noise_;
+
+    // IMU samples since the last filter step. Other measurements wait in the history's queue.
+    std::shared_ptr<kalman::ImuPreintegration> preintegration_;
+    measurements::MeasurementSet pending_;
+
+    // Most samples a filter step has taken in, reserved up front by recycled preintegrations
+    size_t max_preintegration_samples_;
+
+    // Last filtered state carried forward to the newest IMU sample
+    State forward_state_;
+
+    kalman::FixedLagSmootherT<Scalar> smoother_;
+
+    kalman::AdaptiveNoise<Scalar, State::DoF> adaptive_Q_;
+    // Mean of the snapshot being corrected, before its updates
+    State predicted_;
+
+    // Registered once (see Metrics), recorded on every filter step
+    Metrics::Histogram& filter_time_;
+    Metrics::Histogram& predict_time_;
+    Metrics::Histogram& update_time_;
+    Metrics::Histogram& replay_depth_;
+    Metrics::Histogram& replay_steps_;
+    Metrics::Gauge& replay_backlog_;
 };
 
+using Estimator = EstimatorT<double>;
+
 }  // namespace gnc
 }  // namespace maav
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+
+#include <gnc/Estimator.hpp>
+#include <gnc/utils/Metrics.hpp>
+#include <gnc/utils/ThreadPool.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Competing estimators that disagree on whether to trust large global updates
+ *
+ * A global update far from the estimate is either an outlier or SLAM relocalizing. An estimator
+ * that rejects it never recovers from a relocalization, one that takes it follows every bad data
+ * association. The bank runs a hypothesis of each kind side by side and follows whichever
+ * predicts the readings best.
+ *
+ * Every hypothesis is a full EstimatorT built from the same config, except for the keys of
+ * updates/global_update it overrides (typically 'enable_outliers', 'outlier_threshold' and
+ * 'inflate_outliers', see kalman::Gate). Every hypothesis takes the same measurements; the
+ * measurements are shared, not copied. The hypotheses step on a ThreadPool, one per core.
+ *
+ * Each hypothesis is scored by the log likelihood of its innovations, faded by 'fade' per filter
+ * tick with new readings. The bank follows the selected hypothesis until another outscores it by
+ * 'switch_margin'. Any hypothesis that falls 'switch_margin' behind the selected one adopts its
+ * states (see EstimatorT::adopt), so the hypotheses branch again from the best estimate. After a
+ * relocalization the inflating hypothesis jumps on the first global update and wins on the next.
+ *
+ * Switches are counted in "bank.switches" and the selected hypothesis is the "bank.selected"
+ * gauge. The update metrics are summed over the hypotheses.
+ */
+template <class Scalar>
+class EstimatorBankT
+{
+public:
+    using Estimator = EstimatorT<Scalar>;
+    using State = StateT<Scalar>;
+    using Smoother = kalman::FixedLagSmootherT<Scalar>;
+
+    /**
+     * @param config The estimator config. Its optional 'bank' key, if enabled, holds
+     *     'hypotheses' (a list of updates/global_update overrides, the first one selected at
+     *     start), 'fade', 'switch_margin' and 'threads' (workers besides the calling thread,
+     *     default one per extra hypothesis). Without it the bank is a single estimator.
+     */
+    explicit EstimatorBankT(YAML::Node config);
+
+    EstimatorBankT(const EstimatorBankT&) = delete;
+    EstimatorBankT& operator=(const EstimatorBankT&) = delete;
+
+    /**
+     * @brief Runs every hypothesis on a set of measurements (see EstimatorT::add_measurement_set)
+     * @return The state of the selected hypothesis
+     */
+    const State& add_measurement_set(const measurements::MeasurementSet& meas);
+
+    void queue_measurement_set(const measurements::MeasurementSet& meas);
+
+    void setBiases(const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias);
+
+    /**
+     * Measurements for the bank should come from the pool of the first hypothesis. The others
+     * hold on to the same measurements, which go back to the pool once all of them let go.
+     */
+    measurements::MeasurementPool& measurementPool();
+
+    /**
+     * @brief Sets the function smoothed windows of the selected hypothesis are handed to
+     */
+    void setSmootherCallback(typename Smoother::Callback callback);
+
+    size_t size() const { return hypotheses_.size(); }
+
+    /**
+     * @return The hypothesis the bank follows
+     */
+    Estimator& selected() { return *hypotheses_[selected_.load()]; }
+    const Estimator& selected() const { return *hypotheses_[selected_.load()]; }
+    size_t selectedIndex() const { return selected_.load(); }
+
+    Estimator& hypothesis(size_t i) { return *hypotheses_[i]; }
+    double score(size_t i) const { return scores_[i]; }
+
+private:
+    /**
+     * Fades the scores with the newest innovations, then switches and prunes hypotheses
+     */
+    void updateScores();
+
+    std::vector<std::unique_ptr<Estimator>> hypotheses_;
+    std::vector<double> scores_;
+    std::vector<const State*> states_;
+
+    double fade_;
+    double switch_margin_;
+
+    // Only used with more than one hypothesis
+    std::unique_ptr<ThreadPool> pool_;
+
+    // Read by the smoother threads
+    std::atomic<size_t> selected_;
+
+    Metrics::Counter& switches_;
+    Metrics::Gauge& selected_gauge_;
+};
+
+using EstimatorBank = EstimatorBankT<double>;
+
+}  // namespace gnc
+}  // namespace maav
@@ -1,14 +1,15 @@
 #ifndef __MAAV_OCCUPANCY_MAP__HPP__
 #define __MAAV_OCCUPANCY_MAP__HPP__
 
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <yaml-cpp/yaml.h>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-#include <pcl/filters/passthrough.h>
+#include <Eigen/Dense>
 #include <zcm/zcm-cpp.hpp>
+#include <common/messages/point_cloud_t.hpp>
 #include <gnc/PointMapper.hpp>
+#include <gnc/RayInserter.hpp>
 #include <octomap/octomap.h>
 #include <octomap/OcTree.h>
 
@@ -25,6 +26,11 @@ namespace gnc
  * Octree. The member pointmapper_ subscribes to the STATE channel automatically so a 
  * zcm instance must be passed in.
  *
+ * Each cloud is cropped and downsampled to one point per voxel of the map before its rays
+ * are cast, which leaves far fewer rays than there are pixels.
+ * Rays are cast on insert_threads threads. The inner nodes of the tree (and pruning) are
+ * only updated every inner_update_period clouds, in between they lag behind the leaves.
+ *
  */
 
 class OccupancyMap
@@ -36,10 +42,20 @@ public:
      */
     explicit OccupancyMap(YAML::Node& config, YAML::Node& camera_config, zcm::ZCM &zcm);
 
-    void update(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, uint64_t utime);
+    /**
+     * @param cloud Points in the camera frame, inserted from where the camera was at its utime.
+     * Dropped if no state arrives within pose_timeout.
+     */
+    void update(const point_cloud_t& cloud);
 
     std::shared_ptr<const octomap::OcTree> map() const { return octree_; }
 
+    /**
+     * Voxels whose occupancy changed since the last call are listed by the change detection of
+     * map(), for publishing them as a delta
+     */
+    void resetChanges() { octree_->resetChangeDetection(); }
+
 	// Unblocks the point mapper if waiting if program is being killed
     void kill() { point_mapper_.kill(); };
 
@@ -58,9 +74,21 @@ private:
 	double point_cloud_max_z_;
 	bool compress_map_;
 	bool simulator;
+	unsigned inner_update_period_;
+	unsigned clouds_since_inner_update_;
+	std::chrono::microseconds pose_timeout_;
 	PointMapper point_mapper_;
+	RayInserter inserter_;
 	std::shared_ptr<octomap::OcTree> octree_;
-	std::vector<pcl::PassThrough<pcl::PointXYZ>> cloud_filters_;
+	// Voxels hit by the cloud being downsampled, kept between clouds for its buckets
+	octomap::KeySet voxels_;
+	octomap::Pointcloud points_;
+
+	/**
+	 * @brief Crops cloud in the camera frame, maps it to the world and keeps the center of each
+	 * voxel it hits, in a single pass into points_
+	 */
+	void downsample(const point_cloud_t& cloud, const Eigen::Matrix4d& camera_to_world);
 };
 
 }  // namespace gnc
@@ -2,45 +2,44 @@
 #define __POINT_MAPPER_HPP___
 
 #include <yaml-cpp/yaml.h>
-#include <sophus/so3.hpp>
+#include <sophus/se3.hpp>
 #include <Eigen/Core>
 #include <Eigen/Eigen>
 #include <zcm/zcm-cpp.hpp>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
 
-#include <gnc/State.hpp>
-#include <gnc/State.hpp>
 #include <common/messages/groundtruth_inertial_t.hpp>
 #include <common/messages/state_t.hpp>
+#include <common/messages/state_trajectory_t.hpp>
 #include <common/messages/MsgChannels.hpp>
+#include <gnc/utils/PoseBuffer.hpp>
 #include <gnc/utils/ZcmConversion.hpp>
 
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <deque>
+#include <chrono>
 
 /* To use, create an instance of the PointMapper class.
  * It will automatically subscribe to STATE_CHANNEL
  * or GT_INERTIAL (for the simulator) and
- * store the last 100 received states, under the assumption
- * that states are sent at 100hz. The intention is to hold a
- * queue (but still needing the functionality of a deque for
- * random access) of the states we were in in the last second.
- * All that one needs to do to use it is pass in the utime in
- * order to access to closest state for any of its public
- * functions. Relies upon correct camera to body extrinsics
- * specified in the camera config that is passed into the
- * constructor to work correctly.
+ * store the poses of the last 100 received states, under the
+ * assumption that states are sent at 100hz. All that one needs
+ * to do to use it is pass in the utime of a point cloud, and the
+ * camera pose is interpolated between the states around it.
+ * Relies upon correct camera to body extrinsics specified in the
+ * camera config that is passed into the constructor to work
+ * correctly.
+ *
+ * Outside the simulator it also subscribes to SMOOTHED_STATE_CHANNEL
+ * and keeps the poses of the smoothed windows. Times within the
+ * smoothed poses are looked up in them instead of the causal states.
+ *
+ * Poses are kept in PoseBuffers written by the zcm thread, so
+ * lookups from other threads never wait on it for a lock.
 */
 
 namespace maav::gnc
 {
 
 // Maps points from the camera frame point cloud
-// to the world frame. Also returns the matrix
-// used for that transformation.
+// to the world frame.
 class PointMapper
 {
 public:
@@ -49,76 +48,65 @@ public:
     PointMapper(YAML::Node& config, zcm::ZCM &zcm, bool simulator);
     // Stops the zcm subscription
     ~PointMapper();
-    // Returns the camera_to_world transformation matrix
-    Eigen::Matrix4d getCameraToWorldMatrix(uint64_t utime);
-    // Get the sensor origin used for octomap
-    Eigen::Vector3d getCameraOrigin(uint64_t utime);
-    // Transforms all points from the camera frame to the global
-    // frame in the passed in point cloud
-    pcl::PointCloud<pcl::PointXYZ>::Ptr
-        transformCloud(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud,
-        uint64_t utime);
+    // Finds the camera_to_world transformation at utime, waiting up
+    // to timeout for the states around it. The translation is the
+    // sensor origin used for octomap. Returns false if there was no
+    // state by then or the point mapper was killed.
+    bool getCameraToWorld(uint64_t utime, std::chrono::microseconds timeout,
+        Eigen::Matrix4d& camera_to_world);
     // Unblocks the point mapper if waiting if program is being killed
     void kill();
 private:
-    // Queue of last 100 states
-    std::deque<State> latest_states_;
+    // Poses of the last 100 states
+    PoseBuffer latest_poses_;
+    // Poses of the smoothed windows
+    PoseBuffer smoothed_poses_;
     // Created during construction
     Eigen::Matrix4d camera_to_body_;
     // reference to zcm oject, used to receieve state messages and
-    // update the latest states deque
+    // update the latest poses
     zcm::ZCM &zcm_;
-    std::mutex mtx_;
-    std::condition_variable cv_;
-    // Used to find the state nearest to the passed in utime
-    State nearestState(uint64_t utime);
     bool simulator_ = false; // used to subscribe to simulator zcm channels
     // Handler class for receiving the zcm messages and updating
-    // the deque
+    // the pose buffers. Only the zcm thread writes to them.
     class Handler
     {
     public:
-        Handler(std::deque<State>& latest_states, std::mutex& mtx,
-                std::condition_variable& cv) :
-            latest_states_ {latest_states}, mtx_ {mtx}, cv_ {cv}
+        Handler(PoseBuffer& latest_poses, PoseBuffer& smoothed_poses) :
+            latest_poses_ {latest_poses}, smoothed_poses_ {smoothed_poses}
         {
 
         }
-        // Adds the latest state to the deque, and keeps the
-        // deque at a max size of 100
+        // Adds the pose of the latest state
         void handle(const zcm::ReceiveBuffer*, const std::string&,
                 const state_t* message)
         {
-            std::unique_lock<std::mutex>(mtx_);
-
-            latest_states_.push_back(maav::gnc::ConvertState(*message));
-            if (latest_states_.size() > 100)
-            {
-                latest_states_.pop_front();
-            }
-            // Wake the PointMapper if it is waiting
-            cv_.notify_all();
+            latest_poses_.push(message->utime,
+                maav::gnc::convertPose(message->attitude, message->position));
         }
 
-        // Adds the latest state to the deque, and keeps the
-        // deque at a max size of 100. Simulator channel
+        // Adds the pose of the latest state. Simulator channel
         void handleSim(const zcm::ReceiveBuffer*, const std::string&,
                 const groundtruth_inertial_t* message)
         {
-            std::unique_lock<std::mutex>(mtx_);
+            latest_poses_.push(message->utime,
+                maav::gnc::convertPose(message->attitude, message->position));
+        }
 
-            latest_states_.push_back(maav::gnc::ConvertGroundTruthState(*message));
-            if (latest_states_.size() > 100)
+        // Writes the newest window over the poses it re-estimated. Each
+        // window covers the last one up to the lag.
+        void handleSmoothed(const zcm::ReceiveBuffer*, const std::string&,
+                const state_trajectory_t* message)
+        {
+            for (const state_t& state : message->states)
             {
-                latest_states_.pop_front();
+                smoothed_poses_.push(state.utime,
+                    maav::gnc::convertPose(state.attitude, state.position));
             }
-            // Wake the PointMapper if it is waiting
-            cv_.notify_all();
         }
     private:
-        std::deque<State>& latest_states_;
-        std::mutex& mtx_;
-        std::condition_variable& cv_;
+        PoseBuffer& latest_poses_;
+        PoseBuffer& smoothed_poses_;
     } handler_;
 };
 }
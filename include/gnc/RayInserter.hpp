@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <octomap/OcTree.h>
+#include <octomap/octomap.h>
+
+#include <gnc/utils/ThreadPool.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Inserts point clouds into an octomap, casting the rays on several threads
+ *
+ * @details Does what OcTree::insertPointCloud does with discretization, except that the rays are
+ * cast in parallel chunks of the cloud. As there, each voxel the cloud has points in casts a single
+ * ray, to the voxel's center. Each chunk collects the keys of the free voxels along its rays and of
+ * the occupied voxels at their ends, and the chunks are merged so every voxel is updated once per
+ * cloud, occupied if any ray ended in it. Only that merge and the tree updates run on the calling
+ * thread.
+ *
+ * Voxels are updated lazily: the inner nodes of the tree are stale until the caller runs
+ * OcTree::updateInnerOccupancy. Leaf queries (search by key or coordinate at full depth) are
+ * always up to date.
+ */
+class RayInserter
+{
+public:
+    /**
+     * @param num_threads Number of threads casting rays alongside the calling thread
+     * @param max_range Rays longer than this are cut to it and only clear space. Negative for
+     * no limit.
+     */
+    RayInserter(size_t num_threads, double max_range);
+
+    /**
+     * @brief Marks the voxels between origin and the points of cloud as free, and the voxels of
+     * the points as occupied
+     * @param cloud Points in the frame of tree
+     * @param origin Sensor origin in the frame of tree
+     */
+    void insert(octomap::OcTree& tree, const octomap::Pointcloud& cloud,
+        const octomap::point3d& origin);
+
+private:
+    /**
+     * Keys found by the rays of one part of the cloud. Kept between clouds so the sets keep their
+     * buckets.
+     */
+    struct Chunk
+    {
+        octomap::KeySet endpoints;
+        octomap::KeySet free;
+        octomap::KeySet occupied;
+        octomap::KeyRay ray;
+    };
+
+    /**
+     * @brief Casts the rays of points [begin, end) of cloud into chunk
+     */
+    void castRays(const octomap::OcTree& tree, const octomap::Pointcloud& cloud,
+        const octomap::point3d& origin, size_t begin, size_t end, Chunk& chunk) const;
+
+    ThreadPool pool_;
+    double max_range_;
+    std::vector<Chunk> chunks_;
+    octomap::KeySet free_;
+};
+
+}  // namespace gnc
+}  // namespace maav
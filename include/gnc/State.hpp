@@ -1,7 +1,9 @@
 #ifndef STATE_HPP
 #define STATE_HPP
 
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <ostream>
 
 #include <Eigen/Dense>
@@ -12,9 +14,22 @@ namespace maav
 {
 namespace gnc
 {
-class State
+/**
+ * Estimated variables of the vehicle and their covariance
+ *
+ * Scalar is the precision the filter runs in. State (double) is what the rest of the stack works
+ * with; StateT<float> is only used inside a single precision estimator (see EstimatorT), and cast()
+ * converts between the two.
+ */
+template <class Scalar_>
+class StateT
 {
 public:
+    using Scalar = Scalar_;
+    using Vector3 = Eigen::Matrix<Scalar, 3, 1>;
+    using SO3 = Sophus::SO3<Scalar>;
+    using SE3 = Sophus::SE3<Scalar>;
+
     // TODO: Increase this to estimate more variables
     /**
      * Minimum number of variables needed to parameterize the state
@@ -26,17 +41,74 @@ public:
      */
     constexpr static size_t N = 1 + 2 * DoF;
 
-    using CovarianceMatrix = Eigen::Matrix<double, DoF, DoF>;
-    using ErrorStateVector = Eigen::Matrix<double, DoF, 1>;
+    using CovarianceMatrix = Eigen::Matrix<Scalar, DoF, DoF>;
+    using ErrorStateVector = Eigen::Matrix<Scalar, DoF, 1>;
+
+    /**
+     * Weights of the sigma points of an unscented transform
+     */
+    using Weights = std::array<Scalar, N>;
+
+    /**
+     * Vector variables in the order they are packed. Position, velocity and the biases come first,
+     * in the order of their blocks of the error state.
+     */
+    enum VectorIndex : size_t
+    {
+        POSITION,
+        VELOCITY,
+        GYRO_BIAS,
+        ACCEL_BIAS,
+        ANGULAR_VELOCITY,
+        ACCELERATION,
+        GRAVITY,
+        MAGNETIC_FIELD,
+        VECTOR_COUNT
+    };
+
+    /**
+     * Number of values in all vector variables
+     */
+    constexpr static size_t VectorSize = 3 * VECTOR_COUNT;
+
+    using PackedVector = Eigen::Matrix<Scalar, VectorSize, 1>;
+
+    /**
+     * @brief Sigma points stored a variable at a time
+     *
+     * Each row holds one value of every point, so weighted sums over the points are single
+     * matrix products instead of a pass over each point's members.
+     */
+    struct PackedPoints
+    {
+        explicit PackedPoints(const std::array<StateT, N>& points);
+
+        uint64_t time_usec;
+
+        // Attitude of the center point, and every point's attitude relative to it
+        SO3 attitude;
+        Eigen::Matrix<Scalar, 3, N, Eigen::RowMajor> attitude_offsets;
+
+        Eigen::Matrix<Scalar, VectorSize, N, Eigen::RowMajor> vectors;
+    };
 
-    State() = default;
+    StateT() = default;
+
+    /**
+     * Copies carry the Cholesky factor only if other has one. Assigning reuses the storage of the
+     * factor, so a state that keeps being overwritten allocates it once.
+     */
+    StateT(const StateT& other);
+    StateT(StateT&& other) noexcept = default;
+    StateT& operator=(const StateT& other);
+    StateT& operator=(StateT&& other) noexcept;
 
     /**
      * @breif Sets time, but leaves all other variables uninitialized
      *
      * @param time_usec Timestamp to initialize this state
      */
-    explicit State(uint64_t time_usec);
+    explicit StateT(uint64_t time_usec);
 
     /**
      * Initializes position, velocity, angular rates, and biases to zero. Attitude is initialized to
@@ -47,14 +119,22 @@ public:
      *
      * @param time_usec Timestamp to initialize this state
      */
-    static State zero(uint64_t time_usec);
+    static StateT zero(uint64_t time_usec);
+
+    /**
+     * @brief Copy of this state in another precision, including the covariance and its factor
+     */
+    template <class Other>
+    StateT<Other> cast() const;
 
 private:
-    static State mean(
-        const std::array<State, N>& sigma_points, const std::array<double, N>& weights);
+    using Residuals = Eigen::Matrix<Scalar, DoF, N, Eigen::RowMajor>;
+
+    static void mean(const PackedPoints& points, const Weights& weights, StateT& mean_state);
 
-    static CovarianceMatrix cov(const State& mean, const std::array<State, N>& sigma_points,
-        const std::array<double, N>& weights);
+    static CovarianceMatrix cov(const Residuals& residuals, const Weights& weights);
+
+    static Residuals residuals(const StateT& mean, const PackedPoints& points);
 
 public:
     /**
@@ -65,15 +145,27 @@ public:
      * @param c_weights Covariance weights
      * @return A `State` representing the probability distribution
      */
-    static State compute_gaussian(const std::array<State, 1 + 2 * DoF>& points,
-        const std::array<double, N>& m_weights, const std::array<double, N>& c_weights);
+    static StateT compute_gaussian(
+        const std::array<StateT, N>& points, const Weights& m_weights, const Weights& c_weights);
+
+    /**
+     * @brief Same as compute_gaussian, but also carries the Cholesky factor of the covariance
+     *
+     * The factor is built with a QR decomposition of the weighted residuals and a rank one
+     * update for the center point, so it stays positive definite where summing outer products
+     * can lose it. Falls back to compute_gaussian if the center point downdate fails.
+     *
+     * @param mu Set to the distribution, reusing the storage of its factor
+     */
+    static void compute_sqrt_gaussian(const std::array<StateT, N>& points,
+        const Weights& m_weights, const Weights& c_weights, StateT& mu);
 
     /**
      * @brief Adds an infinitesmal change to the state
      *
      * @param e_state A small change represented in the tangent space
      */
-    State& operator+=(const ErrorStateVector& e_state);
+    StateT& operator+=(const ErrorStateVector& e_state);
 
     /**
      * @brief Takes the difference between two states in the tangent space
@@ -81,72 +173,115 @@ public:
      * @param other Other state to take the difference
      * @return A small change between two states represented in the tangent space
      */
-    ErrorStateVector operator-(const State& other) const;
+    ErrorStateVector operator-(const StateT& other) const;
 
 public:
-    const Sophus::SO3d& attitude() const;
-    Sophus::SO3d& attitude();
+    const SO3& attitude() const;
+    SO3& attitude();
 
-    const Eigen::Vector3d& angularVelocity() const;
-    Eigen::Vector3d& angularVelocity();
+    const Vector3& angularVelocity() const;
+    Vector3& angularVelocity();
 
-    const Eigen::Vector3d& position() const;
-    Eigen::Vector3d& position();
+    const Vector3& position() const;
+    Vector3& position();
 
-    const Eigen::Vector3d& velocity() const;
-    Eigen::Vector3d& velocity();
+    const Vector3& velocity() const;
+    Vector3& velocity();
 
-    const Eigen::Vector3d& acceleration() const;
-    Eigen::Vector3d& acceleration();
+    const Vector3& acceleration() const;
+    Vector3& acceleration();
 
-    const Eigen::Vector3d& gyroBias() const;
-    Eigen::Vector3d& gyroBias();
+    const Vector3& gyroBias() const;
+    Vector3& gyroBias();
 
-    const Eigen::Vector3d& accelBias() const;
-    Eigen::Vector3d& accelBias();
+    const Vector3& accelBias() const;
+    Vector3& accelBias();
 
-    const Eigen::Vector3d& gravity() const;
-    Eigen::Vector3d& gravity();
+    const Vector3& gravity() const;
+    Vector3& gravity();
 
-    const Eigen::Vector3d& magneticFieldVector() const;
-    Eigen::Vector3d& magneticFieldVector();
+    const Vector3& magneticFieldVector() const;
+    Vector3& magneticFieldVector();
+
+    /**
+     * @brief Every vector variable back to back, in VectorIndex order
+     */
+    Eigen::Map<const PackedVector, Eigen::AlignedMax> packedVectors() const;
+    Eigen::Map<PackedVector, Eigen::AlignedMax> packedVectors();
 
     const CovarianceMatrix& covariance() const;
     CovarianceMatrix& covariance();
 
+    /**
+     * Lower triangular Cholesky factor of covariance(). Only valid when hasSqrtCovariance() is
+     * true. Square root mode is the only one to set it, so only then does a state allocate room
+     * for it.
+     */
+    const CovarianceMatrix& sqrtCovariance() const;
+
+    /**
+     * @return True if sqrtCovariance() holds the factor of the current covariance. Code that
+     * modifies covariance() directly must call clearSqrtCovariance().
+     */
+    bool hasSqrtCovariance() const;
+
+    /**
+     * @brief Sets the Cholesky factor and recomputes the covariance from it
+     */
+    void setSqrtCovariance(const CovarianceMatrix& sqrt_covariance);
+
+    void clearSqrtCovariance();
+
+    /**
+     * @brief Copies the time and every estimated variable, but not the covariance
+     *
+     * Sigma points only need the mean, and copying a full State costs two covariance matrices.
+     */
+    void copyMean(const StateT& other);
+
     void setTime(uint64_t time_usec);
 
     uint64_t timeUSec() const;
     double timeSec() const;
 
-    Sophus::SE3d getPose() const;
-    void setPose(const Sophus::SE3d& pose);
+    SE3 getPose() const;
+    void setPose(const SE3& pose);
 
 private:
     uint64_t time_usec_;
 
-    Sophus::SO3d attitude_;
-
-    Eigen::Vector3d angular_velocity_;
+    SO3 attitude_;
 
-    Eigen::Vector3d position_;
+    // Indexed by VectorIndex. Vector3 has no padding, so this is one contiguous block.
+    alignas(EIGEN_MAX_ALIGN_BYTES) std::array<Vector3, VECTOR_COUNT> vectors_;
 
-    Eigen::Vector3d velocity_;
-
-    Eigen::Vector3d acceleration_;
+    CovarianceMatrix covar_;
 
-    Eigen::Vector3d gyro_bias_;
+    // Allocated on the first setSqrtCovariance() and kept from then on
+    std::unique_ptr<CovarianceMatrix> sqrt_covar_;
 
-    Eigen::Vector3d accel_bias_;
+    bool has_sqrt_covar_ = false;
+};
 
-    Eigen::Vector3d gravity_;
+using State = StateT<double>;
 
-    Eigen::Vector3d magnetic_field_;
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const StateT<Scalar>& state);
 
-    CovarianceMatrix covar_;
-};
-
-std::ostream& operator<<(std::ostream& os, const State& state);
+template <class Scalar>
+template <class Other>
+StateT<Other> StateT<Scalar>::cast() const
+{
+    StateT<Other> other(time_usec_);
+    other.attitude() = attitude_.template cast<Other>();
+    other.packedVectors() = packedVectors().template cast<Other>();
+    other.covariance() = covar_.template cast<Other>();
+    if (has_sqrt_covar_)
+    {
+        other.setSqrtCovariance(sqrt_covar_->template cast<Other>());
+    }
+    return other;
+}
 
 }  // namespace gnc
 }  // namespace maav
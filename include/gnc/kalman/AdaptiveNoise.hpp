@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Dense>
+
+#include <gnc/utils/RingBuffer.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * @brief Sliding window estimate of a diagonal noise covariance (covariance matching)
+ *
+ * Each sample is a squared vector the noise should explain, the part of it the filter already
+ * accounts for, and how many IMU intervals it spans. The estimate is
+ *
+ *   (sum of squares - sum of explained) / sum of intervals
+ *
+ * over the newest samples, clamped elementwise to [min, max]. For a sensor's R the squares are
+ * those of its innovations and the explained part is the covariance of the predicted measurement.
+ * For the process noise Q the squares are those of the state corrections, with nothing explained,
+ * which is the innovation based estimate K * C_v * K^T spread over the intervals.
+ *
+ * Samples are keyed by time. A snapshot re-filtered after a delayed measurement replaces the sample
+ * it gave before, and a snapshot the delayed measurement inserted is slotted in by time.
+ */
+template <class Scalar, int Dim>
+class AdaptiveNoise
+{
+public:
+    using Vector = Eigen::Matrix<Scalar, Dim, 1>;
+
+    /**
+     * @param config The optional 'enabled' and 'window' (samples) keys. Disabled if null.
+     * @param initial Estimate until the window first fills up
+     * @param min Lower bound of each element
+     * @param max Upper bound of each element
+     */
+    AdaptiveNoise(YAML::Node config, const Vector& initial, const Vector& min, const Vector& max)
+        : enabled_(config && config["enabled"] && config["enabled"].as<bool>()),
+          samples_(enabled_ ? config["window"].as<size_t>() : 0),
+          estimate_(initial),
+          min_(min),
+          max_(max),
+          since_resum_(0)
+    {
+        clear();
+    }
+
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief Adds a sample, dropping the oldest one once the window is full
+     *
+     * @param time_usec Time of the sample. A sample at the same time as one in the window replaces
+     * it. Samples older than a full window are ignored.
+     * @return True if the estimate changed, which only happens with a full window
+     */
+    bool add(uint64_t time_usec, const Vector& squared, const Vector& explained,
+        Scalar intervals = 1)
+    {
+        if (!enabled_ || samples_.capacity() == 0) return false;
+        const Sample sample{time_usec, squared, explained, static_cast<double>(intervals)};
+
+        auto it = std::lower_bound(samples_.begin(), samples_.end(), time_usec,
+            [](const Sample& other, uint64_t time) { return other.time_usec < time; });
+        if (it != samples_.end() && it->time_usec == time_usec)
+        {
+            // Re-filtered snapshot
+            subtract(*it);
+            *it = sample;
+        }
+        else
+        {
+            size_t idx = static_cast<size_t>(it - samples_.begin());
+            if (samples_.full())
+            {
+                if (idx == 0) return false;
+                subtract(samples_.front());
+                samples_.pop_front();
+                idx--;
+            }
+            samples_.insert(samples_.begin() + idx, sample);
+        }
+        excess_ += (squared - explained).template cast<double>();
+        intervals_ += sample.intervals;
+
+        // Resum every window so the running sums do not drift
+        if (++since_resum_ >= samples_.capacity()) resum();
+
+        if (!samples_.full() || intervals_ <= 0) return false;
+        estimate_ = (excess_ / intervals_).cwiseMax(min_.template cast<double>())
+                        .cwiseMin(max_.template cast<double>())
+                        .template cast<Scalar>();
+        return true;
+    }
+
+    /**
+     * Diagonal of the estimated covariance, or of the initial one until the window fills up
+     */
+    const Vector& estimate() const { return estimate_; }
+
+    /**
+     * @brief Forgets every sample, keeping the current estimate
+     */
+    void clear()
+    {
+        samples_.clear();
+        excess_.setZero();
+        intervals_ = 0;
+        since_resum_ = 0;
+    }
+
+private:
+    struct Sample
+    {
+        uint64_t time_usec;
+        Vector squared;
+        Vector explained;
+        double intervals;
+    };
+
+    void subtract(const Sample& sample)
+    {
+        excess_ -= (sample.squared - sample.explained).template cast<double>();
+        intervals_ -= sample.intervals;
+    }
+
+    void resum()
+    {
+        excess_.setZero();
+        intervals_ = 0;
+        for (const Sample& sample : samples_)
+        {
+            excess_ += (sample.squared - sample.explained).template cast<double>();
+            intervals_ += sample.intervals;
+        }
+        since_resum_ = 0;
+    }
+
+    bool enabled_;
+    RingBuffer<Sample> samples_;
+
+    // Sums over the window, in double whatever the filter runs in
+    Eigen::Matrix<double, Dim, 1> excess_;
+    double intervals_;
+
+    Vector estimate_;
+    Vector min_;
+    Vector max_;
+
+    size_t since_resum_;
+};
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -1,15 +1,23 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
 #include <yaml-cpp/node/detail/bool_type.h>
 #include <yaml-cpp/yaml.h>
 
 #include <common/utils/yaml_matrix.hpp>
+#include <gnc/kalman/AdaptiveNoise.hpp>
+#include <gnc/kalman/CholeskyUpdate.hpp>
 #include <gnc/kalman/Extrinsics.hpp>
+#include <gnc/kalman/FilterType.hpp>
 #include <gnc/kalman/History.hpp>
 #include <gnc/kalman/UnscentedTransform.hpp>
 #include <gnc/measurements/Measurement.hpp>
-
-using std::placeholders::_1;
+#include <gnc/utils/Metrics.hpp>
 
 namespace maav
 {
@@ -17,76 +25,344 @@ namespace gnc
 {
 namespace kalman
 {
+namespace detail
+{
+template <class Update, class = void>
+struct HasJacobian : std::false_type
+{
+};
+
+template <class Update>
+struct HasJacobian<Update, std::void_t<decltype(std::declval<Update&>().jacobian(
+                               std::declval<const typename Update::State&>()))>>
+    : std::true_type
+{
+};
+}  // namespace detail
+
+/**
+ * What to do with a reading, decided by the outlier gate of its update
+ */
+enum class Gate
+{
+    Accept,
+    // Beyond the gate, discarded
+    Reject,
+    // Beyond the gate, but the covariance is scaled up until the reading sits on the gate and the
+    // reading is then fused, so the state jumps to it (e.g. after SLAM relocalized)
+    Inflate
+};
+
 /**
  * TargetSpace is some space where we compare our prediction ot our sensor measurements.
  * Note that TargetSpace doesn't have to be a sensor measured.
+ *
+ * Derived is the update itself (CRTP). The filter runs in TargetSpace::Scalar, and State below is
+ * StateT of that precision. Derived must provide
+ *   TargetSpace predicted(const State& state)
+ *     Nonlinear h function. Maps the current state to some element of the target space.
+ *   TargetSpace measured(const measurements::Measurement& meas)
+ *     Maps the actual sensor measurements to some element of the target space.
+ * Both are called without virtual dispatch, so h can be inlined into the sigma point loop.
+ *
+ * For the ESKF, Derived may also provide
+ *   Eigen::Matrix<Scalar, TargetSpace::DoF, State::DoF> jacobian(const State& state)
+ *     Jacobian of predicted() with respect to the error state.
+ * Updates without one are linearized by central differences.
  */
-template <class TargetSpace>
+template <class Derived, class TargetSpace>
 class BaseUpdate
 {
+public:
+    using Scalar = typename TargetSpace::Scalar;
+    using State = StateT<Scalar>;
+    using Snapshot = typename HistoryT<Scalar>::Snapshot;
+
+    /**
+     * Unscented transform functor that calls Derived::predicted directly
+     */
+    struct Predictor
+    {
+        using Target = TargetSpace;
+
+        Derived* update = nullptr;
+
+        TargetSpace operator()(const State& state) const { return update->predicted(state); }
+    };
+
 private:
-    using UT = UnscentedTransform<TargetSpace>;
+    using UT = UnscentedTransform<TargetSpace, Predictor>;
     constexpr static size_t TargetDoF = TargetSpace::DoF;
     using CovarianceMatrix = typename TargetSpace::CovarianceMatrix;
     using ErrorStateVector = typename TargetSpace::ErrorStateVector;
-    using CrossCovarianceMatrix = Eigen::Matrix<double, State::DoF, TargetDoF>;
+    using CrossCovarianceMatrix = Eigen::Matrix<Scalar, State::DoF, TargetDoF>;
     using KalmanGainMatrix = CrossCovarianceMatrix;
+    using NoiseVector = Eigen::Matrix<double, TargetDoF, 1>;
 
 public:
-    BaseUpdate(YAML::Node config)
-        : enabled_(config["enabled"].as<bool>()),
+    using Target = TargetSpace;
+    using MeasurementJacobian = Eigen::Matrix<Scalar, TargetDoF, State::DoF>;
+
+    /**
+     * @param config Requires 'enabled', 'enable_outliers', 'UT', 'R' and 'extrinsics'. The
+     * optional 'adaptive' key estimates R from the innovations (see AdaptiveNoise), with its
+     * 'R_min' and 'R_max' keys bounding each element. The optional 'outlier_threshold' key
+     * (default 5) is the Mahalanobis distance of the gate, and 'inflate_outliers' (default false)
+     * inflates readings beyond it instead of rejecting them (see Gate).
+     * @param name Names the update's metrics, "update.<name>.accepted", ".rejected" and ".inflated"
+     */
+    BaseUpdate(YAML::Node config, const std::string& name)
+        : accepted_(Metrics::instance().counter("update." + name + ".accepted")),
+          rejected_(Metrics::instance().counter("update." + name + ".rejected")),
+          inflated_(Metrics::instance().counter("update." + name + ".inflated")),
+          enabled_(config["enabled"].as<bool>()),
           enable_outliers_(config["enable_outliers"].as<bool>()),
+          outlier_threshold_(
+              config["outlier_threshold"] ? config["outlier_threshold"].as<Scalar>() : Scalar(5)),
+          inflate_outliers_(
+              config["inflate_outliers"] && config["inflate_outliers"].as<bool>()),
+          scored_until_usec_(0),
+          log_likelihood_(0),
+          scored_readings_(0),
+          filter_(FilterType::UKF),
           unscented_transform_(config["UT"]),
+          adaptive_R_(config["adaptive"], config["R"].as<NoiseVector>().template cast<Scalar>(),
+              bound(config, "R_min"), bound(config, "R_max")),
           extrinsics_(config["extrinsics"])
     {
-        Eigen::Matrix<double, TargetDoF, 1> R_diag =
-            config["R"].as<Eigen::Matrix<double, TargetDoF, 1>>();
-        R_ = Eigen::DiagonalMatrix<double, TargetDoF>(R_diag);
-        unscented_transform_.set_transformation(std::bind(&BaseUpdate::predicted, this, _1));
+        R_ = adaptive_R_.estimate().asDiagonal();
+        unscented_transform_.set_transformation(Predictor{static_cast<Derived*>(this)});
     }
 
     bool enabled() { return enabled_; }
 
-protected:
+    FilterType filter() const { return filter_; }
+    void set_filter(FilterType filter) { filter_ = filter; }
+
     /**
-     * Nonlinear h function.
-     * Maps the current state to some element of the target space
+     * Sensor noise covariance
      */
-    virtual TargetSpace predicted(const State& state) = 0;
+    const typename TargetSpace::CovarianceMatrix& R() const { return R_; }
 
     /**
-     * Maps the actual sensor measurements to some element of the target space.
+     * @return True if R follows the innovations (see adapt)
      */
-    virtual TargetSpace measured(const measurements::Measurement& meas) = 0;
+    bool adaptive() const { return adaptive_R_.enabled(); }
+
+    const ExtrinsicsT<Scalar>& extrinsics() const { return extrinsics_; }
 
-    // Outlier protection. Bad data association causes the filter to diverge quickly.
-    // Discard any measurement more than 3 standard deviations away from the estimate.
-    bool rejectOutlier(const typename TargetSpace::ErrorStateVector& residual,
-        const typename TargetSpace::CovarianceMatrix& covariance)
+    /**
+     * @brief Feeds the innovation of an accepted reading to the adaptive estimate of R
+     *
+     * Does nothing unless 'adaptive' is enabled in the config.
+     *
+     * @param predicted_covariance Covariance of the predicted measurement, without R
+     */
+    void adapt(uint64_t time_usec, const typename TargetSpace::ErrorStateVector& residual,
+        const typename TargetSpace::CovarianceMatrix& predicted_covariance)
+    {
+        if (adaptive_R_.add(time_usec, residual.cwiseAbs2(), predicted_covariance.diagonal()))
+        {
+            R_ = adaptive_R_.estimate().asDiagonal();
+        }
+    }
+
+    /**
+     * @brief Gates a residual with innovation covariance S, if outlier rejection is enabled
+     *
+     * The first time a reading is gated it is counted as accepted, rejected or inflated, and its
+     * innovation is scored (see takeLogLikelihood). Replays of its snapshot are neither counted
+     * nor scored.
+     *
+     * @param time_usec Time of the snapshot the reading is on
+     */
+    Gate gate(uint64_t time_usec, const typename TargetSpace::ErrorStateVector& residual,
+        const typename TargetSpace::CovarianceMatrix& S)
+    {
+        const Scalar mahl_dist_sq = (residual.transpose() * S.inverse() * residual)(0);
+        const Gate gated = decide(mahl_dist_sq);
+        if (time_usec <= scored_until_usec_) return gated;
+        scored_until_usec_ = time_usec;
+
+        // Gaussian log likelihood, without the constant -DoF / 2 * log(2 pi)
+        log_likelihood_ -= 0.5 * static_cast<double>(mahl_dist_sq + std::log(S.determinant()));
+        scored_readings_++;
+
+        switch (gated)
+        {
+            case Gate::Accept:
+                accepted_.add();
+                break;
+            case Gate::Reject:
+                rejected_.add();
+                break;
+            case Gate::Inflate:
+                inflated_.add();
+                break;
+        }
+        return gated;
+    }
+
+    /**
+     * @brief The decision gate() would make, without counting or scoring the reading
+     */
+    Gate classify(const typename TargetSpace::ErrorStateVector& residual,
+        const typename TargetSpace::CovarianceMatrix& S) const
+    {
+        return decide((residual.transpose() * S.inverse() * residual)(0));
+    }
+
+    /**
+     * @brief Adds the log likelihood of the innovations scored since the last call
+     * @return Number of readings it covers
+     */
+    size_t takeLogLikelihood(double& log_likelihood)
     {
-        double mahl_dist = std::sqrt((residual.transpose() * covariance.inverse() * residual)(0));
-        return mahl_dist > 5;
+        log_likelihood += log_likelihood_;
+        const size_t readings = scored_readings_;
+        log_likelihood_ = 0;
+        scored_readings_ = 0;
+        return readings;
+    }
+
+protected:
+    /**
+     * @brief Scales the covariance of state by the squared ratio of the Mahalanobis distance of a
+     * residual with innovation covariance S to the gate
+     *
+     * Where the state dominates S, this puts the reading on the gate.
+     */
+    void inflate(State& state, const typename TargetSpace::ErrorStateVector& residual,
+        const typename TargetSpace::CovarianceMatrix& S)
+    {
+        const Scalar mahl_dist_sq = (residual.transpose() * S.inverse() * residual)(0);
+        const Scalar factor = mahl_dist_sq / (outlier_threshold_ * outlier_threshold_);
+        if (state.hasSqrtCovariance())
+        {
+            state.setSqrtCovariance(std::sqrt(factor) * state.sqrtCovariance());
+        }
+        else
+        {
+            state.covariance() *= factor;
+        }
     }
 
     /**
      * Updates the state based on the measurements in a snapshot.
      */
-    void correct(History::Snapshot& snapshot)
+    void correct(Snapshot& snapshot)
     {
         if (!enabled_) return;
 
+        if (filter_ == FilterType::ESKF)
+        {
+            correctLinearized(snapshot);
+        }
+        else
+        {
+            correctUnscented(snapshot);
+        }
+    }
+
+    /**
+     * @brief Jacobian of Derived::predicted with respect to the error state at state
+     */
+    MeasurementJacobian linearize(const State& state)
+    {
+        Derived& derived = static_cast<Derived&>(*this);
+        if constexpr (detail::HasJacobian<Derived>::value)
+        {
+            return derived.jacobian(state);
+        }
+        else
+        {
+            // Steps near the cube root of epsilon balance truncation and rounding error
+            const Scalar STEP = std::is_same<Scalar, float>::value ? Scalar(1e-3) : Scalar(1e-6);
+            MeasurementJacobian H;
+            State plus;
+            State minus;
+            for (size_t i = 0; i < State::DoF; i++)
+            {
+                const typename State::ErrorStateVector step =
+                    STEP * State::ErrorStateVector::Unit(i);
+                plus.copyMean(state);
+                minus.copyMean(state);
+                plus += step;
+                minus += -step;
+                H.col(i) = (derived.predicted(plus) - derived.predicted(minus)) / (2 * STEP);
+            }
+            return H;
+        }
+    }
+
+private:
+    /**
+     * Error state EKF correction, linearized about the current estimate
+     */
+    void correctLinearized(Snapshot& snapshot)
+    {
+        Derived& derived = static_cast<Derived&>(*this);
+        State& state = snapshot.state;
+
+        const State sensor_state = extrinsics_(state);
+        const TargetSpace predicted_meas = derived.predicted(sensor_state);
+        const TargetSpace measured_meas = derived.measured(snapshot.measurement);
+        const ErrorStateVector residual = measured_meas - predicted_meas;
+
+        const MeasurementJacobian H = linearize(sensor_state) * extrinsics_.errorJacobian();
+        typename State::CovarianceMatrix P = state.covariance();
+        // The matrices are small and fixed size, so coefficient based products beat the blocked
+        // kernels Eigen would otherwise pick
+        CrossCovarianceMatrix PHt = P.lazyProduct(H.transpose());
+        CovarianceMatrix S = H.lazyProduct(PHt) + R_;
+
+        const Gate gated = gate(snapshot.get_time(), residual, S);
+        if (gated == Gate::Reject) return;
+        if (gated == Gate::Inflate)
+        {
+            inflate(state, residual, S);
+            P = state.covariance();
+            PHt = P.lazyProduct(H.transpose());
+            S = H.lazyProduct(PHt) + R_;
+        }
+        else
+        {
+            adapt(snapshot.get_time(), residual, S - R_);
+        }
+
+        const KalmanGainMatrix K = PHt * S.inverse();
+        state += K * residual;
+
+        // Joseph form keeps the covariance symmetric and positive semidefinite
+        const typename State::CovarianceMatrix I_KH = State::CovarianceMatrix::Identity() - K * H;
+        const typename State::CovarianceMatrix I_KH_P = I_KH.lazyProduct(P);
+        state.covariance() = I_KH_P.lazyProduct(I_KH.transpose()) + K * R_ * K.transpose();
+        state.clearSqrtCovariance();
+    }
+
+    void correctUnscented(Snapshot& snapshot)
+    {
         State& state = snapshot.state;
 
-        const TargetSpace predicted_meas = unscented_transform_(extrinsics_(state));
-        const TargetSpace measured_mes = measured(snapshot.measurement);
+        TargetSpace predicted_meas = unscented_transform_(extrinsics_(state));
+        const TargetSpace measured_mes =
+            static_cast<Derived*>(this)->measured(snapshot.measurement);
         ErrorStateVector residual = measured_mes - predicted_meas;
-        const CovarianceMatrix S = predicted_meas.covariance() + R_;
+        CovarianceMatrix S = predicted_meas.covariance() + R_;
 
-        // Reject outliers
-        if (rejectOutlier(residual, S) && enable_outliers_)
+        const Gate gated = gate(snapshot.get_time(), residual, S);
+        if (gated == Gate::Reject) return;
+        if (gated == Gate::Inflate)
+        {
+            // Redraw the sigma points from the inflated covariance
+            inflate(state, residual, S);
+            predicted_meas = unscented_transform_(extrinsics_(state));
+            residual = measured_mes - predicted_meas;
+            S = predicted_meas.covariance() + R_;
+        }
+        else
         {
-            std::cout << "WARNING: Outlier rejected." << std::endl;
-            return;
+            adapt(snapshot.get_time(), residual, predicted_meas.covariance());
         }
 
         // Extract necessary variables from the UT
@@ -96,7 +372,7 @@ protected:
             unscented_transform_.last_transformed_points();
 
         CrossCovarianceMatrix Sigma_x_z = CrossCovarianceMatrix::Zero();
-        for (size_t i = 0; i < UnscentedTransform<TargetSpace>::N; i++)
+        for (size_t i = 0; i < UT::N; i++)
         {
             Sigma_x_z += c_weights[i] * (sigma_points[i] - state) *
                          (transformed_points[i] - predicted_meas).transpose();
@@ -104,17 +380,75 @@ protected:
         const KalmanGainMatrix K = Sigma_x_z * S.inverse();
         // Update the state gaussian in place
         state += K * residual;
+
+        if (unscented_transform_.square_root() && state.hasSqrtCovariance())
+        {
+            // K * S * K^T = U * U^T, so the factor is updated with one downdate per column of U
+            const Eigen::LLT<CovarianceMatrix> S_decomp(S);
+            const CrossCovarianceMatrix U = K * S_decomp.matrixL();
+            typename State::CovarianceMatrix L = state.sqrtCovariance();
+            bool factored = S_decomp.info() == Eigen::Success;
+            for (size_t i = 0; i < TargetDoF && factored; i++)
+            {
+                factored = choleskyUpdate<State::DoF>(L, U.col(i), true);
+            }
+            if (factored)
+            {
+                state.setSqrtCovariance(L);
+                return;
+            }
+            // The square root correction fell back to the covariance form
+            static Metrics::Counter& llt_failures =
+                Metrics::instance().counter("kalman.llt_failures");
+            llt_failures.add();
+        }
+
         state.covariance() -= K * S * K.transpose();
+        state.clearSqrtCovariance();
     }
 
-private:
+    Gate decide(Scalar mahl_dist_sq) const
+    {
+        // Outlier protection. Bad data association causes the filter to diverge quickly.
+        if (!enable_outliers_ || mahl_dist_sq <= outlier_threshold_ * outlier_threshold_)
+        {
+            return Gate::Accept;
+        }
+        return inflate_outliers_ ? Gate::Inflate : Gate::Reject;
+    }
+
+    /**
+     * Bound of the adaptive R from config[key], or R itself if adaptation is disabled
+     */
+    static typename AdaptiveNoise<Scalar, TargetDoF>::Vector bound(
+        YAML::Node config, const char* key)
+    {
+        YAML::Node adaptive = config["adaptive"];
+        const bool enabled = adaptive && adaptive["enabled"] && adaptive["enabled"].as<bool>();
+        const YAML::Node node = enabled ? adaptive[key] : config["R"];
+        return node.as<NoiseVector>().template cast<Scalar>();
+    }
+
+    Metrics::Counter& accepted_;
+    Metrics::Counter& rejected_;
+    Metrics::Counter& inflated_;
+
     bool enabled_;
     bool enable_outliers_;
+    Scalar outlier_threshold_;
+    bool inflate_outliers_;
+
+    // Innovations scored since the last takeLogLikelihood, and the newest snapshot scored
+    uint64_t scored_until_usec_;
+    double log_likelihood_;
+    size_t scored_readings_;
+    FilterType filter_;
     UT unscented_transform_;
+    AdaptiveNoise<Scalar, TargetDoF> adaptive_R_;
     CovarianceMatrix R_;
 
 protected:
-    Extrinsics extrinsics_;
+    ExtrinsicsT<Scalar> extrinsics_;
 };
 }  // namespace kalman
 }  // namespace gnc
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cmath>
+
+#include <Eigen/Dense>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+namespace detail
+{
+/**
+ * Update vector of a Dim x Dim factor. Named through a nested type so the scalar is only deduced
+ * from the factor, and expressions can be passed as the vector.
+ */
+template <class Scalar, int Dim>
+struct CholeskyVector
+{
+    using type = Eigen::Matrix<Scalar, Dim, 1>;
+};
+}  // namespace detail
+
+/**
+ * @brief Rank one update or downdate of a lower triangular Cholesky factor, in place
+ *
+ * Given L with P = L * L^T, overwrites L with the factor of P + x * x^T, or of P - x * x^T when
+ * downdating. Runs in O(n^2) instead of the O(n^3) of refactoring P.
+ *
+ * @param L Lower triangular factor with a positive diagonal
+ * @param x Update vector
+ * @param downdate Subtract x * x^T instead of adding it
+ * @return false if the result would not be positive definite. L is left partially modified and must
+ * not be used in that case.
+ */
+template <int Dim, class Scalar>
+bool choleskyUpdate(Eigen::Matrix<Scalar, Dim, Dim>& L,
+    typename detail::CholeskyVector<Scalar, Dim>::type x, bool downdate = false)
+{
+    const Scalar sign = downdate ? -1 : 1;
+    for (int k = 0; k < Dim; k++)
+    {
+        const Scalar L_kk = L(k, k);
+        const Scalar r_sq = L_kk * L_kk + sign * x(k) * x(k);
+        if (!(L_kk > 0) || !(r_sq > 0)) return false;
+
+        const Scalar r = std::sqrt(r_sq);
+        const Scalar c = r / L_kk;
+        const Scalar s = x(k) / L_kk;
+        L(k, k) = r;
+
+        const int rest = Dim - k - 1;
+        if (rest > 0)
+        {
+            L.col(k).tail(rest) = (L.col(k).tail(rest) + sign * s * x.tail(rest)) / c;
+            x.tail(rest) = c * x.tail(rest) - s * L.col(k).tail(rest);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Flips the sign of any column of L with a negative diagonal element
+ *
+ * L * L^T is unchanged. Factors coming out of a QR decomposition need this before they can be
+ * passed to choleskyUpdate.
+ */
+template <int Dim, class Scalar>
+void normalizeCholeskyFactor(Eigen::Matrix<Scalar, Dim, Dim>& L)
+{
+    for (int k = 0; k < Dim; k++)
+    {
+        if (L(k, k) < 0) L.col(k) *= -1;
+    }
+}
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -19,25 +19,28 @@ namespace kalman
  * State state of our quadcopter is represented by the state of our IMU. In order to correctly add
  * corrections to the state, our sensor model must take into account its relative pose.
  */
-class Extrinsics
+template <class Scalar>
+class ExtrinsicsT
 {
 public:
-    explicit Extrinsics(YAML::Node config);
+    using State = StateT<Scalar>;
+
+    explicit ExtrinsicsT(YAML::Node config);
 
     /**
      * @brief Relative pose of the sensor to the IMU
      */
-    const Sophus::SE3d& pose() const;
+    const typename State::SE3& pose() const;
 
     /**
      * @brief Relative attitude of the sensor to the IMU
      */
-    const Sophus::SO3d& rotation() const;
+    const typename State::SO3& rotation() const;
 
     /**
      * @brief Relative position of the sensor to the IMU
      */
-    const Eigen::Vector3d& position() const;
+    const typename State::Vector3& position() const;
 
     /**
      * @brief Computes the state (world frame) of the sensor given the state of the IMU
@@ -45,12 +48,28 @@ public:
      */
     State operator()(const State& state) const;
 
+    /**
+     * @brief Same as above, but only writes the mean of sensor_state
+     */
+    void operator()(const State& state, State& sensor_state) const;
+
+    /**
+     * @brief Jacobian of operator() with respect to the error state
+     *
+     * Maps an error of the IMU state to the matching error of the sensor state, to first order.
+     */
+    const typename State::CovarianceMatrix& errorJacobian() const;
+
 private:
-    const Sophus::SE3d::Tangent twist_;
-    const Sophus::SE3d pose_;
-    const Sophus::SO3d rot_;
-    const Eigen::Vector3d pos_;
+    static typename State::CovarianceMatrix computeErrorJacobian(const typename State::SE3& pose);
+
+    const typename State::SE3 pose_;
+    const typename State::SO3 rot_;
+    const typename State::Vector3 pos_;
+    const typename State::CovarianceMatrix error_jacobian_;
 };
+
+using Extrinsics = ExtrinsicsT<double>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
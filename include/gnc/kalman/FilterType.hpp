@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * Which kalman filter the estimator runs
+ */
+enum class FilterType
+{
+    // Unscented: UkfPrediction, and updates through an UnscentedTransform
+    UKF,
+    // Error state EKF: EskfPrediction, and updates through the measurement Jacobian
+    ESKF
+};
+
+/**
+ * @param name "ukf" or "eskf"
+ */
+inline FilterType parseFilterType(const std::string& name)
+{
+    if (name == "ukf") return FilterType::UKF;
+    if (name == "eskf") return FilterType::ESKF;
+    throw std::runtime_error("Unknown filter type: " + name);
+}
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+
+#include <gnc/State.hpp>
+#include <gnc/kalman/History.hpp>
+#include <gnc/kalman/ImuPreintegration.hpp>
+#include <gnc/measurements/ImuMeasurement.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * @brief Rauch-Tung-Striebel smoother over the newest part of the history
+ *
+ * Every so often the estimator hands the snapshots within the lag to submit(), which copies their
+ * filtered states and IMU readings into a window. A thread owned by the smoother then runs the
+ * backward pass over that copy and hands the smoothed states to the callback, so smoothing never
+ * touches the history while the estimator is using it.
+ *
+ * The backward pass re-predicts each step with the error state model of EskfPrediction (or the
+ * transition of the step's IMU preintegration), for either filter backend. With the UKF this is
+ * the extended smoother around the unscented estimates.
+ *
+ * submit() never waits. If the thread is still holding on to the last window, the new one is
+ * skipped. The thread runs at idle priority (SCHED_IDLE), so on a single core it only smooths
+ * while the estimator waits for its next sample.
+ */
+template <class Scalar>
+class FixedLagSmootherT
+{
+public:
+    using State = StateT<Scalar>;
+
+    /**
+     * @brief Smoothed states, oldest first. The newest is the filtered state it was smoothed from.
+     */
+    using Trajectory = std::vector<State>;
+
+    /**
+     * Called on the smoother thread with each smoothed window
+     */
+    using Callback = std::function<void(const Trajectory&)>;
+
+    /**
+     * One filtered snapshot and the IMU readings that led to it
+     */
+    struct Step
+    {
+        State state;
+        measurements::ImuMeasurement imu;
+        bool preintegrated = false;
+        ImuPreintegration preintegration;
+    };
+
+    /**
+     * Steps of a window, oldest first. Only the first size steps are used, so steps past it keep
+     * their memory for the next window.
+     */
+    struct Window
+    {
+        std::vector<Step> steps;
+        size_t size = 0;
+    };
+
+    /**
+     * @param config The optional 'enabled', 'lag' [s] and 'rate' [Hz] keys. Disabled if null.
+     * @param prediction_config Requires 'Q_i', the process noise of a single IMU interval
+     * @param max_steps Most snapshots in one window. Older snapshots within the lag are left out.
+     */
+    FixedLagSmootherT(YAML::Node config, YAML::Node prediction_config, size_t max_steps);
+    ~FixedLagSmootherT();
+
+    FixedLagSmootherT(const FixedLagSmootherT&) = delete;
+    FixedLagSmootherT& operator=(const FixedLagSmootherT&) = delete;
+
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief Sets the function smoothed windows are handed to. Must be set before submit().
+     */
+    void setCallback(Callback callback);
+
+    /**
+     * @brief Hands the snapshots within the lag of the newest one to the smoother thread
+     *
+     * Does nothing until a smoother period has passed since the last window, or while the thread
+     * has not picked up the last window yet.
+     *
+     * @return True if a window was handed over
+     */
+    bool submit(HistoryT<Scalar>& history);
+
+    /**
+     * @brief Backward pass over a window, on the calling thread
+     *
+     * @param smoothed Resized to the steps of the window
+     */
+    void smooth(const Window& window, Trajectory& smoothed) const;
+
+    /**
+     * @return Windows skipped because the thread was busy
+     */
+    uint64_t skipped() const;
+
+private:
+    void work();
+
+    const bool enabled_;
+    const uint64_t lag_usec_;
+    const uint64_t period_usec_;
+    const typename State::CovarianceMatrix Q_;
+
+    Callback callback_;
+
+    // Filled by submit() and swapped with working_ by the thread, both under mutex_
+    Window pending_;
+    bool has_pending_;
+    Window working_;
+    Trajectory smoothed_;
+
+    // Time of the newest snapshot of the last window handed over
+    uint64_t last_submit_usec_;
+    bool submitted_;
+    std::atomic<uint64_t> skipped_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_;
+    std::thread thread_;
+};
+
+using FixedLagSmoother = FixedLagSmootherT<double>;
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
-#include <list>
 
 #include <yaml-cpp/yaml.h>
 
 #include <gnc/State.hpp>
+#include <gnc/kalman/MeasurementQueue.hpp>
 #include <gnc/measurements/Measurement.hpp>
+#include <gnc/measurements/MeasurementPool.hpp>
+#include <gnc/utils/RingBuffer.hpp>
 
 namespace maav
 {
@@ -17,11 +20,33 @@ namespace kalman
 /**
  * Time series of sensor measurements and their corresponding estimated
  * states.
+ *
+ * Snapshots are kept in a preallocated ring buffer ordered by time, so adding
+ * an IMU sample never allocates and delayed measurements are placed with a
+ * binary search. The history also owns the pools measurements are recycled
+ * through (see measurementPool()), sized for as many snapshots as it keeps.
+ *
+ * States are kept in the precision of the filter, Scalar. Measurements are
+ * always double.
+ *
+ * Measurements other than the IMU go through a MeasurementQueue first, and
+ * are placed oldest first once the IMU has caught up with them. Readings of
+ * the same sensor that land on the same snapshot replace one another, and the
+ * replaced reading is counted as dropped (see queueStats()). The exception is
+ * a visual odometry reading that moves on from the one already there: the two
+ * are composed into one, so the chain of bases is kept.
  */
-class History
+template <class Scalar>
+class HistoryT
 {
 public:
-    explicit History(YAML::Node config, YAML::Node initial_state_config);
+    using State = StateT<Scalar>;
+
+    /**
+     * @param config Requires 'size' and 'tolerance'. The optional
+     * 'queue_size' and 'latency_budget' keys configure the MeasurementQueue.
+     */
+    explicit HistoryT(YAML::Node config, YAML::Node initial_state_config);
 
 public:
     /**
@@ -29,6 +54,8 @@ public:
      */
     struct Snapshot
     {
+        Snapshot() = default;
+
         Snapshot(const State& state_, const measurements::Measurement& meas_)
             : state(state_), measurement(meas_)
         {
@@ -40,28 +67,85 @@ public:
         uint64_t get_time() const { return state.timeUSec(); }
     };
 
-    using Iterator = std::list<History::Snapshot>::iterator;
-    using ConstIterator = std::list<History::Snapshot>::const_iterator;
+    using Buffer = RingBuffer<Snapshot>;
+    using Iterator = typename Buffer::iterator;
+    using ConstIterator = typename Buffer::const_iterator;
 
     /**
      * Takes a MeasurementSet of all new measurements. Adds all of those
      * into the history, and returns a pair of iterators to the first
      * element that was changed and the end.
      *
-     * IMU must be populated
+     * IMU must be populated. If the IMU preintegration is populated, it must
+     * start at the IMU measurement of the newest snapshot. Other measurements
+     * are queued along with any queued earlier, and placed once the IMU has
+     * caught up with them. The returned iterators are invalidated by the next
+     * call to add_measurement.
+     *
+     * @param keep_time Snapshots at or after this time are never dropped when
+     * the history is trimmed. Used to protect snapshots that still need to be
+     * re-filtered. While they fill the buffer, readings that need a new
+     * snapshot are counted as late, and each IMU sample evicts the oldest
+     * snapshot, counted on the history.evicted metric.
+     */
+    std::pair<Iterator, Iterator> add_measurement(
+        const measurements::MeasurementSet& measurements, uint64_t keep_time = UINT64_MAX);
+
+    /**
+     * Queues every measurement of the set apart from the IMU, to be placed by
+     * the next call to add_measurement
      */
-    std::pair<Iterator, Iterator> add_measurement(const measurements::MeasurementSet& measurements);
+    void queue(const measurements::MeasurementSet& measurements);
+
+    /**
+     * @return Counters of the readings placed and dropped, per sensor
+     */
+    MeasurementQueue::Stats queueStats() const;
+
+    /**
+     * @return Iterator to the first snapshot at or after time
+     */
+    Iterator lower_bound(uint64_t time);
+
+    Iterator begin();
+    Iterator end();
 
     size_t size();
 
     void setInitialBiases(const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias);
 
+    /**
+     * Pools to take the measurements of new sets from. Interpolated snapshots
+     * take theirs from here as well.
+     */
+    measurements::MeasurementPool& measurementPool();
+
 private:
-    void resize(Iterator last_modified);
+    /**
+     * Drops the oldest snapshots until the history fits in _size, but never
+     * drops the snapshot at keep_time or anything newer. Measurements of the
+     * dropped snapshots go back to their pools right away.
+     */
+    void resize(uint64_t keep_time);
+
+    /**
+     * Drops the oldest snapshot and releases its measurements
+     */
+    void pop_front();
+
+    /**
+     * Appends a snapshot holding only the IMU measurement (and preintegration,
+     * if any) of measurements, evicting the oldest one if the buffer is full.
+     * The state is left uninitialized apart from its time, like
+     * State(uint64_t).
+     */
+    Snapshot& append(const measurements::MeasurementSet& measurements);
 
     /***
      * Finds a snapshot within _tolerance of the given time or creates a new
-     * snapshot with an interpolated IMU measurement.
+     * snapshot with an interpolated IMU measurement. A preintegrated interval
+     * the new snapshot falls in is split in two. Returns end() if the time is
+     * older than the history, or if a new snapshot would not fit.
      * @param time
      * @return
      */
@@ -70,21 +154,21 @@ private:
     measurements::ImuMeasurement interpolate_imu(const measurements::ImuMeasurement& prev,
         const measurements::ImuMeasurement& next, uint64_t interp_time) const;
 
-    Iterator set_last_modified(const Iterator last_modified, const Iterator modified) const;
-
-    void moveMeasurements(const measurements::MeasurementSet& measurements);
+    uint64_t set_last_modified(uint64_t last_modified, const Iterator modified) const;
 
 private:
     size_t _size;
     uint64_t _tolerance;
 
-    std::list<History::Snapshot> _history;
+    Buffer _history;
+    MeasurementQueue _queue;
+    measurements::MeasurementPool _pool;
 
     State _initial_state;
-
-    measurements::MeasurementSet _insert;
 };
 
+using History = HistoryT<double>;
+
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
\ No newline at end of file
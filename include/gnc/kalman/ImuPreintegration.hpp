@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <sophus/so3.hpp>
+
+#include <gnc/State.hpp>
+#include <gnc/measurements/ImuMeasurement.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * @brief IMU samples between two filter steps, integrated once on the manifold
+ *
+ * Follows Forster et al., "On-Manifold Preintegration for Real-Time Visual-Inertial Odometry".
+ * Rotation, velocity and position increments are accumulated in the body frame of the first
+ * sample, so they do not depend on the attitude, velocity or position the interval starts from.
+ * Only the biases enter, and their effect is kept to first order through the bias Jacobians. A
+ * state whose bias estimate has moved since the samples were integrated (a sigma point, or a
+ * snapshot being re-filtered) is propagated without touching the samples again.
+ *
+ * Samples are integrated with the same midpoint rule as integrateImu, so for unchanged biases
+ * predict() matches calling integrateImu on every pair of samples. The error state transition and
+ * process noise of those per sample steps are accumulated alongside.
+ */
+class ImuPreintegration
+{
+public:
+    /**
+     * @param start First sample of the interval, i.e. the IMU measurement of the previous snapshot
+     * @param gyro_bias Gyro bias the samples are integrated with
+     * @param accel_bias Accelerometer bias the samples are integrated with
+     * @param Q Process noise added per IMU sample (see processNoise)
+     */
+    ImuPreintegration(const measurements::ImuMeasurement& start, const Eigen::Vector3d& gyro_bias,
+        const Eigen::Vector3d& accel_bias, const State::CovarianceMatrix& Q);
+
+    /**
+     * @brief Empty interval, to be started with reset() before use
+     */
+    ImuPreintegration();
+
+    /**
+     * @brief Starts over from a new first sample, with the same arguments as the constructor
+     *
+     * Keeps the memory used for samples, so an object recycled through an ObjectPool does not
+     * allocate once it has held as many samples before.
+     */
+    void reset(const measurements::ImuMeasurement& start, const Eigen::Vector3d& gyro_bias,
+        const Eigen::Vector3d& accel_bias, const State::CovarianceMatrix& Q);
+
+    /**
+     * @brief Extends the interval to a newer sample
+     */
+    void integrate(const measurements::ImuMeasurement& imu);
+
+    /**
+     * @brief Splits the interval at time into [start, time] and [time, end]
+     *
+     * Both halves get a sample at time interpolated from its neighbours, and are integrated with
+     * the same biases as this one.
+     */
+    std::pair<ImuPreintegration, ImuPreintegration> split(uint64_t time) const;
+
+    /**
+     * @brief Same as split(time), but resets and fills first and second in place
+     */
+    void split(uint64_t time, ImuPreintegration& first, ImuPreintegration& second) const;
+
+    /**
+     * @brief Linearly interpolates the samples at time, which must lie within the interval
+     */
+    measurements::ImuMeasurement interpolate(uint64_t time) const;
+
+    /**
+     * @brief Propagates the mean of prev_state over the interval
+     *
+     * Uses the biases of prev_state. Writes every estimated variable of next_state except its time,
+     * like integrateImu. The increments are applied in double and rounded to Scalar at the end.
+     */
+    template <class Scalar>
+    void predict(const StateT<Scalar>& prev_state, StateT<Scalar>& next_state) const;
+
+    /**
+     * @brief Error state transition over the interval, at the integration biases
+     */
+    const State::CovarianceMatrix& transition() const { return transition_; }
+
+    /**
+     * @brief Process noise accumulated over the interval, at the integration biases
+     */
+    const State::CovarianceMatrix& noise() const { return noise_; }
+
+    uint64_t startTime() const { return samples_.front().time_usec; }
+    uint64_t endTime() const { return samples_.back().time_usec; }
+
+    /**
+     * @return Length of the interval [s]
+     */
+    double deltaT() const { return dt_; }
+
+    const std::vector<measurements::ImuMeasurement>& samples() const { return samples_; }
+
+    /**
+     * @brief Makes room for the given number of samples without reallocating
+     */
+    void reserve(size_t samples) { samples_.reserve(samples); }
+
+    /**
+     * @brief Increments for the given biases, corrected to first order from the integration biases
+     */
+    Sophus::SO3d deltaR(const Eigen::Vector3d& gyro_bias) const;
+    Eigen::Vector3d deltaV(
+        const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias) const;
+    Eigen::Vector3d deltaP(
+        const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias) const;
+
+private:
+    void resetIncrements();
+
+    std::vector<measurements::ImuMeasurement> samples_;
+    Eigen::Vector3d gyro_bias_;
+    Eigen::Vector3d accel_bias_;
+    State::CovarianceMatrix Q_;
+
+    double dt_;
+    Sophus::SO3d delta_R_;
+    Eigen::Vector3d delta_V_;
+    Eigen::Vector3d delta_P_;
+
+    // Jacobians of the increments with respect to the biases. Rotation is perturbed on the right.
+    Eigen::Matrix3d dR_dbg_;
+    Eigen::Matrix3d dV_dbg_;
+    Eigen::Matrix3d dV_dba_;
+    Eigen::Matrix3d dP_dbg_;
+    Eigen::Matrix3d dP_dba_;
+
+    State::CovarianceMatrix transition_;
+    State::CovarianceMatrix noise_;
+};
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <yaml-cpp/yaml.h>
+
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/utils/RingBuffer.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * Measurements waiting to be placed in the history, with one time ordered
+ * queue per sensor.
+ *
+ * Any number of readings of the same sensor may arrive between two IMU
+ * samples, in any order. They are handed to the history oldest first across
+ * all sensors, once the IMU has caught up with them. Readings older than
+ * their sensor's latency budget are dropped instead, and so are the oldest
+ * readings of a sensor whose queue is full. Every drop is counted, along with
+ * the readings the history replaced after placing them.
+ */
+class MeasurementQueue
+{
+public:
+    struct SensorStats
+    {
+        // Readings pushed, and readings placed in the history
+        uint64_t queued = 0;
+        uint64_t merged = 0;
+
+        // Older than the latency budget when the IMU caught up with them
+        uint64_t dropped_stale = 0;
+
+        // Older than the oldest snapshot in the history
+        uint64_t dropped_late = 0;
+
+        // Pushed out of a full queue
+        uint64_t dropped_overflow = 0;
+
+        // Placed, then replaced by a newer reading on the same snapshot
+        uint64_t dropped_replaced = 0;
+
+        // Most readings waiting at once
+        size_t max_depth = 0;
+
+        uint64_t dropped() const
+        {
+            return dropped_stale + dropped_late + dropped_overflow + dropped_replaced;
+        }
+    };
+
+    struct Stats
+    {
+        SensorStats lidar;
+        SensorStats plane_fit;
+        SensorStats visual_odometry;
+        SensorStats global_update;
+    };
+
+    /**
+     * @param config The optional 'queue_size' key bounds the readings waiting
+     * per sensor (16 by default). The optional 'latency_budget' map sets how
+     * far behind the newest IMU sample a reading may be [us], per sensor:
+     * 'lidar', 'plane_fit', 'visual_odometry' and 'global_update'. Sensors
+     * without a budget, or with 0, are only limited by the history length.
+     */
+    explicit MeasurementQueue(YAML::Node config);
+
+    /**
+     * Queues every measurement of the set apart from the IMU
+     */
+    void push(const measurements::MeasurementSet& measurements);
+
+    /**
+     * Takes the oldest queued reading from before the given time. Readings
+     * that blew their latency budget by now are dropped along the way.
+     *
+     * @param now Time of the newest IMU sample
+     * @param before Readings at or after this time stay queued
+     * @param next Set to the reading, with every other field cleared
+     * @return false if nothing is ready
+     */
+    bool pop(uint64_t now, uint64_t before, measurements::Measurement& next);
+
+    /**
+     * Counts a popped reading the history could not place
+     */
+    void dropLate(const measurements::Measurement& late);
+
+    /**
+     * Counts the reading a popped one replaced on its snapshot, which was of the
+     * same sensor and had been counted as merged
+     */
+    void dropReplaced(const measurements::Measurement& replacement);
+
+    /**
+     * @return Readings waiting across all sensors
+     */
+    size_t size() const;
+
+    /**
+     * @return Readings each sensor can have waiting
+     */
+    size_t capacity() const { return lidar_.queue.capacity(); }
+
+    Stats stats() const;
+
+private:
+    template <class T>
+    struct SensorQueue
+    {
+        SensorQueue(size_t capacity, uint64_t latency_budget_)
+            : queue(capacity), latency_budget(latency_budget_)
+        {
+        }
+
+        RingBuffer<std::shared_ptr<const T>> queue;
+
+        // 0 means unlimited
+        uint64_t latency_budget;
+
+        SensorStats stats;
+    };
+
+    template <class T>
+    static void push(SensorQueue<T>& sensor, const std::shared_ptr<const T>& measurement);
+
+    /**
+     * Drops stale readings, then returns the time of the oldest one left, or
+     * UINT64_MAX if there is none
+     */
+    template <class T>
+    static uint64_t front(SensorQueue<T>& sensor, uint64_t now);
+
+    template <class T>
+    static std::shared_ptr<const T> pop(SensorQueue<T>& sensor);
+
+    SensorQueue<measurements::LidarMeasurement> lidar_;
+    SensorQueue<measurements::PlaneFitMeasurement> plane_fit_;
+    SensorQueue<measurements::VisualOdometryMeasurement> visual_odometry_;
+    SensorQueue<measurements::GlobalUpdateMeasurement> global_update_;
+};
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -13,28 +13,144 @@ namespace gnc
 {
 namespace kalman
 {
-class UkfPrediction
+/**
+ * @brief Propagates the mean of a state over one IMU interval with midpoint integration
+ *
+ * Writes every estimated variable of next_state except its time. The covariance is untouched.
+ * Runs in the precision of the states, with the readings rounded to it.
+ *
+ * @param dt Time between the two IMU readings [s]
+ */
+template <class Scalar>
+void integrateImu(const StateT<Scalar>& prev_state, const measurements::ImuMeasurement& prev_imu,
+    const measurements::ImuMeasurement& next_imu, double dt, StateT<Scalar>& next_state);
+
+/**
+ * @brief Additive process noise covariance built from the IMU noise in config["Q_i"]
+ */
+State::CovarianceMatrix processNoise(YAML::Node config);
+
+template <class Scalar>
+class UkfPredictionT
 {
 public:
-    UkfPrediction(YAML::Node config);
+    using State = StateT<Scalar>;
+    using Snapshot = typename HistoryT<Scalar>::Snapshot;
+
+    UkfPredictionT(YAML::Node config);
+
+    /**
+     * @brief Replaces the process noise added per IMU interval. Must be diagonal.
+     */
+    void setProcessNoise(const typename State::CovarianceMatrix& noise);
+
+    /**
+     * @brief Propagates the state of prev forward to the time of next
+     */
+    void operator()(const Snapshot& prev, Snapshot& next);
+
+    /**
+     * @brief Convenience overload for any pair of iterators to snapshots
+     */
+    template <class PrevIterator, class NextIterator>
+    void operator()(const PrevIterator prev, const NextIterator next)
+    {
+        (*this)(*prev, *next);
+    }
 
-    void operator()(const History::ConstIterator prev, const History::Iterator next);
+    /**
+     * Unscented transform functor that calls predict directly and writes each propagated sigma
+     * point in place. Only valid while operator() is running or after it has run once, since
+     * predict reads the snapshots passed to it.
+     */
+    struct Predictor
+    {
+        UkfPredictionT* prediction = nullptr;
+
+        void operator()(const State& state, State& next_state) const
+        {
+            prediction->predict(state, next_state);
+        }
+    };
 
 private:
-    History::ConstIterator _prev;
-    History::Iterator _next;
+    const Snapshot* _prev;
+    Snapshot* _next;
+
+    /**
+     * Transition function. Writes the mean of next_state, leaving its covariance untouched.
+     * Uses the IMU preintegration of the next snapshot when it has one.
+     */
+    void predict(const State& state, State& next_state);
 
-    State predict(const State& state);
+    /**
+     * Adds a full process noise covariance, keeping the square root factor when there is one
+     */
+    static void addNoise(State& state, const typename State::CovarianceMatrix& noise);
 
-    using PredictionUT = UnscentedTransform<State>;
+    using PredictionUT = UnscentedTransform<State, Predictor>;
 
     PredictionUT transformation;
-    Eigen::Matrix<double, State::DoF, State::DoF> Q;
+    Eigen::Matrix<Scalar, State::DoF, State::DoF> Q;
+
+    // Diagonal of the square root of Q, for square root mode
+    typename State::ErrorStateVector sqrt_Q_diag_;
 
 protected:
     // For testing
     const PredictionUT& getUT() const { return transformation; }
 };
+
+/**
+ * Error state EKF prediction. Propagates the mean with the same model as UkfPrediction, but
+ * propagates the covariance through the analytic Jacobian of that model instead of 31 sigma
+ * points.
+ */
+template <class Scalar>
+class EskfPredictionT
+{
+public:
+    using State = StateT<Scalar>;
+    using Snapshot = typename HistoryT<Scalar>::Snapshot;
+    using Vector3 = typename State::Vector3;
+
+    EskfPredictionT(YAML::Node config);
+
+    /**
+     * @brief Replaces the process noise added per IMU interval. Must be diagonal.
+     */
+    void setProcessNoise(const typename State::CovarianceMatrix& noise);
+
+    /**
+     * @brief Propagates the state of prev forward to the time of next
+     */
+    void operator()(const Snapshot& prev, Snapshot& next);
+
+    /**
+     * @brief Convenience overload for any pair of iterators to snapshots
+     */
+    template <class PrevIterator, class NextIterator>
+    void operator()(const PrevIterator prev, const NextIterator next)
+    {
+        (*this)(*prev, *next);
+    }
+
+    /**
+     * @brief Jacobian of integrateImu with respect to the error state (see State::operator+=)
+     *
+     * Maps an error around the previous state to the error around the propagated state, to first
+     * order. Only the biases of the previous state enter.
+     */
+    static typename State::CovarianceMatrix errorJacobian(const Vector3& gyro_bias,
+        const Vector3& accel_bias, const measurements::ImuMeasurement& prev_imu,
+        const measurements::ImuMeasurement& next_imu, double dt);
+
+private:
+    typename State::CovarianceMatrix Q;
+};
+
+using UkfPrediction = UkfPredictionT<double>;
+using EskfPrediction = EskfPredictionT<double>;
 }
 }
 }
@@ -3,12 +3,17 @@
 #include <algorithm>
 #include <array>
 #include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 #include <yaml-cpp/yaml.h>
 #include <Eigen/Cholesky>
 
 #include <gnc/State.hpp>
+#include <gnc/utils/Metrics.hpp>
+#include <gnc/utils/ThreadPool.hpp>
 
 namespace maav
 {
@@ -16,32 +21,71 @@ namespace gnc
 {
 namespace kalman
 {
-template <class TargetSpace>
+/**
+ * Transform is the function applied to each sigma point. The default std::function can hold
+ * anything, at the cost of a type-erased call per sigma point. Passing a concrete functor type
+ * lets the compiler inline the transform into the sigma point loop.
+ *
+ * A functor callable as f(const State&, TargetSpace&) writes each transformed point in place.
+ * Otherwise the functor must return the transformed point, f(const State&) -> TargetSpace.
+ *
+ * The transform runs in the precision of TargetSpace::Scalar, and State below is StateT of that
+ * precision.
+ *
+ * With threads > 0, sigma points are built and transformed on a thread pool owned by the
+ * transform. The transform must then be safe to call from several threads at once, which only the
+ * prediction guarantees; the update transforms cache state lazily and must stay serial. Each point is
+ * computed exactly as in the serial path and the gaussian is still recovered serially, so results
+ * are bit-identical either way.
+ */
+template <class TargetSpace,
+    class Transform = std::function<TargetSpace(const StateT<typename TargetSpace::Scalar>&)>>
 class UnscentedTransform
 {
 public:
+    using Scalar = typename TargetSpace::Scalar;
+    using State = StateT<Scalar>;
+
     constexpr static size_t N = 1 + 2 * State::DoF;
 
-    using Transform = std::function<TargetSpace(const State&)>;
     using SigmaPoints = std::array<State, N>;
     using TransformedPoints = std::array<TargetSpace, N>;
-    using Weights = std::array<double, N>;
+    using Weights = typename State::Weights;
 
     UnscentedTransform() = default;
 
-    UnscentedTransform(Transform transform, double alpha, double beta, double kappa)
+    UnscentedTransform(Transform transform, Scalar alpha, Scalar beta, Scalar kappa)
         : _transformation(transform)
     {
         set_parameters(alpha, beta, kappa);
     }
 
-    UnscentedTransform(YAML::Node config)
+    /**
+     * @param config Requires 'alpha', 'beta' and 'kappa', with optional 'square_root' and 'threads'
+     * @param allow_threads Whether the transform is safe to parallelize. A 'threads' key is an
+     * error otherwise.
+     */
+    UnscentedTransform(YAML::Node config, bool allow_threads = false)
     {
-        double alpha = config["alpha"].as<double>();
-        double beta = config["beta"].as<double>();
-        double kappa = config["kappa"].as<double>();
+        Scalar alpha = config["alpha"].as<Scalar>();
+        Scalar beta = config["beta"].as<Scalar>();
+        Scalar kappa = config["kappa"].as<Scalar>();
 
         set_parameters(alpha, beta, kappa);
+
+        if (config["square_root"])
+        {
+            _square_root = config["square_root"].as<bool>();
+        }
+
+        if (config["threads"])
+        {
+            if (!allow_threads)
+            {
+                throw std::runtime_error("UT threads are only supported in the prediction");
+            }
+            set_threads(config["threads"].as<size_t>());
+        }
     }
     /**
      * Transforms the gaussian from the state space to a gaussian in some target
@@ -49,23 +93,69 @@ public:
      */
     TargetSpace operator()(const State& state);
 
-    void set_parameters(double alpha, double beta, double kappa);
+    /**
+     * Same as above, but writes the gaussian into result. A State result reuses the storage of
+     * its Cholesky factor in square root mode.
+     */
+    void operator()(const State& state, TargetSpace& result);
+
+    /**
+     * Draws the sigma points of state without transforming them, for callers that pass them
+     * through several functions of their own. Same as last_sigma_points() afterwards.
+     */
+    const SigmaPoints& sigma_points(const State& state);
+
+    void set_parameters(Scalar alpha, Scalar beta, Scalar kappa);
 
     void set_transformation(Transform transform);
 
+    /**
+     * In square root mode a State result carries the Cholesky factor of its
+     * covariance (see State::compute_sqrt_gaussian). Sigma points are always
+     * drawn from the factor when the input state has one.
+     */
+    bool square_root() const { return _square_root; }
+    void set_square_root(bool square_root) { _square_root = square_root; }
+
+    /**
+     * Number of worker threads used to propagate sigma points, not counting the calling thread.
+     * 0 propagates them serially.
+     */
+    size_t threads() const { return _pool ? _pool->size() : 0; }
+    void set_threads(size_t threads)
+    {
+        _pool = threads > 0 ? std::make_unique<ThreadPool>(threads) : nullptr;
+    }
+
 private:
     TransformedPoints _transformed_points;
     SigmaPoints _sigma_points;
 
-    void generate_sigma_points(const State& state);
+    // Scaled square root of the input covariance. Column i offsets sigma points 2i+1 and 2i+2.
+    typename State::CovarianceMatrix _sigma_offsets;
+
+    void compute_sigma_offsets(const State& state);
+
+    /**
+     * Draws the sigma points of state and passes them through the transform
+     */
+    void propagate(const State& state);
+
+    void generate_sigma_point(size_t i, const State& state);
+
+    void transform_point(size_t i);
 
 private:
     Transform _transformation;
 
-    double _lambda;
-    double _alpha;
-    double _beta;
-    double _kappa;
+    Scalar _lambda;
+    Scalar _alpha;
+    Scalar _beta;
+    Scalar _kappa;
+
+    bool _square_root = false;
+
+    std::unique_ptr<ThreadPool> _pool;
 
     Weights _m_weights;
     Weights _c_weights;
@@ -77,56 +167,157 @@ public:
     const TransformedPoints& last_transformed_points() const { return _transformed_points; }
 };
 
-template <class TargetSpace>
-TargetSpace UnscentedTransform<TargetSpace>::operator()(const State& state)
+template <class TargetSpace, class Transform>
+TargetSpace UnscentedTransform<TargetSpace, Transform>::operator()(const State& state)
 {
-    generate_sigma_points(state);
-    // Pass all sigma points through the transform
-    std::transform(
-        _sigma_points.begin(), _sigma_points.end(), _transformed_points.begin(), _transformation);
+    propagate(state);
 
     // Recompute the mean and covariance
+    if constexpr (std::is_same<TargetSpace, State>::value)
+    {
+        if (_square_root)
+        {
+            State result;
+            State::compute_sqrt_gaussian(_transformed_points, _m_weights, _c_weights, result);
+            return result;
+        }
+    }
     TargetSpace result = TargetSpace::compute_gaussian(_transformed_points, _m_weights, _c_weights);
     return result;
 }
 
-template <class TargetSpace>
-void UnscentedTransform<TargetSpace>::generate_sigma_points(const State& state)
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::operator()(
+    const State& state, TargetSpace& result)
 {
-    Eigen::LLT<State::CovarianceMatrix> decomp(
-        (static_cast<double>(State::DoF) + _lambda) * state.covariance());
-    const State::CovarianceMatrix L = decomp.matrixL();
+    propagate(state);
 
-    // Set the starting point to the current mean
-    _sigma_points[0] = state;
-    for (size_t i = 0; i < State::DoF; i++)
+    if constexpr (std::is_same<TargetSpace, State>::value)
     {
-        const State::ErrorStateVector& sigma_point_offset = L.col(i);
+        if (_square_root)
+        {
+            State::compute_sqrt_gaussian(_transformed_points, _m_weights, _c_weights, result);
+            return;
+        }
+    }
+    result = TargetSpace::compute_gaussian(_transformed_points, _m_weights, _c_weights);
+}
 
-        State additive_point = state;
-        State subtractive_point = state;
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::propagate(const State& state)
+{
+    compute_sigma_offsets(state);
 
-        additive_point += sigma_point_offset;
-        subtractive_point += (-1) * sigma_point_offset;
+    // Generate each sigma point and pass it through the transform
+    auto propagate_point = [this, &state](size_t i) {
+        generate_sigma_point(i, state);
+        transform_point(i);
+    };
+    if (_pool)
+    {
+        _pool->parallel_for(N, propagate_point);
+    }
+    else
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            propagate_point(i);
+        }
+    }
+}
+
+template <class TargetSpace, class Transform>
+const typename UnscentedTransform<TargetSpace, Transform>::SigmaPoints&
+UnscentedTransform<TargetSpace, Transform>::sigma_points(const State& state)
+{
+    compute_sigma_offsets(state);
+
+    auto generate = [this, &state](size_t i) { generate_sigma_point(i, state); };
+    if (_pool)
+    {
+        _pool->parallel_for(N, generate);
+    }
+    else
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            generate(i);
+        }
+    }
+    return _sigma_points;
+}
+
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::compute_sigma_offsets(const State& state)
+{
+    const Scalar scale = static_cast<Scalar>(State::DoF) + _lambda;
+    if (state.hasSqrtCovariance())
+    {
+        // Square root mode already carries the factor
+        _sigma_offsets = std::sqrt(scale) * state.sqrtCovariance();
+    }
+    else
+    {
+        Eigen::LLT<typename State::CovarianceMatrix> decomp(scale * state.covariance());
+        _sigma_offsets = decomp.matrixL();
+        if (decomp.info() != Eigen::Success)
+        {
+            // The covariance lost positive definiteness, the sigma points are not to be trusted
+            static Metrics::Counter& llt_failures =
+                Metrics::instance().counter("kalman.llt_failures");
+            llt_failures.add();
+        }
+    }
+}
+
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::generate_sigma_point(size_t i, const State& state)
+{
+    // Sigma points only carry a mean, so the covariance is never copied into them
+    State& sigma_point = _sigma_points[i];
+    sigma_point.copyMean(state);
+
+    // The first point is the mean, the rest are pairs on either side of it
+    if (i == 0) return;
+
+    const typename State::ErrorStateVector& sigma_point_offset = _sigma_offsets.col((i - 1) / 2);
+    if (i % 2 == 1)
+    {
+        sigma_point += sigma_point_offset;
+    }
+    else
+    {
+        sigma_point += (-1) * sigma_point_offset;
+    }
+}
 
-        _sigma_points[2 * i + 1] = additive_point;
-        _sigma_points[2 * i + 2] = subtractive_point;
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::transform_point(size_t i)
+{
+    if constexpr (std::is_invocable_v<Transform&, const State&, TargetSpace&>)
+    {
+        _transformation(_sigma_points[i], _transformed_points[i]);
+    }
+    else
+    {
+        _transformed_points[i] = _transformation(_sigma_points[i]);
     }
 }
 
-template <class TargetSpace>
-void UnscentedTransform<TargetSpace>::set_parameters(double alpha, double beta, double kappa)
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::set_parameters(
+    Scalar alpha, Scalar beta, Scalar kappa)
 {
     _alpha = alpha;
     _beta = beta;
     _kappa = kappa;
 
-    constexpr auto n_d = static_cast<double>(State::DoF);
+    constexpr auto n_d = static_cast<Scalar>(State::DoF);
 
     _lambda = _alpha * _alpha * (n_d + _kappa) - n_d;
-    const double w_m_0 = _lambda / (n_d + _lambda);
-    const double w_c_0 = w_m_0 + (1 - (_alpha * _alpha) + _beta);
-    const double w = 1 / (2 * (n_d + _lambda));
+    const Scalar w_m_0 = _lambda / (n_d + _lambda);
+    const Scalar w_c_0 = w_m_0 + (1 - (_alpha * _alpha) + _beta);
+    const Scalar w = 1 / (2 * (n_d + _lambda));
 
     _m_weights.fill(w);
     _c_weights.fill(w);
@@ -134,8 +325,8 @@ void UnscentedTransform<TargetSpace>::set_parameters(double alpha, double beta,
     _c_weights[0] = w_c_0;
 }
 
-template <class TargetSpace>
-void UnscentedTransform<TargetSpace>::set_transformation(Transform transform)
+template <class TargetSpace, class Transform>
+void UnscentedTransform<TargetSpace, Transform>::set_transformation(Transform transform)
 {
     _transformation = transform;
 }
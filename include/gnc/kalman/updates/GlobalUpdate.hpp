@@ -16,42 +16,66 @@ namespace kalman
 /**
  * A correction step for a downward facing lidar on a flat surface
  */
-class GlobalUpdate : public BaseUpdate<measurements::GlobalUpdateMeasurement>
+template <class Scalar_>
+class GlobalUpdateT : public BaseUpdate<GlobalUpdateT<Scalar_>,
+                          measurements::GlobalUpdateMeasurementT<Scalar_>>
 {
+    using Base =
+        BaseUpdate<GlobalUpdateT<Scalar_>, measurements::GlobalUpdateMeasurementT<Scalar_>>;
+
 public:
+    using typename Base::MeasurementJacobian;
+    using typename Base::Scalar;
+    using typename Base::Snapshot;
+    using typename Base::State;
+    using Target = measurements::GlobalUpdateMeasurementT<Scalar>;
+
     /**
      *  @param config This yaml node must have a "lidar" key with unscented transform parameters and
      * a sensor covariance matrix, R
      */
-    GlobalUpdate(YAML::Node config);
+    GlobalUpdateT(YAML::Node config);
 
     /**
      * @breif Computes the observation model (h(x)) for a state provided by an UnscentedTransform
      * @param state A sigma point proved by an UnscentedTransform
      * @return The predicted lidar observation
      */
-    measurements::GlobalUpdateMeasurement predicted(const State& state);
+    Target predicted(const State& state);
 
     /**
      * @param meas
      * @return The relevant lidar measurement from the list of measurements
      */
-    measurements::GlobalUpdateMeasurement measured(const measurements::Measurement& meas);
+    Target measured(const measurements::Measurement& meas);
+
+    /**
+     * @brief Jacobian of predicted() with respect to the error state, for the ESKF
+     * @param state The sensor state the measurement is predicted from
+     */
+    MeasurementJacobian jacobian(const State& state);
+
+    /**
+     * @return Whether meas holds a reading this update can use
+     */
+    bool applies(const measurements::Measurement& meas) const;
 
     /**
      * @brief Performs the correction step for a lidar
      * @param snapshot A mutable reference to a point in time. The state will be updated according
      * to the sensor model
      */
-    void operator()(History::Snapshot& snapshot);
+    void operator()(Snapshot& snapshot);
 
 private:
-    using BaseUpdate<measurements::GlobalUpdateMeasurement>::correct;
+    using Base::correct;
 
     bool initialized_pose_;
-    Sophus::SE3d starting_pose_;
-    Sophus::SE3d starting_pose_inverse_;
+    typename State::SE3 starting_pose_;
+    typename State::SE3 starting_pose_inverse_;
 };
+
+using GlobalUpdate = GlobalUpdateT<double>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
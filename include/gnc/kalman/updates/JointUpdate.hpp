@@ -0,0 +1,135 @@
+#ifndef JOINT_UPDATE_HPP
+#define JOINT_UPDATE_HPP
+
+#include <array>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Dense>
+
+#include <gnc/State.hpp>
+#include <gnc/kalman/History.hpp>
+#include <gnc/kalman/UnscentedTransform.hpp>
+#include <gnc/kalman/updates/GlobalUpdate.hpp>
+#include <gnc/kalman/updates/LidarUpdate.hpp>
+#include <gnc/kalman/updates/PlanefitUpdate.hpp>
+#include <gnc/measurements/Measurement.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * One unscented correction for every sensor that reported at a snapshot
+ *
+ * Running the lidar, plane fit and global updates one after another draws and transforms a set
+ * of sigma points for each. This update draws them once, passes them through the measurement
+ * model of every sensor with a reading, and corrects the state with the stacked innovation.
+ *
+ * Each sensor keeps its own extrinsics, noise and outlier gate. A reading that fails its gate is
+ * left out of the stack, so the other sensors still correct the state. With a single reading, or
+ * when a sensor inflates the covariance for a reading beyond its gate, the sensors' own updates
+ * run in turn instead.
+ *
+ * Only used by the UKF. The ESKF applies its linearized updates in turn.
+ */
+template <class Scalar_>
+class JointUpdateT
+{
+public:
+    using Scalar = Scalar_;
+    using State = StateT<Scalar>;
+    using Snapshot = typename HistoryT<Scalar>::Snapshot;
+
+    /**
+     * @param config The updates node. Its optional "joint" key enables this update and holds its
+     * unscented transform parameters. The sensor updates keep their own configs.
+     */
+    JointUpdateT(YAML::Node config, LidarUpdateT<Scalar>& lidar_update,
+        PlaneFitUpdateT<Scalar>& planefit_update, GlobalUpdateT<Scalar>& global_update);
+
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief Corrects the state of a snapshot with all of its measurements
+     */
+    void operator()(Snapshot& snapshot);
+
+private:
+    constexpr static size_t N = State::N;
+    constexpr static size_t MaxDoF = measurements::LidarMeasurement::DoF +
+                                     PFSensorMeasurement::DoF +
+                                     measurements::GlobalUpdateMeasurement::DoF;
+
+    // Sized for every sensor, so the stacked matrices never allocate
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, MaxDoF, 1>;
+    using CovarianceMatrix =
+        Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, 0, MaxDoF, MaxDoF>;
+    using CrossCovarianceMatrix =
+        Eigen::Matrix<Scalar, State::DoF, Eigen::Dynamic, 0, State::DoF, MaxDoF>;
+    using KalmanGainMatrix = CrossCovarianceMatrix;
+    using Deviations = Eigen::Matrix<Scalar, MaxDoF, N>;
+
+    // Only the sigma points of the transform are used
+    struct Untransformed
+    {
+        using Scalar = Scalar_;
+    };
+    using UT = UnscentedTransform<Untransformed>;
+
+    template <class Update>
+    struct Sensor
+    {
+        explicit Sensor(Update& update_) : update(update_) {}
+
+        Update& update;
+
+        // The sigma points passed through the measurement model
+        std::array<typename Update::Target, N> points;
+
+        // Innovation of the reading, kept for gate() and adapt() once the joint update runs
+        typename Update::Target predicted;
+        typename Update::Target::ErrorStateVector residual;
+    };
+
+    /**
+     * Appends the innovation of a sensor to the stack, unless its gate rejects it. The gate is
+     * only consulted here; the reading is counted by record().
+     * @return Rows in the stack afterwards
+     */
+    template <class Update>
+    size_t stack(Sensor<Update>& sensor, const measurements::Measurement& meas, size_t rows);
+
+    /**
+     * Gates the reading stacked by stack() through the sensor's update, which counts and scores
+     * it, and feeds an accepted innovation to its adaptive R
+     */
+    template <class Update>
+    void record(Sensor<Update>& sensor, uint64_t time_usec);
+
+    bool enabled_;
+    UT unscented_transform_;
+
+    Sensor<LidarUpdateT<Scalar>> lidar_;
+    Sensor<PlaneFitUpdateT<Scalar>> planefit_;
+    Sensor<GlobalUpdateT<Scalar>> global_;
+
+    // Set by stack() when a sensor asks to inflate the covariance for its reading
+    bool inflate_;
+
+    // Scratch space for the sensor state of one sigma point
+    State sensor_state_;
+
+    // Stacked innovation, deviations of the predicted measurements and sensor noise
+    Vector residual_;
+    Deviations deviations_;
+    CovarianceMatrix R_;
+};
+
+using JointUpdate = JointUpdateT<double>;
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
+
+#endif
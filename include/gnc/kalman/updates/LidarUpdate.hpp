@@ -15,41 +15,64 @@ namespace kalman
 /**
  * A correction step for a downward facing lidar on a flat surface
  */
-class LidarUpdate : public BaseUpdate<measurements::LidarMeasurement>
+template <class Scalar_>
+class LidarUpdateT
+    : public BaseUpdate<LidarUpdateT<Scalar_>, measurements::LidarMeasurementT<Scalar_>>
 {
+    using Base = BaseUpdate<LidarUpdateT<Scalar_>, measurements::LidarMeasurementT<Scalar_>>;
+
 public:
+    using typename Base::MeasurementJacobian;
+    using typename Base::Scalar;
+    using typename Base::Snapshot;
+    using typename Base::State;
+    using Target = measurements::LidarMeasurementT<Scalar>;
+
     /**
      *  @param config This yaml node must have a "lidar" key with unscented transform parameters and
      * a sensor covariance matrix, R
      */
-    LidarUpdate(YAML::Node config);
+    LidarUpdateT(YAML::Node config);
 
     /**
      * @breif Computes the observation model (h(x)) for a state provided by an UnscentedTransform
      * @param state A sigma point proved by an UnscentedTransform
      * @return The predicted lidar observation
      */
-    measurements::LidarMeasurement predicted(const State& state);
+    Target predicted(const State& state);
 
     /**
      * @param meas
      * @return The relevant lidar measurement from the list of measurements
      */
-    measurements::LidarMeasurement measured(const measurements::Measurement& meas);
+    Target measured(const measurements::Measurement& meas);
+
+    /**
+     * @brief Jacobian of predicted() with respect to the error state, for the ESKF
+     * @param state The sensor state the measurement is predicted from
+     */
+    MeasurementJacobian jacobian(const State& state);
+
+    /**
+     * @return Whether meas holds a reading this update can use
+     */
+    bool applies(const measurements::Measurement& meas) const;
 
     /**
      * @brief Performs the correction step for a lidar
      * @param snapshot A mutable reference to a point in time. The state will be updated according
      * to the sensor model
      */
-    void operator()(History::Snapshot& snapshot);
+    void operator()(Snapshot& snapshot);
 
 private:
-    using BaseUpdate<measurements::LidarMeasurement>::correct;
+    using Base::correct;
 
-    double bias_;
-    double imu_height_;
+    Scalar bias_;
+    Scalar imu_height_;
 };
+
+using LidarUpdate = LidarUpdateT<double>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
@@ -16,26 +16,29 @@ namespace kalman
  * TODO: Combine this with maav::gnc::measurements::PlaneFit
  * Represents the TargetSpace of the lidar update
  */
-class PFSensorMeasurement
+template <class Scalar_>
+class PFSensorMeasurementT
 {
 public:
     /**
      * Necessary definitions
      */
+    using Scalar = Scalar_;
     constexpr static size_t DoF = 4;
-    using CovarianceMatrix = Eigen::Matrix<double, DoF, DoF>;
-    using ErrorStateVector = Eigen::Matrix<double, DoF, 1>;
-    using SensorVector = Eigen::Matrix<double, DoF, 1>;
+    using CovarianceMatrix = Eigen::Matrix<Scalar, DoF, DoF>;
+    using ErrorStateVector = Eigen::Matrix<Scalar, DoF, 1>;
+    using SensorVector = Eigen::Matrix<Scalar, DoF, 1>;
+    using Weights = typename StateT<Scalar>::Weights;
 
     /**
      * @brief Computes the error state between two SensorMeasurements
      */
-    ErrorStateVector operator-(const PFSensorMeasurement& other) const;
+    ErrorStateVector operator-(const PFSensorMeasurementT& other) const;
 
     /**
      * @brief adds the error state into a PFSensorMeasurement
      */
-    PFSensorMeasurement& operator+=(const ErrorStateVector& other);
+    PFSensorMeasurementT& operator+=(const ErrorStateVector& other);
 
     /**
      * @return Const reference to the covariance matrix
@@ -63,12 +66,11 @@ public:
      * @param m_weights Mean weights from an UnscentedTransform
      * @param c_weights Covariance weights from an UnscentedTransform
      */
-    static PFSensorMeasurement compute_gaussian(
-        const std::array<PFSensorMeasurement, State::N>& points,
-        const std::array<double, State::N>& m_weights,
-        const std::array<double, State::N>& c_weights)
+    static PFSensorMeasurementT compute_gaussian(
+        const std::array<PFSensorMeasurementT, State::N>& points, const Weights& m_weights,
+        const Weights& c_weights)
     {
-        PFSensorMeasurement gaussian;
+        PFSensorMeasurementT gaussian;
         gaussian.readings() = SensorVector::Zero();
         for (size_t i = 0; i < State::N; i++)
         {
@@ -90,39 +92,56 @@ private:
     CovarianceMatrix covariance_;
 };
 
-class PlaneFitUpdate : public BaseUpdate<PFSensorMeasurement>
+using PFSensorMeasurement = PFSensorMeasurementT<double>;
+
+template <class Scalar_>
+class PlaneFitUpdateT : public BaseUpdate<PlaneFitUpdateT<Scalar_>, PFSensorMeasurementT<Scalar_>>
 {
+    using Base = BaseUpdate<PlaneFitUpdateT<Scalar_>, PFSensorMeasurementT<Scalar_>>;
+
 public:
+    using typename Base::Scalar;
+    using typename Base::Snapshot;
+    using typename Base::State;
+    using Target = PFSensorMeasurementT<Scalar>;
+
     /**
      *  @param config This yaml node must have a "planefit" key with unscented transform parameters
      * and
      * a sensor covariance matrix, R
      */
-    PlaneFitUpdate(YAML::Node config);
+    PlaneFitUpdateT(YAML::Node config);
 
     /**
      * @breif Computes the observation model (h(x)) for a state provided by an UnscentedTransform
      * @param state A sigma point proved by an UnscentedTransform
      * @return The predicted lidar observation
      */
-    PFSensorMeasurement predicted(const State& state);
+    Target predicted(const State& state);
 
     /**
      * @param meas
      * @return The relevant lidar measurement from the list of measurements
      */
-    PFSensorMeasurement measured(const measurements::Measurement& meas);
+    Target measured(const measurements::Measurement& meas);
+
+    /**
+     * @return Whether meas holds a reading this update can use
+     */
+    bool applies(const measurements::Measurement& meas) const;
 
     /**
      * @brief Performs the correction step for a lidar
      * @param snapshot A mutable reference to a point in time. The state will be updated according
      * to the sensor model
      */
-    void operator()(History::Snapshot& snapshot);
+    void operator()(Snapshot& snapshot);
 
 private:
-    using BaseUpdate<PFSensorMeasurement>::correct;
+    using Base::correct;
 };
+
+using PlaneFitUpdate = PlaneFitUpdateT<double>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
@@ -0,0 +1,129 @@
+#ifndef VISUAL_ODOMETRY_UPDATE_HPP
+#define VISUAL_ODOMETRY_UPDATE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+#include <sophus/se3.hpp>
+
+#include <gnc/kalman/BaseUpdate.hpp>
+#include <gnc/measurements/VisualOdometry.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+/**
+ * A correction step for a camera tracking its own motion, such as the T265
+ *
+ * Each reading is the motion of the camera between two frames, so its prediction depends on two
+ * snapshots: the one the reading is on and the one of the frame it moved from (its base). The
+ * update keeps the corrected camera pose of the snapshots its readings landed on, one per snapshot
+ * the history can hold, and predicts a reading as the motion from the pose kept for its base.
+ * Replays revisit snapshots in time order, so a base that was re-filtered has been kept again by
+ * the time it is needed.
+ *
+ * The base pose is taken as known. Its correlation with the current state is dropped rather than
+ * cloning the base into the state, so R should cover the uncertainty of the base as well. A
+ * reading whose base is not kept (the first reading, or one after a dropped reading) only starts
+ * a new base, and is counted once in "update.visual_odometry.missing_base".
+ */
+template <class Scalar_>
+class VisualOdometryUpdateT
+    : public BaseUpdate<VisualOdometryUpdateT<Scalar_>,
+          measurements::VisualOdometryMeasurementT<Scalar_>>
+{
+    using Base = BaseUpdate<VisualOdometryUpdateT<Scalar_>,
+        measurements::VisualOdometryMeasurementT<Scalar_>>;
+
+public:
+    using typename Base::MeasurementJacobian;
+    using typename Base::Scalar;
+    using typename Base::Snapshot;
+    using typename Base::State;
+    using Target = measurements::VisualOdometryMeasurementT<Scalar>;
+
+    /**
+     * @param config The updates node. Its optional "visual_odometry" key has the unscented
+     * transform parameters, the sensor covariance R of a single reading and the camera
+     * extrinsics. Without it the update is disabled.
+     * @param history_size Maximum history size. A replay reaches back at most this many
+     * snapshots, so one more pose covers the base of the oldest reading it revisits.
+     */
+    VisualOdometryUpdateT(YAML::Node config, size_t history_size);
+
+    /**
+     * @brief Computes the observation model (h(x)) for a state provided by an UnscentedTransform
+     * @param state A sigma point of the camera state
+     * @return The motion of the camera since the base of the reading
+     */
+    Target predicted(const State& state);
+
+    /**
+     * @return The visual odometry reading from the list of measurements
+     */
+    Target measured(const measurements::Measurement& meas);
+
+    /**
+     * @brief Jacobian of predicted() with respect to the error state, for the ESKF
+     * @param state The sensor state the measurement is predicted from
+     */
+    MeasurementJacobian jacobian(const State& state);
+
+    /**
+     * @return Whether meas holds a reading this update can use
+     */
+    bool applies(const measurements::Measurement& meas) const;
+
+    /**
+     * @brief Performs the correction step for a camera, and keeps the corrected pose as the base
+     * of the next reading
+     * @param snapshot A mutable reference to a point in time. The state will be updated according
+     * to the sensor model
+     */
+    void operator()(Snapshot& snapshot);
+
+    /**
+     * @brief Takes over the kept bases of another update, after its estimator's states were
+     * adopted (see EstimatorT::adopt)
+     */
+    void adopt(const VisualOdometryUpdateT& other);
+
+private:
+    using Base::correct;
+
+    /**
+     * Corrected camera pose at the frame of a reading
+     */
+    struct Anchor
+    {
+        uint64_t time_usec = 0;
+        typename State::SE3 pose;
+    };
+
+    /**
+     * @return The kept pose at the frame at time_usec, or nullptr
+     */
+    Anchor* find(uint64_t time_usec);
+
+    Metrics::Counter& missing_base_;
+    // Time of the newest reading seen, before which a reading is a replay
+    uint64_t counted_until_usec_;
+
+    // Ring of kept poses, allocated once
+    std::vector<Anchor> anchors_;
+    size_t next_anchor_;
+
+    typename State::SE3 base_inverse_;
+    State sensor_state_;
+};
+
+using VisualOdometryUpdate = VisualOdometryUpdateT<double>;
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
+
+#endif
@@ -18,25 +18,29 @@ namespace measurements
 /*
  * Stores the necessary info we need from a global update (SLAM) measurement
  */
-class GlobalUpdateMeasurement
+template <class Scalar_>
+class GlobalUpdateMeasurementT
 {
 public:
     /**
      * Necessary definitions
      */
+    using Scalar = Scalar_;
+    using SE3 = Sophus::SE3<Scalar>;
     constexpr static size_t DoF = 6;
-    using CovarianceMatrix = Eigen::Matrix<double, DoF, DoF>;
-    using ErrorStateVector = Eigen::Matrix<double, DoF, 1>;
+    using CovarianceMatrix = Eigen::Matrix<Scalar, DoF, DoF>;
+    using ErrorStateVector = Eigen::Matrix<Scalar, DoF, 1>;
+    using Weights = typename StateT<Scalar>::Weights;
 
     /**
      * @brief Computes the error state between two SensorMeasurements
      */
-    ErrorStateVector operator-(const GlobalUpdateMeasurement& other) const;
+    ErrorStateVector operator-(const GlobalUpdateMeasurementT& other) const;
 
     /**
      * @brief adds the error state into a GlobalUpdateMeasurement
      */
-    GlobalUpdateMeasurement& operator+=(const ErrorStateVector& other);
+    GlobalUpdateMeasurementT& operator+=(const ErrorStateVector& other);
 
     /**
      * @return Const reference to the covariance matrix
@@ -51,12 +55,12 @@ public:
     /**
      * @return Const reference to the measured value
      */
-    const Sophus::SE3d& pose() const;
+    const SE3& pose() const;
 
     /**
      * @return Mutable reference to the measured value
      */
-    Sophus::SE3d& pose();
+    SE3& pose();
 
     /**
      * @brief Computes the mean and covariance of a set of SensorMeasurements
@@ -64,12 +68,11 @@ public:
      * @param m_weights Mean weights from an UnscentedTransform
      * @param c_weights Covariance weights from an UnscentedTransform
      */
-    static GlobalUpdateMeasurement compute_gaussian(
-        const std::array<GlobalUpdateMeasurement, State::N>& points,
-        const std::array<double, State::N>& m_weights,
-        const std::array<double, State::N>& c_weights)
+    static GlobalUpdateMeasurementT compute_gaussian(
+        const std::array<GlobalUpdateMeasurementT, State::N>& points, const Weights& m_weights,
+        const Weights& c_weights)
     {
-        GlobalUpdateMeasurement gaussian;
+        GlobalUpdateMeasurementT gaussian;
         gaussian.pose().so3() = points[0].pose().so3();
         for (size_t i = 0; i < State::N; i++)
         {
@@ -86,16 +89,33 @@ public:
         return gaussian;
     }
 
+    /**
+     * @brief Copy of the reading in another precision
+     */
+    template <class Other>
+    GlobalUpdateMeasurementT<Other> cast() const
+    {
+        GlobalUpdateMeasurementT<Other> other;
+        other.setTime(time_usec_);
+        other.pose() = Sophus::SE3<Other>(
+            pose_.so3().template cast<Other>(), pose_.translation().template cast<Other>());
+        other.covariance() = covariance_.template cast<Other>();
+        return other;
+    }
+
     uint64_t timeUSec() const;
     void setTime(uint64_t time_usec);
 
 private:
-    Sophus::SE3d pose_;
+    SE3 pose_;
     uint64_t time_usec_;
     CovarianceMatrix covariance_;
 };
 
-std::ostream& operator<<(std::ostream& os, const GlobalUpdateMeasurement& meas);
+using GlobalUpdateMeasurement = GlobalUpdateMeasurementT<double>;
+
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const GlobalUpdateMeasurementT<Scalar>& meas);
 
 }  // namespace measurements
 }  // namespace gnc
@@ -15,27 +15,33 @@ namespace measurements
 {
 /*
  * Stores the necessary info we need from a lidar message.
+ *
+ * Readings are LidarMeasurement (double). A single precision estimator predicts them as
+ * LidarMeasurementT<float>.
  */
-class LidarMeasurement
+template <class Scalar_>
+class LidarMeasurementT
 {
 public:
     /**
      * Necessary definitions
      */
+    using Scalar = Scalar_;
     constexpr static size_t DoF = 1;
-    using CovarianceMatrix = Eigen::Matrix<double, DoF, DoF>;
-    using ErrorStateVector = Eigen::Matrix<double, DoF, 1>;
-    using SensorVector = Eigen::Matrix<double, 1, 1>;
+    using CovarianceMatrix = Eigen::Matrix<Scalar, DoF, DoF>;
+    using ErrorStateVector = Eigen::Matrix<Scalar, DoF, 1>;
+    using SensorVector = Eigen::Matrix<Scalar, 1, 1>;
+    using Weights = typename StateT<Scalar>::Weights;
 
     /**
      * @brief Computes the error state between two SensorMeasurements
      */
-    ErrorStateVector operator-(const LidarMeasurement& other) const;
+    ErrorStateVector operator-(const LidarMeasurementT& other) const;
 
     /**
      * @brief adds the error state into a LidarMeasurement
      */
-    LidarMeasurement& operator+=(const ErrorStateVector& other);
+    LidarMeasurementT& operator+=(const ErrorStateVector& other);
 
     /**
      * @return Const reference to the covariance matrix
@@ -63,11 +69,10 @@ public:
      * @param m_weights Mean weights from an UnscentedTransform
      * @param c_weights Covariance weights from an UnscentedTransform
      */
-    static LidarMeasurement compute_gaussian(const std::array<LidarMeasurement, State::N>& points,
-        const std::array<double, State::N>& m_weights,
-        const std::array<double, State::N>& c_weights)
+    static LidarMeasurementT compute_gaussian(const std::array<LidarMeasurementT, State::N>& points,
+        const Weights& m_weights, const Weights& c_weights)
     {
-        LidarMeasurement gaussian;
+        LidarMeasurementT gaussian;
         gaussian.distance() = SensorVector::Zero();
         for (size_t i = 0; i < State::N; i++)
         {
@@ -84,6 +89,19 @@ public:
         return gaussian;
     }
 
+    /**
+     * @brief Copy of the reading in another precision
+     */
+    template <class Other>
+    LidarMeasurementT<Other> cast() const
+    {
+        LidarMeasurementT<Other> other;
+        other.setTime(time_usec_);
+        other.distance() = distance_.template cast<Other>();
+        other.covariance() = covariance_.template cast<Other>();
+        return other;
+    }
+
     uint64_t timeUSec() const;
     void setTime(uint64_t time_usec);
 
@@ -93,7 +111,10 @@ private:
     CovarianceMatrix covariance_;
 };
 
-std::ostream& operator<<(std::ostream& os, const LidarMeasurement& meas);
+using LidarMeasurement = LidarMeasurementT<double>;
+
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const LidarMeasurementT<Scalar>& meas);
 }  // namespace measurements
 }  // namespace gnc
 }  // namespace maav
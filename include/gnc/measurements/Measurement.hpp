@@ -12,6 +12,11 @@ namespace maav
 {
 namespace gnc
 {
+namespace kalman
+{
+class ImuPreintegration;
+}
+
 namespace measurements
 {
 /**
@@ -21,6 +26,8 @@ namespace measurements
 struct Measurement
 {
     std::shared_ptr<const ImuMeasurement> imu;
+    // IMU samples since the previous snapshot, when the filter runs slower than the IMU
+    std::shared_ptr<const kalman::ImuPreintegration> imu_preintegration;
     std::shared_ptr<const LidarMeasurement> lidar;
     std::shared_ptr<const PlaneFitMeasurement> plane_fit;
     std::shared_ptr<const VisualOdometryMeasurement> visual_odometry;
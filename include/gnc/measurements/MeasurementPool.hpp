@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+#include <gnc/kalman/ImuPreintegration.hpp>
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/utils/ObjectPool.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace measurements
+{
+/**
+ * @brief Recycled storage for everything a Measurement points to
+ *
+ * Measurements acquired here go back to their pool when the last snapshot or set holding them lets
+ * go, rather than being freed. The history trims its snapshots in History::resize and sizes the
+ * pools for the snapshots it keeps, so once it has filled up, feeding the estimator from these
+ * pools does not allocate.
+ *
+ * Recycled objects keep the values of their last use; see ObjectPool.
+ */
+struct MeasurementPool
+{
+    explicit MeasurementPool(size_t capacity = 0) { reserve(capacity); }
+
+    /**
+     * @brief Grows the pool of every sensor to hold at least capacity measurements
+     *
+     * Preintegrations are only used with a filter rate set, so their pool is left to grow on
+     * demand.
+     */
+    void reserve(size_t capacity)
+    {
+        imu.reserve(capacity);
+        lidar.reserve(capacity);
+        plane_fit.reserve(capacity);
+        visual_odometry.reserve(capacity);
+        global_update.reserve(capacity);
+    }
+
+    ObjectPool<ImuMeasurement> imu;
+    ObjectPool<kalman::ImuPreintegration> imu_preintegration;
+    ObjectPool<LidarMeasurement> lidar;
+    ObjectPool<PlaneFitMeasurement> plane_fit;
+    ObjectPool<VisualOdometryMeasurement> visual_odometry;
+    ObjectPool<GlobalUpdateMeasurement> global_update;
+};
+
+}  // namespace measurements
+}  // namespace gnc
+}  // namespace maav
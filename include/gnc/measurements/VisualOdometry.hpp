@@ -1,7 +1,13 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <ostream>
+
 #include <Eigen/Dense>
-#include "sophus/so3.hpp"
+#include <sophus/se3.hpp>
+
+#include <gnc/State.hpp>
 
 namespace maav
 {
@@ -10,15 +16,120 @@ namespace gnc
 namespace measurements
 {
 /*
- * Stores the necessary info we need from a visual odometry measurement
+ * Stores the necessary info we need from a visual odometry measurement: how the camera moved
+ * between two frames, in the camera frame at the earlier one
  */
-struct VisualOdometryMeasurement
+template <class Scalar_>
+class VisualOdometryMeasurementT
 {
-    Eigen::Vector3d translation;
-    Sophus::SO3d rotation;
-    uint64_t time_usec;
+public:
+    /**
+     * Necessary definitions
+     */
+    using Scalar = Scalar_;
+    using SE3 = Sophus::SE3<Scalar>;
+    constexpr static size_t DoF = 6;
+    using CovarianceMatrix = Eigen::Matrix<Scalar, DoF, DoF>;
+    using ErrorStateVector = Eigen::Matrix<Scalar, DoF, 1>;
+    using Weights = typename StateT<Scalar>::Weights;
+
+    /**
+     * @brief Computes the error state between two relative poses
+     */
+    ErrorStateVector operator-(const VisualOdometryMeasurementT& other) const;
+
+    /**
+     * @brief adds the error state into a relative pose
+     */
+    VisualOdometryMeasurementT& operator+=(const ErrorStateVector& other);
+
+    /**
+     * @return Const reference to the covariance matrix
+     */
+    const CovarianceMatrix& covariance() const;
+
+    /**
+     * @return Mutable reference to the covariance matrix
+     */
+    CovarianceMatrix& covariance();
+
+    /**
+     * @return Const reference to the motion of the camera since the base frame
+     */
+    const SE3& pose() const;
+
+    /**
+     * @return Mutable reference to the motion of the camera since the base frame
+     */
+    SE3& pose();
+
+    /**
+     * @brief Computes the mean and covariance of a set of relative poses
+     * @param points Sigma points from an UnscentedTransform
+     * @param m_weights Mean weights from an UnscentedTransform
+     * @param c_weights Covariance weights from an UnscentedTransform
+     */
+    static VisualOdometryMeasurementT compute_gaussian(
+        const std::array<VisualOdometryMeasurementT, State::N>& points, const Weights& m_weights,
+        const Weights& c_weights)
+    {
+        VisualOdometryMeasurementT gaussian;
+        gaussian.pose().so3() = points[0].pose().so3();
+        gaussian.pose().translation().setZero();
+        for (size_t i = 0; i < State::N; i++)
+        {
+            gaussian.pose().translation() += m_weights[i] * points[i].pose().translation();
+        }
+
+        gaussian.covariance() = CovarianceMatrix::Zero();
+        for (size_t i = 0; i < State::N; i++)
+        {
+            gaussian.covariance() +=
+                c_weights[i] * (points[i] - gaussian) * (points[i] - gaussian).transpose();
+        }
+
+        return gaussian;
+    }
+
+    /**
+     * @brief Copy of the reading in another precision
+     */
+    template <class Other>
+    VisualOdometryMeasurementT<Other> cast() const
+    {
+        VisualOdometryMeasurementT<Other> other;
+        other.setTime(time_usec_);
+        other.setBaseTime(base_time_usec_);
+        other.pose() = Sophus::SE3<Other>(
+            pose_.so3().template cast<Other>(), pose_.translation().template cast<Other>());
+        other.covariance() = covariance_.template cast<Other>();
+        return other;
+    }
+
+    /**
+     * Time of the frame the camera moved to
+     */
+    uint64_t timeUSec() const;
+    void setTime(uint64_t time_usec);
+
+    /**
+     * Time of the frame the camera moved from, that of the previous reading
+     */
+    uint64_t baseTimeUSec() const;
+    void setBaseTime(uint64_t base_time_usec);
+
+private:
+    SE3 pose_;
+    uint64_t time_usec_ = 0;
+    uint64_t base_time_usec_ = 0;
+    CovarianceMatrix covariance_;
 };
 
+using VisualOdometryMeasurement = VisualOdometryMeasurementT<double>;
+
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const VisualOdometryMeasurementT<Scalar>& meas);
+
 }  // namespace measurements
 }  // namespace gnc
 }  // namespace maav
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Histogram of latencies [us] over a fixed set of logarithmic buckets
+ *
+ * Bucket i holds latencies in [2^(i/4), 2^((i+1)/4)), except that the first bucket also takes
+ * everything below 1 us (including negative latencies from clock skew) and the last one everything
+ * past the top edge (about 16 s). Four buckets per power of two keep percentiles within 19 % of the
+ * true value. Adding a sample never allocates, so it can be done on every IMU tick.
+ */
+class LatencyHistogram
+{
+public:
+    constexpr static size_t BUCKETS_PER_OCTAVE = 4;
+    constexpr static size_t NUM_BUCKETS = 24 * BUCKETS_PER_OCTAVE;
+
+    LatencyHistogram() { reset(); }
+
+    void add(int64_t latency_usec);
+
+    /**
+     * @brief Empties every bucket
+     */
+    void reset();
+
+    uint64_t count() const { return count_; }
+
+    /**
+     * @return Mean latency [us], 0 when empty
+     */
+    double mean() const;
+
+    /**
+     * @return Largest latency added [us], 0 when empty
+     */
+    int64_t max() const { return max_; }
+
+    /**
+     * @brief Upper bound on the p quantile (p in [0, 1]) [us]
+     *
+     * This is the upper edge of the bucket holding the quantile, capped at max(). 0 when empty.
+     */
+    double percentile(double p) const;
+
+    uint64_t bucketCount(size_t bucket) const { return buckets_[bucket]; }
+
+    /**
+     * @return Exclusive upper edge of a bucket [us]
+     */
+    static double bucketUpper(size_t bucket);
+
+private:
+    static size_t bucketIndex(int64_t latency_usec);
+
+    std::array<uint64_t, NUM_BUCKETS> buckets_;
+    uint64_t count_;
+    double sum_;
+    int64_t max_;
+};
+
+}  // namespace gnc
+}  // namespace maav
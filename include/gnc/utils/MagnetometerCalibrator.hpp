@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Dense>
+
+#include <gnc/utils/MagnetometerEllipsoidFit.hpp>
+#include <gnc/utils/Metrics.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Fits the magnetometer calibration in flight
+ *
+ * Raw readings are handed to add() on the IMU thread. A reading is only kept once the field has
+ * turned by min_separation since the last kept one, so hovering does not outweigh the rest of the
+ * sphere. A thread owned by the calibrator folds the kept readings into an EllipsoidFit and,
+ * every fit_period readings, solves it. A fit replaces the calibration in use once it has
+ * min_samples readings behind it, is an ellipsoid and its axes differ by at most max_axis_ratio.
+ *
+ * The calibration is swapped as a whole through an atomic shared_ptr, so calibration() never
+ * waits for a fit and never sees half of one. Until the first fit it is the one given to
+ * setCalibration(), or none (zero offset, unit scale).
+ *
+ * Fits are counted in "magnetometer.fits" and "magnetometer.rejected_fits".
+ */
+class MagnetometerCalibrator
+{
+public:
+    /**
+     * @param config The 'enabled', 'min_separation' (fraction of the field), 'min_samples',
+     *     'fit_period', 'forgetting' and 'max_axis_ratio' keys. Disabled if null.
+     */
+    explicit MagnetometerCalibrator(YAML::Node config);
+    ~MagnetometerCalibrator();
+
+    MagnetometerCalibrator(const MagnetometerCalibrator&) = delete;
+    MagnetometerCalibrator& operator=(const MagnetometerCalibrator&) = delete;
+
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief Replaces the calibration in use, e.g. with the one from imu-calib.yaml
+     */
+    void setCalibration(const MagParams& params);
+
+    /**
+     * @brief The calibration in use. Any thread may call this.
+     */
+    std::shared_ptr<const MagParams> calibration() const;
+
+    /**
+     * @brief Hands a raw reading to the fitting thread. Never waits for a fit.
+     */
+    void add(const Eigen::Vector3d& reading);
+
+    /**
+     * @return Fits of this calibrator that replaced the calibration
+     */
+    uint64_t fits() const { return applied_.load(); }
+
+private:
+    void work();
+    void fit();
+
+    // Readings waiting for the thread beyond this are dropped
+    constexpr static size_t MAX_PENDING = 256;
+
+    const bool enabled_;
+    const double min_separation_;
+    const double min_samples_;
+    const size_t fit_period_;
+    const double max_axis_ratio_;
+
+    // Only touched by the thread
+    EllipsoidFit fit_;
+    size_t since_fit_;
+
+    // Only touched by add()
+    Eigen::Vector3d last_reading_;
+    bool has_reading_;
+
+    // Filled by add() and swapped with working_ by the thread, both under mutex_
+    std::vector<Eigen::Vector3d> pending_;
+    std::vector<Eigen::Vector3d> working_;
+
+    // Read and replaced with std::atomic_load and std::atomic_store
+    std::shared_ptr<const MagParams> calibration_;
+    std::atomic<uint64_t> applied_;
+
+    Metrics::Counter& fits_;
+    Metrics::Counter& rejected_fits_;
+    Metrics::Gauge& samples_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_;
+    std::thread thread_;
+};
+
+}  // namespace gnc
+}  // namespace maav
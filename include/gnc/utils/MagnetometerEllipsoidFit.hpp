@@ -1,3 +1,5 @@
+#pragma once
+
 #include <gnc/control/MagParams.hpp>
 #include <Eigen/Dense>
 
@@ -7,6 +9,45 @@ namespace maav
 {
 namespace gnc
 {
+/**
+ * @brief Least squares fit of an ellipsoid to magnetometer readings, one reading at a time
+ *
+ * Fits v in D v = 1, where each reading adds the row
+ * D_i = [x^2, y^2, z^2, 2xy, 2zx, 2yz, 2x, 2y, 2z]. Instead of keeping D, each reading is folded
+ * into the normal equations D^T D v = D^T 1, the information form of recursive least squares, so
+ * adding costs the same at the first and the millionth reading and memory stays constant.
+ *
+ * With a forgetting factor below 1 older readings are weighted down geometrically, so the fit
+ * follows a field that changes over time. The effective window is about 1 / (1 - forgetting).
+ */
+class EllipsoidFit
+{
+public:
+    explicit EllipsoidFit(double forgetting = 1);
+
+    void add(const Eigen::Vector3d& reading);
+
+    /**
+     * @brief Weighted number of readings in the fit
+     */
+    double weight() const { return weight_; }
+
+    /**
+     * @brief Offset, scale and rotation of the fitted ellipsoid
+     *
+     * @return False if the fit is not an ellipsoid, e.g. while the readings only cover a plane
+     */
+    bool solve(MagParams& params) const;
+
+    void reset();
+
+private:
+    const double forgetting_;
+    Eigen::Matrix<double, 9, 9> information_;
+    Eigen::Matrix<double, 9, 1> target_;
+    double weight_;
+};
+
 MagParams runMagnetometerCalibration(const VectorXd& x, const VectorXd& y, const VectorXd& z);
 }
 }  // namespace maav
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gnc/utils/LatencyHistogram.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Process wide registry of the counters, gauges and histograms of the GNC stack
+ *
+ * A metric is looked up by name once, usually into a reference held by whatever records it, and
+ * stays registered for the life of the process. Counters and gauges are then recorded lock free.
+ * A histogram takes a lock of its own, which is uncontended except while a report is read.
+ * Nothing is printed; the estimator driver publishes a report every second on GNC_METRICS.
+ *
+ * Names are dot separated, starting with the part of the stack, e.g. "update.lidar.rejected".
+ * Histograms end in their unit, e.g. "estimator.predict_usec".
+ */
+class Metrics
+{
+public:
+    /**
+     * @brief Total since the process started
+     */
+    class Counter
+    {
+    public:
+        void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_{0};
+    };
+
+    /**
+     * @brief Last value set
+     */
+    class Gauge
+    {
+    public:
+        void set(double value) { value_.store(value, std::memory_order_relaxed); }
+        double value() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value_{0};
+    };
+
+    /**
+     * @brief Distribution of the samples recorded since the last report
+     *
+     * Uses the logarithmic buckets of LatencyHistogram, so adding never allocates.
+     */
+    class Histogram
+    {
+    public:
+        void add(int64_t value)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            histogram_.add(value);
+        }
+
+        /**
+         * @brief Copies the histogram out and empties it
+         */
+        LatencyHistogram take()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const LatencyHistogram taken = histogram_;
+            histogram_.reset();
+            return taken;
+        }
+
+    private:
+        std::mutex mutex_;
+        LatencyHistogram histogram_;
+    };
+
+    /**
+     * @brief Adds the time [us] from construction to destruction to a histogram
+     */
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& histogram)
+            : histogram_(histogram), start_(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            histogram_.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_)
+                               .count());
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram& histogram_;
+        const std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * @brief Every metric, sorted by name within each kind
+     */
+    struct Report
+    {
+        struct Summary
+        {
+            std::string name;
+            uint64_t count;
+            double mean;
+            double p50;
+            double p99;
+            int64_t max;
+        };
+
+        std::vector<std::pair<std::string, uint64_t>> counters;
+        std::vector<std::pair<std::string, double>> gauges;
+        std::vector<Summary> histograms;
+    };
+
+    static Metrics& instance();
+
+    /**
+     * @brief The metric called name, registered on first use
+     */
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    Histogram& histogram(const std::string& name);
+
+    /**
+     * @brief Reads every metric. Histograms are emptied, so each report covers one period.
+     */
+    Report report();
+
+private:
+    Metrics() = default;
+
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Counter>> counters_;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+};
+
+}  // namespace gnc
+}  // namespace maav
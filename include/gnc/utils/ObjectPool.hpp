@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Recycles objects handed out as shared_ptrs
+ *
+ * acquire() returns a shared_ptr to an object from the pool. When the last reference is released,
+ * the object goes back to the pool instead of being destroyed, so whatever it owns (the capacity
+ * of a std::vector member, say) is kept for the next user. The shared_ptr control blocks come from
+ * a free list of their own. Once the pool holds as many objects as are ever alive at once,
+ * acquiring and releasing never touches the heap.
+ *
+ * Recycled objects are not reset: the caller assigns every field it relies on.
+ *
+ * The pool grows by doubling whenever it runs dry. Its storage is shared with the objects it
+ * handed out, so they may outlive the pool itself. Acquiring and releasing are thread safe.
+ */
+template <class T>
+class ObjectPool
+{
+public:
+    /**
+     * @param capacity Number of objects to allocate up front
+     */
+    explicit ObjectPool(size_t capacity = 0) : storage_(std::make_shared<Storage>())
+    {
+        reserve(capacity);
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    std::shared_ptr<T> acquire()
+    {
+        T* object = storage_->take();
+        return std::shared_ptr<T>(object, Recycler{storage_.get()}, BlockAllocator<T>(storage_));
+    }
+
+    /**
+     * @brief Grows the pool to hold at least capacity objects
+     */
+    void reserve(size_t capacity) { storage_->reserve(capacity); }
+
+    /**
+     * @return Number of objects the pool owns, in use or not
+     */
+    size_t capacity() const { return storage_->capacity(); }
+
+    /**
+     * @return Number of objects ready to be acquired
+     */
+    size_t available() const { return storage_->available(); }
+
+private:
+    // Big enough for the control block of a shared_ptr with a custom deleter and allocator
+    constexpr static size_t BLOCK_SIZE = 128;
+
+    struct alignas(alignof(std::max_align_t)) Block
+    {
+        unsigned char bytes[BLOCK_SIZE];
+    };
+
+    class Storage
+    {
+    public:
+        T* take()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_objects_.empty()) grow(std::max<size_t>(1, objects_.size()));
+            T* object = free_objects_.back();
+            free_objects_.pop_back();
+            return object;
+        }
+
+        void give(T* object)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_objects_.push_back(object);
+        }
+
+        Block* takeBlock()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_blocks_.empty()) grow(std::max<size_t>(1, objects_.size()));
+            Block* block = free_blocks_.back();
+            free_blocks_.pop_back();
+            return block;
+        }
+
+        void giveBlock(Block* block)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_blocks_.push_back(block);
+        }
+
+        void reserve(size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (capacity > objects_.size()) grow(capacity - objects_.size());
+        }
+
+        size_t capacity() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return objects_.size();
+        }
+
+        size_t available() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return free_objects_.size();
+        }
+
+    private:
+        /**
+         * Adds count objects and control blocks. The free lists get room for every object the pool
+         * owns, so returning one never reallocates them.
+         */
+        void grow(size_t count)
+        {
+            const size_t total = objects_.size() + count;
+            objects_.reserve(total);
+            free_objects_.reserve(total);
+            free_blocks_.reserve(total);
+
+            blocks_.emplace_back(new Block[count]);
+            for (size_t i = 0; i < count; i++)
+            {
+                objects_.emplace_back(new T());
+                free_objects_.push_back(objects_.back().get());
+                free_blocks_.push_back(&blocks_.back()[i]);
+            }
+        }
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<T>> objects_;
+        std::vector<std::unique_ptr<Block[]>> blocks_;
+        std::vector<T*> free_objects_;
+        std::vector<Block*> free_blocks_;
+    };
+
+    /**
+     * Deleter that hands the object back. The control block it lives in holds a BlockAllocator,
+     * which keeps the storage alive until the deleter has run.
+     */
+    struct Recycler
+    {
+        void operator()(T* object) const { storage->give(object); }
+
+        Storage* storage;
+    };
+
+    /**
+     * Allocator for the shared_ptr control blocks, which std::shared_ptr rebinds to its own type
+     */
+    template <class U>
+    class BlockAllocator
+    {
+    public:
+        using value_type = U;
+
+        explicit BlockAllocator(std::shared_ptr<Storage> storage) : storage_(std::move(storage)) {}
+
+        template <class V>
+        BlockAllocator(const BlockAllocator<V>& other) : storage_(other.storage_)
+        {
+        }
+
+        U* allocate(size_t n)
+        {
+            static_assert(sizeof(U) <= BLOCK_SIZE, "ObjectPool::BLOCK_SIZE is too small");
+            static_assert(alignof(U) <= alignof(Block), "ObjectPool::Block is underaligned");
+            assert(n == 1);
+            (void)n;
+            return reinterpret_cast<U*>(storage_->takeBlock());
+        }
+
+        void deallocate(U* pointer, size_t)
+        {
+            storage_->giveBlock(reinterpret_cast<Block*>(pointer));
+        }
+
+        template <class V>
+        bool operator==(const BlockAllocator<V>& other) const
+        {
+            return storage_ == other.storage_;
+        }
+
+        template <class V>
+        bool operator!=(const BlockAllocator<V>& other) const
+        {
+            return storage_ != other.storage_;
+        }
+
+    private:
+        template <class V>
+        friend class BlockAllocator;
+
+        std::shared_ptr<Storage> storage_;
+    };
+
+    std::shared_ptr<Storage> storage_;
+};
+
+}  // namespace gnc
+}  // namespace maav
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <sophus/se3.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Ring of the latest timestamped poses, written by one thread and read by any number
+ *
+ * @details Each slot is a seqlock: the writer bumps the slot's sequence number to odd, writes the
+ * pose and bumps it back to even, and readers retry a slot whose sequence number was odd or
+ * changed while they read it. Neither side ever blocks the other, and a read copies 8 words per
+ * slot rather than a whole State.
+ *
+ * Poses are pushed in time order. Pushing a pose no newer than the newest one rewinds the ring to
+ * where that time belongs and overwrites from there, so a window of re-estimated poses can be
+ * written over the previous one.
+ *
+ * Only waitFor takes a lock, and only while it waits; the writer only notifies when a reader is
+ * waiting.
+ */
+class PoseBuffer
+{
+public:
+    /**
+     * @param capacity Number of poses kept
+     */
+    explicit PoseBuffer(size_t capacity);
+
+    PoseBuffer(const PoseBuffer&) = delete;
+    PoseBuffer& operator=(const PoseBuffer&) = delete;
+
+    /**
+     * @brief Adds the pose at time_usec. Must only be called from one thread at a time.
+     */
+    void push(uint64_t time_usec, const Sophus::SE3d& pose);
+
+    /**
+     * @brief Interpolates the pose at time_usec between the poses before and after it, spherically
+     * for the rotation and linearly for the translation. Times outside the buffer get the nearest
+     * pose.
+     * @return false if the buffer is empty
+     */
+    bool at(uint64_t time_usec, Sophus::SE3d& pose) const;
+
+    /**
+     * @brief Like at(), but first waits up to timeout for a pose at or after time_usec
+     * @return false if the buffer is still empty after timeout or interrupt() was called. A time
+     * still not reached after timeout gets the newest pose.
+     */
+    bool waitFor(uint64_t time_usec, std::chrono::microseconds timeout, Sophus::SE3d& pose);
+
+    /**
+     * @brief Wakes the threads in waitFor, and makes later calls return false right away
+     */
+    void interrupt();
+
+    /**
+     * @return Time of the oldest and newest pose, false if the buffer is empty
+     */
+    bool range(uint64_t& oldest_usec, uint64_t& newest_usec) const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        // Ring index the slot was last written for, which tells readers it was lapped
+        std::atomic<uint64_t> index{0};
+        std::atomic<uint64_t> time_usec{0};
+        // Quaternion x, y, z, w then translation x, y, z
+        std::array<std::atomic<double>, 7> values{};
+    };
+
+    struct Pose
+    {
+        uint64_t time_usec;
+        Sophus::SE3d pose;
+    };
+
+    /**
+     * @brief Reads a consistent copy of the pose at ring index i
+     * @return false if the writer has since moved past i
+     */
+    bool read(uint64_t i, Pose& pose) const;
+
+    /**
+     * @return Whether the newest pose is at or after time_usec
+     */
+    bool reached(uint64_t time_usec) const;
+
+    /**
+     * @brief Writes pose at ring index i
+     */
+    void write(uint64_t i, uint64_t time_usec, const Sophus::SE3d& pose);
+
+    std::vector<Slot> slots_;
+
+    // Ring indices of the oldest pose and one past the newest. Only the writer changes them.
+    std::atomic<uint64_t> begin_;
+    std::atomic<uint64_t> end_;
+
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    std::atomic<size_t> waiters_;
+    std::atomic<bool> interrupted_;
+};
+
+}  // namespace gnc
+}  // namespace maav
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Fixed capacity circular buffer with random access iterators
+ *
+ * All storage is allocated once on construction. Elements live in a pool of cache line aligned
+ * slots, and the ring itself only holds slot indices, so inserting in the middle shifts indices
+ * rather than whole elements. Elements are never destroyed while the buffer lives; popping only
+ * moves the head, and pushing assigns into an existing slot, so T must be default constructible and
+ * assignable.
+ *
+ * Iterators refer to a logical position (0 is the oldest element). They stay valid across
+ * push_back, but pop_front and insert shift the logical positions of the remaining elements.
+ */
+template <class T>
+class RingBuffer
+{
+private:
+    constexpr static size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        T value;
+    };
+
+public:
+    template <bool Const>
+    class IteratorBase
+    {
+    private:
+        using Buffer = std::conditional_t<Const, const RingBuffer, RingBuffer>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        IteratorBase() : buffer_(nullptr), idx_(0) {}
+        IteratorBase(Buffer* buffer, size_t idx) : buffer_(buffer), idx_(idx) {}
+
+        /**
+         * @brief Allows a mutable iterator to be passed where a const iterator is expected
+         */
+        template <bool OtherConst, class = std::enable_if_t<Const && !OtherConst>>
+        IteratorBase(const IteratorBase<OtherConst>& other)
+            : buffer_(other.buffer_), idx_(other.idx_)
+        {
+        }
+
+        reference operator*() const { return (*buffer_)[idx_]; }
+        pointer operator->() const { return &(*buffer_)[idx_]; }
+        reference operator[](difference_type n) const { return (*buffer_)[idx_ + n]; }
+
+        IteratorBase& operator++()
+        {
+            ++idx_;
+            return *this;
+        }
+        IteratorBase operator++(int)
+        {
+            IteratorBase copy = *this;
+            ++idx_;
+            return copy;
+        }
+        IteratorBase& operator--()
+        {
+            --idx_;
+            return *this;
+        }
+        IteratorBase operator--(int)
+        {
+            IteratorBase copy = *this;
+            --idx_;
+            return copy;
+        }
+        IteratorBase& operator+=(difference_type n)
+        {
+            idx_ += n;
+            return *this;
+        }
+        IteratorBase& operator-=(difference_type n)
+        {
+            idx_ -= n;
+            return *this;
+        }
+        IteratorBase operator+(difference_type n) const { return IteratorBase(buffer_, idx_ + n); }
+        IteratorBase operator-(difference_type n) const { return IteratorBase(buffer_, idx_ - n); }
+        friend IteratorBase operator+(difference_type n, const IteratorBase& it) { return it + n; }
+        difference_type operator-(const IteratorBase& other) const
+        {
+            return static_cast<difference_type>(idx_) - static_cast<difference_type>(other.idx_);
+        }
+
+        bool operator==(const IteratorBase& other) const { return idx_ == other.idx_; }
+        bool operator!=(const IteratorBase& other) const { return idx_ != other.idx_; }
+        bool operator<(const IteratorBase& other) const { return idx_ < other.idx_; }
+        bool operator>(const IteratorBase& other) const { return idx_ > other.idx_; }
+        bool operator<=(const IteratorBase& other) const { return idx_ <= other.idx_; }
+        bool operator>=(const IteratorBase& other) const { return idx_ >= other.idx_; }
+
+        /**
+         * @return Logical position of this iterator in the buffer
+         */
+        size_t index() const { return idx_; }
+
+    private:
+        friend class IteratorBase<!Const>;
+
+        Buffer* buffer_;
+        size_t idx_;
+    };
+
+    using iterator = IteratorBase<false>;
+    using const_iterator = IteratorBase<true>;
+    using value_type = T;
+
+    explicit RingBuffer(size_t capacity) : storage_(capacity), order_(capacity), head_(0), size_(0)
+    {
+        // The ring always holds a permutation of slot indices. Positions past the last element
+        // hold the free slots.
+        for (size_t i = 0; i < capacity; i++)
+        {
+            order_[i] = i;
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return storage_.size(); }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == storage_.size(); }
+
+    T& operator[](size_t idx) { return storage_[order_[physical(idx)]].value; }
+    const T& operator[](size_t idx) const { return storage_[order_[physical(idx)]].value; }
+
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[size_ - 1]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    /**
+     * @brief Appends an element. The buffer must not be full.
+     */
+    void push_back(const T& value)
+    {
+        ++size_;
+        back() = value;
+    }
+
+    /**
+     * @brief Appends the next free slot without assigning to it. The buffer must not be full.
+     *
+     * The returned element still holds whatever value was last stored in that slot. This lets
+     * callers overwrite only the members they need instead of copying a whole element.
+     *
+     * @return Reference to the appended element
+     */
+    T& recycle_back()
+    {
+        ++size_;
+        return back();
+    }
+
+    /**
+     * @brief Drops the oldest element. The buffer must not be empty.
+     */
+    void pop_front()
+    {
+        head_ = physical(1);
+        --size_;
+    }
+
+    /**
+     * @brief Inserts an element before pos. The buffer must not be full.
+     *
+     * Elements are shifted toward whichever end of the buffer is closer to pos, so inserting near
+     * the newest element only moves a handful of elements.
+     *
+     * @return Iterator to the inserted element
+     */
+    iterator insert(const_iterator pos, const T& value)
+    {
+        const size_t idx = pos.index();
+        size_t slot;
+        if (idx < size_ / 2)
+        {
+            // Claim the free slot before the head and shift the older elements down
+            head_ = physical(capacity() - 1);
+            slot = order_[head_];
+            for (size_t i = 0; i < idx; i++)
+            {
+                order_[physical(i)] = order_[physical(i + 1)];
+            }
+        }
+        else
+        {
+            // Claim the free slot after the tail and shift the newer elements up
+            slot = order_[physical(size_)];
+            for (size_t i = size_; i > idx; i--)
+            {
+                order_[physical(i)] = order_[physical(i - 1)];
+            }
+        }
+        ++size_;
+        order_[physical(idx)] = slot;
+        storage_[slot].value = value;
+        return iterator(this, idx);
+    }
+
+    void clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+private:
+    size_t physical(size_t idx) const
+    {
+        const size_t pos = head_ + idx;
+        return pos >= storage_.size() ? pos - storage_.size() : pos;
+    }
+
+    std::vector<Slot> storage_;
+    std::vector<size_t> order_;
+    size_t head_;
+    size_t size_;
+};
+
+}  // namespace gnc
+}  // namespace maav
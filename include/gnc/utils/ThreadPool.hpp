@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace maav
+{
+namespace gnc
+{
+/**
+ * @brief Fixed set of worker threads for splitting short loops across cores
+ *
+ * Threads are started once on construction and live until destruction, so a parallel loop never
+ * creates threads or allocates. The calling thread works on the loop alongside the workers.
+ * When there are enough cores, workers keep polling for a short while after each loop before going
+ * to sleep, which keeps back to back loops (such as a history replay) from paying for a wake up
+ * every time.
+ *
+ * parallel_for must only be called from one thread at a time.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param num_threads Number of worker threads, not counting the calling thread
+     */
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @return Number of worker threads, not counting the calling thread
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief Calls f(i) for every i in [0, count) and returns once all calls have finished
+     *
+     * Indices are handed out dynamically, so f must not depend on which thread runs it or in what
+     * order indices run.
+     */
+    template <class F>
+    void parallel_for(size_t count, F& f)
+    {
+        run(count, [](void* context, size_t i) { (*static_cast<F*>(context))(i); }, &f);
+    }
+
+private:
+    using Invoke = void (*)(void*, size_t);
+
+    struct Job
+    {
+        Invoke invoke = nullptr;
+        void* context = nullptr;
+        size_t count = 0;
+    };
+
+    void run(size_t count, Invoke invoke, void* context);
+
+    void work();
+
+    /**
+     * @brief Runs indices of job until none are left
+     */
+    void drain(const Job& job);
+
+    const bool spin_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_;
+
+    // Guarded by mutex_, but also polled by spinning workers
+    std::atomic<uint64_t> generation_;
+    Job job_;
+
+    std::atomic<size_t> next_;
+    std::atomic<size_t> done_;
+    // Workers holding a copy of job_
+    std::atomic<size_t> active_;
+};
+
+}  // namespace gnc
+}  // namespace maav
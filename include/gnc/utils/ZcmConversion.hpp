@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <Eigen/Eigen>
 
@@ -13,11 +14,13 @@
 #include <common/messages/path_t.hpp>
 #include <common/messages/plane_fit_t.hpp>
 #include <common/messages/quaternion_t.hpp>
+#include <common/messages/state_lite_t.hpp>
 #include <common/messages/state_t.hpp>
 #include <common/messages/vector1_t.hpp>
 #include <common/messages/vector2_t.hpp>
 #include <common/messages/vector3_t.hpp>
 #include <common/messages/vector4_t.hpp>
+#include <common/messages/visual_odometry_t.hpp>
 #include <common/messages/waypoint_t.hpp>
 
 #include <gnc/State.hpp>
@@ -25,7 +28,9 @@
 #include <gnc/measurements/GlobalUpdateMeasurement.hpp>
 #include <gnc/measurements/ImuMeasurement.hpp>
 #include <gnc/measurements/LidarMeasurement.hpp>
+#include <gnc/measurements/MeasurementPool.hpp>
 #include <gnc/measurements/PlaneFitMeasurement.hpp>
+#include <gnc/measurements/VisualOdometry.hpp>
 #include <gnc/measurements/Waypoint.hpp>
 #include <gnc/planner/Path.hpp>
 
@@ -36,6 +41,19 @@ namespace gnc
 state_t ConvertState(const State& state);
 State ConvertState(const state_t& state);
 
+/*
+ * Fills a state message kept between states. The covariance reuses the rows already allocated.
+ */
+void ConvertState(const State& state, state_t& zcm_state);
+
+/*
+ * The compact state only carries the covariance if with_covariance is set, as its upper triangle
+ * row by row. Converting it back returns whether it did. Without one the covariance of the state
+ * is left alone, so a receiver can keep the last one it got.
+ */
+void ConvertState(const State& state, state_lite_t& zcm_state, bool with_covariance);
+bool ConvertState(const state_lite_t& zcm_state, State& state);
+
 State ConvertGroundTruthState(const groundtruth_inertial_t& state);
 
 waypoint_t ConvertWaypoint(const Waypoint& waypoint);
@@ -44,20 +62,47 @@ Waypoint ConvertWaypoint(const waypoint_t& zcm_waypoint);
 path_t ConvertPath(const Path& path);
 Path ConvertPath(const path_t& zcm_path);
 
+/*
+ * Each sensor message converts three ways: into a newly allocated measurement, into one recycled
+ * through a MeasurementPool, or in place. Pooled measurements are reset before being filled.
+ */
 std::shared_ptr<measurements::LidarMeasurement> convertLidar(const lidar_t& zcm_lidar);
+std::shared_ptr<measurements::LidarMeasurement> convertLidar(
+    const lidar_t& zcm_lidar, measurements::MeasurementPool& pool);
+void convertLidar(const lidar_t& zcm_lidar, measurements::LidarMeasurement& lidar);
 // lidar_t convertLidar(const measurements::LidarMeasurement& lidar);
 
 std::shared_ptr<measurements::ImuMeasurement> convertImu(const imu_t& zcm_imu);
+std::shared_ptr<measurements::ImuMeasurement> convertImu(
+    const imu_t& zcm_imu, measurements::MeasurementPool& pool);
+void convertImu(const imu_t& zcm_imu, measurements::ImuMeasurement& imu);
 // imu_t convertImu(const measurements::ImuMeasurement& imu);
 
 std::shared_ptr<measurements::PlaneFitMeasurement> convertPlaneFit(
     const plane_fit_t& zcm_plane_fit);
+std::shared_ptr<measurements::PlaneFitMeasurement> convertPlaneFit(
+    const plane_fit_t& zcm_plane_fit, measurements::MeasurementPool& pool);
+void convertPlaneFit(
+    const plane_fit_t& zcm_plane_fit, measurements::PlaneFitMeasurement& plane_fit);
 // plane_fit_t convertPlaneFit(const measurements::PlaneFitMeasurement& plane_fit);
 
 std::shared_ptr<measurements::GlobalUpdateMeasurement> convertGlobalUpdate(
     const global_update_t& zcm_global);
+std::shared_ptr<measurements::GlobalUpdateMeasurement> convertGlobalUpdate(
+    const global_update_t& zcm_global, measurements::MeasurementPool& pool);
+void convertGlobalUpdate(
+    const global_update_t& zcm_global, measurements::GlobalUpdateMeasurement& global_update);
 // global_update_t convertGlobalUpdate(const measurements::GlobalUpdateMeasurement& global);
 
+/**
+ * visual_odometry_t does not say which frame the camera moved from, so the base time of the
+ * converted reading is left for the caller to set
+ */
+std::shared_ptr<measurements::VisualOdometryMeasurement> convertVisualOdometry(
+    const visual_odometry_t& zcm_odometry, measurements::MeasurementPool& pool);
+void convertVisualOdometry(const visual_odometry_t& zcm_odometry,
+    measurements::VisualOdometryMeasurement& visual_odometry);
+
 vector1_t convertVector1d(double vec);
 double convertVector1d(const vector1_t& zcm_vec);
 
@@ -81,8 +126,8 @@ void convertMatrix(const Eigen::MatrixBase<EigenDerived>& mat, matrix_t& zcm_mat
 {
     zcm_mat.rows = static_cast<int32_t>(mat.rows());
     zcm_mat.cols = static_cast<int32_t>(mat.cols());
-    zcm_mat.data =
-        std::vector<std::vector<double>>(zcm_mat.rows, std::vector<double>(zcm_mat.cols));
+    zcm_mat.data.resize(zcm_mat.rows);
+    for (std::vector<double>& row : zcm_mat.data) row.resize(zcm_mat.cols);
     for (size_t i = 0; i < static_cast<size_t>(mat.rows()); i++)
     {
         for (size_t j = 0; j < static_cast<size_t>(mat.cols()); j++)
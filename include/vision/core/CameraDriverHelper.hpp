@@ -8,8 +8,10 @@
 #include <yaml-cpp/yaml.h>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <sophus/se3.hpp>
 #include <zcm/zcm-cpp.hpp>
 
+#include <common/messages/point_cloud_t.hpp>
 #include <common/messages/rgbd_image_t.hpp>
 #include <vision/core/D400CameraInterface.hpp>
 
@@ -40,14 +42,20 @@ private:
     bool publish_rgbd_;
     bool publish_pc_;
     bool publish_pose_; // TODO usage in impl
+    // Pose goes out as visual odometry instead of a global update
+    bool publish_visual_odometry_;
     bool autoexposure_;
     zcm::ZCM zcm_;
     maav::vision::D400CameraInterface camera_;
     bool running_;
+    // T265 pose at the last frame. Visual odometry is the motion since then.
+    bool has_last_pose_;
+    Sophus::SE3d last_pose_;
     std::thread publish_thread_;
     std::string rgbd_channel_;
     std::string pointcloud_channel_;
     std::string pose_channel_;// TODO using in impl
+    point_cloud_t point_cloud_;
     // TODO ZCM message type for pos data
 
     void publish();
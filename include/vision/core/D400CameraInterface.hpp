@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "CameraInterfaceBase.hpp"
+#include "DepthProjector.hpp"
 
 namespace maav::vision
 {
@@ -74,6 +75,16 @@ public:
     const void* getRawDepth() const;
     const void* getRawColor() const;
 
+    /**
+     * Projects getRawDepth() to points, with the rays of the depth intrinsics
+     */
+    const DepthProjector& getDepthProjector() const { return *depth_projector_; }
+
+    /**
+     * Meters per unit of getRawDepth()
+     */
+    float getDepthScale() const { return scale_; }
+
     int getStreamWidth() const;
     int getStreamHeight() const;
 
@@ -103,6 +114,7 @@ private:
     rs2_intrinsics color_intrinsics_;
     std::unique_ptr<rs2::align> align_object_;
     float scale_;
+    std::unique_ptr<DepthProjector> depth_projector_;
 
     rs2::sensor sensor_color_;
     rs2::sensor sensor_depth_;
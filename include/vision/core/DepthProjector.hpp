@@ -0,0 +1,84 @@
+#ifndef __DEPTH_PROJECTOR_HPP_MAAV_VISION__
+#define __DEPTH_PROJECTOR_HPP_MAAV_VISION__
+
+#include <cstdint>
+
+#include <Eigen/Dense>
+
+namespace maav::vision
+{
+/**
+ * @brief Turns a Z16 depth image into points in any frame in one pass
+ *
+ * @details The ray of every pixel (its point at a depth of 1 in the camera frame) is computed
+ * once, so projecting a pixel is a multiply by its depth followed by the camera to frame
+ * transform. The image is processed a row at a time on Eigen arrays, which vectorize, and only
+ * the points with a depth are handed to the output, so no intermediate cloud is built.
+ *
+ * Shared by every consumer of camera depth: the point clouds the camera driver publishes for the
+ * octomap and the plane fitter, and the PCL clouds of the camera interface.
+ */
+class DepthProjector
+{
+public:
+    /**
+     * @brief Pinhole camera without distortion: pixel (u, v) looks along
+     * ((u - ppx) / fx, (v - ppy) / fy, 1)
+     */
+    DepthProjector(int width, int height, float fx, float fy, float ppx, float ppy);
+
+    /**
+     * @brief Camera with the given rays, for models with distortion
+     * @param ray_x x of the point at a depth of 1 for each pixel, row major
+     * @param ray_y y of the point at a depth of 1 for each pixel, row major
+     */
+    DepthProjector(int width, int height, Eigen::ArrayXf ray_x, Eigen::ArrayXf ray_y);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    /**
+     * @brief Calls emit(x, y, z) with every pixel that has a depth, in row major order
+     * @param depth Row major Z16 image of width() x height() pixels, 0 where there is no depth
+     * @param depth_scale Meters per depth unit
+     * @param camera_to_frame Transform from the camera frame to the frame of the points
+     */
+    template <class Emit>
+    void project(const uint16_t* depth, float depth_scale, const Eigen::Matrix4d& camera_to_frame,
+        Emit&& emit) const
+    {
+        const Eigen::Matrix4f transform = camera_to_frame.cast<float>();
+        Eigen::ArrayXf z(width_);
+        Eigen::ArrayXf x(width_);
+        Eigen::ArrayXf y(width_);
+        Eigen::ArrayXf fx(width_);
+        Eigen::ArrayXf fy(width_);
+        Eigen::ArrayXf fz(width_);
+        for (int row = 0; row < height_; row++)
+        {
+            const uint16_t* row_depth = depth + row * width_;
+            z = Eigen::Map<const Eigen::Array<uint16_t, Eigen::Dynamic, 1>>(row_depth, width_)
+                    .cast<float>() *
+                depth_scale;
+            x = ray_x_.segment(row * width_, width_) * z;
+            y = ray_y_.segment(row * width_, width_) * z;
+            fx = transform(0, 0) * x + transform(0, 1) * y + transform(0, 2) * z + transform(0, 3);
+            fy = transform(1, 0) * x + transform(1, 1) * y + transform(1, 2) * z + transform(1, 3);
+            fz = transform(2, 0) * x + transform(2, 1) * y + transform(2, 2) * z + transform(2, 3);
+
+            for (int col = 0; col < width_; col++)
+            {
+                if (row_depth[col] != 0) emit(fx[col], fy[col], fz[col]);
+            }
+        }
+    }
+
+private:
+    int width_;
+    int height_;
+    Eigen::ArrayXf ray_x_;
+    Eigen::ArrayXf ray_y_;
+};
+}  // namespace maav::vision
+
+#endif
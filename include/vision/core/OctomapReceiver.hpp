@@ -0,0 +1,55 @@
+#ifndef __OCTOMAP_RECEIVER_HPP_MAAV_VISION__
+#define __OCTOMAP_RECEIVER_HPP_MAAV_VISION__
+
+#include <cstdint>
+#include <memory>
+
+#include <octomap/OcTree.h>
+
+#include <common/messages/octomap_delta_t.hpp>
+#include <common/messages/octomap_t.hpp>
+
+namespace maav::vision
+{
+/**
+ * @brief Rebuilds the occupancy map published by maav-octomap
+ *
+ * @details The map is published as a full octomap_t every few updates (a keyframe) and as an
+ * octomap_delta_t of the changed voxels in between. A keyframe replaces the map. A delta is
+ * applied if it follows the last map received, otherwise it is dropped and the map stays at its
+ * last version until the next keyframe.
+ *
+ * Not thread safe, callers receiving on one thread and reading the map on another must lock
+ * around both. Maps returned by map() are not changed by later deltas, so they can be read after
+ * the lock is released.
+ */
+class OctomapReceiver
+{
+public:
+    /**
+     * @return Whether the map changed
+     */
+    bool receive(const octomap_t* msg);
+
+    /**
+     * @return Whether the map changed
+     */
+    bool receive(const octomap_delta_t* msg);
+
+    /**
+     * @return The last map, or nullptr before the first keyframe
+     */
+    std::shared_ptr<octomap::OcTree> map() const { return octree_; }
+
+    /**
+     * @return utime of the last map received
+     */
+    int64_t utime() const { return utime_; }
+
+private:
+    std::shared_ptr<octomap::OcTree> octree_;
+    int64_t utime_ = 0;
+};
+}  // namespace maav::vision
+
+#endif
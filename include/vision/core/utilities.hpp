@@ -8,6 +8,7 @@
 #include <common/messages/rgbd_image_t.hpp>
 #include <common/messages/point_cloud_t.hpp>
 #include <common/messages/octomap_t.hpp>
+#include <common/messages/octomap_delta_t.hpp>
 
 #include <memory>
 
@@ -36,5 +37,10 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr zcmTypeToPCLPointCloud(const point_cloud_t&
 
 void octomapToZcmType(const std::shared_ptr<const octomap::OcTree>& octMap, octomap_t* msg);
 
+// Fills msg with the voxels whose occupancy changed since octMap last reset its change
+// detection, which must be enabled. Only the key and log odds of each voxel are written,
+// the caller stamps utime and base_utime.
+void octomapChangesToZcmType(const octomap::OcTree& octMap, octomap_delta_t* msg);
+
 std::shared_ptr<octomap::OcTree> zcmTypeToOctomap(const octomap_t* msg);
 }
@@ -12,11 +12,17 @@ const char* const DOWNWARD_CAMERA_POINT_CLOUD_CHANNEL = "DOWNWARD_POINT_CLOUD";
 
 // GNC messages
 const char* const STATE_CHANNEL = "STATE";
+const char* const STATE_LITE_CHANNEL = "STATE_LITE";
+const char* const STATE_COVARIANCE_REQUEST_CHANNEL = "STATE_COVARIANCE_REQUEST";
 const char* const IMU_CHANNEL = "IMU";
 const char* const HEIGHT_LIDAR_CHANNEL = "HLIDAR";
 const char* const PLANE_FIT_CHANNEL = "PLANE_FIT";
 const char* const GLOBAL_UPDATE_CHANNEL = "GLOBAL_UPDATE";
 const char* const VISUAL_ODOMETRY_CHANNEL = "VISUAL_ODOMETRY";
+const char* const ESTIMATOR_LATENCY_CHANNEL = "ESTIMATOR_LATENCY";
+const char* const ESTIMATOR_NOISE_CHANNEL = "ESTIMATOR_NOISE";
+const char* const GNC_METRICS_CHANNEL = "GNC_METRICS";
+const char* const SMOOTHED_STATE_CHANNEL = "SMOOTHED_STATE";
 
 const char* const SIM_IMU_CHANNEL = "SIM_IMU";
 const char* const SIM_HEIGHT_LIDAR_CHANNEL = "SIM_HLIDAR";
@@ -57,6 +63,7 @@ const char* const ATTITUDE_TARGET_CHANNEL = "ATTITUDE_TARGET";
 const char* const CAMERA_POS_CHANNEL = "CAMERA_POS_CHANNEL";
 const char* const OCCUPANCY_MAP_HEARTBEAT_CHANNEL = "OCCUPANCY_MAP_HEARTBEAT_CHANNEL";
 const char* const OCCUPANCY_MAP_CHANNEL = "OCCUPANCY_MAP_CHANNEL";
+const char* const OCCUPANCY_MAP_DELTA_CHANNEL = "OCCUPANCY_MAP_DELTA_CHANNEL";
 const char* const STATE_FORWARD_HEARTBEAT_CHANNEL = "STATE_FORWARD_HEARTBEAT_CHANNEL"; 
 
 // clang-format on
@@ -34,7 +34,7 @@ StatusFrame::StatusFrame(GlibZCM& zcm, const GCSConsts& consts_in)
 	: Gtk::Frame("Status"),
 	  CONSTS{consts_in},
 	  path_planner{zcm, NAV_RUNSTATE_STAT, "Mission Planner:", CONSTS},
-	  localization{zcm, STATE_CHANNEL, "Localization:", CONSTS},
+	  localization{zcm, CONSTS},
 	  line_det{zcm, VISION_STAT, "Line Det.:", CONSTS},
 	  roomba_det{zcm, VISION_STAT, "Roomba Det.:", CONSTS},
 	  obstacle_det{zcm, OBST_HEARTBEAT_CHANNEL, "Obstacle Det.:", CONSTS},
@@ -1,4 +1,8 @@
+#include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
 
 #include <gnc/Estimator.hpp>
 #include <gnc/State.hpp>
@@ -11,14 +15,89 @@ namespace gnc
 {
 using namespace kalman;
 
-Estimator::Estimator(YAML::Node config)
-    : empty_state_(0),
+namespace
+{
+/**
+ * Diagonal of the configured Q scaled by config["adaptive"][key], or of Q itself if adaptation is
+ * disabled
+ */
+template <class Scalar>
+typename StateT<Scalar>::ErrorStateVector scaledProcessNoise(YAML::Node config, const char* key)
+{
+    const YAML::Node adaptive = config["adaptive"];
+    const bool enabled = adaptive && adaptive["enabled"] && adaptive["enabled"].as<bool>();
+    const double scale = enabled ? adaptive[key].as<double>() : 1.0;
+    return (scale * processNoise(config).diagonal()).template cast<Scalar>();
+}
+}  // namespace
+
+template <class Scalar>
+EstimatorT<Scalar>::EstimatorT(YAML::Node config)
+    : empty_state_(State::zero(0)),
+      filter_(config["filter"] ? parseFilterType(config["filter"].as<std::string>())
+                               : FilterType::UKF),
       history_(config["history"], config["state"]),
       prediction_(config["prediction"]),
+      eskf_prediction_(config["prediction"]),
       lidar_update_(config["updates"]),
       planefit_update_(config["updates"]),
-      global_update_(config["updates"])
+      global_update_(config["updates"]),
+      joint_update_(config["updates"], lidar_update_, planefit_update_, global_update_),
+      visual_odometry_update_(config["updates"], config["history"]["size"].as<size_t>()),
+      max_replay_steps_(0),
+      replay_pending_(false),
+      replay_from_(0),
+      filter_period_usec_(0),
+      process_noise_(processNoise(config["prediction"])),
+      max_preintegration_samples_(0),
+      forward_state_(0),
+      smoother_(config["smoother"], config["prediction"], config["history"]["size"].as<size_t>()),
+      adaptive_Q_(config["prediction"]["adaptive"], process_noise_.diagonal().cast<Scalar>(),
+          scaledProcessNoise<Scalar>(config["prediction"], "min_scale"),
+          scaledProcessNoise<Scalar>(config["prediction"], "max_scale")),
+      predicted_(0),
+      filter_time_(Metrics::instance().histogram("estimator.filter_usec")),
+      predict_time_(Metrics::instance().histogram("estimator.predict_usec")),
+      update_time_(Metrics::instance().histogram("estimator.update_usec")),
+      replay_depth_(Metrics::instance().histogram("estimator.replay_depth_usec")),
+      replay_steps_(Metrics::instance().histogram("estimator.replay_steps")),
+      replay_backlog_(Metrics::instance().gauge("estimator.replay_backlog_steps"))
 {
+    if (config["max_replay_steps"])
+    {
+        max_replay_steps_ = config["max_replay_steps"].as<size_t>();
+        // One step propagates the newest snapshot and one more is needed to keep up with it, so
+        // smaller bounds never catch up with a delayed measurement
+        if (max_replay_steps_ > 0 && max_replay_steps_ < 3)
+        {
+            throw std::runtime_error("max_replay_steps must be 0 (unbounded) or at least 3");
+        }
+    }
+
+    if (config["filter_rate"])
+    {
+        const double filter_rate = config["filter_rate"].as<double>();
+        if (filter_rate < 0)
+        {
+            throw std::runtime_error("filter_rate must not be negative");
+        }
+        if (filter_rate > 0)
+        {
+            filter_period_usec_ = static_cast<uint64_t>(std::round(1e6 / filter_rate));
+        }
+    }
+
+    lidar_update_.set_filter(filter_);
+    planefit_update_.set_filter(filter_);
+    global_update_.set_filter(filter_);
+    visual_odometry_update_.set_filter(filter_);
+
+    std::cout << "Filter:           ";
+    if (filter_ == FilterType::ESKF)
+        std::cout << "ESKF\n";
+    else
+        std::cout << "UKF\n";
+
     std::cout << "Lidar Update:     ";
     if (lidar_update_.enabled())
         std::cout << "ENABLED\n";
@@ -36,40 +115,317 @@ Estimator::Estimator(YAML::Node config)
         std::cout << "ENABLED\n";
     else
         std::cout << "DISABLED\n";
+
+    std::cout << "Visual Odometry:  ";
+    if (visual_odometry_update_.enabled())
+        std::cout << "ENABLED\n";
+    else
+        std::cout << "DISABLED\n";
+
+    std::cout << "Joint Update:     ";
+    if (filter_ == FilterType::UKF && joint_update_.enabled())
+        std::cout << "ENABLED\n";
+    else
+        std::cout << "DISABLED\n";
+
+    std::cout << "Smoother:         ";
+    if (smoother_.enabled())
+        std::cout << "ENABLED\n";
+    else
+        std::cout << "DISABLED\n";
+
+    std::cout << "Adaptive Noise:   ";
+    if (adaptiveNoise())
+        std::cout << "ENABLED\n";
+    else
+        std::cout << "DISABLED\n";
 }
 
-const State& Estimator::add_measurement_set(const MeasurementSet& meas)
+template <class Scalar>
+const StateT<Scalar>& EstimatorT<Scalar>::add_measurement_set(const MeasurementSet& meas)
 {
-    auto it_pair = history_.add_measurement(meas);
-    History::Iterator begin = it_pair.first;
-    History::Iterator end = it_pair.second;
+    if (filter_period_usec_ == 0)
+    {
+        return filter(meas);
+    }
+
+    if (!preintegration_)
+    {
+        // The first sample only starts the history
+        const State& state = filter(meas);
+        startPreintegration(*meas.imu);
+        return state;
+    }
+
+    preintegration_->integrate(*meas.imu);
+
+    // Other sensors wait for the next filter step
+    history_.queue(meas);
+
+    if (meas.imu->time_usec - preintegration_->startTime() < filter_period_usec_)
+    {
+        const State& last = std::prev(history_.end())->state;
+        forward_state_ = last;
+        preintegration_->predict(last, forward_state_);
+        forward_state_.setTime(meas.imu->time_usec);
+        return forward_state_;
+    }
+
+    pending_.imu = meas.imu;
+    max_preintegration_samples_ =
+        std::max(max_preintegration_samples_, preintegration_->samples().size());
+    pending_.imu_preintegration = std::move(preintegration_);
+    const State& state = filter(pending_);
+    pending_ = MeasurementSet();
+    startPreintegration(*meas.imu);
+    return state;
+}
+
+template <class Scalar>
+void EstimatorT<Scalar>::queue_measurement_set(const MeasurementSet& meas)
+{
+    history_.queue(meas);
+}
+
+template <class Scalar>
+void EstimatorT<Scalar>::startPreintegration(const measurements::ImuMeasurement& imu)
+{
+    const State& last = std::prev(history_.end())->state;
+    preintegration_ = history_.measurementPool().imu_preintegration.acquire();
+    preintegration_->reset(imu, last.gyroBias().template cast<double>(),
+        last.accelBias().template cast<double>(), process_noise_);
+    preintegration_->reserve(max_preintegration_samples_);
+}
+
+template <class Scalar>
+const StateT<Scalar>& EstimatorT<Scalar>::filter(const MeasurementSet& meas)
+{
+    const Metrics::ScopedTimer timer(filter_time_);
+
+    // Snapshots still waiting to be replayed must not be trimmed from the history
+    const uint64_t keep_time = replay_pending_ ? replay_from_ : UINT64_MAX;
+    // Newest snapshot with a filtered state. Those added after it only have a time.
+    const uint64_t tail_time = history_.size() > 0 ? std::prev(history_.end())->get_time() : 0;
+    auto it_pair = history_.add_measurement(meas, keep_time);
+    typename History::Iterator begin = it_pair.first;
+    typename History::Iterator end = it_pair.second;
 
     if (begin == end)
     {
         return empty_state_;
     }
 
-    History::Iterator prev, next;
-    next = prev = begin;
-    next++;
+    typename History::Iterator last = std::prev(end);
+    replay_stats_.last_depth_usec = last->get_time() - begin->get_time();
+    replay_stats_.max_depth_usec =
+        std::max(replay_stats_.max_depth_usec, replay_stats_.last_depth_usec);
+
+    // Merge the new correction with whatever is left over from earlier ticks
+    if (!replay_pending_ || begin->get_time() < replay_from_)
+    {
+        replay_from_ = begin->get_time();
+    }
+    typename History::Iterator prev = history_.lower_bound(replay_from_);
 
-    while (next != end)
+    size_t remaining = static_cast<size_t>(std::distance(prev, last));
+    size_t budget = remaining;
+    const typename History::Iterator tail = history_.lower_bound(tail_time);
+    if (max_replay_steps_ > 0 && remaining > max_replay_steps_)
     {
-        prediction_(prev, next);
+        // Leave the steps that carry the old tail forward to the newest snapshot. Only more
+        // snapshots added past the tail than max_replay_steps leave nothing to replay.
+        const size_t extrapolation = static_cast<size_t>(std::distance(tail, last));
+        budget = max_replay_steps_ > extrapolation ? max_replay_steps_ - extrapolation : 0;
+        replay_stats_.deferred_ticks++;
+    }
 
-        lidar_update_(*next);
-        planefit_update_(*next);
-        global_update_(*next);
+    size_t steps = 0;
+    for (; steps < budget; steps++, prev++)
+    {
+        step(prev, std::next(prev));
+    }
 
-        prev++;
-        next++;
+    if (prev == last)
+    {
+        replay_pending_ = false;
     }
-    return prev->state;
+    else
+    {
+        // Snapshots between prev and the old tail keep their states from before the correction,
+        // and those added after the tail have none yet. The newest state is carried forward from
+        // the old tail, through every snapshot added after it.
+        for (typename History::Iterator it = tail; it != last; it++, steps++)
+        {
+            step(it, std::next(it));
+        }
+        // The replay never starts past the tail, so it is only done if it stopped there
+        replay_pending_ = prev != tail;
+        replay_from_ = prev->get_time();
+    }
+
+    replay_stats_.last_steps = steps;
+    replay_stats_.max_steps = std::max(replay_stats_.max_steps, steps);
+    replay_stats_.total_steps += steps;
+    replay_stats_.backlog_steps =
+        replay_pending_ ? static_cast<size_t>(std::distance(prev, last)) : 0;
+
+    replay_depth_.add(static_cast<int64_t>(replay_stats_.last_depth_usec));
+    replay_steps_.add(static_cast<int64_t>(steps));
+    replay_backlog_.set(static_cast<double>(replay_stats_.backlog_steps));
+
+    // Only smooth once every snapshot has been re-filtered
+    if (!replay_pending_) smoother_.submit(history_);
+
+    return last->state;
 }
 
-void Estimator::setBiases(const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias)
+template <class Scalar>
+void EstimatorT<Scalar>::step(
+    const typename History::Iterator prev, const typename History::Iterator next)
+{
+    {
+        const Metrics::ScopedTimer timer(predict_time_);
+        if (filter_ == FilterType::ESKF)
+        {
+            eskf_prediction_(prev, next);
+        }
+        else
+        {
+            prediction_(prev, next);
+        }
+    }
+
+    if (adaptive_Q_.enabled()) predicted_.copyMean(next->state);
+
+    {
+        const Metrics::ScopedTimer timer(update_time_);
+        if (filter_ == FilterType::UKF && joint_update_.enabled())
+        {
+            joint_update_(*next);
+        }
+        else
+        {
+            lidar_update_(*next);
+            planefit_update_(*next);
+            global_update_(*next);
+        }
+        // Needs the corrected state of an earlier snapshot, so it is not part of the joint update
+        visual_odometry_update_(*next);
+    }
+
+    if (adaptive_Q_.enabled()) adaptProcessNoise(*next);
+}
+
+template <class Scalar>
+void EstimatorT<Scalar>::adaptProcessNoise(const typename History::Snapshot& snapshot)
+{
+    const typename State::ErrorStateVector correction = snapshot.state - predicted_;
+
+    // A preintegrated step spans every IMU interval since the last filter step
+    const ImuPreintegration* preintegration = snapshot.measurement.imu_preintegration.get();
+    const Scalar intervals =
+        preintegration ? static_cast<Scalar>(preintegration->samples().size() - 1) : Scalar(1);
+
+    if (!adaptive_Q_.add(snapshot.get_time(), correction.cwiseAbs2(),
+            State::ErrorStateVector::Zero(), intervals))
+    {
+        return;
+    }
+
+    const typename State::CovarianceMatrix Q = adaptive_Q_.estimate().asDiagonal();
+    prediction_.setProcessNoise(Q);
+    eskf_prediction_.setProcessNoise(Q);
+    process_noise_ = Q.template cast<double>();
+}
+
+template <class Scalar>
+measurements::MeasurementPool& EstimatorT<Scalar>::measurementPool()
+{
+    return history_.measurementPool();
+}
+
+template <class Scalar>
+const typename EstimatorT<Scalar>::ReplayStats& EstimatorT<Scalar>::replayStats() const
+{
+    return replay_stats_;
+}
+
+template <class Scalar>
+kalman::MeasurementQueue::Stats EstimatorT<Scalar>::queueStats() const
+{
+    return history_.queueStats();
+}
+
+template <class Scalar>
+FilterType EstimatorT<Scalar>::filter() const
+{
+    return filter_;
+}
+
+template <class Scalar>
+bool EstimatorT<Scalar>::adaptiveNoise() const
+{
+    return adaptive_Q_.enabled() || lidar_update_.adaptive() || planefit_update_.adaptive() ||
+           global_update_.adaptive() || visual_odometry_update_.adaptive();
+}
+
+template <class Scalar>
+typename EstimatorT<Scalar>::Noise EstimatorT<Scalar>::noise() const
+{
+    Noise noise;
+    noise.Q = adaptive_Q_.estimate().template cast<double>();
+    noise.lidar_R = lidar_update_.R().diagonal().template cast<double>();
+    noise.plane_fit_R = planefit_update_.R().diagonal().template cast<double>();
+    noise.global_update_R = global_update_.R().diagonal().template cast<double>();
+    noise.visual_odometry_R = visual_odometry_update_.R().diagonal().template cast<double>();
+    return noise;
+}
+
+template <class Scalar>
+FixedLagSmootherT<Scalar>& EstimatorT<Scalar>::smoother()
+{
+    return smoother_;
+}
+
+template <class Scalar>
+size_t EstimatorT<Scalar>::takeLogLikelihood(double& log_likelihood)
+{
+    return lidar_update_.takeLogLikelihood(log_likelihood) +
+           planefit_update_.takeLogLikelihood(log_likelihood) +
+           global_update_.takeLogLikelihood(log_likelihood) +
+           visual_odometry_update_.takeLogLikelihood(log_likelihood);
+}
+
+template <class Scalar>
+bool EstimatorT<Scalar>::adopt(EstimatorT& other)
+{
+    if (history_.size() != other.history_.size()) return false;
+    for (auto it = history_.begin(), other_it = other.history_.begin(); it != history_.end();
+         ++it, ++other_it)
+    {
+        if (it->get_time() != other_it->get_time()) return false;
+    }
+
+    for (auto it = history_.begin(), other_it = other.history_.begin(); it != history_.end();
+         ++it, ++other_it)
+    {
+        it->state = other_it->state;
+    }
+    visual_odometry_update_.adopt(other.visual_odometry_update_);
+    forward_state_ = other.forward_state_;
+    replay_pending_ = other.replay_pending_;
+    replay_from_ = other.replay_from_;
+    return true;
+}
+
+template <class Scalar>
+void EstimatorT<Scalar>::setBiases(
+    const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias)
 {
     history_.setInitialBiases(gyro_bias, accel_bias);
 }
+
+template class EstimatorT<double>;
+template class EstimatorT<float>;
 }  // namespace gnc
 }  // namespace maav
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <gnc/EstimatorBank.hpp>
+
+using maav::gnc::measurements::MeasurementSet;
+
+namespace maav
+{
+namespace gnc
+{
+namespace
+{
+bool isEnabled(YAML::Node config) { return config && config["enabled"].as<bool>(); }
+
+/**
+ * Config of a hypothesis: the estimator config with the global update keys overridden
+ */
+YAML::Node hypothesisConfig(YAML::Node config, YAML::Node overrides)
+{
+    YAML::Node hypothesis = YAML::Clone(config);
+    for (const auto& entry : overrides)
+    {
+        hypothesis["updates"]["global_update"][entry.first.as<std::string>()] = entry.second;
+    }
+    return hypothesis;
+}
+}  // namespace
+
+template <class Scalar>
+EstimatorBankT<Scalar>::EstimatorBankT(YAML::Node config)
+    : fade_(0),
+      switch_margin_(0),
+      selected_(0),
+      switches_(Metrics::instance().counter("bank.switches")),
+      selected_gauge_(Metrics::instance().gauge("bank.selected"))
+{
+    const YAML::Node bank = config["bank"];
+    if (!isEnabled(bank))
+    {
+        hypotheses_.push_back(std::make_unique<Estimator>(config));
+    }
+    else
+    {
+        for (const YAML::Node& overrides : bank["hypotheses"])
+        {
+            hypotheses_.push_back(std::make_unique<Estimator>(hypothesisConfig(config, overrides)));
+        }
+        if (hypotheses_.empty())
+        {
+            throw std::runtime_error("bank needs at least one hypothesis");
+        }
+        fade_ = bank["fade"].as<double>();
+        switch_margin_ = bank["switch_margin"].as<double>();
+    }
+
+    scores_.assign(hypotheses_.size(), 0);
+    states_.assign(hypotheses_.size(), nullptr);
+    if (hypotheses_.size() > 1)
+    {
+        const size_t threads = bank["threads"] ? bank["threads"].as<size_t>()
+                                               : hypotheses_.size() - 1;
+        pool_ = std::make_unique<ThreadPool>(threads);
+    }
+}
+
+template <class Scalar>
+const StateT<Scalar>& EstimatorBankT<Scalar>::add_measurement_set(const MeasurementSet& meas)
+{
+    if (hypotheses_.size() == 1)
+    {
+        return hypotheses_.front()->add_measurement_set(meas);
+    }
+
+    auto run = [this, &meas](size_t i) { states_[i] = &hypotheses_[i]->add_measurement_set(meas); };
+    pool_->parallel_for(hypotheses_.size(), run);
+
+    updateScores();
+    return *states_[selected_.load()];
+}
+
+template <class Scalar>
+void EstimatorBankT<Scalar>::updateScores()
+{
+    bool scored = false;
+    for (size_t i = 0; i < hypotheses_.size(); i++)
+    {
+        double log_likelihood = 0;
+        if (hypotheses_[i]->takeLogLikelihood(log_likelihood) > 0)
+        {
+            scores_[i] = fade_ * scores_[i] + log_likelihood;
+            scored = true;
+        }
+    }
+    if (!scored) return;
+
+    size_t selected = selected_.load();
+    const size_t best = static_cast<size_t>(
+        std::distance(scores_.begin(), std::max_element(scores_.begin(), scores_.end())));
+    if (best != selected && scores_[best] > scores_[selected] + switch_margin_)
+    {
+        selected = best;
+        selected_ = best;
+        switches_.add();
+        selected_gauge_.set(static_cast<double>(best));
+    }
+
+    for (size_t i = 0; i < hypotheses_.size(); i++)
+    {
+        if (i == selected || scores_[i] >= scores_[selected] - switch_margin_) continue;
+        if (hypotheses_[i]->adopt(*hypotheses_[selected])) scores_[i] = scores_[selected];
+    }
+}
+
+template <class Scalar>
+void EstimatorBankT<Scalar>::queue_measurement_set(const MeasurementSet& meas)
+{
+    for (auto& hypothesis : hypotheses_) hypothesis->queue_measurement_set(meas);
+}
+
+template <class Scalar>
+void EstimatorBankT<Scalar>::setBiases(
+    const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias)
+{
+    for (auto& hypothesis : hypotheses_) hypothesis->setBiases(gyro_bias, accel_bias);
+}
+
+template <class Scalar>
+measurements::MeasurementPool& EstimatorBankT<Scalar>::measurementPool()
+{
+    return hypotheses_.front()->measurementPool();
+}
+
+template <class Scalar>
+void EstimatorBankT<Scalar>::setSmootherCallback(typename Smoother::Callback callback)
+{
+    for (size_t i = 0; i < hypotheses_.size(); i++)
+    {
+        hypotheses_[i]->smoother().setCallback(
+            [this, i, callback](const typename Smoother::Trajectory& trajectory) {
+                if (i == selected_.load()) callback(trajectory);
+            });
+    }
+}
+
+template class EstimatorBankT<double>;
+template class EstimatorBankT<float>;
+}  // namespace gnc
+}  // namespace maav
@@ -1,11 +1,11 @@
 #include <gnc/OccupancyMap.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <limits>
 #include <iostream>
 #include <Eigen/Dense>
-#include <pcl/point_cloud.h>
-#include <pcl/common/transforms.h>
 
 using std::string;
 using std::vector;
@@ -14,6 +14,7 @@ using std::numeric_limits;
 using Eigen::Matrix4d;
 using Eigen::Matrix4f;
 using Eigen::Vector3d;
+using Eigen::Vector3f;
 
 
 namespace maav
@@ -35,9 +36,14 @@ OccupancyMap::OccupancyMap(YAML::Node& config, YAML::Node& camera_config, zcm::Z
      point_cloud_min_z_(config["point_cloud_min_z"].as<double>()),
      point_cloud_max_z_(config["point_cloud_max_z"].as<double>()),
     compress_map_(config["compress"].as<bool>()),
-    point_mapper_{PointMapper(camera_config, zcm, config["simulator"].as<bool>())}
+    inner_update_period_(std::max(1u, config["inner_update_period"].as<unsigned>())),
+    clouds_since_inner_update_(0),
+    pose_timeout_(std::chrono::milliseconds(config["pose_timeout"].as<int64_t>())),
+    point_mapper_{PointMapper(camera_config, zcm, config["simulator"].as<bool>())},
+    inserter_(config["insert_threads"].as<size_t>(), max_range_)
 {
     octree_ = make_shared<octomap::OcTree>(map_res_);
+    octree_->enableChangeDetection(true);
     // octree_->setProbHit(prob_hit_);
     // octree_->setProbMiss(prob_miss_);
     // octree_->setClampingThresMin(thresh_max_);
@@ -46,47 +52,51 @@ OccupancyMap::OccupancyMap(YAML::Node& config, YAML::Node& camera_config, zcm::Z
     std::cout << "ProbMiss : " << octree_->getProbMiss() << std::endl;
     std::cout << "ClampingThreshMin : " << octree_->getClampingThresMin() << std::endl;
     std::cout << "ClampingThreshMax : " << octree_->getClampingThresMax() << std::endl;
-    cloud_filters_.resize(3);
-    cloud_filters_[0].setFilterFieldName("x");
-    cloud_filters_[0].setFilterLimits(point_cloud_min_x_, point_cloud_max_x_);
-    cloud_filters_[1].setFilterFieldName("y");
-    cloud_filters_[1].setFilterLimits(point_cloud_min_y_, point_cloud_max_y_);
-    cloud_filters_[2].setFilterFieldName("z");
-    cloud_filters_[2].setFilterLimits(point_cloud_min_z_, point_cloud_max_z_);
 }
 
-void OccupancyMap::update(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, uint64_t utime)
+void OccupancyMap::update(const point_cloud_t& cloud)
 {
-    for (auto& cf : cloud_filters_)
-    {
-        cf.setInputCloud(cloud);
-        cf.filter(*cloud);
-    }
-    
-    pcl::PointCloud<pcl::PointXYZ>::Ptr world_cloud = point_mapper_.transformCloud(cloud, utime);
-    Vector3d camera_origin = point_mapper_.getCameraOrigin(utime);
-    
+    Matrix4d camera_to_world;
+    if (!point_mapper_.getCameraToWorld(cloud.utime, pose_timeout_, camera_to_world)) return;
+    downsample(cloud, camera_to_world);
+    const Vector3d camera_origin = camera_to_world.topRightCorner<3, 1>();
 
-    // octomap pointcloud type
-    octomap::Pointcloud pc;
-    for (unsigned i = 0; i < world_cloud->size(); ++i)
-    {
-        const auto pt = (*world_cloud)[i];
-        pc.push_back(pt.x, pt.y, pt.z);
-    }
     // octomap point type
     octomap::point3d sensor_origin(camera_origin(0), camera_origin(1), camera_origin(2));
 
     // octomap point cloud insertion
-    octree_->insertPointCloud(pc, sensor_origin, max_range_, true, true);
-    //octree_->insertPointCloud(pc, sensor_origin, frame_origin, max_range_, false, true);
-    octree_->updateInnerOccupancy();
-    if (compress_map_) octree_->prune();
+    inserter_.insert(*octree_, points_, sensor_origin);
+    // Both run over the whole tree, so they are deferred to a lower rate than the clouds
+    if (++clouds_since_inner_update_ >= inner_update_period_)
+    {
+        octree_->updateInnerOccupancy();
+        if (compress_map_) octree_->prune();
+        clouds_since_inner_update_ = 0;
+    }
+}
+
+void OccupancyMap::downsample(const point_cloud_t& cloud, const Matrix4d& camera_to_world)
+{
+    const Matrix4f transform = camera_to_world.cast<float>();
+    voxels_.clear();
+    points_.clear();
+    for (const point_t& pt : cloud.point_cloud)
+    {
+        // Written so that NaN points are cropped too
+        if (!(pt.x >= point_cloud_min_x_ && pt.x <= point_cloud_max_x_ &&
+                pt.y >= point_cloud_min_y_ && pt.y <= point_cloud_max_y_ &&
+                pt.z >= point_cloud_min_z_ && pt.z <= point_cloud_max_z_))
+        {
+            continue;
+        }
+
+        const Vector3f world = transform.topLeftCorner<3, 3>() * Vector3f(pt.x, pt.y, pt.z) +
+            transform.topRightCorner<3, 1>();
+        octomap::OcTreeKey key;
+        if (!octree_->coordToKeyChecked(world.x(), world.y(), world.z(), key)) continue;
+        if (voxels_.insert(key).second) points_.push_back(octree_->keyToCoord(key));
+    }
 }
-/*
-* TODO:
-* Optimize code with a concurrent filter - concurrent filter doesn't exist in PCL. Maybe we can template
-*/
 
 }
 }
@@ -0,0 +1,93 @@
+#include <gnc/RayInserter.hpp>
+
+using octomap::KeySet;
+using octomap::OcTree;
+using octomap::OcTreeKey;
+using octomap::Pointcloud;
+using octomap::point3d;
+
+namespace maav
+{
+namespace gnc
+{
+namespace
+{
+// Chunks per thread, so threads finishing early pick up the rest of the cloud
+constexpr size_t CHUNKS_PER_THREAD = 4;
+}  // namespace
+
+RayInserter::RayInserter(size_t num_threads, double max_range)
+    : pool_(num_threads), max_range_(max_range), chunks_((num_threads + 1) * CHUNKS_PER_THREAD)
+{
+}
+
+void RayInserter::insert(OcTree& tree, const Pointcloud& cloud, const point3d& origin)
+{
+    const size_t num_points = cloud.size();
+    const size_t num_chunks = chunks_.size();
+    auto cast = [&](size_t i) {
+        castRays(tree, cloud, origin, i * num_points / num_chunks,
+            (i + 1) * num_points / num_chunks, chunks_[i]);
+    };
+    pool_.parallel_for(num_chunks, cast);
+
+    // A voxel is occupied if any ray ended in it, even if others passed through it
+    KeySet& occupied = chunks_.front().occupied;
+    for (size_t i = 1; i < num_chunks; ++i)
+    {
+        occupied.insert(chunks_[i].occupied.begin(), chunks_[i].occupied.end());
+    }
+    free_.clear();
+    for (const Chunk& chunk : chunks_)
+    {
+        for (const OcTreeKey& key : chunk.free)
+        {
+            if (occupied.find(key) == occupied.end()) free_.insert(key);
+        }
+    }
+
+    for (const OcTreeKey& key : free_)
+    {
+        tree.updateNode(key, false, true);
+    }
+    for (const OcTreeKey& key : occupied)
+    {
+        tree.updateNode(key, true, true);
+    }
+}
+
+void RayInserter::castRays(const OcTree& tree, const Pointcloud& cloud, const point3d& origin,
+    size_t begin, size_t end, Chunk& chunk) const
+{
+    chunk.endpoints.clear();
+    chunk.free.clear();
+    chunk.occupied.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+        OcTreeKey key;
+        if (!tree.coordToKeyChecked(cloud[i], key)) continue;
+        // Points falling in the same voxel cast the same ray, to the voxel's center
+        if (!chunk.endpoints.insert(key).second) continue;
+        const point3d point = tree.keyToCoord(key);
+        const double range = (point - origin).norm();
+        if (max_range_ < 0 || range <= max_range_)
+        {
+            chunk.occupied.insert(key);
+            if (tree.computeRayKeys(origin, point, chunk.ray))
+            {
+                chunk.free.insert(chunk.ray.begin(), chunk.ray.end());
+            }
+        }
+        else
+        {
+            const point3d cut = origin + (point - origin).normalized() * max_range_;
+            if (tree.computeRayKeys(origin, cut, chunk.ray))
+            {
+                chunk.free.insert(chunk.ray.begin(), chunk.ray.end());
+            }
+        }
+    }
+}
+
+}  // namespace gnc
+}  // namespace maav
@@ -1,167 +1,426 @@
+#include <cmath>
+
 #include <gnc/Constants.hpp>
 #include <gnc/State.hpp>
+#include <gnc/kalman/CholeskyUpdate.hpp>
 
 namespace maav
 {
 namespace gnc
 {
-State::State(uint64_t time_usec) : time_usec_(time_usec) {}
-State State::zero(uint64_t time_usec)
-{
-    State new_state(time_usec);
-    new_state.attitude() = Sophus::SO3d(Eigen::Quaterniond::Identity());
-    new_state.position() = Eigen::Vector3d::Zero();
-    new_state.velocity() = Eigen::Vector3d::Zero();
-    new_state.angularVelocity() = Eigen::Vector3d::Zero();
-    new_state.acceleration() = {0.0, 0.0, -constants::STANDARD_GRAVITY};
-    new_state.gyroBias() = Eigen::Vector3d::Zero();
-    new_state.accelBias() = Eigen::Vector3d::Zero();
+namespace
+{
+// The averaged vectors: everything packed before gravity, which is not estimated
+constexpr size_t MeanSize = 3 * State::GRAVITY;
+
+// Position and velocity side by side, matching their blocks of the error state
+template <class Scalar>
+using PositionVelocityT = Eigen::Matrix<Scalar, 3, 2>;
+
+template <class Scalar>
+using BiasesT = Eigen::Matrix<Scalar, 6, 1>;
+
+template <class Scalar>
+Eigen::Map<const Eigen::Matrix<Scalar, State::N, 1>> weightVector(
+    const typename StateT<Scalar>::Weights& weights)
+{
+    return Eigen::Map<const Eigen::Matrix<Scalar, State::N, 1>>(weights.data());
+}
+
+template <class Scalar>
+Eigen::Matrix<Scalar, 3, 1> standardGravity()
+{
+    return {0, 0, static_cast<Scalar>(-constants::STANDARD_GRAVITY)};
+}
+}  // namespace
+
+template <class Scalar>
+StateT<Scalar>::StateT(uint64_t time_usec) : time_usec_(time_usec)
+{
+}
+
+template <class Scalar>
+StateT<Scalar>::StateT(const StateT& other)
+    : time_usec_(other.time_usec_),
+      attitude_(other.attitude_),
+      vectors_(other.vectors_),
+      covar_(other.covar_),
+      sqrt_covar_(other.has_sqrt_covar_ ? std::make_unique<CovarianceMatrix>(*other.sqrt_covar_)
+                                        : nullptr),
+      has_sqrt_covar_(other.has_sqrt_covar_)
+{
+}
+
+template <class Scalar>
+StateT<Scalar>& StateT<Scalar>::operator=(const StateT& other)
+{
+    if (this == &other) return *this;
+    copyMean(other);
+    covar_ = other.covar_;
+    if (other.has_sqrt_covar_)
+    {
+        if (sqrt_covar_)
+        {
+            *sqrt_covar_ = *other.sqrt_covar_;
+        }
+        else
+        {
+            sqrt_covar_ = std::make_unique<CovarianceMatrix>(*other.sqrt_covar_);
+        }
+    }
+    has_sqrt_covar_ = other.has_sqrt_covar_;
+    return *this;
+}
+
+template <class Scalar>
+StateT<Scalar>& StateT<Scalar>::operator=(StateT&& other) noexcept
+{
+    copyMean(other);
+    covar_ = other.covar_;
+    // Trading factors keeps this state's storage alive in other rather than freeing it
+    if (other.has_sqrt_covar_) sqrt_covar_.swap(other.sqrt_covar_);
+    has_sqrt_covar_ = other.has_sqrt_covar_;
+    return *this;
+}
+
+template <class Scalar>
+StateT<Scalar> StateT<Scalar>::zero(uint64_t time_usec)
+{
+    StateT new_state(time_usec);
+    new_state.attitude() = SO3(Eigen::Quaternion<Scalar>::Identity());
+    new_state.position() = Vector3::Zero();
+    new_state.velocity() = Vector3::Zero();
+    new_state.angularVelocity() = Vector3::Zero();
+    new_state.acceleration() = standardGravity<Scalar>();
+    new_state.gyroBias() = Vector3::Zero();
+    new_state.accelBias() = Vector3::Zero();
     // The standard gravity vector
-    new_state.gravity() = {0.0, 0.0, -constants::STANDARD_GRAVITY};
+    new_state.gravity() = standardGravity<Scalar>();
     // Ann Arbor's Magnetic field in NED in microtesla
-    new_state.magneticFieldVector() = constants::ANN_ARBOR_MAGNETIC_FIELD;
+    new_state.magneticFieldVector() = constants::ANN_ARBOR_MAGNETIC_FIELD.cast<Scalar>();
     // Constant start
     new_state.covariance() = 0.00001 * CovarianceMatrix::Identity();
     return new_state;
 }
 
-State State::mean(const std::array<State, N>& sigma_points, const std::array<double, N>& weights)
+template <class Scalar>
+StateT<Scalar>::PackedPoints::PackedPoints(const std::array<StateT, N>& points)
+    : time_usec(points[0].timeUSec()), attitude(points[0].attitude())
 {
-    const State& first = sigma_points[0];
-    uint64_t time = first.timeUSec();
-    State mean_state = State::zero(time);
+    const SO3 attitude_inverse = attitude.inverse();
+    for (size_t i = 0; i < N; i++)
+    {
+        attitude_offsets.col(i) = (attitude_inverse * points[i].attitude()).log();
+        vectors.col(i) = points[i].packedVectors();
+    }
+}
+
+template <class Scalar>
+void StateT<Scalar>::mean(const PackedPoints& points, const Weights& weights, StateT& mean_state)
+{
+    mean_state.setTime(points.time_usec);
 
     // Use only the previous mean's transformed point because this is linear with respect to the
     // attitude
-    mean_state.attitude() = sigma_points[0].attitude();
-    for (size_t i = 0; i < sigma_points.size(); i++)
-    {
-        mean_state.position() += sigma_points[i].position() * weights[i];
-        mean_state.velocity() += sigma_points[i].velocity() * weights[i];
+    mean_state.attitude() = points.attitude;
 
-        mean_state.acceleration() += sigma_points[i].acceleration() * weights[i];
-        mean_state.angularVelocity() += sigma_points[i].angularVelocity() * weights[i];
+    // TODO: Determine if other values are necessary to average.
+    auto mean_vectors = mean_state.packedVectors().template head<MeanSize>();
+    const auto vectors = points.vectors.template topRows<MeanSize>();
+    mean_vectors.noalias() = vectors * weightVector<Scalar>(weights);
+    // The weighted sum always started from zero(), whose acceleration is standard gravity
+    mean_state.acceleration() += standardGravity<Scalar>();
 
-        // TODO: Determine if other values are necessary to average.
-        // TODO: Use other estimated parameters
-        // Propagate bias
-        mean_state.gyroBias() += sigma_points[i].gyroBias() * weights[i];
-        mean_state.accelBias() += sigma_points[i].accelBias() * weights[i];
-    }
-    return mean_state;
+    // TODO: Use other estimated parameters
+    mean_state.gravity() = standardGravity<Scalar>();
+    mean_state.magneticFieldVector() = constants::ANN_ARBOR_MAGNETIC_FIELD.cast<Scalar>();
 }
 
-State::CovarianceMatrix State::cov(const State& mean, const std::array<State, N>& sigma_points,
-    const std::array<double, N>& weights)
+template <class Scalar>
+typename StateT<Scalar>::Residuals StateT<Scalar>::residuals(
+    const StateT& mean, const PackedPoints& points)
 {
-    std::array<ErrorStateVector, N> points;
-    for (size_t i = 0; i < N; i++)
-    {
-        const State& state = sigma_points[i];
-        ErrorStateVector& e_state = points[i];
-        Eigen::Vector3d q_err = (mean.attitude().inverse() * state.attitude()).log();
-        e_state.segment<3>(0) = q_err;
-        e_state.segment<3>(3) = state.position();
-        e_state.segment<3>(6) = state.velocity();
-        e_state.segment<3>(9) = state.gyroBias();
-        e_state.segment<3>(12) = state.accelBias();
-
-        // TODO: add more states to estimate
-    }
-
-    ErrorStateVector mean_e_state;
-    Eigen::Vector3d q_err = Eigen::Vector3d::Zero();
-    mean_e_state.segment<3>(0) = q_err;
-    mean_e_state.segment<3>(3) = mean.position();
-    mean_e_state.segment<3>(6) = mean.velocity();
-    mean_e_state.segment<3>(9) = mean.gyroBias();
-    mean_e_state.segment<3>(12) = mean.accelBias();
-
-    CovarianceMatrix new_covariance = CovarianceMatrix::Zero();
-    for (size_t i = 0; i < sigma_points.size(); i++)
-    {
-        ErrorStateVector residual = points[i] - mean_e_state;
-        new_covariance += weights[i] * residual * residual.transpose();
-    }
+    // The mean attitude is the center point's, so the attitude offsets are already residuals
+    Residuals residuals;
+    residuals.template topRows<3>() = points.attitude_offsets;
+    residuals.template bottomRows<DoF - 3>() =
+        points.vectors.template topRows<DoF - 3>().colwise() -
+        mean.packedVectors().template head<DoF - 3>();
+    return residuals;
+}
 
+template <class Scalar>
+typename StateT<Scalar>::CovarianceMatrix StateT<Scalar>::cov(
+    const Residuals& residuals, const Weights& weights)
+{
+    const Residuals weighted = residuals * weightVector<Scalar>(weights).asDiagonal();
+    CovarianceMatrix new_covariance;
+    new_covariance.noalias() = weighted * residuals.transpose();
     return new_covariance;
 }
 
-State State::compute_gaussian(const std::array<State, N>& points,
-    const std::array<double, N>& m_weights, const std::array<double, N>& c_weights)
+template <class Scalar>
+StateT<Scalar> StateT<Scalar>::compute_gaussian(
+    const std::array<StateT, N>& points, const Weights& m_weights, const Weights& c_weights)
 {
-    State mu = State::mean(points, m_weights);
-    mu.covariance() = State::cov(mu, points, c_weights);
+    const PackedPoints packed(points);
+    StateT mu;
+    mean(packed, m_weights, mu);
+    mu.covariance() = cov(residuals(mu, packed), c_weights);
     return mu;
 }
 
-State& State::operator+=(const State::ErrorStateVector& e_state)
+template <class Scalar>
+void StateT<Scalar>::compute_sqrt_gaussian(const std::array<StateT, N>& points,
+    const Weights& m_weights, const Weights& c_weights, StateT& mu)
+{
+    const PackedPoints packed(points);
+    mean(packed, m_weights, mu);
+    const Residuals res = residuals(mu, packed);
+
+    // All but the center point share the same positive weight, so their contribution
+    // A^T * A factors directly through the R of A = QR
+    const Eigen::Map<const Eigen::Matrix<Scalar, N - 1, 1>> outer_weights(c_weights.data() + 1);
+    const Eigen::Matrix<Scalar, N - 1, DoF> A =
+        (res.template rightCols<N - 1>() * outer_weights.cwiseSqrt().asDiagonal()).transpose();
+    const Eigen::HouseholderQR<Eigen::Matrix<Scalar, N - 1, DoF>> qr(A);
+    const CovarianceMatrix R =
+        qr.matrixQR().template topRows<DoF>().template triangularView<Eigen::Upper>();
+    CovarianceMatrix L = R.transpose();
+    kalman::normalizeCholeskyFactor(L);
+
+    // The center weight is usually negative, which makes this a downdate
+    const Scalar w_0 = c_weights[0];
+    const ErrorStateVector center = std::sqrt(std::abs(w_0)) * res.col(0);
+    if (kalman::choleskyUpdate<DoF>(L, center, w_0 < 0))
+    {
+        mu.setSqrtCovariance(L);
+    }
+    else
+    {
+        mu.covariance() = cov(res, c_weights);
+        mu.clearSqrtCovariance();
+    }
+}
+
+template <class Scalar>
+StateT<Scalar>& StateT<Scalar>::operator+=(const ErrorStateVector& e_state)
 {
-    const Sophus::SO3d attitude_err = Sophus::SO3d::exp(e_state.head(3));
-    const Eigen::Vector3d position_err = e_state.segment<3>(3);
-    const Eigen::Vector3d velocity_err = e_state.segment<3>(6);
-    const Eigen::Vector3d gyro_bias_err = e_state.segment<3>(9);
-    const Eigen::Vector3d accel_bias_err = e_state.segment<3>(12);
+    using PositionVelocity = PositionVelocityT<Scalar>;
+    const SO3 attitude_err = SO3::exp(e_state.template head<3>());
 
-    position() += attitude() * position_err;
-    velocity() += attitude() * velocity_err;
+    // Position and velocity errors rotate in one product, the biases add in one pass
+    Eigen::Map<PositionVelocity> position_velocity(vectors_[POSITION].data());
+    position_velocity.noalias() +=
+        attitude().matrix() * Eigen::Map<const PositionVelocity>(e_state.data() + 3);
     attitude() *= attitude_err;
-    gyroBias() += gyro_bias_err;
-    accelBias() += accel_bias_err;
+    Eigen::Map<BiasesT<Scalar>>(vectors_[GYRO_BIAS].data()) += e_state.template tail<6>();
 
     return *this;
 }
 
-State::ErrorStateVector State::operator-(const State& other) const
+template <class Scalar>
+typename StateT<Scalar>::ErrorStateVector StateT<Scalar>::operator-(const StateT& other) const
 {
+    using PositionVelocity = PositionVelocityT<Scalar>;
+    using Biases = BiasesT<Scalar>;
+    const SO3 other_inverse = other.attitude().inverse();
+
     ErrorStateVector difference;
-    difference.segment<3>(0) = (other.attitude().inverse() * attitude()).log();
-    difference.segment<3>(3) = other.attitude().inverse() * (position() - other.position());
-    difference.segment<3>(6) = other.attitude().inverse() * (velocity() - other.velocity());
-    difference.segment<3>(9) = gyroBias() - other.gyroBias();
-    difference.segment<3>(12) = accelBias() - other.accelBias();
+    difference.template head<3>() = (other_inverse * attitude()).log();
+    Eigen::Map<PositionVelocity>(difference.data() + 3).noalias() =
+        other_inverse.matrix() *
+        (Eigen::Map<const PositionVelocity>(vectors_[POSITION].data()) -
+            Eigen::Map<const PositionVelocity>(other.vectors_[POSITION].data()));
+    difference.template tail<6>() = Eigen::Map<const Biases>(vectors_[GYRO_BIAS].data()) -
+                           Eigen::Map<const Biases>(other.vectors_[GYRO_BIAS].data());
 
     return difference;
 }
 
-Sophus::SE3d State::getPose() const
+template <class Scalar>
+typename StateT<Scalar>::SE3 StateT<Scalar>::getPose() const
 {
-    Sophus::SE3d pose;
+    SE3 pose;
     pose.so3() = attitude();
     pose.translation() = position();
     return pose;
 }
 
-void State::setPose(const Sophus::SE3d& pose)
+template <class Scalar>
+void StateT<Scalar>::setPose(const SE3& pose)
 {
     attitude() = pose.so3();
     position() = pose.translation();
 }
 
-const Sophus::SO3d& State::attitude() const { return attitude_; }
-Sophus::SO3d& State::attitude() { return attitude_; }
-const Eigen::Vector3d& State::angularVelocity() const { return angular_velocity_; }
-Eigen::Vector3d& State::angularVelocity() { return angular_velocity_; }
-const Eigen::Vector3d& State::position() const { return position_; }
-Eigen::Vector3d& State::position() { return position_; }
-const Eigen::Vector3d& State::velocity() const { return velocity_; }
-Eigen::Vector3d& State::velocity() { return velocity_; }
-const Eigen::Vector3d& State::acceleration() const { return acceleration_; }
-Eigen::Vector3d& State::acceleration() { return acceleration_; }
-void State::setTime(uint64_t usec) { time_usec_ = usec; }
-uint64_t State::timeUSec() const { return time_usec_; }
-double State::timeSec() const { return static_cast<double>(time_usec_) * constants::USEC_TO_SEC; }
-const Eigen::Vector3d& State::gyroBias() const { return gyro_bias_; }
-Eigen::Vector3d& State::gyroBias() { return gyro_bias_; }
-const Eigen::Vector3d& State::accelBias() const { return accel_bias_; }
-Eigen::Vector3d& State::accelBias() { return accel_bias_; }
-const Eigen::Vector3d& State::gravity() const { return gravity_; }
-Eigen::Vector3d& State::gravity() { return gravity_; }
-const Eigen::Vector3d& State::magneticFieldVector() const { return magnetic_field_; }
-Eigen::Vector3d& State::magneticFieldVector() { return magnetic_field_; }
-const State::CovarianceMatrix& State::covariance() const { return covar_; }
-State::CovarianceMatrix& State::covariance() { return covar_; }
-std::ostream& operator<<(std::ostream& os, const State& state)
+template <class Scalar>
+void StateT<Scalar>::copyMean(const StateT& other)
+{
+    time_usec_ = other.time_usec_;
+    attitude_ = other.attitude_;
+    vectors_ = other.vectors_;
+}
+
+template <class Scalar>
+const typename StateT<Scalar>::SO3& StateT<Scalar>::attitude() const
+{
+    return attitude_;
+}
+template <class Scalar>
+typename StateT<Scalar>::SO3& StateT<Scalar>::attitude()
+{
+    return attitude_;
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::angularVelocity() const
+{
+    return vectors_[ANGULAR_VELOCITY];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::angularVelocity()
+{
+    return vectors_[ANGULAR_VELOCITY];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::position() const
+{
+    return vectors_[POSITION];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::position()
+{
+    return vectors_[POSITION];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::velocity() const
+{
+    return vectors_[VELOCITY];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::velocity()
+{
+    return vectors_[VELOCITY];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::acceleration() const
+{
+    return vectors_[ACCELERATION];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::acceleration()
+{
+    return vectors_[ACCELERATION];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::gyroBias() const
+{
+    return vectors_[GYRO_BIAS];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::gyroBias()
+{
+    return vectors_[GYRO_BIAS];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::accelBias() const
+{
+    return vectors_[ACCEL_BIAS];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::accelBias()
+{
+    return vectors_[ACCEL_BIAS];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::gravity() const
+{
+    return vectors_[GRAVITY];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::gravity()
+{
+    return vectors_[GRAVITY];
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& StateT<Scalar>::magneticFieldVector() const
+{
+    return vectors_[MAGNETIC_FIELD];
+}
+template <class Scalar>
+typename StateT<Scalar>::Vector3& StateT<Scalar>::magneticFieldVector()
+{
+    return vectors_[MAGNETIC_FIELD];
+}
+template <class Scalar>
+Eigen::Map<const typename StateT<Scalar>::PackedVector, Eigen::AlignedMax>
+StateT<Scalar>::packedVectors() const
+{
+    static_assert(sizeof(Vector3) == 3 * sizeof(Scalar), "Vectors must pack densely");
+    return Eigen::Map<const PackedVector, Eigen::AlignedMax>(vectors_[0].data());
+}
+template <class Scalar>
+Eigen::Map<typename StateT<Scalar>::PackedVector, Eigen::AlignedMax> StateT<Scalar>::packedVectors()
+{
+    return Eigen::Map<PackedVector, Eigen::AlignedMax>(vectors_[0].data());
+}
+template <class Scalar>
+void StateT<Scalar>::setTime(uint64_t usec)
+{
+    time_usec_ = usec;
+}
+template <class Scalar>
+uint64_t StateT<Scalar>::timeUSec() const
+{
+    return time_usec_;
+}
+template <class Scalar>
+double StateT<Scalar>::timeSec() const
+{
+    return static_cast<double>(time_usec_) * constants::USEC_TO_SEC;
+}
+template <class Scalar>
+const typename StateT<Scalar>::CovarianceMatrix& StateT<Scalar>::covariance() const
+{
+    return covar_;
+}
+template <class Scalar>
+typename StateT<Scalar>::CovarianceMatrix& StateT<Scalar>::covariance()
+{
+    return covar_;
+}
+template <class Scalar>
+const typename StateT<Scalar>::CovarianceMatrix& StateT<Scalar>::sqrtCovariance() const
+{
+    return *sqrt_covar_;
+}
+template <class Scalar>
+bool StateT<Scalar>::hasSqrtCovariance() const
+{
+    return has_sqrt_covar_;
+}
+template <class Scalar>
+void StateT<Scalar>::setSqrtCovariance(const CovarianceMatrix& sqrt_covariance)
+{
+    if (sqrt_covar_)
+    {
+        *sqrt_covar_ = sqrt_covariance;
+    }
+    else
+    {
+        sqrt_covar_ = std::make_unique<CovarianceMatrix>(sqrt_covariance);
+    }
+    covar_.noalias() =
+        sqrt_covar_->template triangularView<Eigen::Lower>() * sqrt_covar_->transpose();
+    has_sqrt_covar_ = true;
+}
+template <class Scalar>
+void StateT<Scalar>::clearSqrtCovariance()
+{
+    has_sqrt_covar_ = false;
+}
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const StateT<Scalar>& state)
 {
     std::cout << "State - Attitude: " << state.attitude().unit_quaternion().w() << ' '
               << state.attitude().unit_quaternion().x() << ' '
@@ -183,5 +442,10 @@ std::ostream& operator<<(std::ostream& os, const State& state)
     return os;
 }
 
+template class StateT<double>;
+template class StateT<float>;
+template std::ostream& operator<<(std::ostream& os, const StateT<double>& state);
+template std::ostream& operator<<(std::ostream& os, const StateT<float>& state);
+
 }  // namespace gnc
 }  // namespace maav
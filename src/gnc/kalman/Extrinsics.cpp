@@ -10,24 +10,86 @@ namespace gnc
 {
 namespace kalman
 {
-Extrinsics::Extrinsics(YAML::Node config)
-    : twist_(config.as<Sophus::SE3d::Tangent>()),
-      pose_(Sophus::SE3d::exp(twist_)),
+namespace
+{
+/**
+ * The pose is built in double from the config and only then rounded to Scalar
+ */
+template <class Scalar>
+typename StateT<Scalar>::SE3 parsePose(YAML::Node config)
+{
+    const Sophus::SE3d pose = Sophus::SE3d::exp(config.as<Sophus::SE3d::Tangent>());
+    return typename StateT<Scalar>::SE3(
+        pose.so3().cast<Scalar>(), pose.translation().cast<Scalar>());
+}
+}  // namespace
+
+template <class Scalar>
+ExtrinsicsT<Scalar>::ExtrinsicsT(YAML::Node config)
+    : pose_(parsePose<Scalar>(config)),
       rot_(pose_.so3()),
-      pos_(pose_.translation())
+      pos_(pose_.translation()),
+      error_jacobian_(computeErrorJacobian(pose_))
 {
 }
 
-State Extrinsics::operator()(const State& state) const
+template <class Scalar>
+StateT<Scalar> ExtrinsicsT<Scalar>::operator()(const State& state) const
 {
     State sensor_state = state;
     sensor_state.setPose(state.getPose() * pose_);
     return sensor_state;
 }
 
-const Sophus::SE3d& Extrinsics::pose() const { return pose_; }
-const Sophus::SO3d& Extrinsics::rotation() const { return rot_; }
-const Eigen::Vector3d& Extrinsics::position() const { return pos_; }
+template <class Scalar>
+void ExtrinsicsT<Scalar>::operator()(const State& state, State& sensor_state) const
+{
+    sensor_state.copyMean(state);
+    sensor_state.setPose(state.getPose() * pose_);
+}
+
+template <class Scalar>
+typename StateT<Scalar>::CovarianceMatrix ExtrinsicsT<Scalar>::computeErrorJacobian(
+    const typename State::SE3& pose)
+{
+    using Matrix3 = Eigen::Matrix<Scalar, 3, 3>;
+
+    // The sensor attitude is R * R_e and its position is p + R * t_e. Errors of both are in the
+    // sensor frame, so they pick up a rotation by R_e^T, and an attitude error also moves the
+    // sensor by the lever arm t_e.
+    const Matrix3 R_e_T = pose.so3().matrix().transpose();
+
+    typename State::CovarianceMatrix J = State::CovarianceMatrix::Identity();
+    J.template block<3, 3>(0, 0) = R_e_T;
+    J.template block<3, 3>(3, 0) = -R_e_T * State::SO3::hat(pose.translation());
+    J.template block<3, 3>(3, 3) = R_e_T;
+    J.template block<3, 3>(6, 6) = R_e_T;
+    return J;
+}
+
+template <class Scalar>
+const typename StateT<Scalar>::SE3& ExtrinsicsT<Scalar>::pose() const
+{
+    return pose_;
+}
+template <class Scalar>
+const typename StateT<Scalar>::SO3& ExtrinsicsT<Scalar>::rotation() const
+{
+    return rot_;
+}
+template <class Scalar>
+const typename StateT<Scalar>::Vector3& ExtrinsicsT<Scalar>::position() const
+{
+    return pos_;
+}
+template <class Scalar>
+const typename StateT<Scalar>::CovarianceMatrix& ExtrinsicsT<Scalar>::errorJacobian() const
+{
+    return error_jacobian_;
+}
+
+template class ExtrinsicsT<double>;
+template class ExtrinsicsT<float>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <Eigen/Cholesky>
+
+#include <gnc/Constants.hpp>
+#include <gnc/kalman/FixedLagSmoother.hpp>
+#include <gnc/kalman/Prediction.hpp>
+#include <gnc/utils/Metrics.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+namespace
+{
+bool isEnabled(YAML::Node config) { return config && config["enabled"].as<bool>(); }
+
+uint64_t seconds(YAML::Node config, const char* key, double default_value)
+{
+    const double value = config && config[key] ? config[key].as<double>() : default_value;
+    return static_cast<uint64_t>(value * constants::SEC_TO_USEC);
+}
+
+uint64_t period(YAML::Node config)
+{
+    const double rate = config && config["rate"] ? config["rate"].as<double>() : 0;
+    return rate > 0 ? static_cast<uint64_t>(constants::SEC_TO_USEC / rate) : 0;
+}
+}  // namespace
+
+template <class Scalar>
+FixedLagSmootherT<Scalar>::FixedLagSmootherT(
+    YAML::Node config, YAML::Node prediction_config, size_t max_steps)
+    : enabled_(isEnabled(config)),
+      lag_usec_(seconds(config, "lag", 1)),
+      period_usec_(period(config)),
+      Q_(processNoise(prediction_config).cast<Scalar>()),
+      has_pending_(false),
+      last_submit_usec_(0),
+      submitted_(false),
+      skipped_(0),
+      stop_(false)
+{
+    if (!enabled_) return;
+
+    // Everything a window needs is allocated up front, so submit() only copies
+    pending_.steps.resize(max_steps);
+    working_.steps.resize(max_steps);
+    smoothed_.reserve(max_steps);
+
+    thread_ = std::thread(&FixedLagSmootherT::work, this);
+
+    // Only run in time the estimator leaves idle, so smoothing never preempts it
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(thread_.native_handle(), SCHED_IDLE, &param);
+}
+
+template <class Scalar>
+FixedLagSmootherT<Scalar>::~FixedLagSmootherT()
+{
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+template <class Scalar>
+void FixedLagSmootherT<Scalar>::setCallback(Callback callback)
+{
+    callback_ = std::move(callback);
+}
+
+template <class Scalar>
+bool FixedLagSmootherT<Scalar>::submit(HistoryT<Scalar>& history)
+{
+    if (!enabled_ || history.size() == 0) return false;
+
+    const uint64_t newest = std::prev(history.end())->get_time();
+    if (submitted_ && newest - last_submit_usec_ < period_usec_) return false;
+
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || has_pending_)
+    {
+        skipped_++;
+        return false;
+    }
+
+    typename HistoryT<Scalar>::Iterator begin =
+        history.lower_bound(newest > lag_usec_ ? newest - lag_usec_ : 0);
+    const size_t count = static_cast<size_t>(std::distance(begin, history.end()));
+    if (count > pending_.steps.size())
+    {
+        std::advance(begin, count - pending_.steps.size());
+    }
+
+    pending_.size = 0;
+    for (auto it = begin; it != history.end(); ++it)
+    {
+        Step& step = pending_.steps[pending_.size];
+        step.state.copyMean(it->state);
+        step.state.covariance() = it->state.covariance();
+        step.state.clearSqrtCovariance();
+        step.imu = *(it->measurement.imu);
+
+        // The interval leading to the oldest snapshot is never smoothed over
+        step.preintegrated = pending_.size > 0 && it->measurement.imu_preintegration;
+        if (step.preintegrated) step.preintegration = *(it->measurement.imu_preintegration);
+        pending_.size++;
+    }
+
+    has_pending_ = true;
+    last_submit_usec_ = newest;
+    submitted_ = true;
+    lock.unlock();
+    wake_.notify_one();
+    return true;
+}
+
+template <class Scalar>
+void FixedLagSmootherT<Scalar>::smooth(const Window& window, Trajectory& smoothed) const
+{
+    smoothed.resize(window.size);
+    if (window.size == 0) return;
+
+    smoothed.back() = window.steps[window.size - 1].state;
+
+    using CovarianceMatrix = typename State::CovarianceMatrix;
+    State prior;
+    CovarianceMatrix F;
+    CovarianceMatrix preintegrated_noise;
+    for (size_t k = window.size - 1; k-- > 0;)
+    {
+        const Step& step = window.steps[k];
+        const Step& next = window.steps[k + 1];
+        const State& filtered = step.state;
+
+        // Predict the next step again from the filtered state, like the ESKF
+        const CovarianceMatrix* noise = &Q_;
+        if (next.preintegrated)
+        {
+            next.preintegration.predict(filtered, prior);
+            F = next.preintegration.transition().template cast<Scalar>();
+            preintegrated_noise = next.preintegration.noise().template cast<Scalar>();
+            noise = &preintegrated_noise;
+        }
+        else
+        {
+            const double dt = static_cast<double>(next.imu.time_usec - step.imu.time_usec) *
+                              constants::USEC_TO_SEC;
+            integrateImu(filtered, step.imu, next.imu, dt, prior);
+            F = EskfPredictionT<Scalar>::errorJacobian(
+                filtered.gyroBias(), filtered.accelBias(), step.imu, next.imu, dt);
+        }
+        const CovarianceMatrix& P = filtered.covariance();
+        const CovarianceMatrix FP = F * P;
+        const CovarianceMatrix prior_P = FP * F.transpose() + *noise;
+
+        // G = P F^T prior_P^-1, and both covariances are symmetric
+        const CovarianceMatrix G = prior_P.ldlt().solve(FP).transpose();
+
+        const State& smoothed_next = smoothed[k + 1];
+        State& smoothed_state = smoothed[k];
+        smoothed_state = filtered;
+        smoothed_state += G * (smoothed_next - prior);
+        smoothed_state.covariance() =
+            P + G * (smoothed_next.covariance() - prior_P) * G.transpose();
+    }
+}
+
+template <class Scalar>
+uint64_t FixedLagSmootherT<Scalar>::skipped() const
+{
+    return skipped_;
+}
+
+template <class Scalar>
+void FixedLagSmootherT<Scalar>::work()
+{
+    Metrics::Histogram& smooth_time = Metrics::instance().histogram("smoother.smooth_usec");
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || has_pending_; });
+            if (stop_) return;
+
+            // Swapping keeps the memory of both windows
+            std::swap(pending_, working_);
+            has_pending_ = false;
+        }
+
+        {
+            const Metrics::ScopedTimer timer(smooth_time);
+            smooth(working_, smoothed_);
+        }
+        if (callback_) callback_(smoothed_);
+    }
+}
+
+template class FixedLagSmootherT<double>;
+template class FixedLagSmootherT<float>;
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -1,13 +1,17 @@
-#include <iostream>
+#include <algorithm>
 #include <iterator>
 #include <memory>
 
 #include <common/utils/yaml_matrix.hpp>
 #include <gnc/kalman/History.hpp>
+#include <gnc/kalman/ImuPreintegration.hpp>
+#include <gnc/utils/Metrics.hpp>
 
 using maav::gnc::measurements::ImuMeasurement;
 using maav::gnc::measurements::Measurement;
+using maav::gnc::measurements::MeasurementPool;
 using maav::gnc::measurements::MeasurementSet;
+using maav::gnc::measurements::VisualOdometryMeasurement;
 using std::pair;
 
 namespace maav
@@ -16,9 +20,104 @@ namespace gnc
 {
 namespace kalman
 {
-History::History(YAML::Node config, YAML::Node initial_state_config)
+namespace
+{
+/**
+ * A measurement set adds one IMU snapshot and usually at most one interpolated snapshot per other
+ * sensor. resize() may also keep the history above its nominal size while old snapshots are still
+ * being re-filtered, so the buffer is allocated with room for both. Once it is full anyway,
+ * find_snapshot() refuses readings that need a new snapshot and append() evicts the oldest one,
+ * counting it on history.evicted.
+ */
+constexpr size_t SNAPSHOTS_PER_SET = 5;
+
+size_t bufferCapacity(size_t size) { return 2 * size + SNAPSHOTS_PER_SET; }
+
+/**
+ * Measurements held outside the history and its queue at any one time: the set being added, the
+ * set the estimator batches between filter steps and the one the caller is putting together.
+ */
+constexpr size_t MEASUREMENTS_IN_FLIGHT = 4;
+
+/**
+ * Time of a measurement popped off the queue, which holds a single reading
+ */
+uint64_t readingTime(const Measurement &reading)
+{
+    if (reading.lidar) return reading.lidar->timeUSec();
+    if (reading.plane_fit) return reading.plane_fit->time_usec;
+    if (reading.visual_odometry) return reading.visual_odometry->timeUSec();
+    return reading.global_update->timeUSec();
+}
+
+/**
+ * Puts a reading on a snapshot. A reading of the same sensor already there is replaced, and
+ * counted as dropped.
+ */
+template <class T>
+void placeReading(const std::shared_ptr<const T> &reading, std::shared_ptr<const T> &slot,
+    const Measurement &popped, MeasurementQueue &queue)
+{
+    if (!reading) return;
+    if (slot) queue.dropReplaced(popped);
+    slot = reading;
+}
+
+/**
+ * Each visual odometry reading moves from the frame of the one before, so replacing one would
+ * leave the next without a base. A reading that moves on from the one already on the snapshot is
+ * composed with it instead, into a single reading from the older base.
+ */
+void placeOdometry(const Measurement &reading, Measurement &snapshot, MeasurementQueue &queue,
+    MeasurementPool &pool)
+{
+    const std::shared_ptr<const VisualOdometryMeasurement> &next = reading.visual_odometry;
+    std::shared_ptr<const VisualOdometryMeasurement> &slot = snapshot.visual_odometry;
+    if (!next || !slot || next->baseTimeUSec() != slot->timeUSec())
+    {
+        placeReading(next, slot, reading, queue);
+        return;
+    }
+
+    const std::shared_ptr<VisualOdometryMeasurement> composed = pool.visual_odometry.acquire();
+    composed->setTime(next->timeUSec());
+    composed->setBaseTime(slot->baseTimeUSec());
+    composed->pose() = slot->pose() * next->pose();
+    // The error of the first motion is carried into the frame the second one ends in
+    const VisualOdometryMeasurement::CovarianceMatrix adjoint = next->pose().inverse().Adj();
+    composed->covariance() =
+        adjoint * slot->covariance() * adjoint.transpose() + next->covariance();
+    slot = composed;
+}
+
+void placeReading(const Measurement &reading, Measurement &snapshot, MeasurementQueue &queue,
+    MeasurementPool &pool)
+{
+    placeReading(reading.lidar, snapshot.lidar, reading, queue);
+    placeReading(reading.plane_fit, snapshot.plane_fit, reading, queue);
+    placeOdometry(reading, snapshot, queue, pool);
+    placeReading(reading.global_update, snapshot.global_update, reading, queue);
+}
+
+/**
+ * Counts a reading that could not be placed in the history, in both the queue's statistics and
+ * the history.late metric
+ */
+void dropLate(const Measurement &reading, MeasurementQueue &queue)
+{
+    static Metrics::Counter &late = Metrics::instance().counter("history.late");
+    late.add();
+    queue.dropLate(reading);
+}
+}  // namespace
+
+template <class Scalar>
+HistoryT<Scalar>::HistoryT(YAML::Node config, YAML::Node initial_state_config)
     : _size(config["size"].as<size_t>()),
       _tolerance(config["tolerance"].as<uint64_t>()),
+      _history(bufferCapacity(_size)),
+      _queue(config),
+      _pool(bufferCapacity(_size) + _queue.capacity() + MEASUREMENTS_IN_FLIGHT),
       _initial_state(State::zero(0))
 {
     Eigen::Vector4d initial_attitude = initial_state_config["attitude"].as<Eigen::Vector4d>();
@@ -29,155 +128,122 @@ History::History(YAML::Node config, YAML::Node initial_state_config)
     Eigen::Matrix<double, State::DoF, 1> diag_covariance =
         initial_state_config["covariance"].as<Eigen::Matrix<double, State::DoF, 1>>();
 
-    _initial_state.attitude() = Sophus::SO3d(Eigen::Quaterniond(initial_quat));
-    _initial_state.position() = initial_position;
-    _initial_state.velocity() = initial_velocity;
+    _initial_state.attitude() = Sophus::SO3d(Eigen::Quaterniond(initial_quat)).cast<Scalar>();
+    _initial_state.position() = initial_position.cast<Scalar>();
+    _initial_state.velocity() = initial_velocity.cast<Scalar>();
 
-    _initial_state.covariance() = Eigen::DiagonalMatrix<double, State::DoF>(diag_covariance);
+    _initial_state.covariance() =
+        Eigen::DiagonalMatrix<Scalar, State::DoF>(diag_covariance.template cast<Scalar>());
 }
 
-void printTimingWarning(std::string sensor)
-{
-    std::cout << "WARNING: " << sensor << " measurement was overriden. Are your timings correct?"
-              << std::endl;
-}
+template <class Scalar>
+void HistoryT<Scalar>::queue(const MeasurementSet &measurements) { _queue.push(measurements); }
 
-void History::moveMeasurements(const MeasurementSet &measurements)
-{
-    if (measurements.lidar)
-    {
-        if (_insert.lidar) printTimingWarning("lidar");
-        _insert.lidar = measurements.lidar;
-    }
-    if (measurements.plane_fit)
-    {
-        if (_insert.plane_fit) printTimingWarning("plane fitting");
-        _insert.plane_fit = measurements.plane_fit;
-    }
-    if (measurements.visual_odometry)
-    {
-        if (_insert.visual_odometry) printTimingWarning("visual odometry");
-        _insert.visual_odometry = measurements.visual_odometry;
-    }
-    if (measurements.global_update)
-    {
-        if (_insert.global_update) printTimingWarning("global update");
-        _insert.global_update = measurements.global_update;
-    }
-}
-
-pair<History::Iterator, History::Iterator> History::add_measurement(
-    const MeasurementSet &measurements)
+template <class Scalar>
+pair<typename HistoryT<Scalar>::Iterator, typename HistoryT<Scalar>::Iterator>
+HistoryT<Scalar>::add_measurement(
+    const MeasurementSet &measurements, uint64_t keep_time)
 {
     // Insert zero state if empty
     if (_history.empty())
     {
         uint64_t start_time = measurements.imu->time_usec;
-        Measurement start_measurement;
-        start_measurement.imu = measurements.imu;
         _initial_state.setTime(start_time);
 
-        _history.emplace_back(_initial_state, start_measurement);
+        append(measurements).state = _initial_state;
         return {_history.end(), _history.end()};
     }
 
     // Insert IMU first
     uint64_t imu_time = measurements.imu->time_usec;
-    Measurement imu_measurement;
-    imu_measurement.imu = measurements.imu;
-    _history.emplace_back(State(imu_time), imu_measurement);
-    auto last_modified = std::prev(_history.end());
+    append(measurements);
+
+    // Inserting interpolated snapshots shifts positions in the buffer, so the
+    // oldest modified snapshot is tracked by time instead of by iterator
+    uint64_t last_modified = imu_time;
 
     // Microsecond _tolerance to merge measurements
     // IMU will be running on a 10000 microsecond period
-
-    moveMeasurements(measurements);
-    if (_insert.lidar)
+    // Place everything the IMU has caught up with, oldest first. Readings within _tolerance past
+    // the newest snapshot still belong to it.
+    _queue.push(measurements);
+    Measurement reading;
+    while (_queue.pop(imu_time, imu_time + _tolerance, reading))
     {
-        uint64_t lidar_time = _insert.lidar->timeUSec();
-        auto snap_iter = find_snapshot(lidar_time);
-        if (snap_iter != _history.end())
+        auto snap_iter = find_snapshot(readingTime(reading));
+        if (snap_iter == _history.end())
         {
-            snap_iter->measurement.lidar = _insert.lidar;
-            _insert.lidar = nullptr;
-            last_modified = set_last_modified(last_modified, snap_iter);
+            dropLate(reading, _queue);
+            continue;
         }
+        placeReading(reading, snap_iter->measurement, _queue, _pool);
+        last_modified = set_last_modified(last_modified, snap_iter);
     }
 
-    if (_insert.plane_fit)
+    // Re-filtering starts from the snapshot before the oldest modified one
+    auto start = lower_bound(last_modified);
+    if (start != _history.begin())
     {
-        uint64_t plane_fit_time = _insert.plane_fit->time_usec;
-        auto snap_iter = find_snapshot(plane_fit_time);
-        if (snap_iter != _history.end())
-        {
-            snap_iter->measurement.plane_fit = _insert.plane_fit;
-            _insert.plane_fit = nullptr;
-            last_modified = set_last_modified(last_modified, snap_iter);
-        }
+        std::advance(start, -1);
     }
+    const uint64_t start_time = start->get_time();
+    resize(std::min(start_time, keep_time));
 
-    if (_insert.visual_odometry)
-    {
-        uint64_t vo_time = _insert.visual_odometry->time_usec;
-        auto snap_iter = find_snapshot(vo_time);
-        if (snap_iter != _history.end())
-        {
-            snap_iter->measurement.visual_odometry = _insert.visual_odometry;
-            _insert.visual_odometry = nullptr;
-            last_modified = set_last_modified(last_modified, snap_iter);
-        }
-    }
-
-    if (_insert.global_update)
-    {
-        uint64_t gu_time = _insert.global_update->timeUSec();
-        auto snap_iter = find_snapshot(gu_time);
-        if (snap_iter != _history.end())
-        {
-            snap_iter->measurement.global_update = _insert.global_update;
-            _insert.global_update = nullptr;
-            last_modified = set_last_modified(last_modified, snap_iter);
-        }
-    }
+    return {lower_bound(start_time), _history.end()};
+}
 
-    if (last_modified != _history.begin())
+template <class Scalar>
+void HistoryT<Scalar>::resize(uint64_t keep_time)
+{
+    while (_history.size() > _size && _history.front().get_time() < keep_time)
     {
-        std::advance(last_modified, -1);
+        pop_front();
     }
-    resize(last_modified);
+}
 
-    return {last_modified, _history.end()};
+template <class Scalar>
+void HistoryT<Scalar>::pop_front()
+{
+    // Popped slots are only overwritten when reused, so release the measurements now
+    _history.front().measurement = Measurement();
+    _history.pop_front();
 }
 
-void History::resize(Iterator last_modified)
+template <class Scalar>
+typename HistoryT<Scalar>::Snapshot &HistoryT<Scalar>::append(const MeasurementSet &measurements)
 {
-    while (_history.size() > _size)
+    if (_history.full())
     {
-        auto iter = _history.begin();
-        if (iter == last_modified)
-        {
-            break;
-        }
-        else
-        {
-            _history.pop_front();
-        }
+        // Every snapshot is still waiting to be re-filtered, but the IMU sample cannot wait. The
+        // replay carries on from the oldest snapshot left.
+        static Metrics::Counter &evicted = Metrics::instance().counter("history.evicted");
+        evicted.add();
+        pop_front();
     }
+
+    // Reuse the slot in place rather than copying in a whole new state
+    Snapshot &snapshot = _history.recycle_back();
+    snapshot.state.setTime(measurements.imu->time_usec);
+    snapshot.measurement = Measurement();
+    snapshot.measurement.imu = measurements.imu;
+    snapshot.measurement.imu_preintegration = measurements.imu_preintegration;
+    return snapshot;
 }
 
-void printLateWarning()
+template <class Scalar>
+typename HistoryT<Scalar>::Iterator HistoryT<Scalar>::lower_bound(uint64_t time)
 {
-    std::cout << "Warning: measurement was not inserted because it arrived too late to be placed "
-                 "in the history."
-              << std::endl;
+    return std::lower_bound(_history.begin(), _history.end(), time,
+        [](const Snapshot &snapshot, uint64_t t) { return snapshot.get_time() < t; });
 }
 
-History::Iterator History::find_snapshot(uint64_t time)
+template <class Scalar>
+typename HistoryT<Scalar>::Iterator HistoryT<Scalar>::find_snapshot(uint64_t time)
 {
-    auto end = _history.rbegin();
-    if (time > end->get_time())
+    const Snapshot &last = _history.back();
+    if (time > last.get_time())
     {
-        if (time - end->get_time() < _tolerance)
+        if (time - last.get_time() < _tolerance)
         {
             // If within _tolerance of last IMU, add it
             return std::prev(_history.end());
@@ -189,44 +255,65 @@ History::Iterator History::find_snapshot(uint64_t time)
         }
     }
 
-    for (auto r_iter = std::next(end); r_iter != _history.rend(); std::advance(r_iter, 1))
+    // First snapshot at or after time. Everything before it is strictly older.
+    auto next_iter = lower_bound(time);
+    if (next_iter == _history.begin())
     {
-        uint64_t snapshot_time = r_iter->get_time();
-        if (time > snapshot_time)
-        {
-            auto next_iter = r_iter.base();
-            auto prev_iter = std::prev(next_iter);
-
-            uint64_t next_t = next_iter->get_time();
-            uint64_t prev_t = prev_iter->get_time();
-
-            // Check tolerances and insert interpolated IMU if necessary
-            if (time - prev_t <= _tolerance)
-            {
-                return prev_iter;
-            }
-            else if (next_t - time <= _tolerance)
-            {
-                return next_iter;
-            }
-            else
-            {
-                ImuMeasurement interp_imu = interpolate_imu(
-                    *(prev_iter->measurement.imu), *(next_iter->measurement.imu), time);
-                Measurement interp_measurement;
-                interp_measurement.imu = std::make_shared<ImuMeasurement>(interp_imu);
-                Snapshot interp_snapshot{State(time), interp_measurement};
-                return _history.insert(next_iter, interp_snapshot);
-            }
-        }
+        // If older than oldest measurement, discard
+        return _history.end();
     }
+    auto prev_iter = std::prev(next_iter);
 
-    printLateWarning();
-    // If older than oldest measurement, discard
-    return _history.end();
+    uint64_t next_t = next_iter->get_time();
+    uint64_t prev_t = prev_iter->get_time();
+
+    // Check tolerances and insert interpolated IMU if necessary
+    if (time - prev_t <= _tolerance)
+    {
+        return prev_iter;
+    }
+    else if (next_t - time <= _tolerance)
+    {
+        return next_iter;
+    }
+
+    if (_history.full())
+    {
+        // Making room would drop a snapshot a replay still needs, so the reading is refused and
+        // counted as late instead
+        return _history.end();
+    }
+
+    Measurement interp_measurement;
+    const std::shared_ptr<const ImuPreintegration> preintegration =
+        next_iter->measurement.imu_preintegration;
+    if (preintegration)
+    {
+        // Interpolate between the raw samples rather than the snapshots around them
+        const std::shared_ptr<ImuPreintegration> first = _pool.imu_preintegration.acquire();
+        const std::shared_ptr<ImuPreintegration> second = _pool.imu_preintegration.acquire();
+        preintegration->split(time, *first, *second);
+
+        const std::shared_ptr<ImuMeasurement> interp_imu = _pool.imu.acquire();
+        *interp_imu = second->samples().front();
+        interp_measurement.imu = interp_imu;
+        interp_measurement.imu_preintegration = first;
+        next_iter->measurement.imu_preintegration = second;
+    }
+    else
+    {
+        const std::shared_ptr<ImuMeasurement> interp_imu = _pool.imu.acquire();
+        *interp_imu =
+            interpolate_imu(*(prev_iter->measurement.imu), *(next_iter->measurement.imu), time);
+        interp_measurement.imu = interp_imu;
+    }
+    Snapshot interp_snapshot{State(time), interp_measurement};
+
+    return _history.insert(next_iter, interp_snapshot);
 }
 
-ImuMeasurement History::interpolate_imu(
+template <class Scalar>
+ImuMeasurement HistoryT<Scalar>::interpolate_imu(
     const ImuMeasurement &prev, const ImuMeasurement &next, uint64_t interp_time) const
 {
     ImuMeasurement interpolated = prev;
@@ -244,25 +331,47 @@ ImuMeasurement History::interpolate_imu(
     return interpolated;
 }
 
-History::Iterator History::set_last_modified(
-    const History::Iterator last_modified, const History::Iterator modified) const
+template <class Scalar>
+uint64_t HistoryT<Scalar>::set_last_modified(uint64_t last_modified, const Iterator modified) const
 {
-    if (modified->get_time() < last_modified->get_time())
-    {
-        return modified;
-    }
-    else
-    {
-        return last_modified;
-    }
+    return std::min(last_modified, modified->get_time());
 }
 
-size_t History::size() { return _history.size(); }
-void History::setInitialBiases(const Eigen::Vector3d &gyro_bias, const Eigen::Vector3d &accel_bias)
+template <class Scalar>
+typename HistoryT<Scalar>::Iterator HistoryT<Scalar>::begin()
 {
-    _initial_state.gyroBias() = gyro_bias;
-    _initial_state.accelBias() = accel_bias;
+    return _history.begin();
 }
+template <class Scalar>
+typename HistoryT<Scalar>::Iterator HistoryT<Scalar>::end()
+{
+    return _history.end();
+}
+template <class Scalar>
+size_t HistoryT<Scalar>::size()
+{
+    return _history.size();
+}
+template <class Scalar>
+MeasurementQueue::Stats HistoryT<Scalar>::queueStats() const
+{
+    return _queue.stats();
+}
+template <class Scalar>
+measurements::MeasurementPool &HistoryT<Scalar>::measurementPool()
+{
+    return _pool;
+}
+template <class Scalar>
+void HistoryT<Scalar>::setInitialBiases(
+    const Eigen::Vector3d &gyro_bias, const Eigen::Vector3d &accel_bias)
+{
+    _initial_state.gyroBias() = gyro_bias.cast<Scalar>();
+    _initial_state.accelBias() = accel_bias.cast<Scalar>();
+}
+
+template class HistoryT<double>;
+template class HistoryT<float>;
 
 }  // namespace kalman
 }  // namespace gnc
@@ -0,0 +1,243 @@
+#include <cassert>
+#include <cmath>
+
+#include <gnc/Constants.hpp>
+#include <gnc/kalman/ImuPreintegration.hpp>
+#include <gnc/kalman/Prediction.hpp>
+
+using maav::gnc::measurements::ImuMeasurement;
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+namespace
+{
+/**
+ * Right Jacobian of SO(3): Exp(phi + d) ~= Exp(phi) * Exp(J_r(phi) * d) for small d
+ */
+Eigen::Matrix3d rightJacobian(const Eigen::Vector3d& phi)
+{
+    const double theta = phi.norm();
+    const Eigen::Matrix3d phi_hat = Sophus::SO3d::hat(phi);
+    if (theta < 1e-5)
+    {
+        return Eigen::Matrix3d::Identity() - 0.5 * phi_hat;
+    }
+    const double theta_sq = theta * theta;
+    return Eigen::Matrix3d::Identity() - (1.0 - std::cos(theta)) / theta_sq * phi_hat +
+           (theta - std::sin(theta)) / (theta_sq * theta) * phi_hat * phi_hat;
+}
+
+ImuMeasurement interpolateSample(
+    const ImuMeasurement& prev, const ImuMeasurement& next, uint64_t time)
+{
+    ImuMeasurement interpolated = prev;
+    const double weight = static_cast<double>(time - prev.time_usec) /
+                          static_cast<double>(next.time_usec - prev.time_usec);
+
+    interpolated.time_usec = time;
+    interpolated.angular_rates += weight * (next.angular_rates - prev.angular_rates);
+    interpolated.acceleration += weight * (next.acceleration - prev.acceleration);
+    interpolated.magnetometer += weight * (next.magnetometer - prev.magnetometer);
+    return interpolated;
+}
+}  // namespace
+
+ImuPreintegration::ImuPreintegration(const ImuMeasurement& start, const Eigen::Vector3d& gyro_bias,
+    const Eigen::Vector3d& accel_bias, const State::CovarianceMatrix& Q)
+    : samples_{start}, gyro_bias_(gyro_bias), accel_bias_(accel_bias), Q_(Q)
+{
+    resetIncrements();
+}
+
+ImuPreintegration::ImuPreintegration()
+    : samples_{ImuMeasurement()},
+      gyro_bias_(Eigen::Vector3d::Zero()),
+      accel_bias_(Eigen::Vector3d::Zero()),
+      Q_(State::CovarianceMatrix::Zero())
+{
+    resetIncrements();
+}
+
+void ImuPreintegration::reset(const ImuMeasurement& start, const Eigen::Vector3d& gyro_bias,
+    const Eigen::Vector3d& accel_bias, const State::CovarianceMatrix& Q)
+{
+    samples_.clear();
+    samples_.push_back(start);
+    gyro_bias_ = gyro_bias;
+    accel_bias_ = accel_bias;
+    Q_ = Q;
+    resetIncrements();
+}
+
+void ImuPreintegration::resetIncrements()
+{
+    dt_ = 0;
+    delta_R_ = Sophus::SO3d();
+    delta_V_.setZero();
+    delta_P_.setZero();
+    dR_dbg_.setZero();
+    dV_dbg_.setZero();
+    dV_dba_.setZero();
+    dP_dbg_.setZero();
+    dP_dba_.setZero();
+    transition_.setIdentity();
+    noise_.setZero();
+}
+
+void ImuPreintegration::integrate(const ImuMeasurement& imu)
+{
+    const ImuMeasurement& prev = samples_.back();
+    assert(imu.time_usec > prev.time_usec);
+    const double dt = static_cast<double>(imu.time_usec - prev.time_usec) * constants::USEC_TO_SEC;
+
+    // Same midpoint rule as integrateImu, in the body frame of the first sample
+    const Eigen::Vector3d w_mid = (prev.angular_rates + imu.angular_rates) / 2.0 - gyro_bias_;
+    const Eigen::Vector3d f_prev = prev.acceleration - accel_bias_;
+    const Eigen::Vector3d f_next = imu.acceleration - accel_bias_;
+
+    const Sophus::SO3d dR = Sophus::SO3d::exp(w_mid * dt);
+    const Sophus::SO3d R_next = delta_R_ * dR;
+    const Eigen::Matrix3d R_prev_mat = delta_R_.matrix();
+    const Eigen::Matrix3d R_next_mat = R_next.matrix();
+
+    const Eigen::Vector3d a_mid = (R_prev_mat * f_prev + R_next_mat * f_next) / 2.0;
+
+    // Bias Jacobians, differentiating the same update
+    const Eigen::Matrix3d dR_dbg_next =
+        dR.matrix().transpose() * dR_dbg_ - rightJacobian(w_mid * dt) * dt;
+    const Eigen::Matrix3d da_dbg = -(R_prev_mat * Sophus::SO3d::hat(f_prev) * dR_dbg_ +
+                                       R_next_mat * Sophus::SO3d::hat(f_next) * dR_dbg_next) /
+                                   2.0;
+    const Eigen::Matrix3d da_dba = -(R_prev_mat + R_next_mat) / 2.0;
+
+    delta_P_ += delta_V_ * dt + 0.5 * a_mid * dt * dt;
+    dP_dbg_ += dV_dbg_ * dt + 0.5 * da_dbg * dt * dt;
+    dP_dba_ += dV_dba_ * dt + 0.5 * da_dba * dt * dt;
+
+    delta_V_ += a_mid * dt;
+    dV_dbg_ += da_dbg * dt;
+    dV_dba_ += da_dba * dt;
+
+    delta_R_ = R_next;
+    dR_dbg_ = dR_dbg_next;
+
+    // Covariance of the per sample filter steps this interval stands in for
+    const State::CovarianceMatrix F =
+        EskfPrediction::errorJacobian(gyro_bias_, accel_bias_, prev, imu, dt);
+    transition_ = F * transition_;
+    noise_ = F * noise_ * F.transpose() + Q_;
+
+    dt_ += dt;
+    samples_.push_back(imu);
+}
+
+std::pair<ImuPreintegration, ImuPreintegration> ImuPreintegration::split(uint64_t time) const
+{
+    std::pair<ImuPreintegration, ImuPreintegration> halves;
+    split(time, halves.first, halves.second);
+    return halves;
+}
+
+void ImuPreintegration::split(
+    uint64_t time, ImuPreintegration& first, ImuPreintegration& second) const
+{
+    assert(time > startTime() && time < endTime());
+    assert(&first != this && &second != this);
+
+    const ImuMeasurement middle = interpolate(time);
+    first.reset(samples_.front(), gyro_bias_, accel_bias_, Q_);
+    second.reset(middle, gyro_bias_, accel_bias_, Q_);
+
+    // Either half may end up with every sample plus the interpolated one. Reserving for that keeps
+    // recycled halves from growing one sample at a time
+    first.reserve(samples_.size() + 1);
+    second.reserve(samples_.size() + 1);
+    for (size_t i = 1; i < samples_.size(); i++)
+    {
+        const ImuMeasurement& sample = samples_[i];
+        if (sample.time_usec < time)
+        {
+            first.integrate(sample);
+        }
+        else if (sample.time_usec > time)
+        {
+            if (first.endTime() < time) first.integrate(middle);
+            second.integrate(sample);
+        }
+    }
+    if (first.endTime() < time) first.integrate(middle);
+}
+
+ImuMeasurement ImuPreintegration::interpolate(uint64_t time) const
+{
+    assert(time >= startTime() && time <= endTime());
+
+    for (size_t i = 1; i < samples_.size(); i++)
+    {
+        if (samples_[i].time_usec >= time)
+        {
+            return interpolateSample(samples_[i - 1], samples_[i], time);
+        }
+    }
+    return samples_.back();
+}
+
+Sophus::SO3d ImuPreintegration::deltaR(const Eigen::Vector3d& gyro_bias) const
+{
+    return delta_R_ * Sophus::SO3d::exp(dR_dbg_ * (gyro_bias - gyro_bias_));
+}
+
+Eigen::Vector3d ImuPreintegration::deltaV(
+    const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias) const
+{
+    return delta_V_ + dV_dbg_ * (gyro_bias - gyro_bias_) + dV_dba_ * (accel_bias - accel_bias_);
+}
+
+Eigen::Vector3d ImuPreintegration::deltaP(
+    const Eigen::Vector3d& gyro_bias, const Eigen::Vector3d& accel_bias) const
+{
+    return delta_P_ + dP_dbg_ * (gyro_bias - gyro_bias_) + dP_dba_ * (accel_bias - accel_bias_);
+}
+
+template <class Scalar>
+void ImuPreintegration::predict(const StateT<Scalar>& prev_state, StateT<Scalar>& next_state) const
+{
+    const Eigen::Vector3d gyro_bias = prev_state.gyroBias().template cast<double>();
+    const Eigen::Vector3d accel_bias = prev_state.accelBias().template cast<double>();
+    const Sophus::SO3d R = prev_state.attitude().template cast<double>();
+    const Eigen::Vector3d g = prev_state.gravity().template cast<double>();
+    const Eigen::Vector3d v = prev_state.velocity().template cast<double>();
+
+    // Propagate unchanged biases
+    next_state.gyroBias() = prev_state.gyroBias();
+    next_state.accelBias() = prev_state.accelBias();
+    next_state.gravity() = prev_state.gravity();
+    next_state.magneticFieldVector() = prev_state.magneticFieldVector();
+
+    const Sophus::SO3d next_R = R * deltaR(gyro_bias);
+    next_state.attitude() = next_R.cast<Scalar>();
+    next_state.velocity() =
+        (v + R * deltaV(gyro_bias, accel_bias) - g * dt_).template cast<Scalar>();
+    next_state.position() = (prev_state.position().template cast<double>() + v * dt_ +
+                             R * deltaP(gyro_bias, accel_bias) - 0.5 * g * dt_ * dt_)
+                                .template cast<Scalar>();
+
+    // Move corrected sensor readings from the last sample
+    const ImuMeasurement& last = samples_.back();
+    next_state.angularVelocity() = (last.angular_rates - gyro_bias).template cast<Scalar>();
+    next_state.acceleration() =
+        (next_R * (last.acceleration - accel_bias) - g).template cast<Scalar>();
+}
+
+template void ImuPreintegration::predict(
+    const StateT<double>& prev_state, StateT<double>& next_state) const;
+template void ImuPreintegration::predict(
+    const StateT<float>& prev_state, StateT<float>& next_state) const;
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -0,0 +1,184 @@
+#include <algorithm>
+
+#include <gnc/kalman/MeasurementQueue.hpp>
+
+using maav::gnc::measurements::GlobalUpdateMeasurement;
+using maav::gnc::measurements::LidarMeasurement;
+using maav::gnc::measurements::Measurement;
+using maav::gnc::measurements::MeasurementSet;
+using maav::gnc::measurements::PlaneFitMeasurement;
+using maav::gnc::measurements::VisualOdometryMeasurement;
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+namespace
+{
+constexpr size_t DEFAULT_QUEUE_SIZE = 16;
+
+size_t queueSize(const YAML::Node& config)
+{
+    return config["queue_size"] ? config["queue_size"].as<size_t>() : DEFAULT_QUEUE_SIZE;
+}
+
+uint64_t latencyBudget(const YAML::Node& config, const char* sensor)
+{
+    const YAML::Node budgets = config["latency_budget"];
+    return budgets && budgets[sensor] ? budgets[sensor].as<uint64_t>() : 0;
+}
+
+uint64_t timeUSec(const LidarMeasurement& lidar) { return lidar.timeUSec(); }
+uint64_t timeUSec(const PlaneFitMeasurement& plane_fit) { return plane_fit.time_usec; }
+uint64_t timeUSec(const VisualOdometryMeasurement& vo) { return vo.timeUSec(); }
+uint64_t timeUSec(const GlobalUpdateMeasurement& global) { return global.timeUSec(); }
+
+// Popping counted the reading as merged
+void countLate(MeasurementQueue::SensorStats& stats)
+{
+    stats.merged--;
+    stats.dropped_late++;
+}
+
+void countReplaced(MeasurementQueue::SensorStats& stats)
+{
+    stats.merged--;
+    stats.dropped_replaced++;
+}
+}  // namespace
+
+MeasurementQueue::MeasurementQueue(YAML::Node config)
+    : lidar_(queueSize(config), latencyBudget(config, "lidar")),
+      plane_fit_(queueSize(config), latencyBudget(config, "plane_fit")),
+      visual_odometry_(queueSize(config), latencyBudget(config, "visual_odometry")),
+      global_update_(queueSize(config), latencyBudget(config, "global_update"))
+{
+}
+
+void MeasurementQueue::push(const MeasurementSet& measurements)
+{
+    if (measurements.lidar) push(lidar_, measurements.lidar);
+    if (measurements.plane_fit) push(plane_fit_, measurements.plane_fit);
+    if (measurements.visual_odometry) push(visual_odometry_, measurements.visual_odometry);
+    if (measurements.global_update) push(global_update_, measurements.global_update);
+}
+
+bool MeasurementQueue::pop(uint64_t now, uint64_t before, Measurement& next)
+{
+    next = Measurement();
+
+    const uint64_t lidar_time = front(lidar_, now);
+    const uint64_t plane_fit_time = front(plane_fit_, now);
+    const uint64_t vo_time = front(visual_odometry_, now);
+    const uint64_t global_time = front(global_update_, now);
+
+    const uint64_t oldest = std::min({lidar_time, plane_fit_time, vo_time, global_time});
+    if (oldest >= before) return false;
+
+    // Ties go to the sensor listed first, so equal times merge in a fixed order
+    if (lidar_time == oldest)
+    {
+        next.lidar = pop(lidar_);
+        lidar_.stats.merged++;
+    }
+    else if (plane_fit_time == oldest)
+    {
+        next.plane_fit = pop(plane_fit_);
+        plane_fit_.stats.merged++;
+    }
+    else if (vo_time == oldest)
+    {
+        next.visual_odometry = pop(visual_odometry_);
+        visual_odometry_.stats.merged++;
+    }
+    else
+    {
+        next.global_update = pop(global_update_);
+        global_update_.stats.merged++;
+    }
+    return true;
+}
+
+void MeasurementQueue::dropLate(const Measurement& late)
+{
+    if (late.lidar) countLate(lidar_.stats);
+    if (late.plane_fit) countLate(plane_fit_.stats);
+    if (late.visual_odometry) countLate(visual_odometry_.stats);
+    if (late.global_update) countLate(global_update_.stats);
+}
+
+void MeasurementQueue::dropReplaced(const Measurement& replacement)
+{
+    if (replacement.lidar) countReplaced(lidar_.stats);
+    if (replacement.plane_fit) countReplaced(plane_fit_.stats);
+    if (replacement.visual_odometry) countReplaced(visual_odometry_.stats);
+    if (replacement.global_update) countReplaced(global_update_.stats);
+}
+
+size_t MeasurementQueue::size() const
+{
+    return lidar_.queue.size() + plane_fit_.queue.size() + visual_odometry_.queue.size() +
+           global_update_.queue.size();
+}
+
+MeasurementQueue::Stats MeasurementQueue::stats() const
+{
+    Stats stats;
+    stats.lidar = lidar_.stats;
+    stats.plane_fit = plane_fit_.stats;
+    stats.visual_odometry = visual_odometry_.stats;
+    stats.global_update = global_update_.stats;
+    return stats;
+}
+
+template <class T>
+void MeasurementQueue::push(SensorQueue<T>& sensor, const std::shared_ptr<const T>& measurement)
+{
+    sensor.stats.queued++;
+    if (sensor.queue.full())
+    {
+        pop(sensor);
+        sensor.stats.dropped_overflow++;
+    }
+
+    // Readings almost always arrive in order, so search from the newest end
+    const uint64_t time = timeUSec(*measurement);
+    auto pos = sensor.queue.end();
+    while (pos != sensor.queue.begin() && timeUSec(**std::prev(pos)) > time)
+    {
+        --pos;
+    }
+    sensor.queue.insert(pos, measurement);
+    sensor.stats.max_depth = std::max(sensor.stats.max_depth, sensor.queue.size());
+}
+
+template <class T>
+uint64_t MeasurementQueue::front(SensorQueue<T>& sensor, uint64_t now)
+{
+    while (!sensor.queue.empty())
+    {
+        const uint64_t time = timeUSec(*sensor.queue.front());
+        if (sensor.latency_budget == 0 || time >= now || now - time <= sensor.latency_budget)
+        {
+            return time;
+        }
+        pop(sensor);
+        sensor.stats.dropped_stale++;
+    }
+    return UINT64_MAX;
+}
+
+template <class T>
+std::shared_ptr<const T> MeasurementQueue::pop(SensorQueue<T>& sensor)
+{
+    // Popped slots are only overwritten when reused, so let go of the reading now
+    std::shared_ptr<const T> measurement = std::move(sensor.queue.front());
+    sensor.queue.pop_front();
+    return measurement;
+}
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -1,6 +1,9 @@
 #include <common/utils/yaml_matrix.hpp>
 #include <gnc/Constants.hpp>
+#include <gnc/kalman/CholeskyUpdate.hpp>
+#include <gnc/kalman/ImuPreintegration.hpp>
 #include <gnc/kalman/Prediction.hpp>
+#include <gnc/utils/Metrics.hpp>
 
 namespace maav
 {
@@ -8,12 +11,8 @@ namespace gnc
 {
 namespace kalman
 {
-UkfPrediction::UkfPrediction(YAML::Node config) : transformation(config["UT"])
+State::CovarianceMatrix processNoise(YAML::Node config)
 {
-    using std::placeholders::_1;
-    std::function<State(const State&)> functor = std::bind(&UkfPrediction::predict, this, _1);
-    transformation.set_transformation(functor);
-
     constexpr size_t IMU_DoF = 12;
     using ImpulseVector = Eigen::Matrix<double, IMU_DoF, 1>;
     ImpulseVector Q_i_vec = config["Q_i"].as<ImpulseVector>();
@@ -27,31 +26,119 @@ UkfPrediction::UkfPrediction(YAML::Node config) : transformation(config["UT"])
     F_i.block<3, 3>(9, 6) = Eigen::Matrix3d::Identity();
     F_i.block<3, 3>(12, 9) = Eigen::Matrix3d::Identity();
 
-    Q = F_i * Q_i * F_i.transpose();
+    return F_i * Q_i * F_i.transpose();
+}
+
+template <class Scalar>
+UkfPredictionT<Scalar>::UkfPredictionT(YAML::Node config)
+    : transformation(config["UT"], true), Q(processNoise(config).cast<Scalar>())
+{
+    transformation.set_transformation(Predictor{this});
+
+    // F_i only maps each impulse onto its own state, so Q is diagonal
+    sqrt_Q_diag_ = Q.diagonal().cwiseSqrt();
 }
 
-void UkfPrediction::operator()(const History::ConstIterator prev, const History::Iterator next)
+template <class Scalar>
+void UkfPredictionT<Scalar>::setProcessNoise(const typename State::CovarianceMatrix& noise)
+{
+    Q = noise;
+    sqrt_Q_diag_ = Q.diagonal().cwiseSqrt();
+}
+
+template <class Scalar>
+void UkfPredictionT<Scalar>::operator()(const Snapshot& prev, Snapshot& next)
 {
     // Set internal references for use in the transition function
-    _prev = prev;
-    _next = next;
+    _prev = &prev;
+    _next = &next;
 
-    // Propagate previous state
-    _next->state = transformation(prev->state);
+    // Propagate previous state, in place so a square root factor keeps its storage
+    transformation(prev.state, _next->state);
 
     // Add process noise
-    _next->state.covariance() += Q;
+    State& next_state = _next->state;
+    const ImuPreintegration* preintegration = _next->measurement.imu_preintegration.get();
+    if (preintegration)
+    {
+        addNoise(next_state, preintegration->noise().cast<Scalar>());
+        return;
+    }
+
+    if (next_state.hasSqrtCovariance())
+    {
+        // Q is diagonal, so it goes into the factor as one rank one update per noisy state
+        typename State::CovarianceMatrix L = next_state.sqrtCovariance();
+        bool factored = true;
+        for (size_t i = 0; i < State::DoF && factored; i++)
+        {
+            if (sqrt_Q_diag_(i) == 0.0) continue;
+            factored = choleskyUpdate<State::DoF>(
+                L, sqrt_Q_diag_(i) * State::ErrorStateVector::Unit(i));
+        }
+        if (factored)
+        {
+            next_state.setSqrtCovariance(L);
+            return;
+        }
+        next_state.clearSqrtCovariance();
+    }
+    next_state.covariance() += Q;
 }
 
-State UkfPrediction::predict(const State& state)
+template <class Scalar>
+void UkfPredictionT<Scalar>::addNoise(
+    State& state, const typename State::CovarianceMatrix& noise)
 {
-    const State& prev_state = state;
-    State next_state(_next->state.timeUSec());
+    if (state.hasSqrtCovariance())
+    {
+        // Noise accumulated over several samples is no longer diagonal, so it goes into the
+        // factor one column of its own factor at a time
+        const Eigen::LLT<typename State::CovarianceMatrix> noise_decomp(noise);
+        typename State::CovarianceMatrix L = state.sqrtCovariance();
+        bool factored = noise_decomp.info() == Eigen::Success;
+        const typename State::CovarianceMatrix noise_L = noise_decomp.matrixL();
+        for (size_t i = 0; i < State::DoF && factored; i++)
+        {
+            factored = choleskyUpdate<State::DoF>(L, noise_L.col(i));
+        }
+        if (factored)
+        {
+            state.setSqrtCovariance(L);
+            return;
+        }
+        static Metrics::Counter& llt_failures =
+            Metrics::instance().counter("kalman.llt_failures");
+        llt_failures.add();
+        state.clearSqrtCovariance();
+    }
+    state.covariance() += noise;
+}
 
-    const measurements::ImuMeasurement& prev_imu = *(_prev->measurement.imu);
-    const measurements::ImuMeasurement& next_imu = *(_next->measurement.imu);
+template <class Scalar>
+void UkfPredictionT<Scalar>::predict(const State& state, State& next_state)
+{
+    next_state.setTime(_next->state.timeUSec());
 
-    double dt = static_cast<double>(_next->get_time() - _prev->get_time()) * constants::USEC_TO_SEC;
+    const ImuPreintegration* preintegration = _next->measurement.imu_preintegration.get();
+    if (preintegration)
+    {
+        preintegration->predict(state, next_state);
+        return;
+    }
+
+    const double dt =
+        static_cast<double>(_next->get_time() - _prev->get_time()) * constants::USEC_TO_SEC;
+    integrateImu(state, *(_prev->measurement.imu), *(_next->measurement.imu), dt, next_state);
+}
+
+template <class Scalar>
+void integrateImu(const StateT<Scalar>& prev_state, const measurements::ImuMeasurement& prev_imu,
+    const measurements::ImuMeasurement& next_imu, double dt, StateT<Scalar>& next_state)
+{
+    using Vector3 = typename StateT<Scalar>::Vector3;
+    using SO3 = typename StateT<Scalar>::SO3;
+    const Scalar h = static_cast<Scalar>(dt);
 
     // Propagate unchanged biases
     next_state.gyroBias() = prev_state.gyroBias();
@@ -59,10 +146,10 @@ State UkfPrediction::predict(const State& state)
     next_state.gravity() = prev_state.gravity();
     next_state.magneticFieldVector() = prev_state.magneticFieldVector();
 
-    const Eigen::Vector3d& w_prev = prev_imu.angular_rates - prev_state.gyroBias();
-    const Eigen::Vector3d& w_next = next_imu.angular_rates - next_state.gyroBias();
-    const Eigen::Vector3d w_mid = (w_next + w_prev) / 2.0;
-    const Sophus::SO3d dR = Sophus::SO3d::exp(w_mid * dt);
+    const Vector3& w_prev = prev_imu.angular_rates.cast<Scalar>() - prev_state.gyroBias();
+    const Vector3& w_next = next_imu.angular_rates.cast<Scalar>() - next_state.gyroBias();
+    const Vector3 w_mid = (w_next + w_prev) / Scalar(2);
+    const SO3 dR = SO3::exp(w_mid * h);
     next_state.attitude() = prev_state.attitude() * dR;
 
     /**
@@ -70,27 +157,130 @@ State UkfPrediction::predict(const State& state)
      * Rotate to global frame
      * Remove gravity
      */
-    const Eigen::Vector3d& a_prev =
-        prev_state.attitude() * (prev_imu.acceleration - prev_state.accelBias()) -
+    const Vector3& a_prev =
+        prev_state.attitude() * (prev_imu.acceleration.cast<Scalar>() - prev_state.accelBias()) -
         prev_state.gravity();
-    const Eigen::Vector3d& a_next =
-        next_state.attitude() * (next_imu.acceleration - next_state.accelBias()) -
+    const Vector3& a_next =
+        next_state.attitude() * (next_imu.acceleration.cast<Scalar>() - next_state.accelBias()) -
         next_state.gravity();
 
-    const Eigen::Vector3d a_mid = (a_next + a_prev) / 2.0;
-    next_state.velocity() = prev_state.velocity() + (a_mid * dt);
+    const Vector3 a_mid = (a_next + a_prev) / Scalar(2);
+    next_state.velocity() = prev_state.velocity() + (a_mid * h);
 
-    const Eigen::Vector3d& v_prev = prev_state.velocity();
-    const Eigen::Vector3d& v_next = next_state.velocity();
-    const Eigen::Vector3d v_mid = (v_next + v_prev) / 2.0;
-    next_state.position() = prev_state.position() + (v_mid * dt);
+    const Vector3& v_prev = prev_state.velocity();
+    const Vector3& v_next = next_state.velocity();
+    const Vector3 v_mid = (v_next + v_prev) / Scalar(2);
+    next_state.position() = prev_state.position() + (v_mid * h);
 
     // Move corrected sensor readings
     next_state.angularVelocity() = w_next;
     next_state.acceleration() = a_next;
+}
 
-    return next_state;
+template <class Scalar>
+EskfPredictionT<Scalar>::EskfPredictionT(YAML::Node config)
+    : Q(processNoise(config).cast<Scalar>())
+{
 }
+
+template <class Scalar>
+void EskfPredictionT<Scalar>::setProcessNoise(const typename State::CovarianceMatrix& noise)
+{
+    Q = noise;
+}
+
+template <class Scalar>
+void EskfPredictionT<Scalar>::operator()(const Snapshot& prev, Snapshot& next)
+{
+    State& next_state = next.state;
+    const typename State::CovarianceMatrix& P = prev.state.covariance();
+
+    const ImuPreintegration* preintegration = next.measurement.imu_preintegration.get();
+    if (preintegration)
+    {
+        // The transition and noise were accumulated at the integration biases, which is as far as
+        // the first order model goes anyway
+        preintegration->predict(prev.state, next_state);
+        const typename State::CovarianceMatrix F = preintegration->transition().cast<Scalar>();
+        next_state.covariance() = F * P * F.transpose() + preintegration->noise().cast<Scalar>();
+        next_state.clearSqrtCovariance();
+        return;
+    }
+
+    const measurements::ImuMeasurement& prev_imu = *(prev.measurement.imu);
+    const measurements::ImuMeasurement& next_imu = *(next.measurement.imu);
+    const double dt =
+        static_cast<double>(next.get_time() - prev.get_time()) * constants::USEC_TO_SEC;
+
+    integrateImu(prev.state, prev_imu, next_imu, dt, next_state);
+
+    const typename State::CovarianceMatrix F = errorJacobian(
+        prev.state.gyroBias(), prev.state.accelBias(), prev_imu, next_imu, dt);
+    next_state.covariance() = F * P * F.transpose() + Q;
+    next_state.clearSqrtCovariance();
+}
+
+template <class Scalar>
+typename StateT<Scalar>::CovarianceMatrix EskfPredictionT<Scalar>::errorJacobian(
+    const Vector3& gyro_bias, const Vector3& accel_bias,
+    const measurements::ImuMeasurement& prev_imu, const measurements::ImuMeasurement& next_imu,
+    double dt_sec)
+{
+    using Matrix3 = Eigen::Matrix<Scalar, 3, 3>;
+    using SO3 = typename State::SO3;
+    constexpr size_t DoF = State::DoF;
+    const Scalar dt = static_cast<Scalar>(dt_sec);
+
+    /**
+     * Error state layout: [attitude, position, velocity, gyro bias, accel bias]. Position and
+     * velocity errors are in the body frame (see State::operator+=), so each block is expressed
+     * in the body frame of the propagated state. First order in the error, with the right
+     * Jacobian of SO(3) taken as identity over one IMU interval.
+     */
+    const Vector3 w_mid =
+        ((prev_imu.angular_rates + next_imu.angular_rates) / 2.0).cast<Scalar>() - gyro_bias;
+    const Matrix3 dR_T = SO3::exp(w_mid * dt).matrix().transpose();
+    const Vector3 f_prev = prev_imu.acceleration.cast<Scalar>() - accel_bias;
+    const Vector3 f_next = next_imu.acceleration.cast<Scalar>() - accel_bias;
+    const Matrix3 f_prev_hat = SO3::hat(f_prev);
+    const Matrix3 f_next_hat = SO3::hat(f_next);
+    const Matrix3 I = Matrix3::Identity();
+    const Scalar half = Scalar(0.5);
+
+    typename State::CovarianceMatrix F = State::CovarianceMatrix::Zero();
+
+    // Attitude
+    F.template block<3, 3>(0, 0) = dR_T;
+    F.template block<3, 3>(0, 9) = -dt * I;
+
+    // Velocity, from the trapezoid of the accelerations at both ends of the interval
+    F.template block<3, 3>(6, 0) = -dt * half * (dR_T * f_prev_hat + f_next_hat * dR_T);
+    F.template block<3, 3>(6, 6) = dR_T;
+    F.template block<3, 3>(6, 9) = dt * dt * half * f_next_hat;
+    F.template block<3, 3>(6, 12) = -dt * half * (dR_T + I);
+
+    // Position, from the trapezoid of the velocities
+    F.template block<3, DoF>(3, 0) = dt * half * F.template block<3, DoF>(6, 0);
+    F.template block<3, 3>(3, 3) += dR_T;
+    F.template block<3, 3>(3, 6) += dt * half * dR_T;
+
+    // Biases are constant
+    F.template block<6, 6>(9, 9).setIdentity();
+
+    return F;
+}
+
+template void integrateImu(const StateT<double>& prev_state,
+    const measurements::ImuMeasurement& prev_imu, const measurements::ImuMeasurement& next_imu,
+    double dt, StateT<double>& next_state);
+template void integrateImu(const StateT<float>& prev_state,
+    const measurements::ImuMeasurement& prev_imu, const measurements::ImuMeasurement& next_imu,
+    double dt, StateT<float>& next_state);
+
+template class UkfPredictionT<double>;
+template class UkfPredictionT<float>;
+template class EskfPredictionT<double>;
+template class EskfPredictionT<float>;
 }  // namespace kalman
 }  // namespace gnc
-}  // namespace maav
\ No newline at end of file
+}  // namespace maav
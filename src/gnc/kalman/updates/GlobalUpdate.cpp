@@ -1,15 +1,19 @@
 #include <gnc/kalman/updates/GlobalUpdate.hpp>
 
-using maav::gnc::measurements::GlobalUpdateMeasurement;
-
 namespace maav
 {
 namespace gnc
 {
 namespace kalman
 {
-GlobalUpdate::GlobalUpdate(YAML::Node config) : BaseUpdate(config["global_update"]) {}
-GlobalUpdateMeasurement GlobalUpdate::predicted(const State& state)
+template <class Scalar>
+GlobalUpdateT<Scalar>::GlobalUpdateT(YAML::Node config)
+    : Base(config["global_update"], "global_update"), initialized_pose_(false)
+{
+}
+
+template <class Scalar>
+typename GlobalUpdateT<Scalar>::Target GlobalUpdateT<Scalar>::predicted(const State& state)
 {
     if (!initialized_pose_)
     {
@@ -18,31 +22,51 @@ GlobalUpdateMeasurement GlobalUpdate::predicted(const State& state)
         initialized_pose_ = true;
     }
 
-    Sophus::SE3d pose = starting_pose_inverse_ * state.getPose();
+    typename State::SE3 pose = starting_pose_inverse_ * state.getPose();
 
     /*
     Here, we predict the position and attitude of our quadcopter
     */
 
-    GlobalUpdateMeasurement predicted_measurement;
+    Target predicted_measurement;
     predicted_measurement.pose() = pose;
 
     return predicted_measurement;
 }
 
-GlobalUpdateMeasurement GlobalUpdate::measured(const measurements::Measurement& meas)
+template <class Scalar>
+typename GlobalUpdateT<Scalar>::MeasurementJacobian GlobalUpdateT<Scalar>::jacobian(const State&)
 {
-    return *(meas.global_update);
+    // An error in the state is a right perturbation of its pose, which passes straight through
+    // the fixed starting pose. The SE(3) tangent is ordered [translation, rotation] while the
+    // error state leads with attitude.
+    MeasurementJacobian H = MeasurementJacobian::Zero();
+    H.template block<3, 3>(0, 3).setIdentity();
+    H.template block<3, 3>(3, 0).setIdentity();
+    return H;
 }
 
-void GlobalUpdate::operator()(History::Snapshot& snapshot)
+template <class Scalar>
+typename GlobalUpdateT<Scalar>::Target GlobalUpdateT<Scalar>::measured(
+    const measurements::Measurement& meas)
 {
-    // Check the validity of the lidar measurements
-    if (snapshot.measurement.global_update)
-    {
-        correct(snapshot);
-    }
+    return meas.global_update->template cast<Scalar>();
 }
+
+template <class Scalar>
+bool GlobalUpdateT<Scalar>::applies(const measurements::Measurement& meas) const
+{
+    return meas.global_update != nullptr;
+}
+
+template <class Scalar>
+void GlobalUpdateT<Scalar>::operator()(Snapshot& snapshot)
+{
+    if (applies(snapshot.measurement)) correct(snapshot);
+}
+
+template class GlobalUpdateT<double>;
+template class GlobalUpdateT<float>;
 }  // namespace kalman
 }  // namespace gnc
-}  // namespace maav
\ No newline at end of file
+}  // namespace maav
@@ -0,0 +1,169 @@
+#include <gnc/kalman/updates/JointUpdate.hpp>
+#include <gnc/utils/Metrics.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+template <class Scalar>
+JointUpdateT<Scalar>::JointUpdateT(YAML::Node config, LidarUpdateT<Scalar>& lidar_update,
+    PlaneFitUpdateT<Scalar>& planefit_update, GlobalUpdateT<Scalar>& global_update)
+    : enabled_(config["joint"] && config["joint"]["enabled"].as<bool>()),
+      lidar_(lidar_update),
+      planefit_(planefit_update),
+      global_(global_update),
+      inflate_(false),
+      residual_(Vector::Zero(MaxDoF)),
+      deviations_(Deviations::Zero()),
+      R_(CovarianceMatrix::Zero(MaxDoF, MaxDoF))
+{
+    if (enabled_) unscented_transform_ = UT(config["joint"]["UT"]);
+}
+
+template <class Scalar>
+void JointUpdateT<Scalar>::operator()(Snapshot& snapshot)
+{
+    const measurements::Measurement& meas = snapshot.measurement;
+    const bool lidar = lidar_.update.enabled() && lidar_.update.applies(meas);
+    const bool planefit = planefit_.update.enabled() && planefit_.update.applies(meas);
+    const bool global = global_.update.enabled() && global_.update.applies(meas);
+
+    if (lidar + planefit + global < 2)
+    {
+        // Nothing to share the sigma points with
+        lidar_.update(snapshot);
+        planefit_.update(snapshot);
+        global_.update(snapshot);
+        return;
+    }
+
+    State& state = snapshot.state;
+    const typename UT::SigmaPoints& sigma_points = unscented_transform_.sigma_points(state);
+
+    R_.setZero();
+    size_t rows = 0;
+    inflate_ = false;
+    if (lidar) rows = stack(lidar_, meas, rows);
+    if (planefit) rows = stack(planefit_, meas, rows);
+    if (global) rows = stack(global_, meas, rows);
+
+    if (inflate_)
+    {
+        // Inflating changes the sigma points every other sensor was predicted from. Nothing was
+        // counted yet, so each update gates its reading once.
+        lidar_.update(snapshot);
+        planefit_.update(snapshot);
+        global_.update(snapshot);
+        return;
+    }
+
+    const uint64_t time_usec = snapshot.get_time();
+    if (lidar) record(lidar_, time_usec);
+    if (planefit) record(planefit_, time_usec);
+    if (global) record(global_, time_usec);
+    if (rows == 0) return;
+
+    Eigen::Matrix<Scalar, State::DoF, N> state_deviations;
+    for (size_t i = 0; i < N; i++)
+    {
+        state_deviations.col(i) = sigma_points[i] - state;
+    }
+
+    // Every sensor is predicted from the same sigma points, so the stacked covariances carry the
+    // correlations between them
+    const Eigen::Map<const Eigen::Matrix<Scalar, N, 1>> c_weights(
+        unscented_transform_.c_weights().data());
+    const auto Z = deviations_.topRows(rows);
+    const Eigen::Matrix<Scalar, Eigen::Dynamic, N, 0, MaxDoF, N> weighted_Z =
+        Z * c_weights.asDiagonal();
+    const CovarianceMatrix S =
+        weighted_Z.lazyProduct(Z.transpose()) + R_.topLeftCorner(rows, rows);
+    const CrossCovarianceMatrix Sigma_x_z = state_deviations.lazyProduct(weighted_Z.transpose());
+
+    const CovarianceMatrix S_inverse = S.inverse();
+    const KalmanGainMatrix K = Sigma_x_z * S_inverse;
+    // Update the state gaussian in place
+    state += K * residual_.head(rows);
+
+    if (unscented_transform_.square_root() && state.hasSqrtCovariance())
+    {
+        // K * S * K^T = U * U^T, so the factor is updated with one downdate per column of U
+        const Eigen::LLT<CovarianceMatrix> S_decomp(S);
+        const CrossCovarianceMatrix U = K * S_decomp.matrixL();
+        typename State::CovarianceMatrix L = state.sqrtCovariance();
+        bool factored = S_decomp.info() == Eigen::Success;
+        for (size_t i = 0; i < rows && factored; i++)
+        {
+            factored = choleskyUpdate<State::DoF>(L, U.col(i), true);
+        }
+        if (factored)
+        {
+            state.setSqrtCovariance(L);
+            return;
+        }
+        static Metrics::Counter& llt_failures =
+            Metrics::instance().counter("kalman.llt_failures");
+        llt_failures.add();
+    }
+
+    state.covariance() -= K * S * K.transpose();
+    state.clearSqrtCovariance();
+}
+
+template <class Scalar>
+template <class Update>
+size_t JointUpdateT<Scalar>::stack(
+    Sensor<Update>& sensor, const measurements::Measurement& meas, size_t rows)
+{
+    using Target = typename Update::Target;
+    constexpr size_t DoF = Target::DoF;
+
+    const typename UT::SigmaPoints& sigma_points = unscented_transform_.last_sigma_points();
+    const ExtrinsicsT<Scalar>& extrinsics = sensor.update.extrinsics();
+    for (size_t i = 0; i < N; i++)
+    {
+        extrinsics(sigma_points[i], sensor_state_);
+        sensor.points[i] = sensor.update.predicted(sensor_state_);
+    }
+    sensor.predicted = Target::compute_gaussian(
+        sensor.points, unscented_transform_.m_weights(), unscented_transform_.c_weights());
+    sensor.residual = sensor.update.measured(meas) - sensor.predicted;
+
+    // Gate on the sensor's own block of the joint innovation covariance
+    const Gate gated = sensor.update.classify(
+        sensor.residual, sensor.predicted.covariance() + sensor.update.R());
+    if (gated != Gate::Accept)
+    {
+        inflate_ = inflate_ || gated == Gate::Inflate;
+        return rows;
+    }
+
+    residual_.template segment<DoF>(rows) = sensor.residual;
+    for (size_t i = 0; i < N; i++)
+    {
+        deviations_.template block<DoF, 1>(rows, i) = sensor.points[i] - sensor.predicted;
+    }
+    R_.template block<DoF, DoF>(rows, rows) = sensor.update.R();
+    return rows + DoF;
+}
+
+template <class Scalar>
+template <class Update>
+void JointUpdateT<Scalar>::record(Sensor<Update>& sensor, uint64_t time_usec)
+{
+    const Gate gated = sensor.update.gate(
+        time_usec, sensor.residual, sensor.predicted.covariance() + sensor.update.R());
+    if (gated == Gate::Accept)
+    {
+        sensor.update.adapt(time_usec, sensor.residual, sensor.predicted.covariance());
+    }
+}
+
+template class JointUpdateT<double>;
+template class JointUpdateT<float>;
+
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
@@ -1,52 +1,83 @@
 #include <gnc/kalman/updates/LidarUpdate.hpp>
 
-using maav::gnc::measurements::LidarMeasurement;
-
 namespace maav
 {
 namespace gnc
 {
 namespace kalman
 {
-LidarUpdate::LidarUpdate(YAML::Node config)
-    : BaseUpdate(config["lidar"]),
-      bias_(config["lidar"]["lidar_bias"].as<double>()),
-      imu_height_(config["imu_height"].as<double>())
+template <class Scalar>
+LidarUpdateT<Scalar>::LidarUpdateT(YAML::Node config)
+    : Base(config["lidar"], "lidar"),
+      bias_(config["lidar"]["lidar_bias"].as<Scalar>()),
+      imu_height_(config["imu_height"].as<Scalar>())
 {
 }
 
-LidarMeasurement LidarUpdate::predicted(const State& state)
+template <class Scalar>
+typename LidarUpdateT<Scalar>::Target LidarUpdateT<Scalar>::predicted(const State& state)
 {
     /*
         Here, we predict the length of a lidar beam given our state. With some trigonometry, you can
        observe that the length of a beam going down is -z / cos(theta). We rotate a unit z vector
        and dot it with the unit z vector to find cos(theta)
     */
-    LidarMeasurement predicted_measurement;
-    const Eigen::Vector3d vertical_vec = Eigen::Vector3d::UnitZ();
-    double cos_theta = (state.attitude() * vertical_vec).dot(vertical_vec);
+    Target predicted_measurement;
+    const Eigen::Matrix<Scalar, 3, 1> vertical_vec = Eigen::Matrix<Scalar, 3, 1>::UnitZ();
+    Scalar cos_theta = (state.attitude() * vertical_vec).dot(vertical_vec);
     predicted_measurement.distance()(0) = -state.position().z() / cos_theta + bias_ + imu_height_ -
-                                          BaseUpdate::extrinsics_.position().z();
+                                          Base::extrinsics_.position().z();
     // std::cout << "Pred lid: " << predicted_measurement.distance() << std::endl;
 
     return predicted_measurement;
 }
 
-LidarMeasurement LidarUpdate::measured(const measurements::Measurement& meas)
+template <class Scalar>
+typename LidarUpdateT<Scalar>::MeasurementJacobian LidarUpdateT<Scalar>::jacobian(
+    const State& state)
+{
+    // With c = cos(theta), h = -z / c + const. An attitude error d_theta changes c by
+    // -r * [e_z]x * d_theta = -(r_y, -r_x, 0) * d_theta, where r is the last row of the attitude,
+    // and a position error d_p moves z by r * d_p.
+    const Eigen::Matrix<Scalar, 3, 3> R = state.attitude().matrix();
+    const Scalar cos_theta = R(2, 2);
+    const Scalar z = state.position().z();
+    const Scalar dh_dc = z / (cos_theta * cos_theta);
+
+    MeasurementJacobian H = MeasurementJacobian::Zero();
+    H(0, 0) = -dh_dc * R(2, 1);
+    H(0, 1) = dh_dc * R(2, 0);
+    for (int i = 0; i < 3; i++)
+    {
+        H(0, 3 + i) = -R(2, i) / cos_theta;
+    }
+    return H;
+}
+
+template <class Scalar>
+typename LidarUpdateT<Scalar>::Target LidarUpdateT<Scalar>::measured(
+    const measurements::Measurement& meas)
 {
-    return *(meas.lidar);
+    return meas.lidar->template cast<Scalar>();
 }
 
-void LidarUpdate::operator()(History::Snapshot& snapshot)
+template <class Scalar>
+bool LidarUpdateT<Scalar>::applies(const measurements::Measurement& meas) const
 {
     // Check the validity of the lidar measurements
-    if (!snapshot.measurement.lidar) return;
-    double distance = snapshot.measurement.lidar->distance()(0);
-    if (std::isfinite(distance) && distance >= 0 && distance <= 1.25)
-    {
-        correct(snapshot);
-    }
+    if (!meas.lidar) return false;
+    double distance = meas.lidar->distance()(0);
+    return std::isfinite(distance) && distance >= 0 && distance <= 1.25;
+}
+
+template <class Scalar>
+void LidarUpdateT<Scalar>::operator()(Snapshot& snapshot)
+{
+    if (applies(snapshot.measurement)) correct(snapshot);
 }
+
+template class LidarUpdateT<double>;
+template class LidarUpdateT<float>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
\ No newline at end of file
@@ -6,36 +6,59 @@ namespace gnc
 {
 namespace kalman
 {
-using ErrorStateVector = PFSensorMeasurement::ErrorStateVector;
-using CovarianceMatrix = PFSensorMeasurement::CovarianceMatrix;
-using SensorVector = PFSensorMeasurement::SensorVector;
-
-ErrorStateVector PFSensorMeasurement::operator-(const PFSensorMeasurement& other) const
+template <class Scalar>
+typename PFSensorMeasurementT<Scalar>::ErrorStateVector PFSensorMeasurementT<Scalar>::operator-(
+    const PFSensorMeasurementT& other) const
 {
     return readings_ - other.readings_;
 }
 
-PFSensorMeasurement& PFSensorMeasurement::operator+=(const ErrorStateVector& other)
+template <class Scalar>
+PFSensorMeasurementT<Scalar>& PFSensorMeasurementT<Scalar>::operator+=(
+    const ErrorStateVector& other)
 {
     readings_ += other;
     return *this;
 }
 
-const CovarianceMatrix& PFSensorMeasurement::covariance() const { return covariance_; }
-CovarianceMatrix& PFSensorMeasurement::covariance() { return covariance_; }
-const SensorVector& PFSensorMeasurement::readings() const { return readings_; }
-SensorVector& PFSensorMeasurement::readings() { return readings_; }
-PlaneFitUpdate::PlaneFitUpdate(YAML::Node config) : BaseUpdate(config["planefit"]) {}
-PFSensorMeasurement PlaneFitUpdate::predicted(const State& state)
+template <class Scalar>
+const typename PFSensorMeasurementT<Scalar>::CovarianceMatrix&
+PFSensorMeasurementT<Scalar>::covariance() const
+{
+    return covariance_;
+}
+template <class Scalar>
+typename PFSensorMeasurementT<Scalar>::CovarianceMatrix& PFSensorMeasurementT<Scalar>::covariance()
+{
+    return covariance_;
+}
+template <class Scalar>
+const typename PFSensorMeasurementT<Scalar>::SensorVector& PFSensorMeasurementT<Scalar>::readings()
+    const
+{
+    return readings_;
+}
+template <class Scalar>
+typename PFSensorMeasurementT<Scalar>::SensorVector& PFSensorMeasurementT<Scalar>::readings()
 {
-    const Eigen::Vector3d euler =
+    return readings_;
+}
+template <class Scalar>
+PlaneFitUpdateT<Scalar>::PlaneFitUpdateT(YAML::Node config)
+    : Base(config["planefit"], "planefit")
+{
+}
+template <class Scalar>
+typename PlaneFitUpdateT<Scalar>::Target PlaneFitUpdateT<Scalar>::predicted(const State& state)
+{
+    const Eigen::Matrix<Scalar, 3, 1> euler =
         state.attitude().unit_quaternion().toRotationMatrix().eulerAngles(2, 1, 0);
-    double roll = euler[2];
-    double pitch = euler[1];
-    double height_z = state.position().z();
-    double z_dot = state.velocity().z();
+    Scalar roll = euler[2];
+    Scalar pitch = euler[1];
+    Scalar height_z = state.position().z();
+    Scalar z_dot = state.velocity().z();
 
-    PFSensorMeasurement predicted_measurement;
+    Target predicted_measurement;
     predicted_measurement.readings()(0) = roll;
     predicted_measurement.readings()(1) = pitch;
     predicted_measurement.readings()(2) = height_z;
@@ -44,22 +67,35 @@ PFSensorMeasurement PlaneFitUpdate::predicted(const State& state)
     return predicted_measurement;
 }
 
-PFSensorMeasurement PlaneFitUpdate::measured(const measurements::Measurement& meas)
+template <class Scalar>
+typename PlaneFitUpdateT<Scalar>::Target PlaneFitUpdateT<Scalar>::measured(
+    const measurements::Measurement& meas)
 {
-    PFSensorMeasurement sensor_measurement;
-    sensor_measurement.readings()(0) = meas.plane_fit->roll;
-    sensor_measurement.readings()(1) = meas.plane_fit->pitch;
-    sensor_measurement.readings()(2) = meas.plane_fit->height;
-    sensor_measurement.readings()(3) = meas.plane_fit->vertical_speed;
+    Target sensor_measurement;
+    sensor_measurement.readings()(0) = static_cast<Scalar>(meas.plane_fit->roll);
+    sensor_measurement.readings()(1) = static_cast<Scalar>(meas.plane_fit->pitch);
+    sensor_measurement.readings()(2) = static_cast<Scalar>(meas.plane_fit->height);
+    sensor_measurement.readings()(3) = static_cast<Scalar>(meas.plane_fit->vertical_speed);
     return sensor_measurement;
 }
 
-void PlaneFitUpdate::operator()(History::Snapshot& snapshot)
+template <class Scalar>
+bool PlaneFitUpdateT<Scalar>::applies(const measurements::Measurement& meas) const
 {
     // Check the validity of the plane_fit measurements
-    if (snapshot.measurement.plane_fit) correct(snapshot);
+    return meas.plane_fit != nullptr;
+}
+
+template <class Scalar>
+void PlaneFitUpdateT<Scalar>::operator()(Snapshot& snapshot)
+{
+    if (applies(snapshot.measurement)) correct(snapshot);
 }
 
+template class PFSensorMeasurementT<double>;
+template class PFSensorMeasurementT<float>;
+template class PlaneFitUpdateT<double>;
+template class PlaneFitUpdateT<float>;
 }  // namespace kalman
 }  // namespace gnc
 }  // namespace maav
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <algorithm>
+
+#include <gnc/kalman/updates/VisualOdometryUpdate.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace kalman
+{
+namespace
+{
+/**
+ * Configs without a "visual_odometry" key leave the update disabled
+ */
+YAML::Node updateConfig(YAML::Node config)
+{
+    if (config["visual_odometry"]) return config["visual_odometry"];
+    return YAML::Load(
+        "{enabled: false, enable_outliers: false, UT: {alpha: 0.1, beta: 2.0, kappa: 0.0}, "
+        "R: [1, 1, 1, 1, 1, 1], extrinsics: [0, 0, 0, 0, 0, 0]}");
+}
+}  // namespace
+
+template <class Scalar>
+VisualOdometryUpdateT<Scalar>::VisualOdometryUpdateT(YAML::Node config, size_t history_size)
+    : Base(updateConfig(config), "visual_odometry"),
+      missing_base_(Metrics::instance().counter("update.visual_odometry.missing_base")),
+      counted_until_usec_(0),
+      anchors_(history_size + 1),
+      next_anchor_(0),
+      sensor_state_(0)
+{
+}
+
+template <class Scalar>
+typename VisualOdometryUpdateT<Scalar>::Target VisualOdometryUpdateT<Scalar>::predicted(
+    const State& state)
+{
+    Target predicted_measurement;
+    predicted_measurement.pose() = base_inverse_ * state.getPose();
+    return predicted_measurement;
+}
+
+template <class Scalar>
+typename VisualOdometryUpdateT<Scalar>::MeasurementJacobian VisualOdometryUpdateT<
+    Scalar>::jacobian(const State&)
+{
+    // As for the global update, with the base pose in place of the starting pose
+    MeasurementJacobian H = MeasurementJacobian::Zero();
+    H.template block<3, 3>(0, 3).setIdentity();
+    H.template block<3, 3>(3, 0).setIdentity();
+    return H;
+}
+
+template <class Scalar>
+typename VisualOdometryUpdateT<Scalar>::Target VisualOdometryUpdateT<Scalar>::measured(
+    const measurements::Measurement& meas)
+{
+    return meas.visual_odometry->template cast<Scalar>();
+}
+
+template <class Scalar>
+bool VisualOdometryUpdateT<Scalar>::applies(const measurements::Measurement& meas) const
+{
+    return meas.visual_odometry != nullptr;
+}
+
+template <class Scalar>
+void VisualOdometryUpdateT<Scalar>::operator()(Snapshot& snapshot)
+{
+    if (!this->enabled() || !applies(snapshot.measurement)) return;
+    const measurements::VisualOdometryMeasurement& reading = *snapshot.measurement.visual_odometry;
+
+    const Anchor* base = find(reading.baseTimeUSec());
+    if (base)
+    {
+        base_inverse_ = base->pose.inverse();
+        correct(snapshot);
+    }
+    else if (reading.timeUSec() > counted_until_usec_)
+    {
+        // Replays of the snapshot are not counted again
+        missing_base_.add();
+    }
+    counted_until_usec_ = std::max(counted_until_usec_, reading.timeUSec());
+
+    // A replay keeps the re-filtered pose in place of the old one
+    Anchor* anchor = find(reading.timeUSec());
+    if (!anchor)
+    {
+        anchor = &anchors_[next_anchor_];
+        next_anchor_ = (next_anchor_ + 1) % anchors_.size();
+    }
+    this->extrinsics_(snapshot.state, sensor_state_);
+    anchor->time_usec = reading.timeUSec();
+    anchor->pose = sensor_state_.getPose();
+}
+
+template <class Scalar>
+void VisualOdometryUpdateT<Scalar>::adopt(const VisualOdometryUpdateT& other)
+{
+    counted_until_usec_ = other.counted_until_usec_;
+    anchors_ = other.anchors_;
+    next_anchor_ = other.next_anchor_;
+}
+
+template <class Scalar>
+typename VisualOdometryUpdateT<Scalar>::Anchor* VisualOdometryUpdateT<Scalar>::find(
+    uint64_t time_usec)
+{
+    for (Anchor& anchor : anchors_)
+    {
+        if (anchor.time_usec == time_usec && time_usec != 0) return &anchor;
+    }
+    return nullptr;
+}
+
+template class VisualOdometryUpdateT<double>;
+template class VisualOdometryUpdateT<float>;
+}  // namespace kalman
+}  // namespace gnc
+}  // namespace maav
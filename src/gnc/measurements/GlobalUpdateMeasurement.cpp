@@ -6,39 +6,72 @@ namespace gnc
 {
 namespace measurements
 {
-using ErrorStateVector = GlobalUpdateMeasurement::ErrorStateVector;
-using CovarianceMatrix = GlobalUpdateMeasurement::CovarianceMatrix;
-
-ErrorStateVector GlobalUpdateMeasurement::operator-(const GlobalUpdateMeasurement& other) const
+template <class Scalar>
+typename GlobalUpdateMeasurementT<Scalar>::ErrorStateVector GlobalUpdateMeasurementT<
+    Scalar>::operator-(const GlobalUpdateMeasurementT& other) const
 {
-    const Sophus::SE3d pose_error = other.pose().inverse() * pose();
+    const SE3 pose_error = other.pose().inverse() * pose();
     return pose_error.log();
 }
 
-GlobalUpdateMeasurement& GlobalUpdateMeasurement::operator+=(const ErrorStateVector& other)
+template <class Scalar>
+GlobalUpdateMeasurementT<Scalar>& GlobalUpdateMeasurementT<Scalar>::operator+=(
+    const ErrorStateVector& other)
 {
-    pose() = pose() * Sophus::SE3d::exp(other);
+    pose() = pose() * SE3::exp(other);
     return *this;
 }
 
-const Sophus::SE3d& GlobalUpdateMeasurement::pose() const { return pose_; }
-Sophus::SE3d& GlobalUpdateMeasurement::pose() { return pose_; }
+template <class Scalar>
+const typename GlobalUpdateMeasurementT<Scalar>::SE3& GlobalUpdateMeasurementT<Scalar>::pose() const
+{
+    return pose_;
+}
+template <class Scalar>
+typename GlobalUpdateMeasurementT<Scalar>::SE3& GlobalUpdateMeasurementT<Scalar>::pose()
+{
+    return pose_;
+}
 
-const CovarianceMatrix& GlobalUpdateMeasurement::covariance() const { return covariance_; }
-CovarianceMatrix& GlobalUpdateMeasurement::covariance() { return covariance_; }
+template <class Scalar>
+const typename GlobalUpdateMeasurementT<Scalar>::CovarianceMatrix&
+GlobalUpdateMeasurementT<Scalar>::covariance() const
+{
+    return covariance_;
+}
+template <class Scalar>
+typename GlobalUpdateMeasurementT<Scalar>::CovarianceMatrix&
+GlobalUpdateMeasurementT<Scalar>::covariance()
+{
+    return covariance_;
+}
 
-uint64_t GlobalUpdateMeasurement::timeUSec() const { return time_usec_; }
-void GlobalUpdateMeasurement::setTime(uint64_t time_usec) { time_usec_ = time_usec; }
+template <class Scalar>
+uint64_t GlobalUpdateMeasurementT<Scalar>::timeUSec() const
+{
+    return time_usec_;
+}
+template <class Scalar>
+void GlobalUpdateMeasurementT<Scalar>::setTime(uint64_t time_usec)
+{
+    time_usec_ = time_usec;
+}
 
-std::ostream& operator<<(std::ostream& os, const GlobalUpdateMeasurement& meas)
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const GlobalUpdateMeasurementT<Scalar>& meas)
 {
     std::cout << "Global - Time: " << meas.timeUSec() << '\n';
-    const Eigen::Quaterniond& q = meas.pose().so3().unit_quaternion();
+    const Eigen::Quaternion<Scalar>& q = meas.pose().so3().unit_quaternion();
     std::cout << "Global - Attitude: " << q.w() << ' ' << q.x() << ' ' << q.y() << ' ' << q.z()
               << '\n';
     std::cout << "Global - Position: " << meas.pose().translation().transpose() << '\n';
     return os;
 }
+
+template class GlobalUpdateMeasurementT<double>;
+template class GlobalUpdateMeasurementT<float>;
+template std::ostream& operator<<(std::ostream& os, const GlobalUpdateMeasurementT<double>& meas);
+template std::ostream& operator<<(std::ostream& os, const GlobalUpdateMeasurementT<float>& meas);
 }  // namespace measurements
 }  // namespace gnc
 }  // namespace maav
\ No newline at end of file
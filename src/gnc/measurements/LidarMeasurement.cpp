@@ -6,33 +6,63 @@ namespace gnc
 {
 namespace measurements
 {
-using ErrorStateVector = LidarMeasurement::ErrorStateVector;
-using CovarianceMatrix = LidarMeasurement::CovarianceMatrix;
-using SensorVector = LidarMeasurement::SensorVector;
-
-ErrorStateVector LidarMeasurement::operator-(const LidarMeasurement& other) const
+template <class Scalar>
+typename LidarMeasurementT<Scalar>::ErrorStateVector LidarMeasurementT<Scalar>::operator-(
+    const LidarMeasurementT& other) const
 {
     return distance_ - other.distance_;
 }
 
-LidarMeasurement& LidarMeasurement::operator+=(const ErrorStateVector& other)
+template <class Scalar>
+LidarMeasurementT<Scalar>& LidarMeasurementT<Scalar>::operator+=(const ErrorStateVector& other)
 {
     distance_ += other;
     return *this;
 }
 
-const CovarianceMatrix& LidarMeasurement::covariance() const { return covariance_; }
-CovarianceMatrix& LidarMeasurement::covariance() { return covariance_; }
-const SensorVector& LidarMeasurement::distance() const { return distance_; }
-SensorVector& LidarMeasurement::distance() { return distance_; }
-uint64_t LidarMeasurement::timeUSec() const { return time_usec_; }
-void LidarMeasurement::setTime(uint64_t time_usec) { time_usec_ = time_usec; }
-std::ostream& operator<<(std::ostream& os, const LidarMeasurement& meas)
+template <class Scalar>
+const typename LidarMeasurementT<Scalar>::CovarianceMatrix& LidarMeasurementT<Scalar>::covariance()
+    const
+{
+    return covariance_;
+}
+template <class Scalar>
+typename LidarMeasurementT<Scalar>::CovarianceMatrix& LidarMeasurementT<Scalar>::covariance()
+{
+    return covariance_;
+}
+template <class Scalar>
+const typename LidarMeasurementT<Scalar>::SensorVector& LidarMeasurementT<Scalar>::distance() const
+{
+    return distance_;
+}
+template <class Scalar>
+typename LidarMeasurementT<Scalar>::SensorVector& LidarMeasurementT<Scalar>::distance()
+{
+    return distance_;
+}
+template <class Scalar>
+uint64_t LidarMeasurementT<Scalar>::timeUSec() const
+{
+    return time_usec_;
+}
+template <class Scalar>
+void LidarMeasurementT<Scalar>::setTime(uint64_t time_usec)
+{
+    time_usec_ = time_usec;
+}
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const LidarMeasurementT<Scalar>& meas)
 {
     os << "Lidar - Time: " << meas.timeUSec() << '\n';
     os << "Lidar Dist: " << meas.distance() << '\n';
     return os;
 }
+
+template class LidarMeasurementT<double>;
+template class LidarMeasurementT<float>;
+template std::ostream& operator<<(std::ostream& os, const LidarMeasurementT<double>& meas);
+template std::ostream& operator<<(std::ostream& os, const LidarMeasurementT<float>& meas);
 }
 }
 }
\ No newline at end of file
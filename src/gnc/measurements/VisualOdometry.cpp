@@ -0,0 +1,90 @@
+#include <gnc/measurements/VisualOdometry.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace measurements
+{
+template <class Scalar>
+typename VisualOdometryMeasurementT<Scalar>::ErrorStateVector VisualOdometryMeasurementT<
+    Scalar>::operator-(const VisualOdometryMeasurementT& other) const
+{
+    const SE3 pose_error = other.pose().inverse() * pose();
+    return pose_error.log();
+}
+
+template <class Scalar>
+VisualOdometryMeasurementT<Scalar>& VisualOdometryMeasurementT<Scalar>::operator+=(
+    const ErrorStateVector& other)
+{
+    pose() = pose() * SE3::exp(other);
+    return *this;
+}
+
+template <class Scalar>
+const typename VisualOdometryMeasurementT<Scalar>::SE3& VisualOdometryMeasurementT<Scalar>::pose()
+    const
+{
+    return pose_;
+}
+template <class Scalar>
+typename VisualOdometryMeasurementT<Scalar>::SE3& VisualOdometryMeasurementT<Scalar>::pose()
+{
+    return pose_;
+}
+
+template <class Scalar>
+const typename VisualOdometryMeasurementT<Scalar>::CovarianceMatrix&
+VisualOdometryMeasurementT<Scalar>::covariance() const
+{
+    return covariance_;
+}
+template <class Scalar>
+typename VisualOdometryMeasurementT<Scalar>::CovarianceMatrix&
+VisualOdometryMeasurementT<Scalar>::covariance()
+{
+    return covariance_;
+}
+
+template <class Scalar>
+uint64_t VisualOdometryMeasurementT<Scalar>::timeUSec() const
+{
+    return time_usec_;
+}
+template <class Scalar>
+void VisualOdometryMeasurementT<Scalar>::setTime(uint64_t time_usec)
+{
+    time_usec_ = time_usec;
+}
+
+template <class Scalar>
+uint64_t VisualOdometryMeasurementT<Scalar>::baseTimeUSec() const
+{
+    return base_time_usec_;
+}
+template <class Scalar>
+void VisualOdometryMeasurementT<Scalar>::setBaseTime(uint64_t base_time_usec)
+{
+    base_time_usec_ = base_time_usec;
+}
+
+template <class Scalar>
+std::ostream& operator<<(std::ostream& os, const VisualOdometryMeasurementT<Scalar>& meas)
+{
+    os << "Visual Odometry - Time: " << meas.baseTimeUSec() << " to " << meas.timeUSec() << '\n';
+    const Eigen::Quaternion<Scalar>& q = meas.pose().so3().unit_quaternion();
+    os << "Visual Odometry - Rotation: " << q.w() << ' ' << q.x() << ' ' << q.y() << ' ' << q.z()
+       << '\n';
+    os << "Visual Odometry - Translation: " << meas.pose().translation().transpose() << '\n';
+    return os;
+}
+
+template class VisualOdometryMeasurementT<double>;
+template class VisualOdometryMeasurementT<float>;
+template std::ostream& operator<<(
+    std::ostream& os, const VisualOdometryMeasurementT<double>& meas);
+template std::ostream& operator<<(std::ostream& os, const VisualOdometryMeasurementT<float>& meas);
+}  // namespace measurements
+}  // namespace gnc
+}  // namespace maav
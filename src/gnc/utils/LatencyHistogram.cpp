@@ -0,0 +1,66 @@
+#include <gnc/utils/LatencyHistogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace maav
+{
+namespace gnc
+{
+void LatencyHistogram::add(int64_t latency_usec)
+{
+    buckets_[bucketIndex(latency_usec)]++;
+    count_++;
+    sum_ += static_cast<double>(latency_usec);
+    max_ = std::max(max_, latency_usec);
+}
+
+void LatencyHistogram::reset()
+{
+    buckets_.fill(0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+double LatencyHistogram::mean() const
+{
+    return count_ ? sum_ / static_cast<double>(count_) : 0;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+    if (count_ == 0) return 0;
+
+    // Rank of the sample holding the quantile, counting from 1
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(count_))));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++)
+    {
+        seen += buckets_[i];
+        if (seen >= rank)
+        {
+            return std::min(bucketUpper(i), static_cast<double>(max_));
+        }
+    }
+    return static_cast<double>(max_);
+}
+
+double LatencyHistogram::bucketUpper(size_t bucket)
+{
+    return std::exp2(static_cast<double>(bucket + 1) / BUCKETS_PER_OCTAVE);
+}
+
+size_t LatencyHistogram::bucketIndex(int64_t latency_usec)
+{
+    if (latency_usec <= 1) return 0;
+
+    const double index =
+        std::floor(std::log2(static_cast<double>(latency_usec)) * BUCKETS_PER_OCTAVE);
+    return std::min(static_cast<size_t>(index), NUM_BUCKETS - 1);
+}
+
+}  // namespace gnc
+}  // namespace maav
@@ -0,0 +1,139 @@
+#include <pthread.h>
+#include <sched.h>
+
+#include <gnc/utils/MagnetometerCalibrator.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace
+{
+bool isEnabled(YAML::Node config) { return config && config["enabled"].as<bool>(); }
+
+template <class T>
+T value(YAML::Node config, const char* key, T default_value)
+{
+    return config && config[key] ? config[key].as<T>() : default_value;
+}
+
+std::shared_ptr<const MagParams> uncalibrated()
+{
+    return std::make_shared<const MagParams>(MagParams{
+        Eigen::Vector3d::Zero(), Eigen::Vector3d::Ones(), Eigen::Matrix3d::Identity()});
+}
+}  // namespace
+
+MagnetometerCalibrator::MagnetometerCalibrator(YAML::Node config)
+    : enabled_(isEnabled(config)),
+      min_separation_(value(config, "min_separation", 0.05)),
+      min_samples_(value(config, "min_samples", 200.0)),
+      fit_period_(value<size_t>(config, "fit_period", 50)),
+      max_axis_ratio_(value(config, "max_axis_ratio", 2.0)),
+      fit_(value(config, "forgetting", 1.0)),
+      since_fit_(0),
+      last_reading_(Eigen::Vector3d::Zero()),
+      has_reading_(false),
+      calibration_(uncalibrated()),
+      applied_(0),
+      fits_(Metrics::instance().counter("magnetometer.fits")),
+      rejected_fits_(Metrics::instance().counter("magnetometer.rejected_fits")),
+      samples_(Metrics::instance().gauge("magnetometer.samples")),
+      stop_(false)
+{
+    if (!enabled_) return;
+
+    pending_.reserve(MAX_PENDING);
+    working_.reserve(MAX_PENDING);
+
+    thread_ = std::thread(&MagnetometerCalibrator::work, this);
+
+    // Fitting is never urgent, so it only runs in time the estimator leaves idle
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(thread_.native_handle(), SCHED_IDLE, &param);
+}
+
+MagnetometerCalibrator::~MagnetometerCalibrator()
+{
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void MagnetometerCalibrator::setCalibration(const MagParams& params)
+{
+    std::atomic_store(&calibration_, std::make_shared<const MagParams>(params));
+}
+
+std::shared_ptr<const MagParams> MagnetometerCalibrator::calibration() const
+{
+    return std::atomic_load(&calibration_);
+}
+
+void MagnetometerCalibrator::add(const Eigen::Vector3d& reading)
+{
+    if (!enabled_) return;
+
+    if (has_reading_ &&
+        (reading - last_reading_).norm() < min_separation_ * last_reading_.norm())
+    {
+        return;
+    }
+    last_reading_ = reading;
+    has_reading_ = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= MAX_PENDING) return;
+        pending_.push_back(reading);
+    }
+    wake_.notify_one();
+}
+
+void MagnetometerCalibrator::work()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+            if (stop_) return;
+
+            // Swapping keeps the memory of both buffers
+            std::swap(pending_, working_);
+        }
+
+        for (const Eigen::Vector3d& reading : working_)
+        {
+            fit_.add(reading);
+            if (++since_fit_ >= fit_period_) fit();
+        }
+        working_.clear();
+        samples_.set(fit_.weight());
+    }
+}
+
+void MagnetometerCalibrator::fit()
+{
+    since_fit_ = 0;
+    if (fit_.weight() < min_samples_) return;
+
+    MagParams params;
+    if (!fit_.solve(params) || params.scale.maxCoeff() > max_axis_ratio_ * params.scale.minCoeff())
+    {
+        rejected_fits_.add();
+        return;
+    }
+
+    setCalibration(params);
+    applied_++;
+    fits_.add();
+}
+
+}  // namespace gnc
+}  // namespace maav
@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include <gnc/utils/MagnetometerEllipsoidFit.hpp>
 using Eigen::Matrix4d;
 using Eigen::MatrixXd;
@@ -11,31 +13,36 @@ namespace maav
 {
 namespace gnc
 {
-MagParams runMagnetometerCalibration(const VectorXd& x, const VectorXd& y, const VectorXd& z)
+EllipsoidFit::EllipsoidFit(double forgetting) : forgetting_(forgetting) { reset(); }
+
+void EllipsoidFit::reset()
 {
-    // Algorithm from
-    // https://github.com/martindeegan/drone/blob/master/copter/matlab/ellipsoid_fit.m
+    information_.setZero();
+    target_.setZero();
+    weight_ = 0;
+}
 
-    MatrixXd D(x.size(), 9);
+void EllipsoidFit::add(const Vector3d& reading)
+{
+    const double x = reading.x();
+    const double y = reading.y();
+    const double z = reading.z();
 
-    for (int i = 0; i < (int)x.size(); i++)
-    {
-        D(i, 0) = (x(i) * x(i));
-        D(i, 1) = (y(i) * y(i));
-        D(i, 2) = (z(i) * z(i));
-        D(i, 3) = 2 * x(i) * y(i);
-        D(i, 4) = 2 * z(i) * x(i);
-        D(i, 5) = 2 * y(i) * z(i);
-        D(i, 6) = 2 * x(i);
-        D(i, 7) = 2 * y(i);
-        D(i, 8) = 2 * z(i);
-    }
+    Eigen::Matrix<double, 9, 1> d;
+    d << x * x, y * y, z * z, 2 * x * y, 2 * z * x, 2 * y * z, 2 * x, 2 * y, 2 * z;
+
+    information_ *= forgetting_;
+    information_.noalias() += d * d.transpose();
+    target_ = forgetting_ * target_ + d;
+    weight_ = forgetting_ * weight_ + 1;
+}
 
-    MatrixXd v;
+bool EllipsoidFit::solve(MagParams& params) const
+{
+    // Algorithm from
+    // https://github.com/martindeegan/drone/blob/master/copter/matlab/ellipsoid_fit.m
 
-    v = (D.transpose() * D)
-            .colPivHouseholderQr()
-            .solve(D.transpose() * Eigen::MatrixXd::Ones(D.rows(), 1));
+    const Eigen::Matrix<double, 9, 1> v = information_.colPivHouseholderQr().solve(target_);
 
     Matrix4d A;
     A(0, 0) = v(0);
@@ -80,7 +87,23 @@ MagParams runMagnetometerCalibration(const VectorXd& x, const VectorXd& y, const
 
     Vector3d scale(scale_x, scale_y, scale_z);
 
-    return {offset, scale, rotM};
+    params = {offset, scale, rotM};
+
+    // A hyperboloid or a degenerate fit has an axis that is not positive
+    return offset.allFinite() && (ev.array() > 0).all() && scale.allFinite();
+}
+
+MagParams runMagnetometerCalibration(const VectorXd& x, const VectorXd& y, const VectorXd& z)
+{
+    EllipsoidFit fit;
+    for (int i = 0; i < (int)x.size(); i++)
+    {
+        fit.add(Vector3d(x(i), y(i), z(i)));
+    }
+
+    MagParams params;
+    fit.solve(params);
+    return params;
 }
 }  // namespace gnc
-}  // namespace maav
\ No newline at end of file
+}  // namespace maav
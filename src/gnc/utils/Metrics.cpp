@@ -0,0 +1,70 @@
+#include <gnc/utils/Metrics.hpp>
+
+namespace maav
+{
+namespace gnc
+{
+namespace
+{
+template <class Metric>
+Metric& lookup(std::map<std::string, std::unique_ptr<Metric>>& metrics, const std::string& name)
+{
+    std::unique_ptr<Metric>& metric = metrics[name];
+    if (!metric) metric = std::make_unique<Metric>();
+    return *metric;
+}
+}  // namespace
+
+Metrics& Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Counter& Metrics::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lookup(counters_, name);
+}
+
+Metrics::Gauge& Metrics::gauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lookup(gauges_, name);
+}
+
+Metrics::Histogram& Metrics::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lookup(histograms_, name);
+}
+
+Metrics::Report Metrics::report()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Report report;
+    report.counters.reserve(counters_.size());
+    for (const auto& counter : counters_)
+    {
+        report.counters.emplace_back(counter.first, counter.second->value());
+    }
+
+    report.gauges.reserve(gauges_.size());
+    for (const auto& gauge : gauges_)
+    {
+        report.gauges.emplace_back(gauge.first, gauge.second->value());
+    }
+
+    report.histograms.reserve(histograms_.size());
+    for (const auto& histogram : histograms_)
+    {
+        const LatencyHistogram taken = histogram.second->take();
+        report.histograms.push_back({histogram.first, taken.count(), taken.mean(),
+            taken.percentile(0.5), taken.percentile(0.99), taken.max()});
+    }
+    return report;
+}
+
+}  // namespace gnc
+}  // namespace maav
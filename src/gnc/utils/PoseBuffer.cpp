@@ -0,0 +1,207 @@
+#include <gnc/utils/PoseBuffer.hpp>
+
+#include <thread>
+
+using Sophus::SE3d;
+
+namespace maav
+{
+namespace gnc
+{
+PoseBuffer::PoseBuffer(size_t capacity)
+    : slots_(capacity), begin_(0), end_(0), waiters_(0), interrupted_(false)
+{
+}
+
+void PoseBuffer::push(uint64_t time_usec, const SE3d& pose)
+{
+    const uint64_t begin = begin_.load(std::memory_order_relaxed);
+    uint64_t end = end_.load(std::memory_order_relaxed);
+
+    // Rewind over the poses this one replaces, hiding them from readers first
+    Pose newest;
+    while (end > begin && read(end - 1, newest) && newest.time_usec >= time_usec)
+    {
+        end--;
+    }
+    if (end != end_.load(std::memory_order_relaxed))
+    {
+        end_.store(end, std::memory_order_release);
+    }
+
+    // The oldest pose leaves the ring before its slot is reused
+    if (end - begin == slots_.size())
+    {
+        begin_.store(begin + 1, std::memory_order_release);
+    }
+    write(end, time_usec, pose);
+    end_.store(end + 1, std::memory_order_release);
+
+    // Pairs with the fence in waitFor, so either the waiter sees the pose or this sees the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+        }
+        wait_cv_.notify_all();
+    }
+}
+
+bool PoseBuffer::at(uint64_t time_usec, SE3d& pose) const
+{
+    for (;;)
+    {
+        const uint64_t end = end_.load(std::memory_order_acquire);
+        const uint64_t begin = begin_.load(std::memory_order_acquire);
+        if (begin >= end) return false;
+
+        // Walks back from the newest pose, since most lookups are for recent times
+        Pose newer;
+        Pose older;
+        bool has_newer = false;
+        bool lapped = false;
+        for (uint64_t i = end; i > begin; i--)
+        {
+            if (!read(i - 1, older))
+            {
+                lapped = true;
+                break;
+            }
+            if (older.time_usec <= time_usec) break;
+            newer = older;
+            has_newer = true;
+        }
+        if (lapped) continue;
+
+        if (!has_newer)
+        {
+            // At or after the newest pose
+            pose = older.pose;
+        }
+        else if (older.time_usec > time_usec || newer.time_usec == older.time_usec)
+        {
+            // Before the oldest pose
+            pose = newer.pose;
+        }
+        else
+        {
+            const double s = static_cast<double>(time_usec - older.time_usec) /
+                             static_cast<double>(newer.time_usec - older.time_usec);
+            const Eigen::Quaterniond rotation = older.pose.unit_quaternion().slerp(
+                s, newer.pose.unit_quaternion());
+            const Eigen::Vector3d translation =
+                older.pose.translation() +
+                s * (newer.pose.translation() - older.pose.translation());
+            pose = SE3d(rotation, translation);
+        }
+        return true;
+    }
+}
+
+bool PoseBuffer::waitFor(uint64_t time_usec, std::chrono::microseconds timeout, SE3d& pose)
+{
+    if (!interrupted_ && !reached(time_usec))
+    {
+        waiters_.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            wait_cv_.wait_for(
+                lock, timeout, [&] { return interrupted_ || reached(time_usec); });
+        }
+        waiters_.fetch_sub(1);
+    }
+    if (interrupted_) return false;
+    return at(time_usec, pose);
+}
+
+void PoseBuffer::interrupt()
+{
+    interrupted_ = true;
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+    }
+    wait_cv_.notify_all();
+}
+
+bool PoseBuffer::range(uint64_t& oldest_usec, uint64_t& newest_usec) const
+{
+    for (;;)
+    {
+        const uint64_t end = end_.load(std::memory_order_acquire);
+        const uint64_t begin = begin_.load(std::memory_order_acquire);
+        if (begin >= end) return false;
+
+        Pose oldest;
+        Pose newest;
+        if (read(begin, oldest) && read(end - 1, newest))
+        {
+            oldest_usec = oldest.time_usec;
+            newest_usec = newest.time_usec;
+            return true;
+        }
+    }
+}
+
+bool PoseBuffer::reached(uint64_t time_usec) const
+{
+    uint64_t oldest_usec;
+    uint64_t newest_usec;
+    return range(oldest_usec, newest_usec) && newest_usec >= time_usec;
+}
+
+bool PoseBuffer::read(uint64_t i, Pose& pose) const
+{
+    const Slot& slot = slots_[i % slots_.size()];
+    for (;;)
+    {
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const uint64_t index = slot.index.load(std::memory_order_relaxed);
+        pose.time_usec = slot.time_usec.load(std::memory_order_relaxed);
+        double values[7];
+        for (size_t j = 0; j < 7; j++)
+        {
+            values[j] = slot.values[j].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+        if (index != i) return false;
+
+        pose.pose = SE3d(Eigen::Quaterniond(values[3], values[0], values[1], values[2]),
+            Eigen::Vector3d(values[4], values[5], values[6]));
+        return true;
+    }
+}
+
+void PoseBuffer::write(uint64_t i, uint64_t time_usec, const SE3d& pose)
+{
+    Slot& slot = slots_[i % slots_.size()];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const Eigen::Quaterniond& rotation = pose.unit_quaternion();
+    const Eigen::Vector3d& translation = pose.translation();
+    slot.index.store(i, std::memory_order_relaxed);
+    slot.time_usec.store(time_usec, std::memory_order_relaxed);
+    slot.values[0].store(rotation.x(), std::memory_order_relaxed);
+    slot.values[1].store(rotation.y(), std::memory_order_relaxed);
+    slot.values[2].store(rotation.z(), std::memory_order_relaxed);
+    slot.values[3].store(rotation.w(), std::memory_order_relaxed);
+    slot.values[4].store(translation.x(), std::memory_order_relaxed);
+    slot.values[5].store(translation.y(), std::memory_order_relaxed);
+    slot.values[6].store(translation.z(), std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}  // namespace gnc
+}  // namespace maav
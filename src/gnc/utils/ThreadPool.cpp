@@ -0,0 +1,108 @@
+#include <gnc/utils/ThreadPool.hpp>
+
+#include <chrono>
+
+namespace maav
+{
+namespace gnc
+{
+namespace
+{
+// How long an idle worker polls for the next loop before sleeping
+constexpr std::chrono::microseconds SPIN_TIME{200};
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads)
+    // Polling only pays off when every worker and the caller have a core to themselves
+    : spin_(std::thread::hardware_concurrency() > num_threads),
+      stop_(false),
+      generation_(0),
+      next_(0),
+      done_(0),
+      active_(0)
+{
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        workers_.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(size_t count, Invoke invoke, void* context)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // A worker that picked up the previous job late may still be about to claim an index.
+        // Holding the lock stops any more workers from picking it up while the rest finish.
+        while (active_.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+
+        job_.invoke = invoke;
+        job_.context = context;
+        job_.count = count;
+        next_.store(0);
+        done_.store(0);
+        generation_.fetch_add(1);
+    }
+    wake_.notify_all();
+
+    drain(Job{invoke, context, count});
+
+    while (done_.load() != count)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void ThreadPool::work()
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        const auto spin_end = std::chrono::steady_clock::now() + SPIN_TIME;
+        while (spin_ && generation_.load() == seen && std::chrono::steady_clock::now() < spin_end)
+        {
+        }
+
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_.load() != seen; });
+            if (stop_) return;
+
+            seen = generation_.load();
+            job = job_;
+            active_.fetch_add(1);
+        }
+
+        drain(job);
+        active_.fetch_sub(1);
+    }
+}
+
+void ThreadPool::drain(const Job& job)
+{
+    for (size_t i = next_.fetch_add(1); i < job.count; i = next_.fetch_add(1))
+    {
+        job.invoke(job.context, i);
+        done_.fetch_add(1);
+    }
+}
+
+}  // namespace gnc
+}  // namespace maav
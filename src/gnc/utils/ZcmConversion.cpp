@@ -6,12 +6,20 @@
 using maav::gnc::measurements::GlobalUpdateMeasurement;
 using maav::gnc::measurements::ImuMeasurement;
 using maav::gnc::measurements::LidarMeasurement;
+using maav::gnc::measurements::MeasurementPool;
 using maav::gnc::measurements::PlaneFitMeasurement;
+using maav::gnc::measurements::VisualOdometryMeasurement;
 
 namespace maav
 {
 namespace gnc
 {
+namespace
+{
+// Elements in the upper triangle of the covariance carried by state_lite_t
+constexpr size_t LITE_COVARIANCE_SIZE = State::DoF * (State::DoF + 1) / 2;
+}  // namespace
+
 vector1_t convertVector1d(double vec)
 {
     vector1_t new_vec;
@@ -112,6 +120,12 @@ Sophus::SE3d convertPose(const quaternion_t& rotation, const vector3_t& position
 state_t ConvertState(const State& state)
 {
     state_t zcm_state;
+    ConvertState(state, zcm_state);
+    return zcm_state;
+}
+
+void ConvertState(const State& state, state_t& zcm_state)
+{
     zcm_state.utime = state.timeUSec();
 
     zcm_state.attitude = convertQuaternion(state.attitude());
@@ -124,8 +138,6 @@ state_t ConvertState(const State& state)
     zcm_state.gyro_biases = convertVector3d(state.gyroBias());
     zcm_state.accel_biases = convertVector3d(state.accelBias());
     convertMatrix(state.covariance(), zcm_state.covariance);
-
-    return zcm_state;
 }
 
 State ConvertState(const state_t& zcm_state)
@@ -146,6 +158,61 @@ State ConvertState(const state_t& zcm_state)
     return state;
 }
 
+void ConvertState(const State& state, state_lite_t& zcm_state, bool with_covariance)
+{
+    zcm_state.utime = state.timeUSec();
+
+    zcm_state.attitude = convertQuaternion(state.attitude());
+    zcm_state.position = convertVector3d(state.position());
+    zcm_state.velocity = convertVector3d(state.velocity());
+    zcm_state.gyro_biases = convertVector3d(state.gyroBias());
+    zcm_state.accel_biases = convertVector3d(state.accelBias());
+
+    // Only covariance_size is encoded, so the vector keeps its storage for the next covariance
+    if (!with_covariance)
+    {
+        zcm_state.covariance_size = 0;
+        return;
+    }
+
+    const State::CovarianceMatrix& covariance = state.covariance();
+    zcm_state.covariance_size = static_cast<int32_t>(LITE_COVARIANCE_SIZE);
+    zcm_state.covariance.resize(LITE_COVARIANCE_SIZE);
+    size_t k = 0;
+    for (size_t i = 0; i < State::DoF; i++)
+    {
+        for (size_t j = i; j < State::DoF; j++)
+        {
+            zcm_state.covariance[k++] = covariance(i, j);
+        }
+    }
+}
+
+bool ConvertState(const state_lite_t& zcm_state, State& state)
+{
+    state.setTime(zcm_state.utime);
+    state.attitude() = convertQuaternion(zcm_state.attitude);
+    state.position() = convertVector3d(zcm_state.position);
+    state.velocity() = convertVector3d(zcm_state.velocity);
+    state.gyroBias() = convertVector3d(zcm_state.gyro_biases);
+    state.accelBias() = convertVector3d(zcm_state.accel_biases);
+
+    if (zcm_state.covariance_size != static_cast<int32_t>(LITE_COVARIANCE_SIZE)) return false;
+
+    State::CovarianceMatrix& covariance = state.covariance();
+    size_t k = 0;
+    for (size_t i = 0; i < State::DoF; i++)
+    {
+        for (size_t j = i; j < State::DoF; j++)
+        {
+            covariance(i, j) = zcm_state.covariance[k];
+            covariance(j, i) = zcm_state.covariance[k];
+            k++;
+        }
+    }
+    return true;
+}
+
 State ConvertGroundTruthState(const groundtruth_inertial_t& zcm_state)
 {
     State state(zcm_state.utime);
@@ -213,13 +280,24 @@ Path ConvertPath(const path_t& zcm_path)
 std::shared_ptr<LidarMeasurement> convertLidar(const lidar_t& zcm_lidar)
 {
     std::shared_ptr<LidarMeasurement> lidar(new LidarMeasurement());
+    convertLidar(zcm_lidar, *lidar);
+    return lidar;
+}
 
-    lidar->distance()(0) = convertVector1d(zcm_lidar.distance);
-    lidar->setTime(zcm_lidar.utime);
-
+std::shared_ptr<LidarMeasurement> convertLidar(const lidar_t& zcm_lidar, MeasurementPool& pool)
+{
+    std::shared_ptr<LidarMeasurement> lidar = pool.lidar.acquire();
+    *lidar = LidarMeasurement();
+    convertLidar(zcm_lidar, *lidar);
     return lidar;
 }
 
+void convertLidar(const lidar_t& zcm_lidar, LidarMeasurement& lidar)
+{
+    lidar.distance()(0) = convertVector1d(zcm_lidar.distance);
+    lidar.setTime(zcm_lidar.utime);
+}
+
 // lidar_t convertLidar(const measurements::LidarMeasurement& lidar)
 // {
 //     lidar_t zcm_lidar;
@@ -231,41 +309,90 @@ std::shared_ptr<LidarMeasurement> convertLidar(const lidar_t& zcm_lidar)
 std::shared_ptr<ImuMeasurement> convertImu(const imu_t& zcm_imu)
 {
     std::shared_ptr<ImuMeasurement> imu(new ImuMeasurement);
+    convertImu(zcm_imu, *imu);
+    return imu;
+}
 
-    imu->time_usec = zcm_imu.utime;
+std::shared_ptr<ImuMeasurement> convertImu(const imu_t& zcm_imu, MeasurementPool& pool)
+{
+    std::shared_ptr<ImuMeasurement> imu = pool.imu.acquire();
+    convertImu(zcm_imu, *imu);
+    return imu;
+}
 
-    imu->acceleration = convertVector3d(zcm_imu.acceleration);
-    imu->angular_rates = convertVector3d(zcm_imu.angular_rates);
-    imu->magnetometer = convertVector3d(zcm_imu.magnetometer);
+void convertImu(const imu_t& zcm_imu, ImuMeasurement& imu)
+{
+    imu.time_usec = zcm_imu.utime;
 
-    return imu;
+    imu.acceleration = convertVector3d(zcm_imu.acceleration);
+    imu.angular_rates = convertVector3d(zcm_imu.angular_rates);
+    imu.magnetometer = convertVector3d(zcm_imu.magnetometer);
 }
 
 std::shared_ptr<PlaneFitMeasurement> convertPlaneFit(const plane_fit_t& zcm_plane_fit)
 {
     std::shared_ptr<PlaneFitMeasurement> plane_fit(new PlaneFitMeasurement());
+    convertPlaneFit(zcm_plane_fit, *plane_fit);
+    return plane_fit;
+}
 
-    plane_fit->time_usec = zcm_plane_fit.utime;
+std::shared_ptr<PlaneFitMeasurement> convertPlaneFit(
+    const plane_fit_t& zcm_plane_fit, MeasurementPool& pool)
+{
+    std::shared_ptr<PlaneFitMeasurement> plane_fit = pool.plane_fit.acquire();
+    convertPlaneFit(zcm_plane_fit, *plane_fit);
+    return plane_fit;
+}
 
-    plane_fit->height = convertVector1d(zcm_plane_fit.z);
-    plane_fit->vertical_speed = convertVector1d(zcm_plane_fit.z_dot);
+void convertPlaneFit(const plane_fit_t& zcm_plane_fit, PlaneFitMeasurement& plane_fit)
+{
+    plane_fit.time_usec = zcm_plane_fit.utime;
 
-    plane_fit->roll = convertVector1d(zcm_plane_fit.roll);
-    plane_fit->pitch = convertVector1d(zcm_plane_fit.pitch);
+    plane_fit.height = convertVector1d(zcm_plane_fit.z);
+    plane_fit.vertical_speed = convertVector1d(zcm_plane_fit.z_dot);
 
-    return plane_fit;
+    plane_fit.roll = convertVector1d(zcm_plane_fit.roll);
+    plane_fit.pitch = convertVector1d(zcm_plane_fit.pitch);
 }
 
 std::shared_ptr<GlobalUpdateMeasurement> convertGlobalUpdate(const global_update_t& zcm_global)
 {
     std::shared_ptr<GlobalUpdateMeasurement> global_update(new GlobalUpdateMeasurement());
+    convertGlobalUpdate(zcm_global, *global_update);
+    return global_update;
+}
 
-    global_update->setTime(zcm_global.utime);
-    global_update->pose() = convertPose(zcm_global.attitude, zcm_global.position);
-
+std::shared_ptr<GlobalUpdateMeasurement> convertGlobalUpdate(
+    const global_update_t& zcm_global, MeasurementPool& pool)
+{
+    std::shared_ptr<GlobalUpdateMeasurement> global_update = pool.global_update.acquire();
+    *global_update = GlobalUpdateMeasurement();
+    convertGlobalUpdate(zcm_global, *global_update);
     return global_update;
 }
 
+void convertGlobalUpdate(const global_update_t& zcm_global, GlobalUpdateMeasurement& global_update)
+{
+    global_update.setTime(zcm_global.utime);
+    global_update.pose() = convertPose(zcm_global.attitude, zcm_global.position);
+}
+
+std::shared_ptr<VisualOdometryMeasurement> convertVisualOdometry(
+    const visual_odometry_t& zcm_odometry, MeasurementPool& pool)
+{
+    std::shared_ptr<VisualOdometryMeasurement> visual_odometry = pool.visual_odometry.acquire();
+    *visual_odometry = VisualOdometryMeasurement();
+    convertVisualOdometry(zcm_odometry, *visual_odometry);
+    return visual_odometry;
+}
+
+void convertVisualOdometry(
+    const visual_odometry_t& zcm_odometry, VisualOdometryMeasurement& visual_odometry)
+{
+    visual_odometry.setTime(zcm_odometry.utime);
+    visual_odometry.pose() = convertPose(zcm_odometry.rotation, zcm_odometry.translation);
+}
+
 control::Controller::Parameters convertControlParams(const ctrl_params_t& ctrl_params)
 {
     using Params = control::Controller::Parameters;
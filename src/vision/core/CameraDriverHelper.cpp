@@ -8,11 +8,10 @@
 #include "common/messages/point_cloud_t.hpp"
 #include "common/messages/point_t.hpp"
 #include "common/messages/rgb_image_t.hpp"
+#include "common/messages/visual_odometry_t.hpp"
 
 #include "vision/core/utilities.hpp"
 
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
 // #include <yaml-cpp/node/detail/bool_type.h>
 
 #include <iostream>
@@ -26,9 +25,6 @@ using std::vector;
 using std::chrono::milliseconds;
 using namespace std::literals::chrono_literals;
 
-using pcl::PointCloud;
-using pcl::PointXYZ;
-
 namespace maav::vision
 {
 const string CameraDriverHelper::FORMAT_IPC = "ipc";
@@ -40,10 +36,13 @@ CameraDriverHelper::CameraDriverHelper(YAML::Node config, const string& zcm_form
       publish_rgbd_(config["publish_rgbd"].as<bool>()),
       publish_pc_(config["publish_pointcloud"].as<bool>()),
       publish_pose_(config["publish_pose"].as<bool>()),
+      publish_visual_odometry_(
+          config["publish_visual_odometry"] && config["publish_visual_odometry"].as<bool>()),
       autoexposure_(config["enable_autoexposure"].as<bool>()),
       zcm_{zcm_format},
       camera_(config),
       running_(false),
+      has_last_pose_(false),
       rgbd_channel_(rgbd_channel_in),
       pointcloud_channel_(pointcloud_channel_in),
       pose_channel_(pose_channel_in)
@@ -106,26 +105,23 @@ void CameraDriverHelper::rgbdPublish()
 
 void CameraDriverHelper::pointcloudPublish()
 {
-    PointCloud<PointXYZ>::Ptr cloud;
-    cloud = camera_.getPointCloudBasic();
-
-    point_cloud_t pcd;
-    pcd.size = static_cast<int>(cloud->size());
-    pcd.point_cloud.reserve(cloud->size());
-
-    for (PointXYZ& p : *cloud)
-    {
-        point_t np;
-        np.x = p.x;
-        np.y = p.y;
-        np.z = p.z;
-
-        pcd.point_cloud.push_back(np);
-    }
-
-    pcd.utime = camera_.getUTime();
-
-    zcm_.publish(pointcloud_channel_, &pcd);
+    // Projected straight into the message, which keeps its storage between frames
+    const DepthProjector& projector = camera_.getDepthProjector();
+    point_cloud_.point_cloud.clear();
+    point_cloud_.point_cloud.reserve(projector.width() * projector.height());
+    point_t np;
+    projector.project(static_cast<const uint16_t*>(camera_.getRawDepth()),
+        camera_.getDepthScale(), Eigen::Matrix4d::Identity(), [&](float x, float y, float z) {
+            np.x = x;
+            np.y = y;
+            np.z = z;
+            point_cloud_.point_cloud.push_back(np);
+        });
+    point_cloud_.size = static_cast<int>(point_cloud_.point_cloud.size());
+
+    point_cloud_.utime = camera_.getUTime();
+
+    zcm_.publish(pointcloud_channel_, &point_cloud_);
 }
 
 void CameraDriverHelper::posPublish()
@@ -164,17 +160,32 @@ void CameraDriverHelper::posPublish()
 
     message.utime = camera_.getUTime();
 
-    global_update_t update;
-
     const Eigen::Vector3d position{-data.z_translation_, data.x_translation_, -data.y_translation_};
     const Eigen::Quaterniond attitude{
         data.Qr_rotation_, -data.Qk_rotation_, data.Qi_rotation_, -data.Qj_rotation_};
 
-    update.position = gnc::convertVector3d(position);
-    update.attitude = gnc::convertQuaternion(Sophus::SO3d{attitude});
-    update.utime = message.utime;
+    if (!publish_visual_odometry_)
+    {
+        global_update_t update;
+        update.position = gnc::convertVector3d(position);
+        update.attitude = gnc::convertQuaternion(Sophus::SO3d{attitude});
+        update.utime = message.utime;
 
-    zcm_.publish(GLOBAL_UPDATE_CHANNEL, &update);
+        zcm_.publish(GLOBAL_UPDATE_CHANNEL, &update);
+        return;
+    }
+
+    // The motion since the last frame, which the estimator fuses as visual odometry
+    const Sophus::SE3d pose{Sophus::SO3d{attitude}, position};
+    if (has_last_pose_)
+    {
+        visual_odometry_t odometry;
+        gnc::convertPose(last_pose_.inverse() * pose, odometry.rotation, odometry.translation);
+        odometry.utime = message.utime;
+        zcm_.publish(VISUAL_ODOMETRY_CHANNEL, &odometry);
+    }
+    last_pose_ = pose;
+    has_last_pose_ = true;
 }
 
 }  // namespace maav::vision
@@ -41,6 +41,24 @@ D400CameraInterface::D400CameraInterface(YAML::Node config)
             selection.get_stream(RS2_STREAM_DEPTH).as<rs2::video_stream_profile>();
         depth_intrinsics_ = depth_stream.get_intrinsics();
 
+        // Deprojection is linear in depth, so the point at a depth of 1 is the ray of a pixel
+        const int pixels = depth_intrinsics_.width * depth_intrinsics_.height;
+        Eigen::ArrayXf ray_x(pixels);
+        Eigen::ArrayXf ray_y(pixels);
+        for (int dy{0}; dy < depth_intrinsics_.height; ++dy)
+        {
+            for (int dx{0}; dx < depth_intrinsics_.width; ++dx)
+            {
+                float depth_pixel[2] = {static_cast<float>(dx), static_cast<float>(dy)};
+                float ray[3];
+                rs2_deproject_pixel_to_point(ray, &depth_intrinsics_, depth_pixel, 1);
+                ray_x[dy * depth_intrinsics_.width + dx] = ray[0];
+                ray_y[dy * depth_intrinsics_.width + dx] = ray[1];
+            }
+        }
+        depth_projector_ = std::make_unique<DepthProjector>(depth_intrinsics_.width,
+            depth_intrinsics_.height, std::move(ray_x), std::move(ray_y));
+
         auto color_stream =
             selection.get_stream(RS2_STREAM_COLOR).as<rs2::video_stream_profile>();
         color_intrinsics_ = color_stream.get_intrinsics();
@@ -152,26 +170,10 @@ D400CameraInterface& D400CameraInterface::operator++()
 pcl::PointCloud<pcl::PointXYZ>::Ptr D400CameraInterface::getPointCloudBasic() const
 {
     pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
-    for (int dy{0}; dy < depth_intrinsics_.height; ++dy)
-    {
-        for (int dx{0}; dx < depth_intrinsics_.width; ++dx)
-        {
-            // Retrieve depth value and map it to more "real" coordinates
-            uint16_t depth_value = depth_image_[(dy * depth_intrinsics_.width) + dx];
-            float depth_in_meters = depth_value * scale_;
-            // Skip over values with a depth of zero (not found depth)
-            if (depth_value == 0) continue;
-            // For mapping color to depth
-            // Map from pixel coordinates in the depth image to pixel
-            // coordinates in the color image
-            float depth_pixel[2] = {static_cast<float>(dx), static_cast<float>(dy)};
-            // Projects the depth value into 3-D space
-            float depth_point[3];
-            rs2_deproject_pixel_to_point(
-                depth_point, &depth_intrinsics_, depth_pixel, depth_in_meters);
-            cloud->push_back(pcl::PointXYZ(depth_point[0], depth_point[1], depth_point[2]));
-        }
-    }
+    cloud->reserve(depth_intrinsics_.width * depth_intrinsics_.height);
+    // Pixels with a depth of zero (not found depth) are skipped
+    depth_projector_->project(depth_image_, scale_, Eigen::Matrix4d::Identity(),
+        [&](float x, float y, float z) { cloud->push_back(pcl::PointXYZ(x, y, z)); });
     return cloud;
 }
 
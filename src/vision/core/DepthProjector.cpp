@@ -0,0 +1,24 @@
+#include "vision/core/DepthProjector.hpp"
+
+#include <utility>
+
+namespace maav::vision
+{
+DepthProjector::DepthProjector(int width, int height, float fx, float fy, float ppx, float ppy)
+    : width_(width), height_(height), ray_x_(width * height), ray_y_(width * height)
+{
+    for (int row = 0; row < height; row++)
+    {
+        for (int col = 0; col < width; col++)
+        {
+            ray_x_[row * width + col] = (static_cast<float>(col) - ppx) / fx;
+            ray_y_[row * width + col] = (static_cast<float>(row) - ppy) / fy;
+        }
+    }
+}
+
+DepthProjector::DepthProjector(int width, int height, Eigen::ArrayXf ray_x, Eigen::ArrayXf ray_y)
+    : width_(width), height_(height), ray_x_(std::move(ray_x)), ray_y_(std::move(ray_y))
+{
+}
+}  // namespace maav::vision
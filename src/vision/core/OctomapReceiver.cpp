@@ -0,0 +1,35 @@
+#include "vision/core/OctomapReceiver.hpp"
+
+#include "vision/core/utilities.hpp"
+
+using std::make_shared;
+
+namespace maav::vision
+{
+bool OctomapReceiver::receive(const octomap_t* msg)
+{
+    auto octree = zcmTypeToOctomap(msg);
+    if (!octree) return false;
+    octree_ = octree;
+    utime_ = msg->utime;
+    return true;
+}
+
+bool OctomapReceiver::receive(const octomap_delta_t* msg)
+{
+    if (!octree_ || msg->base_utime != utime_) return false;
+
+    // Copy on write, the last map may still be read by whoever took it from map()
+    if (octree_.use_count() > 1) octree_ = make_shared<octomap::OcTree>(*octree_);
+
+    for (int32_t i = 0; i < msg->num_voxels; ++i)
+    {
+        const octomap::OcTreeKey key(static_cast<uint16_t>(msg->key_x[i]),
+            static_cast<uint16_t>(msg->key_y[i]), static_cast<uint16_t>(msg->key_z[i]));
+        // Not lazy, so only the parents of the changed voxels are updated
+        octree_->setNodeValue(key, msg->log_odds[i]);
+    }
+    utime_ = msg->utime;
+    return true;
+}
+}  // namespace maav::vision
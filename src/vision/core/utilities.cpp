@@ -61,13 +61,34 @@ void maav::vision::octomapToZcmType(const shared_ptr<const octomap::OcTree>& oct
 {
     std::stringstream ss;
     octMap->write(ss);
-    std::string serialized_map = ss.str();
+    const std::string serialized_map = ss.str();
     msg->size = serialized_map.size();
-    msg->data.resize(msg->size);
-    for (unsigned i = 0; i < serialized_map.size(); ++i)
+    msg->data.assign(serialized_map.begin(), serialized_map.end());
+}
+
+void maav::vision::octomapChangesToZcmType(const octomap::OcTree& octMap, octomap_delta_t* msg)
+{
+    const size_t changes = octMap.numChangesDetected();
+    msg->key_x.clear();
+    msg->key_y.clear();
+    msg->key_z.clear();
+    msg->log_odds.clear();
+    msg->key_x.reserve(changes);
+    msg->key_y.reserve(changes);
+    msg->key_z.reserve(changes);
+    msg->log_odds.reserve(changes);
+    for (auto it = octMap.changedKeysBegin(); it != octMap.changedKeysEnd(); ++it)
     {
-        msg->data[i] = serialized_map[i];
+        const octomap::OcTreeKey& key = it->first;
+        // Finds the pruned parent if the voxel was merged after it changed
+        const octomap::OcTreeNode* node = octMap.search(key);
+        if (!node) continue;
+        msg->key_x.push_back(static_cast<int16_t>(key[0]));
+        msg->key_y.push_back(static_cast<int16_t>(key[1]));
+        msg->key_z.push_back(static_cast<int16_t>(key[2]));
+        msg->log_odds.push_back(node->getLogOdds());
     }
+    msg->num_voxels = msg->log_odds.size();
 }
 
 shared_ptr<octomap::OcTree> maav::vision::zcmTypeToOctomap(const octomap_t* msg)
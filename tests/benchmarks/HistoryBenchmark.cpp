@@ -0,0 +1,115 @@
+/**
+ * Measures the per IMU tick cost of kalman::History::add_measurement.
+ *
+ * Simulates a 100 Hz IMU with a delayed lidar on every tick, a delayed plane fit every third tick,
+ * and a global update landing deep in the history every tenth tick. Only the history bookkeeping is
+ * timed; no filter steps are run.
+ *
+ * Usage: HistoryBenchmark [history size] [ticks]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+
+#include <gnc/kalman/History.hpp>
+#include <gnc/measurements/Measurement.hpp>
+
+using maav::gnc::kalman::History;
+using maav::gnc::measurements::GlobalUpdateMeasurement;
+using maav::gnc::measurements::ImuMeasurement;
+using maav::gnc::measurements::LidarMeasurement;
+using maav::gnc::measurements::MeasurementSet;
+using maav::gnc::measurements::PlaneFitMeasurement;
+
+constexpr uint64_t IMU_PERIOD = 10000;       // [us]
+constexpr uint64_t LIDAR_DELAY = 35000;      // [us]
+constexpr uint64_t PLANE_FIT_DELAY = 82000;  // [us]
+constexpr uint64_t GLOBAL_DELAY = 1203000;   // [us]
+
+MeasurementSet createSet(uint64_t tick)
+{
+    const uint64_t time = tick * IMU_PERIOD;
+
+    MeasurementSet set;
+    auto imu = std::make_shared<ImuMeasurement>();
+    imu->time_usec = time;
+    imu->acceleration = Eigen::Vector3d::Zero();
+    imu->angular_rates = Eigen::Vector3d::Zero();
+    imu->magnetometer = Eigen::Vector3d::Zero();
+    set.imu = imu;
+
+    if (time > LIDAR_DELAY)
+    {
+        auto lidar = std::make_shared<LidarMeasurement>();
+        lidar->setTime(time - LIDAR_DELAY);
+        set.lidar = lidar;
+    }
+
+    if (tick % 3 == 0 && time > PLANE_FIT_DELAY)
+    {
+        auto plane_fit = std::make_shared<PlaneFitMeasurement>();
+        plane_fit->time_usec = time - PLANE_FIT_DELAY;
+        set.plane_fit = plane_fit;
+    }
+
+    if (tick % 10 == 0 && time > GLOBAL_DELAY)
+    {
+        auto global_update = std::make_shared<GlobalUpdateMeasurement>();
+        global_update->setTime(time - GLOBAL_DELAY);
+        set.global_update = global_update;
+    }
+
+    return set;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t history_size = argc > 1 ? std::stoul(argv[1]) : 300;
+    const uint64_t ticks = argc > 2 ? std::stoull(argv[2]) : 200000;
+
+    YAML::Node config;
+    config["size"] = history_size;
+    config["tolerance"] = 1000;
+    YAML::Node initial_state_config = YAML::Load(
+        "attitude: [1, 0, 0, 0]\nposition: [0, 0, 0]\nvelocity: [0, 0, 0]\n"
+        "covariance: [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1]");
+    History history(config, initial_state_config);
+
+    // Fill the history before timing
+    uint64_t tick = 0;
+    for (; tick < 2 * history_size; tick++)
+    {
+        history.add_measurement(createSet(tick));
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::duration elapsed = Clock::duration::zero();
+    size_t replayed = 0;
+    for (uint64_t end = tick + ticks; tick < end; tick++)
+    {
+        // Build measurements outside of the timed region
+        const MeasurementSet set = createSet(tick);
+
+        const auto start = Clock::now();
+        auto it_pair = history.add_measurement(set);
+        elapsed += Clock::now() - start;
+
+        replayed += static_cast<size_t>(std::distance(it_pair.first, it_pair.second));
+    }
+
+    const double ns_per_tick =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+        static_cast<double>(ticks);
+
+    std::cout << "History size:        " << history_size << '\n';
+    std::cout << "Ticks:               " << ticks << '\n';
+    std::cout << "Mean snapshots/tick: " << static_cast<double>(replayed) / ticks << '\n';
+    std::cout << "Mean cost/tick:      " << ns_per_tick << " ns" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * Measures how many depth clouds per second RayInserter puts into an octomap, for each number of
+ * threads.
+ *
+ * Simulates a 640x480 depth camera turning in place in a room, looking at walls 2 to 6 m away.
+ * Each run starts from an empty map and updates the inner nodes and prunes every fifth cloud, as
+ * maav-octomap does with the default config.
+ *
+ * Usage: RayInserterBenchmark [clouds] [max threads]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <octomap/OcTree.h>
+#include <octomap/octomap.h>
+
+#include <gnc/RayInserter.hpp>
+
+using maav::gnc::RayInserter;
+
+constexpr int WIDTH = 640;
+constexpr int HEIGHT = 480;
+constexpr double FOCAL_LENGTH = 385;  // [px]
+constexpr double RESOLUTION = 0.05;   // [m]
+constexpr double MAX_RANGE = 10;      // [m]
+constexpr size_t INNER_UPDATE_PERIOD = 5;
+
+/*
+ * Cloud of the camera at yaw looking at a wall whose depth varies smoothly across the image
+ */
+octomap::Pointcloud createCloud(double yaw)
+{
+    octomap::Pointcloud cloud;
+    cloud.reserve(WIDTH * HEIGHT);
+    const double c = std::cos(yaw);
+    const double s = std::sin(yaw);
+    for (int v = 0; v < HEIGHT; v++)
+    {
+        for (int u = 0; u < WIDTH; u++)
+        {
+            const double depth = 4 + 2 * std::sin(u * 0.01 + yaw) * std::cos(v * 0.013);
+            const double x = depth;
+            const double y = (u - WIDTH / 2) * depth / FOCAL_LENGTH;
+            const double z = (v - HEIGHT / 2) * depth / FOCAL_LENGTH;
+            cloud.push_back(c * x - s * y, s * x + c * y, z);
+        }
+    }
+    return cloud;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t num_clouds = argc > 1 ? std::stoul(argv[1]) : 20;
+    const size_t max_threads = argc > 2 ? std::stoul(argv[2])
+                                        : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<octomap::Pointcloud> clouds;
+    for (size_t i = 0; i < num_clouds; i++)
+    {
+        clouds.push_back(createCloud(i * 0.1));
+    }
+    const octomap::point3d origin(0, 0, 0);
+
+    std::cout << "threads  clouds/s" << std::endl;
+    for (size_t threads = 1; threads <= max_threads; threads++)
+    {
+        octomap::OcTree tree(RESOLUTION);
+        RayInserter inserter(threads - 1, MAX_RANGE);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_clouds; i++)
+        {
+            inserter.insert(tree, clouds[i], origin);
+            if ((i + 1) % INNER_UPDATE_PERIOD == 0)
+            {
+                tree.updateInnerOccupancy();
+                tree.prune();
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << threads << "        " << num_clouds / elapsed.count() << std::endl;
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * Compares the two ways of calling a transform from kalman::UnscentedTransform.
+ *
+ * For the prediction and each update in the estimator config, one transform goes through the
+ * default std::function (type-erased, returns each point by value) and the other uses the
+ * functor type the filter itself uses (called directly, prediction writes points in place).
+ * Both draw sigma points from the same state, so the difference is only the call path.
+ *
+ * Usage: UnscentedTransformBenchmark [estimator config] [iterations]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+
+#include <common/utils/yaml_matrix.hpp>
+#include <gnc/State.hpp>
+#include <gnc/kalman/History.hpp>
+#include <gnc/kalman/Prediction.hpp>
+#include <gnc/kalman/UnscentedTransform.hpp>
+#include <gnc/kalman/updates/GlobalUpdate.hpp>
+#include <gnc/kalman/updates/LidarUpdate.hpp>
+#include <gnc/kalman/updates/PlanefitUpdate.hpp>
+#include <gnc/measurements/Measurement.hpp>
+
+using maav::gnc::State;
+using maav::gnc::kalman::GlobalUpdate;
+using maav::gnc::kalman::History;
+using maav::gnc::kalman::LidarUpdate;
+using maav::gnc::kalman::PlaneFitUpdate;
+using maav::gnc::kalman::UkfPrediction;
+using maav::gnc::kalman::UnscentedTransform;
+using maav::gnc::measurements::ImuMeasurement;
+
+// Keeps results alive so the transforms are not optimized away
+volatile double sink;
+
+/**
+ * @return Mean time per transform in nanoseconds
+ */
+template <class UT>
+double timeTransform(UT& ut, const State& state, size_t iterations)
+{
+    for (size_t i = 0; i < iterations / 10; i++)
+    {
+        sink = ut(state).covariance()(0, 0);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        sink = ut(state).covariance()(0, 0);
+    }
+    const auto elapsed = Clock::now() - start;
+
+    return static_cast<double>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           static_cast<double>(iterations);
+}
+
+template <class ErasedUT, class InlineUT>
+void compare(const std::string& name, ErasedUT& erased, InlineUT& inlined, const State& state,
+    size_t iterations)
+{
+    const double erased_ns = timeTransform(erased, state, iterations);
+    const double inline_ns = timeTransform(inlined, state, iterations);
+
+    std::cout << name << '\n';
+    std::cout << "  std::function: " << erased_ns << " ns\n";
+    std::cout << "  functor:       " << inline_ns << " ns\n";
+    std::cout << "  speedup:       " << erased_ns / inline_ns << "x" << std::endl;
+}
+
+std::shared_ptr<ImuMeasurement> createImu(uint64_t time)
+{
+    auto imu = std::make_shared<ImuMeasurement>();
+    imu->time_usec = time;
+    imu->acceleration = {0.1, -0.2, -9.7};
+    imu->angular_rates = {0.01, 0.02, -0.03};
+    imu->magnetometer = Eigen::Vector3d::Zero();
+    return imu;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string config_path =
+        argc > 1 ? argv[1] : "../../config/gnc/estimator-config.yaml";
+    const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 20000;
+
+    YAML::Node config = YAML::LoadFile(config_path);
+
+    State state = State::zero(0);
+    state.covariance().diagonal() =
+        config["state"]["covariance"].as<Eigen::Matrix<double, State::DoF, 1>>();
+
+    std::cout << "Config:     " << config_path << '\n';
+    std::cout << "Iterations: " << iterations << '\n';
+
+    // Prediction reads the snapshots it is propagating between, so run it once to set them
+    UkfPrediction prediction(config["prediction"]);
+    History::Snapshot prev;
+    History::Snapshot next;
+    prev.state = state;
+    prev.measurement.imu = createImu(0);
+    next.measurement.imu = createImu(10000);
+    next.state.setTime(10000);
+    prediction(prev, next);
+
+    {
+        const UkfPrediction::Predictor predictor{&prediction};
+        UnscentedTransform<State> erased(config["prediction"]["UT"], true);
+        erased.set_transformation([predictor](const State& point) {
+            State next_point;
+            predictor(point, next_point);
+            return next_point;
+        });
+        UnscentedTransform<State, UkfPrediction::Predictor> inlined(
+            config["prediction"]["UT"], true);
+        inlined.set_transformation(predictor);
+        compare("Prediction", erased, inlined, state, iterations);
+    }
+
+    YAML::Node updates_config = config["updates"];
+    using std::placeholders::_1;
+
+    {
+        LidarUpdate lidar(updates_config);
+        UnscentedTransform<LidarUpdate::Predictor::Target> erased(updates_config["lidar"]["UT"]);
+        erased.set_transformation(std::bind(&LidarUpdate::predicted, &lidar, _1));
+        UnscentedTransform<LidarUpdate::Predictor::Target, LidarUpdate::Predictor> inlined(
+            updates_config["lidar"]["UT"]);
+        inlined.set_transformation(LidarUpdate::Predictor{&lidar});
+        compare("Lidar update", erased, inlined, state, iterations);
+    }
+
+    {
+        PlaneFitUpdate plane_fit(updates_config);
+        UnscentedTransform<PlaneFitUpdate::Predictor::Target> erased(
+            updates_config["planefit"]["UT"]);
+        erased.set_transformation(std::bind(&PlaneFitUpdate::predicted, &plane_fit, _1));
+        UnscentedTransform<PlaneFitUpdate::Predictor::Target, PlaneFitUpdate::Predictor> inlined(
+            updates_config["planefit"]["UT"]);
+        inlined.set_transformation(PlaneFitUpdate::Predictor{&plane_fit});
+        compare("Plane fit update", erased, inlined, state, iterations);
+    }
+
+    {
+        GlobalUpdate global_update(updates_config);
+        UnscentedTransform<GlobalUpdate::Predictor::Target> erased(
+            updates_config["global_update"]["UT"]);
+        erased.set_transformation(std::bind(&GlobalUpdate::predicted, &global_update, _1));
+        UnscentedTransform<GlobalUpdate::Predictor::Target, GlobalUpdate::Predictor> inlined(
+            updates_config["global_update"]["UT"]);
+        inlined.set_transformation(GlobalUpdate::Predictor{&global_update});
+        compare("Global update", erased, inlined, state, iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#define BOOST_TEST_MODULE AdaptiveNoiseTest
+
+#include <random>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include <gnc/kalman/AdaptiveNoise.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Estimator;
+using maav::gnc::kalman::AdaptiveNoise;
+using maav::gnc::measurements::MeasurementSet;
+
+using Noise2 = AdaptiveNoise<double, 2>;
+
+YAML::Node windowConfig(size_t window)
+{
+    YAML::Node config;
+    config["enabled"] = true;
+    config["window"] = window;
+    return config;
+}
+
+BOOST_AUTO_TEST_CASE(DisabledTest)
+{
+    Noise2 noise(YAML::Node(), {1, 2}, {0, 0}, {10, 10});
+    BOOST_CHECK(!noise.enabled());
+    BOOST_CHECK(!noise.add(1, {5, 5}, {0, 0}));
+    BOOST_CHECK_EQUAL(noise.estimate(), Eigen::Vector2d(1, 2));
+}
+
+BOOST_AUTO_TEST_CASE(WindowTest)
+{
+    Noise2 noise(windowConfig(4), {1, 1}, {0, 0}, {10, 10});
+    BOOST_REQUIRE(noise.enabled());
+
+    // Nothing changes until the window is full
+    for (uint64_t t = 1; t < 4; t++)
+    {
+        BOOST_CHECK(!noise.add(t, {2, 3}, {1, 1}));
+        BOOST_CHECK_EQUAL(noise.estimate(), Eigen::Vector2d(1, 1));
+    }
+    BOOST_CHECK(noise.add(4, {2, 3}, {1, 1}));
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 1, 1e-9);
+    BOOST_CHECK_CLOSE(noise.estimate()(1), 2, 1e-9);
+
+    // The oldest samples drop out as new ones come in
+    for (uint64_t t = 5; t < 9; t++)
+    {
+        BOOST_CHECK(noise.add(t, {6, 7}, {1, 1}));
+    }
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 5, 1e-9);
+    BOOST_CHECK_CLOSE(noise.estimate()(1), 6, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(IntervalsTest)
+{
+    Noise2 noise(windowConfig(2), {1, 1}, {0, 0}, {10, 10});
+    noise.add(1, {4, 8}, {0, 0}, 2);
+    BOOST_CHECK(noise.add(2, {4, 8}, {0, 0}, 2));
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 2, 1e-9);
+    BOOST_CHECK_CLOSE(noise.estimate()(1), 4, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(BoundsTest)
+{
+    Noise2 noise(windowConfig(2), {1, 1}, {0.5, 0.5}, {3, 3});
+    noise.add(1, {0, 100}, {1, 0});
+    noise.add(2, {0, 100}, {1, 0});
+    BOOST_CHECK_EQUAL(noise.estimate(), Eigen::Vector2d(0.5, 3));
+}
+
+BOOST_AUTO_TEST_CASE(ReplayTest)
+{
+    Noise2 noise(windowConfig(2), {1, 1}, {0, 0}, {100, 100});
+    noise.add(10, {2, 2}, {0, 0});
+    BOOST_CHECK(noise.add(20, {4, 4}, {0, 0}));
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 3, 1e-9);
+
+    // Re-filtered snapshots come in again with their old times and replace their samples
+    BOOST_CHECK(noise.add(10, {6, 6}, {0, 0}));
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 5, 1e-9);
+
+    // A snapshot inserted by a delayed measurement takes its place by time
+    BOOST_CHECK(noise.add(15, {8, 8}, {0, 0}));
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 6, 1e-9);
+
+    // Older than the whole window
+    BOOST_CHECK(!noise.add(5, {50, 50}, {0, 0}));
+    BOOST_CHECK_CLOSE(noise.estimate()(0), 6, 1e-9);
+}
+
+constexpr double LIDAR_STDDEV = 0.05;
+
+/*
+ * Hovers in place with a lidar much noisier than its configured R
+ */
+Estimator::Noise hoverNoisyLidar(const std::string& filter, bool adapt_process)
+{
+    YAML::Node config = estimatorConfig();
+    for (size_t i = 0; i < 3; i++) config["prediction"]["Q_i"][i] = 1e-6;
+    config["updates"]["lidar"]["adaptive"] =
+        YAML::Load("{enabled: true, window: 100, R_min: [1e-5], R_max: [1]}");
+    config["filter"] = filter;
+    config["prediction"]["adaptive"]["enabled"] = adapt_process;
+    config["prediction"]["adaptive"]["window"] = 100;
+    config["prediction"]["adaptive"]["min_scale"] = 0.1;
+    config["prediction"]["adaptive"]["max_scale"] = 10;
+    Estimator estimator(config);
+    BOOST_REQUIRE(estimator.adaptiveNoise());
+
+    const Estimator::Noise initial = estimator.noise();
+    BOOST_CHECK_CLOSE(initial.lidar_R(0), 0.0001, 1e-9);
+
+    std::mt19937 generator(42);
+    std::normal_distribution<double> lidar_noise(0, LIDAR_STDDEV);
+    for (uint64_t tick = 0; tick < 1500; tick++)
+    {
+        MeasurementSet set = createSet(tick, estimator.measurementPool());
+        if (tick % 5 == 0)
+        {
+            addLidar(set, estimator.measurementPool(), 0.2 + lidar_noise(generator));
+        }
+        estimator.add_measurement_set(set);
+    }
+    return estimator.noise();
+}
+
+/*
+ * With Q fixed, R adapts to the actual lidar noise
+ */
+void checkLidarR(const std::string& filter)
+{
+    const Estimator::Noise adapted = hoverNoisyLidar(filter, false);
+    const double variance = LIDAR_STDDEV * LIDAR_STDDEV;
+    BOOST_CHECK_GT(adapted.lidar_R(0), 0.5 * variance);
+    BOOST_CHECK_LT(adapted.lidar_R(0), 2 * variance);
+}
+
+/*
+ * Q stays within its bounds, and the position rows, which get no process noise, stay at zero
+ */
+void checkProcessQ(const std::string& filter)
+{
+    const Estimator::Noise adapted = hoverNoisyLidar(filter, true);
+    const double q_gyro = 1e-6;
+    BOOST_CHECK_GE(adapted.Q(0), 0.1 * q_gyro);
+    BOOST_CHECK_LE(adapted.Q(0), 10 * q_gyro);
+    BOOST_CHECK_EQUAL(adapted.Q.segment<3>(3), Eigen::Vector3d::Zero());
+}
+
+BOOST_AUTO_TEST_CASE(UkfLidarTest) { checkLidarR("ukf"); }
+
+BOOST_AUTO_TEST_CASE(EskfLidarTest) { checkLidarR("eskf"); }
+
+BOOST_AUTO_TEST_CASE(UkfProcessTest) { checkProcessQ("ukf"); }
+
+BOOST_AUTO_TEST_CASE(EskfProcessTest) { checkProcessQ("eskf"); }
@@ -0,0 +1,218 @@
+#define BOOST_TEST_MODULE EskfTest
+/**
+ * Tests for the error state EKF backend: the analytic Jacobians it relies on and how closely it
+ * tracks the UKF
+ */
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+#include <sophus/so3.hpp>
+
+#include <gnc/Constants.hpp>
+#include <gnc/kalman/Extrinsics.hpp>
+#include <gnc/kalman/Prediction.hpp>
+#include <gnc/kalman/updates/GlobalUpdate.hpp>
+#include <gnc/kalman/updates/LidarUpdate.hpp>
+
+using namespace boost::unit_test;
+using namespace Eigen;
+
+using namespace maav::gnc::kalman;
+using namespace maav::gnc;
+
+namespace
+{
+const std::string PREDICTION_CONFIG =
+    "UT:\n  alpha: 0.1\n  beta: 2.0\n  kappa: 0.0\nQ_i: [0.00005, 0.00005, 0.00005, 0.00002, "
+    "0.00002, 0.00002, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001]\n";
+
+const std::string UPDATES_CONFIG =
+    "imu_height: 0.0\n"
+    "lidar:\n  enabled: true\n  enable_outliers: false\n  lidar_bias: 0.0\n  UT:\n    alpha: "
+    "0.1\n    beta: 2.0\n    kappa: 0.0\n  R: [0.01]\n  extrinsics: [0, 0, 0, 0, 0, 0]\n"
+    "global_update:\n  enabled: true\n  enable_outliers: false\n  UT:\n    alpha: 0.1\n    beta: "
+    "2.0\n    kappa: 0.0\n  R: [0.01, 0.01, 0.01, 0.01, 0.01, 0.01]\n  extrinsics: [0, 0, 0, 0, "
+    "0, 0]\n";
+
+measurements::ImuMeasurement createImu(
+    uint64_t time, const Vector3d& angular_rates, const Vector3d& acceleration)
+{
+    measurements::ImuMeasurement imu;
+    imu.time_usec = time;
+    imu.angular_rates = angular_rates;
+    imu.acceleration = acceleration;
+    imu.magnetometer = Vector3d::Zero();
+    return imu;
+}
+
+State createState()
+{
+    State state = State::zero(0);
+    state.attitude() = Sophus::SO3d::exp(Vector3d{0.1, -0.2, 0.7});
+    state.position() = {1.0, -2.0, -1.5};
+    state.velocity() = {0.4, 0.1, -0.2};
+    state.gyroBias() = {0.01, -0.02, 0.005};
+    state.accelBias() = {-0.05, 0.02, 0.1};
+    return state;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(PredictionJacobianTest)
+{
+    const measurements::ImuMeasurement imu1 = createImu(0, {0.3, -0.1, 0.5}, {0.5, -0.3, -9.6});
+    const measurements::ImuMeasurement imu2 =
+        createImu(10000, {0.35, -0.05, 0.45}, {0.6, -0.2, -9.9});
+    constexpr double dt = 0.01;
+
+    const State state = createState();
+    const State::CovarianceMatrix F = EskfPrediction::errorJacobian(
+        state.gyroBias(), state.accelBias(), imu1, imu2, dt);
+
+    State nominal = State::zero(0);
+    integrateImu(state, imu1, imu2, dt, nominal);
+
+    // Central differences of the propagated error for a small error in the previous state
+    constexpr double STEP = 1e-6;
+    State::CovarianceMatrix F_numeric;
+    for (size_t i = 0; i < State::DoF; i++)
+    {
+        const State::ErrorStateVector step = STEP * State::ErrorStateVector::Unit(i);
+        State plus = state;
+        State minus = state;
+        plus += step;
+        minus += -step;
+
+        State next_plus = State::zero(0);
+        State next_minus = State::zero(0);
+        integrateImu(plus, imu1, imu2, dt, next_plus);
+        integrateImu(minus, imu1, imu2, dt, next_minus);
+        F_numeric.col(i) = ((next_plus - nominal) - (next_minus - nominal)) / (2 * STEP);
+    }
+
+    // The right Jacobian of the attitude increment is taken as identity, which is exact to first
+    // order in dt
+    BOOST_CHECK_LE((F - F_numeric).cwiseAbs().maxCoeff(), 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(PredictionCovarianceTest)
+{
+    const YAML::Node config = YAML::Load(PREDICTION_CONFIG);
+    UkfPrediction ukf(config);
+    EskfPrediction eskf(config);
+
+    History::Snapshot ukf_prev;
+    History::Snapshot ukf_next;
+    ukf_prev.state = createState();
+    ukf_prev.state.covariance() *= 0.01;
+    ukf_prev.measurement.imu = std::make_shared<measurements::ImuMeasurement>(
+        createImu(0, {0.3, -0.1, 0.5}, {0.5, -0.3, -9.6}));
+    ukf_next.state = State::zero(10000);
+    ukf_next.measurement.imu = std::make_shared<measurements::ImuMeasurement>(
+        createImu(10000, {0.35, -0.05, 0.45}, {0.6, -0.2, -9.9}));
+    History::Snapshot eskf_prev = ukf_prev;
+    History::Snapshot eskf_next = ukf_next;
+
+    ukf(ukf_prev, ukf_next);
+    eskf(eskf_prev, eskf_next);
+
+    // Over a single short step the two filters see an almost linear system
+    const State& expected = ukf_next.state;
+    const State& actual = eskf_next.state;
+    BOOST_CHECK_EQUAL(actual.timeUSec(), expected.timeUSec());
+    BOOST_CHECK_LE((actual - expected).norm(), 1e-6);
+    BOOST_CHECK_LE((actual.covariance() - expected.covariance()).cwiseAbs().maxCoeff(), 1e-6);
+}
+
+template <class Update>
+void checkMeasurementJacobian(Update& update, const State& state, double tol)
+{
+    const typename Update::MeasurementJacobian H = update.jacobian(state);
+
+    constexpr double STEP = 1e-6;
+    typename Update::MeasurementJacobian H_numeric;
+    for (size_t i = 0; i < State::DoF; i++)
+    {
+        const State::ErrorStateVector step = STEP * State::ErrorStateVector::Unit(i);
+        State plus = state;
+        State minus = state;
+        plus += step;
+        minus += -step;
+        H_numeric.col(i) = (update.predicted(plus) - update.predicted(minus)) / (2 * STEP);
+    }
+
+    BOOST_CHECK_LE((H - H_numeric).cwiseAbs().maxCoeff(), tol);
+}
+
+BOOST_AUTO_TEST_CASE(ExtrinsicsJacobianTest)
+{
+    const Extrinsics extrinsics(YAML::Load("[-0.02, 0.15, 0.05, 0.1, -1.57, 0.2]"));
+    const State state = createState();
+    const State sensor_state = extrinsics(state);
+
+    constexpr double STEP = 1e-6;
+    State::CovarianceMatrix J_numeric;
+    for (size_t i = 0; i < State::DoF; i++)
+    {
+        const State::ErrorStateVector step = STEP * State::ErrorStateVector::Unit(i);
+        State plus = state;
+        State minus = state;
+        plus += step;
+        minus += -step;
+        J_numeric.col(i) =
+            ((extrinsics(plus) - sensor_state) - (extrinsics(minus) - sensor_state)) / (2 * STEP);
+    }
+
+    BOOST_CHECK_LE((extrinsics.errorJacobian() - J_numeric).cwiseAbs().maxCoeff(), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(LidarJacobianTest)
+{
+    LidarUpdate update(YAML::Load(UPDATES_CONFIG));
+    checkMeasurementJacobian(update, createState(), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(GlobalUpdateJacobianTest)
+{
+    GlobalUpdate update(YAML::Load(UPDATES_CONFIG));
+    State start = createState();
+    start.attitude() = Sophus::SO3d::exp(Vector3d{-0.3, 0.1, 1.2});
+    start.position() = {4.0, 1.0, -0.5};
+
+    // The first prediction fixes the starting pose
+    update.predicted(start);
+    checkMeasurementJacobian(update, createState(), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(LidarCorrectionTest)
+{
+    LidarUpdate update(YAML::Load(UPDATES_CONFIG));
+    update.set_filter(FilterType::ESKF);
+
+    State state = State::zero(1000);
+    state.position() = {0, 1, -1};
+    state.covariance() *= 0.01;
+
+    measurements::Measurement measurement;
+    measurement.imu = std::make_shared<measurements::ImuMeasurement>(
+        createImu(1000, Vector3d::Zero(), {0, 0, -constants::STANDARD_GRAVITY}));
+    measurements::LidarMeasurement lidar;
+    lidar.distance() = measurements::LidarMeasurement::SensorVector{1.1};
+    lidar.setTime(1000);
+    measurement.lidar = std::make_shared<measurements::LidarMeasurement>(lidar);
+
+    History::Snapshot snapshot(state, measurement);
+    update(snapshot);
+
+    // The measured range is longer than predicted, so the vehicle moves up (more negative z) and
+    // the height becomes more certain
+    BOOST_CHECK_LT(snapshot.state.position().z(), -1.0);
+    BOOST_CHECK_GT(snapshot.state.position().z(), -1.1);
+    BOOST_CHECK_LT(snapshot.state.covariance()(5, 5), state.covariance()(5, 5));
+    BOOST_CHECK((snapshot.state.covariance() - snapshot.state.covariance().transpose())
+                    .cwiseAbs()
+                    .maxCoeff() < 1e-12);
+}
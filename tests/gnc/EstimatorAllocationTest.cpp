@@ -0,0 +1,121 @@
+#define BOOST_TEST_MODULE EstimatorAllocationTest
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/measurements/MeasurementPool.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Estimator;
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+
+/*
+ * Every heap allocation in this executable goes through these, so the test can count the ones
+ * made while the estimator runs.
+ */
+static std::atomic<size_t> allocations(0);
+
+static void* countedAlloc(std::size_t size)
+{
+    allocations++;
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    allocations++;
+    const size_t alignment = static_cast<size_t>(align);
+    void* pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return countedAlignedAlloc(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return countedAlignedAlloc(size, align);
+}
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+// Enough to fill the history a few times over before counting
+constexpr uint64_t WARM_UP_TICKS = 500;
+constexpr uint64_t COUNTED_TICKS = 500;
+
+/*
+ * IMU at 100 Hz, lidar every 5th sample and a global update every 10th sample, 25 ms late
+ */
+MeasurementSet createFlightSet(uint64_t tick, MeasurementPool& pool)
+{
+    MeasurementSet set = createSet(tick, pool, {0.1, 0, -9.80665}, {0, 0, 0.01});
+    if (tick % 5 == 0) addLidar(set, pool, 0.17);
+
+    if (tick % 10 == 0)
+    {
+        auto global_update = pool.global_update.acquire();
+        global_update->setTime(tick * IMU_PERIOD - 25000);
+        global_update->pose() = Sophus::SE3d();
+        global_update->pose().translation() = {0.001 * static_cast<double>(tick), 0, 0};
+        set.global_update = global_update;
+    }
+    return set;
+}
+
+/*
+ * Runs the estimator to a full history, then counts allocations over the following ticks
+ */
+size_t countAllocations(const char* filter, double filter_rate)
+{
+    YAML::Node config = estimatorConfig();
+    config["history"]["size"] = 50;
+    config["updates"]["global_update"]["enabled"] = true;
+    config["filter"] = filter;
+    config["filter_rate"] = filter_rate;
+    Estimator estimator(config);
+
+    uint64_t tick = 1;
+    for (; tick <= WARM_UP_TICKS; tick++)
+    {
+        estimator.add_measurement_set(createFlightSet(tick, estimator.measurementPool()));
+    }
+
+    const size_t before = allocations;
+    for (; tick <= WARM_UP_TICKS + COUNTED_TICKS; tick++)
+    {
+        estimator.add_measurement_set(createFlightSet(tick, estimator.measurementPool()));
+    }
+    return allocations - before;
+}
+
+BOOST_AUTO_TEST_CASE(UkfTest) { BOOST_CHECK_EQUAL(countAllocations("ukf", 0), 0); }
+
+BOOST_AUTO_TEST_CASE(EskfTest) { BOOST_CHECK_EQUAL(countAllocations("eskf", 0), 0); }
+
+BOOST_AUTO_TEST_CASE(UkfFilterRateTest) { BOOST_CHECK_EQUAL(countAllocations("ukf", 25), 0); }
+
+BOOST_AUTO_TEST_CASE(EskfFilterRateTest) { BOOST_CHECK_EQUAL(countAllocations("eskf", 25), 0); }
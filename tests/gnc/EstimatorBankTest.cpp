@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE EstimatorBankTest
+
+#include <functional>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/EstimatorBank.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::EstimatorBank;
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+
+YAML::Node createConfig()
+{
+    YAML::Node config = estimatorConfig();
+    config["updates"]["lidar"]["enabled"] = false;
+    config["updates"]["global_update"]["enabled"] = true;
+    config["updates"]["global_update"]["enable_outliers"] = true;
+    config["bank"] = YAML::Load(
+        "{enabled: true, fade: 0.5, switch_margin: 10, "
+        "hypotheses: [{}, {inflate_outliers: true}]}");
+    return config;
+}
+
+// Global updates at 10 Hz
+constexpr uint64_t GLOBAL_PERIOD = 10;
+constexpr uint64_t JUMP_TICK = 300;
+constexpr uint64_t TICKS = 600;
+
+/*
+ * Hovers at the origin while SLAM reports x = slam_x(tick)
+ */
+MeasurementSet createSlamSet(
+    uint64_t tick, MeasurementPool& pool, const std::function<double(uint64_t)>& slam_x)
+{
+    MeasurementSet set = createSet(tick, pool);
+    if (tick % GLOBAL_PERIOD == 0)
+    {
+        auto global_update = pool.global_update.acquire();
+        global_update->setTime(tick * IMU_PERIOD);
+        global_update->pose() = Sophus::SE3d();
+        global_update->pose().translation() = {slam_x(tick), 0, 0};
+        set.global_update = global_update;
+    }
+    return set;
+}
+
+/*
+ * SLAM relocalizes 2 m away. The gated hypothesis rejects every reading from then on, the
+ * inflating one jumps, and the bank follows it after the second reading.
+ */
+void checkRelocalization(const char* filter)
+{
+    YAML::Node config = createConfig();
+    config["filter"] = filter;
+    EstimatorBank bank(config);
+    BOOST_REQUIRE_EQUAL(bank.size(), 2u);
+
+    const auto slam_x = [](uint64_t tick) { return tick < JUMP_TICK ? 0.0 : 2.0; };
+    uint64_t switch_tick = 0;
+    double x = 0;
+    for (uint64_t tick = 1; tick <= TICKS; tick++)
+    {
+        const MeasurementSet set = createSlamSet(tick, bank.measurementPool(), slam_x);
+        x = bank.add_measurement_set(set).position().x();
+        if (!switch_tick && bank.selectedIndex() == 1)
+        {
+            switch_tick = tick;
+            BOOST_CHECK_GT(x, 1.5);
+        }
+    }
+
+    BOOST_CHECK_EQUAL(switch_tick, JUMP_TICK + GLOBAL_PERIOD);
+    BOOST_CHECK_EQUAL(bank.selectedIndex(), 1u);
+    BOOST_CHECK_CLOSE(x, 2.0, 1);
+
+    // The losing hypothesis took over the estimate instead of staying lost
+    const MeasurementSet set = createSlamSet(TICKS + 1, bank.measurementPool(), slam_x);
+    BOOST_CHECK_CLOSE(bank.hypothesis(0).add_measurement_set(set).position().x(), 2.0, 1);
+}
+
+BOOST_AUTO_TEST_CASE(UkfRelocalizationTest) { checkRelocalization("ukf"); }
+
+BOOST_AUTO_TEST_CASE(EskfRelocalizationTest) { checkRelocalization("eskf"); }
+
+/*
+ * A single bad reading: the inflating hypothesis jumps and is pruned back on the next reading
+ */
+BOOST_AUTO_TEST_CASE(OutlierTest)
+{
+    EstimatorBank bank(createConfig());
+
+    const auto slam_x = [](uint64_t tick) { return tick == JUMP_TICK ? 2.0 : 0.0; };
+    for (uint64_t tick = 1; tick <= TICKS; tick++)
+    {
+        const MeasurementSet set = createSlamSet(tick, bank.measurementPool(), slam_x);
+        const double x = bank.add_measurement_set(set).position().x();
+        BOOST_REQUIRE_EQUAL(bank.selectedIndex(), 0u);
+        BOOST_REQUIRE_SMALL(x, 0.05);
+    }
+
+    // The inflating hypothesis was pruned back to the estimate
+    const MeasurementSet set = createSlamSet(TICKS + 1, bank.measurementPool(), slam_x);
+    BOOST_CHECK_SMALL(bank.hypothesis(1).add_measurement_set(set).position().x(), 0.05);
+}
+
+/*
+ * Without a bank the single estimator recovers much later
+ */
+BOOST_AUTO_TEST_CASE(DisabledTest)
+{
+    YAML::Node config = createConfig();
+    config["bank"]["enabled"] = false;
+    EstimatorBank bank(config);
+    BOOST_CHECK_EQUAL(bank.size(), 1u);
+
+    const auto slam_x = [](uint64_t tick) { return tick < JUMP_TICK ? 0.0 : 2.0; };
+    uint64_t recovered_tick = 0;
+    for (uint64_t tick = 1; tick <= TICKS && !recovered_tick; tick++)
+    {
+        const MeasurementSet set = createSlamSet(tick, bank.measurementPool(), slam_x);
+        if (bank.add_measurement_set(set).position().x() > 1) recovered_tick = tick;
+    }
+    // Rejects the readings after the jump until its covariance has grown enough to let them in
+    BOOST_CHECK_GT(recovered_tick, JUMP_TICK + 3 * GLOBAL_PERIOD);
+}
@@ -0,0 +1,214 @@
+#define BOOST_TEST_MODULE EstimatorTest
+
+#include <stdexcept>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Estimator;
+using maav::gnc::State;
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+
+YAML::Node createConfig()
+{
+    YAML::Node config = estimatorConfig();
+    config["history"]["size"] = 300;
+    config["updates"]["lidar"]["enabled"] = false;
+    config["updates"]["global_update"]["enabled"] = true;
+    return config;
+}
+
+/*
+ * Turns gently, with a global update arriving 100 ticks late
+ */
+MeasurementSet createLateUpdateSet(uint64_t tick, MeasurementPool& pool)
+{
+    MeasurementSet set = createSet(tick, pool, {0.1, 0, -9.80665}, {0, 0, 0.01});
+
+    if (tick == 150)
+    {
+        auto global_update = pool.global_update.acquire();
+        global_update->setTime(50 * IMU_PERIOD);
+        global_update->pose() = Sophus::SE3d();
+        global_update->pose().translation() = {0.5, 0, 0};
+        set.global_update = global_update;
+    }
+    return set;
+}
+
+BOOST_AUTO_TEST_CASE(BoundedReplayTest)
+{
+    YAML::Node unbounded_config = createConfig();
+    YAML::Node bounded_config = createConfig();
+    bounded_config["max_replay_steps"] = 10;
+
+    Estimator unbounded(unbounded_config);
+    Estimator bounded(bounded_config);
+
+    State unbounded_state(0);
+    State bounded_state(0);
+    for (uint64_t tick = 0; tick < 200; tick++)
+    {
+        unbounded_state = unbounded.add_measurement_set(
+            createLateUpdateSet(tick, unbounded.measurementPool()));
+        bounded_state = bounded.add_measurement_set(
+            createLateUpdateSet(tick, bounded.measurementPool()));
+
+        BOOST_REQUIRE_LE(bounded.replayStats().last_steps, 10);
+        BOOST_REQUIRE_EQUAL(bounded_state.timeUSec(), tick * IMU_PERIOD);
+
+        if (tick == 150)
+        {
+            BOOST_CHECK_EQUAL(unbounded.replayStats().last_depth_usec, 101 * IMU_PERIOD);
+            BOOST_CHECK_EQUAL(unbounded.replayStats().last_steps, 101);
+            BOOST_CHECK_GT(bounded.replayStats().backlog_steps, 0);
+        }
+    }
+
+    // The bounded estimator catches up about 9 steps per tick, so 50 ticks are plenty
+    BOOST_CHECK_EQUAL(bounded.replayStats().backlog_steps, 0);
+    BOOST_CHECK_GT(bounded.replayStats().deferred_ticks, 0);
+    BOOST_CHECK_LE(diff(bounded_state.position(), unbounded_state.position()), 1e-9);
+    BOOST_CHECK_LE(diff(bounded_state.velocity(), unbounded_state.velocity()), 1e-9);
+    BOOST_CHECK_LE(diff(bounded_state.attitude(), unbounded_state.attitude()), 1e-9);
+}
+
+/*
+ * Each tick propagates the newest snapshot and adds one more to replay, so a bound below 3 never
+ * catches up
+ */
+BOOST_AUTO_TEST_CASE(SmallReplayBoundTest)
+{
+    for (size_t max_replay_steps : {1, 2})
+    {
+        YAML::Node config = createConfig();
+        config["max_replay_steps"] = max_replay_steps;
+        BOOST_CHECK_THROW(Estimator estimator(config), std::runtime_error);
+    }
+
+    YAML::Node unbounded_config = createConfig();
+    YAML::Node bounded_config = createConfig();
+    bounded_config["max_replay_steps"] = 3;
+
+    Estimator unbounded(unbounded_config);
+    Estimator bounded(bounded_config);
+
+    State unbounded_state(0);
+    State bounded_state(0);
+    for (uint64_t tick = 0; tick < 300; tick++)
+    {
+        unbounded_state = unbounded.add_measurement_set(
+            createLateUpdateSet(tick, unbounded.measurementPool()));
+        bounded_state =
+            bounded.add_measurement_set(createLateUpdateSet(tick, bounded.measurementPool()));
+        BOOST_REQUIRE_LE(bounded.replayStats().last_steps, 3);
+    }
+
+    // One step of the backlog is caught up per tick
+    BOOST_CHECK_EQUAL(bounded.replayStats().backlog_steps, 0);
+    BOOST_CHECK_LE(diff(bounded_state.position(), unbounded_state.position()), 1e-9);
+    BOOST_CHECK_LE(diff(bounded_state.velocity(), unbounded_state.velocity()), 1e-9);
+}
+
+/*
+ * While a replay is deferred, a reading lands between the newest snapshot and the next IMU sample.
+ * The newest state must still be carried forward from the last filtered one, so until the replay
+ * catches up it matches an estimator that never got the late update.
+ */
+BOOST_AUTO_TEST_CASE(DeferredInsertTest)
+{
+    YAML::Node unbounded_config = createConfig();
+    unbounded_config["updates"]["lidar"]["enabled"] = true;
+    YAML::Node bounded_config = YAML::Clone(unbounded_config);
+    bounded_config["max_replay_steps"] = 3;
+
+    Estimator unbounded(unbounded_config);
+    Estimator bounded(bounded_config);
+    Estimator never_late(unbounded_config);
+
+    auto createInsertSet = [](uint64_t tick, MeasurementPool& pool, bool late) {
+        MeasurementSet set = createLateUpdateSet(tick, pool);
+        if (!late) set.global_update = nullptr;
+        if (tick == 151)
+        {
+            auto lidar = pool.lidar.acquire();
+            lidar->setTime(150 * IMU_PERIOD + IMU_PERIOD / 2);
+            lidar->distance()(0) = 0.2;
+            set.lidar = lidar;
+        }
+        return set;
+    };
+
+    State unbounded_state(0);
+    State bounded_state(0);
+    State never_late_state(0);
+    for (uint64_t tick = 0; tick < 300; tick++)
+    {
+        unbounded_state =
+            unbounded.add_measurement_set(createInsertSet(tick, unbounded.measurementPool(), true));
+        bounded_state =
+            bounded.add_measurement_set(createInsertSet(tick, bounded.measurementPool(), true));
+        never_late_state = never_late.add_measurement_set(
+            createInsertSet(tick, never_late.measurementPool(), false));
+        BOOST_REQUIRE_LE(bounded.replayStats().last_steps, 3);
+
+        if (tick == 151) BOOST_REQUIRE_GT(bounded.replayStats().backlog_steps, 0);
+        if (bounded.replayStats().backlog_steps > 0)
+        {
+            BOOST_REQUIRE_LE(diff(bounded_state.position(), never_late_state.position()), 1e-9);
+            BOOST_REQUIRE_LE(diff(bounded_state.velocity(), never_late_state.velocity()), 1e-9);
+            BOOST_REQUIRE_LE(
+                (bounded_state.covariance() - never_late_state.covariance()).cwiseAbs().maxCoeff(),
+                1e-9);
+        }
+    }
+
+    BOOST_CHECK_EQUAL(bounded.replayStats().backlog_steps, 0);
+    BOOST_CHECK_LE(diff(bounded_state.position(), unbounded_state.position()), 1e-9);
+    BOOST_CHECK_LE(diff(bounded_state.velocity(), unbounded_state.velocity()), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(FilterRateTest)
+{
+    // The ESKF is linearized the same way per sample or over a preintegrated interval, so the two
+    // must agree. A UKF step would instead see the sigma points spread over a longer interval.
+    YAML::Node every_sample_config = createConfig();
+    every_sample_config["filter"] = "eskf";
+    YAML::Node preintegrated_config = createConfig();
+    preintegrated_config["filter"] = "eskf";
+    preintegrated_config["filter_rate"] = 25;
+
+    Estimator every_sample(every_sample_config);
+    Estimator preintegrated(preintegrated_config);
+
+    State expected(0);
+    State actual(0);
+    for (uint64_t tick = 0; tick < 200; tick++)
+    {
+        expected = every_sample.add_measurement_set(
+            createLateUpdateSet(tick, every_sample.measurementPool()));
+        actual = preintegrated.add_measurement_set(
+            createLateUpdateSet(tick, preintegrated.measurementPool()));
+
+        // A state comes out for every IMU sample, filtered or not
+        BOOST_REQUIRE_EQUAL(actual.timeUSec(), tick * IMU_PERIOD);
+
+        // Between filter steps the covariance is left at the last step
+        if (tick % 4 == 0)
+        {
+            BOOST_REQUIRE_LE(
+                (actual.covariance() - expected.covariance()).cwiseAbs().maxCoeff(), 1e-5);
+        }
+    }
+
+    // The filter steps every 4 samples, and the delayed global update lands between two steps
+    BOOST_CHECK_EQUAL(preintegrated.replayStats().max_steps, 27);
+    BOOST_CHECK_LE(diff(actual.position(), expected.position()), 1e-9);
+    BOOST_CHECK_LE(diff(actual.velocity(), expected.velocity()), 1e-9);
+    BOOST_CHECK_LE(diff(actual.attitude(), expected.attitude()), 1e-7);
+}
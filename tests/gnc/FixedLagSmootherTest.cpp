@@ -0,0 +1,148 @@
+#define BOOST_TEST_MODULE FixedLagSmootherTest
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include <gnc/kalman/FixedLagSmoother.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Estimator;
+using maav::gnc::State;
+using maav::gnc::kalman::FixedLagSmoother;
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+
+YAML::Node createConfig()
+{
+    YAML::Node config = estimatorConfig();
+    config["filter"] = "eskf";
+    return config;
+}
+
+constexpr size_t TICKS = 50;
+
+MeasurementSet createTurningSet(uint64_t tick, MeasurementPool& pool)
+{
+    return createSet(tick, pool, {0.1, 0, -9.80665}, {0, 0, 0.01});
+}
+
+/*
+ * Runs a stationary estimator for TICKS samples, with a lidar reading on the last one if lidar
+ * is set, and collects its filtered snapshots into a window. The first sample only starts the
+ * history, so the window starts at the second.
+ */
+FixedLagSmoother::Window runEstimator(bool lidar)
+{
+    Estimator estimator(createConfig());
+    FixedLagSmoother::Window window;
+    for (uint64_t tick = 0; tick < TICKS; tick++)
+    {
+        MeasurementSet set = createTurningSet(tick, estimator.measurementPool());
+        if (lidar && tick == TICKS - 1) addLidar(set, estimator.measurementPool(), 0.2);
+
+        const State& state = estimator.add_measurement_set(set);
+        if (tick == 0) continue;
+
+        FixedLagSmoother::Step step;
+        step.state = state;
+        step.imu = *set.imu;
+        window.steps.push_back(step);
+    }
+    window.size = window.steps.size();
+    return window;
+}
+
+BOOST_AUTO_TEST_CASE(NoUpdatesTest)
+{
+    const YAML::Node config = createConfig();
+    FixedLagSmoother smoother(YAML::Load("enabled: false"), config["prediction"], TICKS);
+    const FixedLagSmoother::Window window = runEstimator(false);
+
+    FixedLagSmoother::Trajectory smoothed;
+    smoother.smooth(window, smoothed);
+    BOOST_REQUIRE_EQUAL(smoothed.size(), window.size);
+
+    // Every filtered state is already the prediction of the one before, so there is nothing to
+    // carry back
+    for (size_t i = 0; i < window.size; i++)
+    {
+        const State& filtered = window.steps[i].state;
+        BOOST_CHECK_LE(diff(filtered.position(), smoothed[i].position()), 1e-9);
+        BOOST_CHECK_LE(diff(filtered.attitude(), smoothed[i].attitude()), 1e-9);
+        BOOST_CHECK_LE((filtered.covariance() - smoothed[i].covariance()).norm(), 1e-9);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CorrectionTest)
+{
+    const YAML::Node config = createConfig();
+    FixedLagSmoother smoother(YAML::Load("enabled: false"), config["prediction"], TICKS);
+    const FixedLagSmoother::Window window = runEstimator(true);
+
+    FixedLagSmoother::Trajectory smoothed;
+    smoother.smooth(window, smoothed);
+    BOOST_REQUIRE_EQUAL(smoothed.size(), window.size);
+
+    // The lidar pulls the newest height down, and the states before it part of the way
+    const double newest_z = window.steps.back().state.position().z();
+    BOOST_REQUIRE_LT(newest_z, -0.1);
+    BOOST_CHECK_EQUAL(smoothed.back().position(), window.steps.back().state.position());
+    for (size_t i = 0; i + 1 < window.size; i++)
+    {
+        const State& filtered = window.steps[i].state;
+        BOOST_CHECK_LT(smoothed[i].position().z(), filtered.position().z());
+        BOOST_CHECK_GT(smoothed[i].position().z(), newest_z);
+        BOOST_CHECK_LT(smoothed[i].covariance()(5, 5), filtered.covariance()(5, 5));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ThreadTest)
+{
+    YAML::Node config = createConfig();
+    config["filter_rate"] = 25;
+    config["smoother"] = YAML::Load("{enabled: true, lag: 0.3, rate: 0}");
+
+    // Declared before the estimator, so they outlive the smoother thread
+    std::mutex mutex;
+    std::condition_variable smoothed_cv;
+    FixedLagSmoother::Trajectory last;
+    size_t windows = 0;
+
+    Estimator estimator(config);
+    estimator.smoother().setCallback([&](const FixedLagSmoother::Trajectory& trajectory) {
+        std::lock_guard<std::mutex> lock(mutex);
+        last = trajectory;
+        windows++;
+        smoothed_cv.notify_one();
+    });
+
+    std::map<uint64_t, State> filtered;
+    for (uint64_t tick = 0; tick < TICKS; tick++)
+    {
+        const MeasurementSet set = createTurningSet(tick, estimator.measurementPool());
+        filtered[tick * IMU_PERIOD] = estimator.add_measurement_set(set);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    BOOST_REQUIRE(smoothed_cv.wait_for(
+        lock, std::chrono::seconds(5), [&] { return windows > 0 && last.size() > 1; }));
+
+    // Filter steps are 40 ms apart, so the window holds the lag's worth of preintegrated steps.
+    // Without updates, smoothing leaves them as filtered.
+    BOOST_CHECK_LE(last.size(), 9);
+    for (const State& state : last)
+    {
+        // The initial state is not returned by the estimator
+        if (state.timeUSec() == 0) continue;
+        const State& expected = filtered.at(state.timeUSec());
+        BOOST_CHECK_LE(diff(expected.position(), state.position()), 1e-9);
+        BOOST_CHECK_LE((expected.covariance() - state.covariance()).norm(), 1e-9);
+    }
+}
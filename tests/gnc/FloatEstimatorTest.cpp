@@ -0,0 +1,120 @@
+#define BOOST_TEST_MODULE FloatEstimatorTest
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include <gnc/State.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::EstimatorT;
+using maav::gnc::State;
+using maav::gnc::StateT;
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+
+constexpr size_t TICKS = 500;
+constexpr size_t LIDAR_EVERY = 5;
+
+/*
+ * A slow yaw with a small lateral wobble, and a lidar reading every few samples
+ */
+MeasurementSet createWobbleSet(uint64_t tick, MeasurementPool& pool)
+{
+    const double t = static_cast<double>(tick * IMU_PERIOD) * 1e-6;
+    MeasurementSet set = createSet(tick, pool,
+        {0.2 * std::sin(2 * t), 0.1 * std::cos(3 * t), -9.80665}, {0.01 * std::sin(t), 0, 0.05});
+    if (tick % LIDAR_EVERY == 0) addLidar(set, pool, 0.2);
+    return set;
+}
+
+struct Divergence
+{
+    double position = 0;
+    double velocity = 0;
+    double attitude = 0;
+};
+
+/*
+ * Runs the double and float estimators over the same readings and returns the largest difference
+ * between their states. alpha sets the spread of the sigma points of the UKF.
+ */
+Divergence runBoth(const std::string& filter, double filter_rate, double alpha = 0.05)
+{
+    YAML::Node config = estimatorConfig();
+    config["filter"] = filter;
+    config["filter_rate"] = filter_rate;
+    config["prediction"]["UT"]["alpha"] = alpha;
+    config["updates"]["lidar"]["UT"]["alpha"] = alpha;
+    EstimatorT<double> reference(config);
+    EstimatorT<float> single(config);
+
+    Divergence divergence;
+    for (uint64_t tick = 0; tick < TICKS; tick++)
+    {
+        const MeasurementSet set = createWobbleSet(tick, reference.measurementPool());
+        const State& expected = reference.add_measurement_set(set);
+        const State actual = single.add_measurement_set(set).cast<double>();
+        BOOST_REQUIRE_EQUAL(actual.timeUSec(), expected.timeUSec());
+
+        divergence.position =
+            std::max(divergence.position, diff(actual.position(), expected.position()));
+        divergence.velocity =
+            std::max(divergence.velocity, diff(actual.velocity(), expected.velocity()));
+        divergence.attitude =
+            std::max(divergence.attitude, diff(actual.attitude(), expected.attitude()));
+    }
+    return divergence;
+}
+
+BOOST_AUTO_TEST_CASE(CastTest)
+{
+    State state = State::zero(1234);
+    state.position() = {1.5, -2.25, 0.125};
+    state.attitude() = Sophus::SO3d::exp(Eigen::Vector3d(0.1, -0.2, 0.3));
+    state.setSqrtCovariance(1e-2 * State::CovarianceMatrix::Identity());
+
+    const StateT<float> single = state.cast<float>();
+    BOOST_CHECK_EQUAL(single.timeUSec(), state.timeUSec());
+    BOOST_CHECK(single.hasSqrtCovariance());
+
+    const State back = single.cast<double>();
+    BOOST_CHECK_LE(diff(back.position(), state.position()), 1e-6);
+    BOOST_CHECK_LE(diff(back.attitude(), state.attitude()), 1e-6);
+    BOOST_CHECK_LE((back.covariance() - state.covariance()).norm(), 1e-9);
+}
+
+/*
+ * With a small alpha the sigma point weights are large and of both signs, so float rounding is
+ * amplified in every mean. The lidar only observes height, and those errors add up horizontally
+ * to about a centimetre over the run, so the UKF cases spread the sigma points wider.
+ */
+BOOST_AUTO_TEST_CASE(UkfTest)
+{
+    const Divergence divergence = runBoth("ukf", 0, 0.5);
+    BOOST_CHECK_LE(divergence.position, 5e-3);
+    BOOST_CHECK_LE(divergence.velocity, 1e-3);
+    BOOST_CHECK_LE(divergence.attitude, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(EskfTest)
+{
+    const Divergence divergence = runBoth("eskf", 0);
+    BOOST_CHECK_LE(divergence.position, 1e-3);
+    BOOST_CHECK_LE(divergence.velocity, 1e-3);
+    BOOST_CHECK_LE(divergence.attitude, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(PreintegratedTest)
+{
+    // Preintegrations stay in double, so only the filter steps round to float
+    const Divergence divergence = runBoth("ukf", 25, 0.5);
+    BOOST_CHECK_LE(divergence.position, 1e-3);
+    BOOST_CHECK_LE(divergence.velocity, 1e-3);
+    BOOST_CHECK_LE(divergence.attitude, 1e-4);
+}
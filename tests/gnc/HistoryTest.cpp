@@ -1,6 +1,7 @@
 #define BOOST_TEST_MODULE HistoryTest
 
 #include <iostream>
+#include <iterator>
 #include <vector>
 
 #include <Eigen/Eigen>
@@ -13,7 +14,9 @@
 #include "gnc/measurements/Measurement.hpp"
 #include "gnc/measurements/PlaneFitMeasurement.hpp"
 #include "gnc/measurements/VisualOdometry.hpp"
+#include "gnc/utils/Metrics.hpp"
 
+using maav::gnc::Metrics;
 using maav::gnc::kalman::History;
 using maav::gnc::measurements::GlobalUpdateMeasurement;
 using maav::gnc::measurements::ImuMeasurement;
@@ -270,3 +273,236 @@ BOOST_AUTO_TEST_CASE(HistoryOlderTest)
     BOOST_CHECK_EQUAL(history_vec5[1].measurement.lidar->timeUSec(), 34000);
     BOOST_CHECK_EQUAL(history_vec5[2].measurement.imu->time_usec, 40000);
 }
+
+BOOST_AUTO_TEST_CASE(HistoryDeepInterpolateTest)
+{
+    YAML::Node config = YAML::Load("size: 10\ntolerance: 1000");
+    YAML::Node initial_state_config = YAML::Load(
+        "# Starting state\nattitude: [1, 0, 0, 0]\nposition: [0, 0, 0] # [m]\nvelocity: [0, 0, 0] "
+        "# [m/s]\n# Starting covariance\ncovariance: [0.00001, 0.00001, 0.00001, 0.001, 0.001, "
+        "0.001, 0.0001, 0.0001, 0.0001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001]");
+    History history(config, initial_state_config);
+
+    // Wrap the buffer around a few times
+    for (size_t i = 0; i < 50; i++)
+    {
+        MeasurementSet set;
+        ImuMeasurement imu;
+        imu.angular_rates = Eigen::Vector3d(1, 1, 1) * i;
+        imu.time_usec = 10000 * i;
+        set.imu = std::make_shared<ImuMeasurement>(imu);
+
+        history.add_measurement(set);
+    }
+
+    // History should have times 400000 - 490000
+
+    // Lidar close to the oldest snapshot, so older snapshots are shifted to make room
+    MeasurementSet set = create_meas(500000, 412500);
+    auto iter_pair = history.add_measurement(set);
+    std::vector<History::Snapshot> history_vec(iter_pair.first, iter_pair.second);
+
+    BOOST_CHECK_EQUAL(history_vec.size(), 11);
+    BOOST_CHECK_EQUAL(history_vec[0].get_time(), 410000);
+    BOOST_CHECK_EQUAL(history_vec[1].get_time(), 412500);
+    BOOST_CHECK_EQUAL(history_vec[2].get_time(), 420000);
+    BOOST_CHECK_EQUAL(history_vec[10].get_time(), 500000);
+    BOOST_CHECK(history_vec[1].measurement.lidar != nullptr);
+    BOOST_CHECK(history_vec[0].measurement.lidar == nullptr);
+    BOOST_CHECK(history_vec[2].measurement.lidar == nullptr);
+
+    for (size_t i = 1; i < history_vec.size(); i++)
+    {
+        BOOST_CHECK_LT(history_vec[i - 1].get_time(), history_vec[i].get_time());
+    }
+
+    const ImuMeasurement &imu_meas = *(history_vec[1].measurement.imu);
+    BOOST_CHECK_LE((imu_meas.angular_rates - Eigen::Vector3d(41.25, 41.25, 41.25)).norm(), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(HistoryQueueTest)
+{
+    YAML::Node config = YAML::Load("size: 10\ntolerance: 1000");
+    YAML::Node initial_state_config = YAML::Load(
+        "# Starting state\nattitude: [1, 0, 0, 0]\nposition: [0, 0, 0] # [m]\nvelocity: [0, 0, 0] "
+        "# [m/s]\n# Starting covariance\ncovariance: [0.00001, 0.00001, 0.00001, 0.001, 0.001, "
+        "0.001, 0.0001, 0.0001, 0.0001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001]");
+    History history(config, initial_state_config);
+
+    ImuMeasurement imu;
+    MeasurementSet set;
+    for (uint64_t time : {0, 10000})
+    {
+        imu.time_usec = time;
+        set.imu = std::make_shared<ImuMeasurement>(imu);
+        history.add_measurement(set);
+    }
+
+    // Two lidar readings out of order and a plane fit between them, plus one the IMU has not
+    // caught up with yet
+    for (uint64_t time : {15000, 12500, 25000})
+    {
+        LidarMeasurement lidar;
+        lidar.setTime(time);
+        MeasurementSet reading;
+        reading.lidar = std::make_shared<LidarMeasurement>(lidar);
+        history.queue(reading);
+    }
+    PlaneFitMeasurement plane_fit;
+    plane_fit.time_usec = 13750;
+    MeasurementSet reading;
+    reading.plane_fit = std::make_shared<PlaneFitMeasurement>(plane_fit);
+    history.queue(reading);
+
+    imu.time_usec = 20000;
+    set.imu = std::make_shared<ImuMeasurement>(imu);
+    auto iter_pair = history.add_measurement(set);
+    std::vector<History::Snapshot> history_vec(iter_pair.first, iter_pair.second);
+
+    BOOST_REQUIRE_EQUAL(history_vec.size(), 5);
+    BOOST_CHECK_EQUAL(history_vec[0].get_time(), 10000);
+    BOOST_CHECK_EQUAL(history_vec[1].measurement.lidar->timeUSec(), 12500);
+    BOOST_CHECK_EQUAL(history_vec[2].measurement.plane_fit->time_usec, 13750);
+    BOOST_CHECK_EQUAL(history_vec[3].measurement.lidar->timeUSec(), 15000);
+    BOOST_CHECK_EQUAL(history_vec[4].get_time(), 20000);
+    BOOST_CHECK(history_vec[4].measurement.lidar == nullptr);
+
+    imu.time_usec = 30000;
+    set.imu = std::make_shared<ImuMeasurement>(imu);
+    iter_pair = history.add_measurement(set);
+    history_vec.assign(iter_pair.first, iter_pair.second);
+
+    BOOST_REQUIRE_EQUAL(history_vec.size(), 3);
+    BOOST_CHECK_EQUAL(history_vec[1].measurement.lidar->timeUSec(), 25000);
+
+    const auto stats = history.queueStats();
+    BOOST_CHECK_EQUAL(stats.lidar.queued, 3);
+    BOOST_CHECK_EQUAL(stats.lidar.merged, 3);
+    BOOST_CHECK_EQUAL(stats.lidar.dropped(), 0);
+    BOOST_CHECK_EQUAL(stats.lidar.max_depth, 3);
+    BOOST_CHECK_EQUAL(stats.plane_fit.merged, 1);
+}
+
+BOOST_AUTO_TEST_CASE(HistoryQueueDropTest)
+{
+    YAML::Node config =
+        YAML::Load("size: 3\ntolerance: 1000\nqueue_size: 2\nlatency_budget: {lidar: 5000}");
+    YAML::Node initial_state_config = YAML::Load(
+        "# Starting state\nattitude: [1, 0, 0, 0]\nposition: [0, 0, 0] # [m]\nvelocity: [0, 0, 0] "
+        "# [m/s]\n# Starting covariance\ncovariance: [0.00001, 0.00001, 0.00001, 0.001, 0.001, "
+        "0.001, 0.0001, 0.0001, 0.0001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001]");
+    History history(config, initial_state_config);
+
+    auto queue_lidar = [&history](uint64_t time) {
+        LidarMeasurement lidar;
+        lidar.setTime(time);
+        MeasurementSet reading;
+        reading.lidar = std::make_shared<LidarMeasurement>(lidar);
+        history.queue(reading);
+    };
+    auto add_imu = [&history](uint64_t time) {
+        ImuMeasurement imu;
+        imu.time_usec = time;
+        MeasurementSet set;
+        set.imu = std::make_shared<ImuMeasurement>(imu);
+        return history.add_measurement(set);
+    };
+
+    add_imu(0);
+    add_imu(10000);
+    add_imu(20000);
+
+    // The queue holds two readings, so the oldest of three is pushed out
+    queue_lidar(24000);
+    queue_lidar(26000);
+    queue_lidar(28000);
+    auto iter_pair = add_imu(30000);
+    std::vector<History::Snapshot> history_vec(iter_pair.first, iter_pair.second);
+    BOOST_CHECK_EQUAL(history_vec[1].get_time(), 26000);
+    BOOST_CHECK_EQUAL(history_vec[2].get_time(), 28000);
+
+    // 17 ms behind the IMU, over the 5 ms budget
+    queue_lidar(23000);
+
+    // Older than anything in the history
+    const uint64_t late_before = Metrics::instance().counter("history.late").value();
+    GlobalUpdateMeasurement global_update;
+    global_update.setTime(1000);
+    MeasurementSet reading;
+    reading.global_update = std::make_shared<GlobalUpdateMeasurement>(global_update);
+    history.queue(reading);
+
+    add_imu(40000);
+
+    const auto stats = history.queueStats();
+    BOOST_CHECK_EQUAL(stats.lidar.queued, 4);
+    BOOST_CHECK_EQUAL(stats.lidar.merged, 2);
+    BOOST_CHECK_EQUAL(stats.lidar.dropped_overflow, 1);
+    BOOST_CHECK_EQUAL(stats.lidar.dropped_stale, 1);
+    BOOST_CHECK_EQUAL(stats.lidar.dropped_late, 0);
+    BOOST_CHECK_EQUAL(stats.global_update.queued, 1);
+    BOOST_CHECK_EQUAL(stats.global_update.merged, 0);
+    BOOST_CHECK_EQUAL(stats.global_update.dropped_late, 1);
+    BOOST_CHECK_EQUAL(Metrics::instance().counter("history.late").value() - late_before, 1);
+
+    // Both land on the snapshot at 50000, where the second replaces the first
+    queue_lidar(50200);
+    queue_lidar(50400);
+    iter_pair = add_imu(50000);
+    BOOST_CHECK_EQUAL(std::prev(iter_pair.second)->measurement.lidar->timeUSec(), 50400);
+
+    const auto replaced_stats = history.queueStats();
+    BOOST_CHECK_EQUAL(replaced_stats.lidar.queued, 6);
+    BOOST_CHECK_EQUAL(replaced_stats.lidar.merged, 3);
+    BOOST_CHECK_EQUAL(replaced_stats.lidar.dropped_replaced, 1);
+    BOOST_CHECK_EQUAL(replaced_stats.lidar.dropped(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(HistoryFullTest)
+{
+    // Room for 2 * 3 + 5 snapshots
+    YAML::Node config = YAML::Load("size: 3\ntolerance: 1000");
+    YAML::Node initial_state_config = YAML::Load(
+        "# Starting state\nattitude: [1, 0, 0, 0]\nposition: [0, 0, 0] # [m]\nvelocity: [0, 0, 0] "
+        "# [m/s]\n# Starting covariance\ncovariance: [0.00001, 0.00001, 0.00001, 0.001, 0.001, "
+        "0.001, 0.0001, 0.0001, 0.0001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001]");
+    History history(config, initial_state_config);
+
+    // Every snapshot is kept for a replay, until the buffer fills
+    for (size_t i = 0; i < 11; i++)
+    {
+        MeasurementSet set;
+        ImuMeasurement imu;
+        imu.time_usec = 10000 * i;
+        set.imu = std::make_shared<ImuMeasurement>(imu);
+        history.add_measurement(set, 0);
+    }
+    BOOST_REQUIRE_EQUAL(history.size(), 11);
+
+    // A reading between two snapshots is refused rather than dropping the oldest one
+    const uint64_t late_before = Metrics::instance().counter("history.late").value();
+    LidarMeasurement lidar;
+    lidar.setTime(45000);
+    MeasurementSet reading;
+    reading.lidar = std::make_shared<LidarMeasurement>(lidar);
+    history.queue(reading);
+
+    const uint64_t evicted_before = Metrics::instance().counter("history.evicted").value();
+    MeasurementSet set;
+    ImuMeasurement imu;
+    imu.time_usec = 110000;
+    set.imu = std::make_shared<ImuMeasurement>(imu);
+    history.add_measurement(set, 0);
+
+    BOOST_CHECK_EQUAL(history.queueStats().lidar.dropped_late, 1);
+    BOOST_CHECK_EQUAL(Metrics::instance().counter("history.late").value() - late_before, 1);
+
+    // The IMU sample cannot be refused, so it evicts the oldest snapshot, and says so
+    BOOST_CHECK_EQUAL(history.size(), 11);
+    BOOST_CHECK_EQUAL(history.begin()->get_time(), 10000);
+    BOOST_CHECK_EQUAL(Metrics::instance().counter("history.evicted").value() - evicted_before, 1);
+    for (auto it = history.begin(); it != history.end(); ++it)
+    {
+        BOOST_CHECK(it->measurement.lidar == nullptr);
+    }
+}
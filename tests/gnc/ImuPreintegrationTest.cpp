@@ -0,0 +1,177 @@
+#define BOOST_TEST_MODULE ImuPreintegrationTest
+
+#include <cmath>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+#include <sophus/so3.hpp>
+
+#include <gnc/Constants.hpp>
+#include <gnc/kalman/ImuPreintegration.hpp>
+#include <gnc/kalman/Prediction.hpp>
+#include "TestHelpers.hpp"
+
+using namespace boost::unit_test;
+using namespace Eigen;
+
+using namespace maav::gnc::kalman;
+using namespace maav::gnc;
+
+namespace
+{
+constexpr size_t SAMPLES = 11;
+
+std::vector<measurements::ImuMeasurement> createSamples()
+{
+    std::vector<measurements::ImuMeasurement> samples(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        samples[i].time_usec = 1000000 + i * IMU_PERIOD;
+        samples[i].angular_rates = {0.3 + 0.02 * i, -0.2, 0.5 - 0.03 * i};
+        samples[i].acceleration = {0.5 * std::cos(0.3 * i), 0.2, -9.7 + 0.05 * i};
+        samples[i].magnetometer = Vector3d::Zero();
+    }
+    return samples;
+}
+
+State createState()
+{
+    State state = State::zero(1000000);
+    state.attitude() = Sophus::SO3d::exp(Vector3d{0.1, -0.2, 0.7});
+    state.position() = {1.0, -2.0, -1.5};
+    state.velocity() = {0.4, 0.1, -0.2};
+    state.gyroBias() = {0.01, -0.02, 0.005};
+    state.accelBias() = {-0.05, 0.02, 0.1};
+    return state;
+}
+
+ImuPreintegration preintegrate(const std::vector<measurements::ImuMeasurement>& samples,
+    const Vector3d& gyro_bias, const Vector3d& accel_bias)
+{
+    ImuPreintegration preintegration(
+        samples.front(), gyro_bias, accel_bias, State::CovarianceMatrix::Identity() * 1e-4);
+    for (size_t i = 1; i < samples.size(); i++)
+    {
+        preintegration.integrate(samples[i]);
+    }
+    return preintegration;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(MatchesPerSampleIntegrationTest)
+{
+    const std::vector<measurements::ImuMeasurement> samples = createSamples();
+    const State start = createState();
+    const State::CovarianceMatrix Q = State::CovarianceMatrix::Identity() * 1e-4;
+
+    // Step through every sample, as the filter does without preintegration
+    State expected = start;
+    State::CovarianceMatrix transition = State::CovarianceMatrix::Identity();
+    State::CovarianceMatrix noise = State::CovarianceMatrix::Zero();
+    for (size_t i = 1; i < SAMPLES; i++)
+    {
+        const double dt = static_cast<double>(IMU_PERIOD) * constants::USEC_TO_SEC;
+        State next = expected;
+        integrateImu(expected, samples[i - 1], samples[i], dt, next);
+        expected = next;
+
+        const State::CovarianceMatrix F = EskfPrediction::errorJacobian(
+            start.gyroBias(), start.accelBias(), samples[i - 1], samples[i], dt);
+        transition = F * transition;
+        noise = F * noise * F.transpose() + Q;
+    }
+
+    const ImuPreintegration preintegration =
+        preintegrate(samples, start.gyroBias(), start.accelBias());
+    State actual = start;
+    preintegration.predict(start, actual);
+
+    BOOST_CHECK_EQUAL(preintegration.startTime(), samples.front().time_usec);
+    BOOST_CHECK_EQUAL(preintegration.endTime(), samples.back().time_usec);
+    BOOST_CHECK_CLOSE(preintegration.deltaT(), 0.1, 1e-9);
+
+    constexpr double tol = 1e-9;
+    // diff() of two rotations goes through acos, which cannot resolve much below 1e-8
+    BOOST_CHECK_LE(diff(actual.attitude(), expected.attitude()), 1e-7);
+    BOOST_CHECK_LE(diff(actual.position(), expected.position()), tol);
+    BOOST_CHECK_LE(diff(actual.velocity(), expected.velocity()), tol);
+    BOOST_CHECK_LE(diff(actual.angularVelocity(), expected.angularVelocity()), tol);
+    BOOST_CHECK_LE(diff(actual.acceleration(), expected.acceleration()), tol);
+    BOOST_CHECK_LE((preintegration.transition() - transition).cwiseAbs().maxCoeff(), tol);
+    BOOST_CHECK_LE((preintegration.noise() - noise).cwiseAbs().maxCoeff(), tol);
+}
+
+BOOST_AUTO_TEST_CASE(BiasCorrectionTest)
+{
+    const std::vector<measurements::ImuMeasurement> samples = createSamples();
+    const State start = createState();
+    const ImuPreintegration preintegration =
+        preintegrate(samples, start.gyroBias(), start.accelBias());
+
+    // A state whose biases moved after the samples were integrated
+    State moved = start;
+    moved.gyroBias() += Vector3d{0.004, -0.003, 0.005};
+    moved.accelBias() += Vector3d{0.03, 0.02, -0.04};
+
+    const ImuPreintegration reintegrated =
+        preintegrate(samples, moved.gyroBias(), moved.accelBias());
+    State expected = moved;
+    reintegrated.predict(moved, expected);
+
+    State corrected = moved;
+    preintegration.predict(moved, corrected);
+
+    // Ignoring the bias Jacobians is what the first order correction is measured against
+    State uncorrected = moved;
+    uncorrected.attitude() = start.attitude() * preintegration.deltaR(start.gyroBias());
+    uncorrected.position() = moved.position() + moved.velocity() * preintegration.deltaT() +
+                             moved.attitude() *
+                                 preintegration.deltaP(start.gyroBias(), start.accelBias()) -
+                             0.5 * moved.gravity() * std::pow(preintegration.deltaT(), 2);
+    uncorrected.velocity() = moved.velocity() +
+                             moved.attitude() *
+                                 preintegration.deltaV(start.gyroBias(), start.accelBias()) -
+                             moved.gravity() * preintegration.deltaT();
+
+    BOOST_CHECK_LE(diff(corrected.attitude(), expected.attitude()),
+        0.01 * diff(uncorrected.attitude(), expected.attitude()));
+    BOOST_CHECK_LE(diff(corrected.position(), expected.position()),
+        0.01 * diff(uncorrected.position(), expected.position()));
+    BOOST_CHECK_LE(diff(corrected.velocity(), expected.velocity()),
+        0.01 * diff(uncorrected.velocity(), expected.velocity()));
+}
+
+BOOST_AUTO_TEST_CASE(SplitTest)
+{
+    const std::vector<measurements::ImuMeasurement> samples = createSamples();
+    const State start = createState();
+    const ImuPreintegration preintegration =
+        preintegrate(samples, start.gyroBias(), start.accelBias());
+
+    const uint64_t split_time = samples[4].time_usec + IMU_PERIOD / 3;
+    const auto halves = preintegration.split(split_time);
+    const ImuPreintegration& first = halves.first;
+    const ImuPreintegration& second = halves.second;
+
+    BOOST_CHECK_EQUAL(first.startTime(), preintegration.startTime());
+    BOOST_CHECK_EQUAL(first.endTime(), split_time);
+    BOOST_CHECK_EQUAL(second.startTime(), split_time);
+    BOOST_CHECK_EQUAL(second.endTime(), preintegration.endTime());
+    BOOST_CHECK_EQUAL(first.samples().size() + second.samples().size(), SAMPLES + 2);
+    BOOST_CHECK_CLOSE(first.deltaT() + second.deltaT(), preintegration.deltaT(), 1e-9);
+
+    State middle = start;
+    first.predict(start, middle);
+    State chained = middle;
+    second.predict(middle, chained);
+
+    State whole = start;
+    preintegration.predict(start, whole);
+
+    // The extra sample only changes how the interval containing it is discretized
+    constexpr double tol = 1e-5;
+    BOOST_CHECK_LE(diff(chained.attitude(), whole.attitude()), tol);
+    BOOST_CHECK_LE(diff(chained.position(), whole.position()), tol);
+    BOOST_CHECK_LE(diff(chained.velocity(), whole.velocity()), tol);
+}
@@ -0,0 +1,165 @@
+#define BOOST_TEST_MODULE JointUpdateTest
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/kalman/History.hpp>
+#include <gnc/kalman/updates/GlobalUpdate.hpp>
+#include <gnc/kalman/updates/JointUpdate.hpp>
+#include <gnc/kalman/updates/LidarUpdate.hpp>
+#include <gnc/kalman/updates/PlanefitUpdate.hpp>
+#include <gnc/utils/Metrics.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Metrics;
+using maav::gnc::State;
+using maav::gnc::kalman::GlobalUpdate;
+using maav::gnc::kalman::History;
+using maav::gnc::kalman::JointUpdate;
+using maav::gnc::kalman::LidarUpdate;
+using maav::gnc::kalman::PlaneFitUpdate;
+using maav::gnc::measurements::MeasurementPool;
+
+YAML::Node createConfig()
+{
+    YAML::Node config = estimatorConfig()["updates"];
+    config["lidar"]["enable_outliers"] = true;
+    config["global_update"]["enabled"] = true;
+    config["global_update"]["enable_outliers"] = true;
+    config["joint"] = YAML::Load("{enabled: true, UT: {alpha: 0.1, beta: 2.0, kappa: 0.0}}");
+    return config;
+}
+
+/*
+ * The sensor updates and a joint update running them
+ */
+struct Updates
+{
+    Updates()
+        : config(createConfig()),
+          lidar(config),
+          planefit(config),
+          global(config),
+          joint(config, lidar, planefit, global)
+    {
+    }
+
+    YAML::Node config;
+    LidarUpdate lidar;
+    PlaneFitUpdate planefit;
+    GlobalUpdate global;
+    JointUpdate joint;
+};
+
+History::Snapshot createSnapshot(
+    MeasurementPool& pool, double lidar_distance, const Eigen::Vector3d& global_position)
+{
+    History::Snapshot snapshot;
+    snapshot.state = State::zero(IMU_PERIOD);
+    snapshot.state.position() = {0.1, -0.2, -0.5};
+    snapshot.state.covariance() = State::CovarianceMatrix::Identity() * 0.01;
+
+    snapshot.measurement = createSet(1, pool);
+    addLidar(snapshot.measurement, pool, lidar_distance);
+
+    auto global_update = pool.global_update.acquire();
+    global_update->setTime(IMU_PERIOD);
+    global_update->pose() = Sophus::SE3d();
+    global_update->pose().translation() = global_position;
+    snapshot.measurement.global_update = global_update;
+    return snapshot;
+}
+
+BOOST_AUTO_TEST_CASE(MatchesSequentialTest)
+{
+    MeasurementPool pool;
+    Updates sequential;
+    Updates joint;
+
+    // The global update compares against the first pose it predicts, so both start from the same
+    History::Snapshot first = createSnapshot(pool, 0.5, Eigen::Vector3d::Zero());
+    first.measurement.lidar = nullptr;
+    History::Snapshot first_copy = first;
+    sequential.global(first);
+    joint.joint(first_copy);
+
+    History::Snapshot expected = createSnapshot(pool, 0.52, {0.03, 0.01, 0.02});
+    History::Snapshot actual = expected;
+    sequential.lidar(expected);
+    sequential.global(expected);
+    joint.joint(actual);
+
+    // Both models are close to linear over the covariance, so one stacked update and two in turn
+    // land on nearly the same posterior
+    BOOST_CHECK_LE(diff(expected.state.position(), actual.state.position()), 1e-4);
+    BOOST_CHECK_LE(diff(expected.state.velocity(), actual.state.velocity()), 1e-4);
+    BOOST_CHECK_LE(diff(expected.state.attitude(), actual.state.attitude()), 1e-4);
+    BOOST_CHECK_LE((expected.state.covariance() - actual.state.covariance()).norm(), 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(SingleSensorTest)
+{
+    MeasurementPool pool;
+    Updates sequential;
+    Updates joint;
+
+    History::Snapshot expected = createSnapshot(pool, 0.52, Eigen::Vector3d::Zero());
+    expected.measurement.global_update = nullptr;
+    History::Snapshot actual = expected;
+    sequential.lidar(expected);
+    joint.joint(actual);
+
+    // With nothing to stack the lidar update runs on its own
+    BOOST_CHECK_EQUAL(expected.state.position(), actual.state.position());
+    BOOST_CHECK_EQUAL(expected.state.covariance(), actual.state.covariance());
+}
+
+BOOST_AUTO_TEST_CASE(OutlierTest)
+{
+    MeasurementPool pool;
+    Updates sequential;
+    Updates joint;
+
+    // A global update 10 m off is gated out, while the lidar still corrects the state
+    History::Snapshot expected = createSnapshot(pool, 0.52, {10, 0, 0});
+    History::Snapshot actual = expected;
+    sequential.global(expected);
+    sequential.lidar(expected);
+    joint.joint(actual);
+
+    BOOST_CHECK_NE(actual.state.position().z(), -0.5);
+    BOOST_CHECK_LE(diff(expected.state.position(), actual.state.position()), 1e-9);
+    BOOST_CHECK_LE((expected.state.covariance() - actual.state.covariance()).norm(), 1e-9);
+}
+
+/*
+ * A global update beyond an inflating gate sends every sensor through its own update, which must
+ * gate each reading once
+ */
+BOOST_AUTO_TEST_CASE(InflateTest)
+{
+    YAML::Node config = createConfig();
+    config["global_update"]["inflate_outliers"] = true;
+    LidarUpdate lidar(config);
+    PlaneFitUpdate planefit(config);
+    GlobalUpdate global(config);
+    JointUpdate joint(config, lidar, planefit, global);
+
+    Metrics& metrics = Metrics::instance();
+    const uint64_t lidar_accepted = metrics.counter("update.lidar.accepted").value();
+    const uint64_t global_accepted = metrics.counter("update.global_update.accepted").value();
+    const uint64_t global_inflated = metrics.counter("update.global_update.inflated").value();
+
+    MeasurementPool pool;
+    History::Snapshot snapshot = createSnapshot(pool, 0.52, {10, 0, 0});
+    joint(snapshot);
+
+    BOOST_CHECK_EQUAL(metrics.counter("update.lidar.accepted").value() - lidar_accepted, 1u);
+    BOOST_CHECK_EQUAL(
+        metrics.counter("update.global_update.accepted").value() - global_accepted, 0u);
+    BOOST_CHECK_EQUAL(
+        metrics.counter("update.global_update.inflated").value() - global_inflated, 1u);
+    // The state jumped to the global update
+    BOOST_CHECK_GT(snapshot.state.position().x(), 5);
+}
@@ -0,0 +1,72 @@
+#define BOOST_TEST_MODULE LatencyHistogramTest
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/utils/LatencyHistogram.hpp>
+
+using namespace boost::unit_test;
+
+using maav::gnc::LatencyHistogram;
+
+BOOST_AUTO_TEST_CASE(EmptyTest)
+{
+    LatencyHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.count(), 0u);
+    BOOST_CHECK_EQUAL(histogram.mean(), 0);
+    BOOST_CHECK_EQUAL(histogram.max(), 0);
+    BOOST_CHECK_EQUAL(histogram.percentile(0.5), 0);
+}
+
+BOOST_AUTO_TEST_CASE(BucketEdgesTest)
+{
+    // Every latency lands in the bucket whose edges surround it
+    for (int64_t latency = 2; latency < 100000; latency = latency * 5 / 4 + 1)
+    {
+        LatencyHistogram histogram;
+        histogram.add(latency);
+
+        size_t bucket = 0;
+        while (histogram.bucketCount(bucket) == 0) bucket++;
+
+        BOOST_CHECK_LT(static_cast<double>(latency), LatencyHistogram::bucketUpper(bucket));
+        if (bucket > 0)
+        {
+            BOOST_CHECK_GE(static_cast<double>(latency), LatencyHistogram::bucketUpper(bucket - 1));
+        }
+    }
+
+    // Out of range latencies are clamped into the first and last buckets
+    LatencyHistogram histogram;
+    histogram.add(-50);
+    histogram.add(0);
+    histogram.add(int64_t{1} << 40);
+    BOOST_CHECK_EQUAL(histogram.bucketCount(0), 2u);
+    BOOST_CHECK_EQUAL(histogram.bucketCount(LatencyHistogram::NUM_BUCKETS - 1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(PercentileTest)
+{
+    LatencyHistogram histogram;
+    for (int64_t latency = 1; latency <= 1000; latency++)
+    {
+        histogram.add(latency);
+    }
+
+    BOOST_CHECK_EQUAL(histogram.count(), 1000u);
+    BOOST_CHECK_CLOSE(histogram.mean(), 500.5, 1e-9);
+    BOOST_CHECK_EQUAL(histogram.max(), 1000);
+
+    // Percentiles are bucket upper edges, so within one bucket width above the exact value
+    const double ratio = std::exp2(1.0 / LatencyHistogram::BUCKETS_PER_OCTAVE);
+    BOOST_CHECK_GE(histogram.percentile(0.5), 500);
+    BOOST_CHECK_LE(histogram.percentile(0.5), 500 * ratio);
+    BOOST_CHECK_GE(histogram.percentile(0.99), 990);
+    BOOST_CHECK_LE(histogram.percentile(0.99), 1000);
+    BOOST_CHECK_EQUAL(histogram.percentile(1), 1000);
+
+    histogram.reset();
+    BOOST_CHECK_EQUAL(histogram.count(), 0u);
+    BOOST_CHECK_EQUAL(histogram.percentile(0.5), 0);
+}
@@ -0,0 +1,152 @@
+#define BOOST_TEST_MODULE MagnetometerCalibratorTest
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/utils/MagnetometerCalibrator.hpp>
+#include <gnc/utils/MagnetometerEllipsoidFit.hpp>
+
+using maav::gnc::EllipsoidFit;
+using maav::gnc::MagnetometerCalibrator;
+using maav::gnc::runMagnetometerCalibration;
+
+using namespace Eigen;
+
+/*
+ * Readings of a unit field from n directions spread over the sphere, distorted by a hard iron
+ * offset and a soft iron scale along rotated axes
+ */
+std::vector<Vector3d> distortedSphere(size_t n, const Vector3d& offset)
+{
+    const Matrix3d rotation =
+        (AngleAxisd(0.4, Vector3d::UnitZ()) * AngleAxisd(-0.3, Vector3d::UnitX())).matrix();
+    const Vector3d scale(0.9, 1.2, 1.05);
+
+    // Fibonacci sphere, so consecutive readings are far apart like a tumbling vehicle
+    std::vector<Vector3d> readings;
+    const double golden_angle = M_PI * (3 - std::sqrt(5.0));
+    for (size_t i = 0; i < n; i++)
+    {
+        const double z = 1 - 2 * (i + 0.5) / n;
+        const double r = std::sqrt(1 - z * z);
+        const double angle = golden_angle * i;
+        const Vector3d direction(r * std::cos(angle), r * std::sin(angle), z);
+        readings.push_back(rotation * scale.asDiagonal() * direction + offset);
+    }
+    return readings;
+}
+
+/*
+ * Corrects a reading the way maav-estimator does
+ */
+Vector3d calibrate(const MagParams& params, const Vector3d& reading)
+{
+    const RowVector3d rotated = (reading - params.offset).transpose() * params.rotM;
+    return rotated.transpose().cwiseQuotient(params.scale);
+}
+
+void checkCalibration(const MagParams& params, const Vector3d& offset)
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        BOOST_CHECK_CLOSE(params.offset(i), offset(i), 1e-3);
+    }
+    for (const Vector3d& reading : distortedSphere(50, offset))
+    {
+        BOOST_CHECK_CLOSE(calibrate(params, reading).norm(), 1, 1e-3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EllipsoidFitTest)
+{
+    const Vector3d offset(0.3, -0.2, 0.5);
+    const std::vector<Vector3d> readings = distortedSphere(500, offset);
+
+    EllipsoidFit fit;
+    for (const Vector3d& reading : readings) fit.add(reading);
+    BOOST_CHECK_EQUAL(fit.weight(), 500);
+
+    MagParams params;
+    BOOST_REQUIRE(fit.solve(params));
+    checkCalibration(params, offset);
+
+    // The batch fit folds the readings in the same way
+    VectorXd x(readings.size()), y(readings.size()), z(readings.size());
+    for (size_t i = 0; i < readings.size(); i++)
+    {
+        x(i) = readings[i].x();
+        y(i) = readings[i].y();
+        z(i) = readings[i].z();
+    }
+    const MagParams batch = runMagnetometerCalibration(x, y, z);
+    BOOST_CHECK(batch.offset.isApprox(params.offset, 1e-12));
+    BOOST_CHECK(batch.scale.isApprox(params.scale, 1e-12));
+}
+
+/*
+ * With forgetting the fit follows an offset that moves, e.g. when a payload is powered on
+ */
+BOOST_AUTO_TEST_CASE(ForgettingTest)
+{
+    const Vector3d before(0.3, -0.2, 0.5);
+    const Vector3d after(-0.4, 0.1, 0.2);
+
+    EllipsoidFit fit(0.98);
+    for (const Vector3d& reading : distortedSphere(1000, before)) fit.add(reading);
+    for (const Vector3d& reading : distortedSphere(1000, after)) fit.add(reading);
+    BOOST_CHECK_CLOSE(fit.weight(), 50, 1e-3);
+
+    MagParams params;
+    BOOST_REQUIRE(fit.solve(params));
+    checkCalibration(params, after);
+}
+
+BOOST_AUTO_TEST_CASE(CalibratorTest)
+{
+    YAML::Node config = YAML::Load(
+        "{enabled: true, min_separation: 0.05, min_samples: 200, fit_period: 50, "
+        "forgetting: 1, max_axis_ratio: 2}");
+    MagnetometerCalibrator calibrator(config);
+
+    // Uncalibrated until enough of the sphere has been seen
+    const Vector3d offset(0.3, -0.2, 0.5);
+    const std::vector<Vector3d> readings = distortedSphere(400, offset);
+    for (size_t i = 0; i < 100; i++) calibrator.add(readings[i]);
+    BOOST_CHECK(calibrator.calibration()->offset.isZero());
+
+    // Hovering in one direction adds nothing
+    for (size_t i = 0; i < 1000; i++) calibrator.add(readings[99]);
+
+    for (size_t i = 100; i < readings.size(); i++)
+    {
+        calibrator.add(readings[i]);
+        // Paced like an IMU, so the calibrator thread keeps up
+        if (i % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (calibrator.fits() < 5 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_REQUIRE_EQUAL(calibrator.fits(), 5u);
+    checkCalibration(*calibrator.calibration(), offset);
+}
+
+BOOST_AUTO_TEST_CASE(DisabledTest)
+{
+    MagnetometerCalibrator calibrator(YAML::Load("{enabled: false}"));
+    BOOST_CHECK(!calibrator.enabled());
+    for (const Vector3d& reading : distortedSphere(400, Vector3d(1, 2, 3)))
+    {
+        calibrator.add(reading);
+    }
+    BOOST_CHECK_EQUAL(calibrator.fits(), 0u);
+    BOOST_CHECK(calibrator.calibration()->scale.isOnes());
+}
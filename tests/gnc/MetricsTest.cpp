@@ -0,0 +1,139 @@
+#define BOOST_TEST_MODULE MetricsTest
+
+#include <algorithm>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/utils/Metrics.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Estimator;
+using maav::gnc::Metrics;
+using maav::gnc::measurements::MeasurementSet;
+
+uint64_t counterValue(const Metrics::Report& report, const std::string& name)
+{
+    for (const auto& counter : report.counters)
+    {
+        if (counter.first == name) return counter.second;
+    }
+    BOOST_FAIL("No counter " + name);
+    return 0;
+}
+
+const Metrics::Report::Summary& histogramSummary(
+    const Metrics::Report& report, const std::string& name)
+{
+    const auto it = std::find_if(report.histograms.begin(), report.histograms.end(),
+        [&name](const Metrics::Report::Summary& summary) { return summary.name == name; });
+    BOOST_REQUIRE(it != report.histograms.end());
+    return *it;
+}
+
+BOOST_AUTO_TEST_CASE(RegistryTest)
+{
+    Metrics& metrics = Metrics::instance();
+
+    // The same name is the same metric
+    Metrics::Counter& counter = metrics.counter("test.b");
+    BOOST_CHECK_EQUAL(&counter, &metrics.counter("test.b"));
+    counter.add();
+    counter.add(4);
+    metrics.counter("test.a").add();
+    metrics.gauge("test.gauge").set(2.5);
+
+    Metrics::Histogram& histogram = metrics.histogram("test.histogram_usec");
+    for (int64_t value = 1; value <= 100; value++) histogram.add(value);
+
+    const Metrics::Report report = metrics.report();
+    BOOST_CHECK_EQUAL(counterValue(report, "test.b"), 5u);
+    BOOST_CHECK(std::is_sorted(report.counters.begin(), report.counters.end()));
+
+    const auto gauge = std::find(report.gauges.begin(), report.gauges.end(),
+        std::make_pair(std::string("test.gauge"), 2.5));
+    BOOST_CHECK(gauge != report.gauges.end());
+
+    const Metrics::Report::Summary& summary = histogramSummary(report, "test.histogram_usec");
+    BOOST_CHECK_EQUAL(summary.count, 100u);
+    BOOST_CHECK_CLOSE(summary.mean, 50.5, 1e-9);
+    BOOST_CHECK_EQUAL(summary.max, 100);
+
+    // Histograms cover one report each, counters keep counting
+    counter.add();
+    const Metrics::Report next = metrics.report();
+    BOOST_CHECK_EQUAL(counterValue(next, "test.b"), 6u);
+    BOOST_CHECK_EQUAL(histogramSummary(next, "test.histogram_usec").count, 0u);
+}
+
+/*
+ * Hovers with a lidar that reads a wild distance every tenth reading, and checks the estimator
+ * counts those as rejected instead of printing them
+ */
+BOOST_AUTO_TEST_CASE(EstimatorTest)
+{
+    YAML::Node config = estimatorConfig();
+    config["updates"]["lidar"]["enable_outliers"] = true;
+
+    Metrics& metrics = Metrics::instance();
+    Estimator estimator(config);
+    metrics.report();
+    const uint64_t accepted = metrics.counter("update.lidar.accepted").value();
+    const uint64_t rejected = metrics.counter("update.lidar.rejected").value();
+
+    for (uint64_t tick = 0; tick < 200; tick++)
+    {
+        MeasurementSet set = createSet(tick, estimator.measurementPool());
+        if (tick % 2 == 0)
+        {
+            addLidar(set, estimator.measurementPool(), tick % 20 == 10 ? 1.0 : 0.0);
+        }
+        estimator.add_measurement_set(set);
+    }
+
+    const Metrics::Report report = metrics.report();
+    BOOST_CHECK_EQUAL(counterValue(report, "update.lidar.rejected") - rejected, 10u);
+    // The first set only starts the history, so its reading is never fused
+    BOOST_CHECK_EQUAL(counterValue(report, "update.lidar.accepted") - accepted, 89u);
+    BOOST_CHECK_EQUAL(histogramSummary(report, "estimator.filter_usec").count, 200u);
+    BOOST_CHECK_EQUAL(histogramSummary(report, "estimator.predict_usec").count, 199u);
+    BOOST_CHECK_EQUAL(histogramSummary(report, "estimator.replay_steps").count, 199u);
+}
+
+/*
+ * Global updates arrive 25 ms late, so the estimator replays over the lidar readings since. Each
+ * reading is still counted once.
+ */
+BOOST_AUTO_TEST_CASE(ReplayTest)
+{
+    YAML::Node config = estimatorConfig();
+    config["updates"]["global_update"]["enabled"] = true;
+
+    Metrics& metrics = Metrics::instance();
+    Estimator estimator(config);
+    const uint64_t lidar_accepted = metrics.counter("update.lidar.accepted").value();
+    const uint64_t global_accepted = metrics.counter("update.global_update.accepted").value();
+
+    for (uint64_t tick = 0; tick < 200; tick++)
+    {
+        MeasurementSet set = createSet(tick, estimator.measurementPool());
+        if (tick % 2 == 0) addLidar(set, estimator.measurementPool(), 0.0);
+        if (tick > 0 && tick % 10 == 0)
+        {
+            auto global_update = estimator.measurementPool().global_update.acquire();
+            global_update->setTime(tick * IMU_PERIOD - 25000);
+            global_update->pose() = Sophus::SE3d();
+            set.global_update = global_update;
+        }
+        estimator.add_measurement_set(set);
+    }
+
+    // The first set only starts the history, so its reading is never fused
+    BOOST_CHECK_EQUAL(metrics.counter("update.lidar.accepted").value() - lidar_accepted, 99u);
+    BOOST_CHECK_EQUAL(
+        metrics.counter("update.global_update.accepted").value() - global_accepted, 19u);
+}
@@ -0,0 +1,180 @@
+#define BOOST_TEST_MODULE PoseBufferTest
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/utils/PoseBuffer.hpp>
+
+using namespace boost::unit_test;
+using namespace std::chrono_literals;
+
+using maav::gnc::PoseBuffer;
+using Sophus::SE3d;
+using Sophus::SO3d;
+
+/*
+ * Pose yawed by time_usec / 1000 degrees, at (time_usec, 2 * time_usec, 0) / 1000
+ */
+SE3d poseAt(uint64_t time_usec)
+{
+    const double t = static_cast<double>(time_usec) / 1000;
+    return SE3d(SO3d::rotZ(t * M_PI / 180), Eigen::Vector3d(t, 2 * t, 0));
+}
+
+void checkPose(const SE3d& actual, const SE3d& expected)
+{
+    BOOST_CHECK_SMALL((actual.translation() - expected.translation()).norm(), 1e-9);
+    BOOST_CHECK_SMALL((actual.so3().inverse() * expected.so3()).log().norm(), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(EmptyTest)
+{
+    PoseBuffer buffer(10);
+    SE3d pose;
+    uint64_t oldest, newest;
+    BOOST_CHECK(!buffer.at(0, pose));
+    BOOST_CHECK(!buffer.range(oldest, newest));
+    BOOST_CHECK(!buffer.waitFor(0, 1ms, pose));
+}
+
+BOOST_AUTO_TEST_CASE(InterpolationTest)
+{
+    PoseBuffer buffer(10);
+    buffer.push(10000, poseAt(10000));
+    buffer.push(20000, poseAt(20000));
+    buffer.push(30000, poseAt(30000));
+
+    // Yaw and position both change linearly with time, so interpolation is exact
+    SE3d pose;
+    for (uint64_t time = 10000; time <= 30000; time += 2500)
+    {
+        BOOST_REQUIRE(buffer.at(time, pose));
+        checkPose(pose, poseAt(time));
+    }
+
+    // No extrapolation
+    BOOST_REQUIRE(buffer.at(5000, pose));
+    checkPose(pose, poseAt(10000));
+    BOOST_REQUIRE(buffer.at(35000, pose));
+    checkPose(pose, poseAt(30000));
+}
+
+BOOST_AUTO_TEST_CASE(CapacityTest)
+{
+    PoseBuffer buffer(4);
+    for (uint64_t time = 1000; time <= 10000; time += 1000)
+    {
+        buffer.push(time, poseAt(time));
+    }
+
+    uint64_t oldest, newest;
+    BOOST_REQUIRE(buffer.range(oldest, newest));
+    BOOST_CHECK_EQUAL(oldest, 7000u);
+    BOOST_CHECK_EQUAL(newest, 10000u);
+
+    SE3d pose;
+    BOOST_REQUIRE(buffer.at(1000, pose));
+    checkPose(pose, poseAt(7000));
+    BOOST_REQUIRE(buffer.at(8500, pose));
+    checkPose(pose, poseAt(8500));
+}
+
+BOOST_AUTO_TEST_CASE(RewindTest)
+{
+    PoseBuffer buffer(10);
+    for (uint64_t time = 1000; time <= 5000; time += 1000)
+    {
+        buffer.push(time, poseAt(time));
+    }
+
+    // A window re-estimating the poses from 3000 on, shifted by 1 m
+    const SE3d shift(SO3d(), Eigen::Vector3d(1, 0, 0));
+    for (uint64_t time = 3000; time <= 6000; time += 1000)
+    {
+        buffer.push(time, shift * poseAt(time));
+    }
+
+    uint64_t oldest, newest;
+    BOOST_REQUIRE(buffer.range(oldest, newest));
+    BOOST_CHECK_EQUAL(oldest, 1000u);
+    BOOST_CHECK_EQUAL(newest, 6000u);
+
+    SE3d pose;
+    BOOST_REQUIRE(buffer.at(2000, pose));
+    checkPose(pose, poseAt(2000));
+    BOOST_REQUIRE(buffer.at(4500, pose));
+    checkPose(pose, shift * poseAt(4500));
+}
+
+BOOST_AUTO_TEST_CASE(WaitTest)
+{
+    PoseBuffer buffer(10);
+    buffer.push(1000, poseAt(1000));
+
+    // A time that never arrives gets the newest pose after the timeout
+    SE3d pose;
+    const auto start = std::chrono::steady_clock::now();
+    BOOST_REQUIRE(buffer.waitFor(2000, 20ms, pose));
+    BOOST_CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+    checkPose(pose, poseAt(1000));
+
+    // Wakes up as soon as the time arrives
+    std::thread writer([&] {
+        std::this_thread::sleep_for(10ms);
+        buffer.push(3000, poseAt(3000));
+    });
+    BOOST_REQUIRE(buffer.waitFor(2000, 10s, pose));
+    checkPose(pose, poseAt(2000));
+    writer.join();
+}
+
+BOOST_AUTO_TEST_CASE(InterruptTest)
+{
+    PoseBuffer buffer(10);
+    SE3d pose;
+    std::thread killer([&] {
+        std::this_thread::sleep_for(10ms);
+        buffer.interrupt();
+    });
+    BOOST_CHECK(!buffer.waitFor(1000, 10s, pose));
+    killer.join();
+    BOOST_CHECK(!buffer.waitFor(1000, 10s, pose));
+}
+
+/*
+ * Readers never see a pose mixed from two writes while the writer laps the ring
+ */
+BOOST_AUTO_TEST_CASE(ConcurrentTest)
+{
+    PoseBuffer buffer(8);
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        for (uint64_t time = 1000; time <= 2000000; time += 1000)
+        {
+            buffer.push(time, poseAt(time));
+        }
+        done = true;
+    });
+
+    size_t torn = 0;
+    while (!done)
+    {
+        uint64_t oldest, newest;
+        if (!buffer.range(oldest, newest)) continue;
+
+        // Both the yaw and y are a fixed multiple of x on every pose, and between poses
+        SE3d pose;
+        BOOST_REQUIRE(buffer.at((oldest + newest) / 2, pose));
+        const double x = pose.translation().x();
+        const double yaw = pose.so3().log().z() * 180 / M_PI;
+        const double wrapped = std::remainder(yaw - x, 360);
+        if (std::abs(pose.translation().y() - 2 * x) > 1e-6 || std::abs(wrapped) > 1e-6) torn++;
+    }
+    writer.join();
+    BOOST_CHECK_EQUAL(torn, 0u);
+}
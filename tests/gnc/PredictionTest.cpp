@@ -5,6 +5,7 @@
 
 #include <cmath>
 #include <list>
+#include <string>
 #include <vector>
 
 #include <Eigen/Eigen>
@@ -99,4 +100,58 @@ BOOST_AUTO_TEST_CASE(PredictionStep)
     BOOST_CHECK_LE(diff(s2.position(), next_position), tol);
     BOOST_CHECK_LE(diff(s2.velocity(), next_velocity), tol);
     BOOST_CHECK_LE(diff(s2.attitude(), next_attitude), tol);
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(ParallelMatchesSerialTest)
+{
+    const std::string config_str =
+        "UT:\n  alpha: 0.1\n  beta: 2.0\n  kappa: 0.0\n  threads: {}\nQ_i: [0.00005, 0.00005, "
+        "0.00005, 0.00002, 0.00002, 0.00002, 0.00001, 0.00001, 0.00001, 0.00001, 0.00001, "
+        "0.00001]\n";
+    const auto load = [&](const std::string& threads) {
+        std::string str = config_str;
+        str.replace(str.find("{}"), 2, threads);
+        return YAML::Load(str);
+    };
+
+    UkfPrediction serial(load("0"));
+    UkfPrediction parallel(load("3"));
+
+    // Propagate the same chain of IMU readings through both
+    constexpr size_t STEPS = 200;
+    std::vector<History::Snapshot> serial_history(STEPS);
+    std::vector<History::Snapshot> parallel_history(STEPS);
+    for (size_t i = 0; i < STEPS; i++)
+    {
+        const uint64_t time = i * 10000;
+        auto imu = std::make_shared<measurements::ImuMeasurement>();
+        imu->time_usec = time;
+        imu->angular_rates = {0.3 * std::sin(0.05 * i), -0.1, 0.2 * std::cos(0.03 * i)};
+        imu->acceleration = {0.5 * std::cos(0.07 * i), 0.2, -9.7};
+        imu->magnetometer = Eigen::Vector3d::Zero();
+
+        for (auto* history : {&serial_history, &parallel_history})
+        {
+            (*history)[i].measurement.imu = imu;
+            (*history)[i].state = State::zero(time);
+        }
+    }
+    serial_history[0].state.covariance() *= 0.05;
+    parallel_history[0].state.covariance() *= 0.05;
+
+    for (size_t i = 1; i < STEPS; i++)
+    {
+        serial(serial_history[i - 1], serial_history[i]);
+        parallel(parallel_history[i - 1], parallel_history[i]);
+
+        // Results must match bit for bit, not just within a tolerance
+        const State& expected = serial_history[i].state;
+        const State& actual = parallel_history[i].state;
+        BOOST_REQUIRE(expected.attitude().unit_quaternion().coeffs() ==
+                      actual.attitude().unit_quaternion().coeffs());
+        BOOST_REQUIRE(expected.position() == actual.position());
+        BOOST_REQUIRE(expected.velocity() == actual.velocity());
+        BOOST_REQUIRE(expected.gyroBias() == actual.gyroBias());
+        BOOST_REQUIRE(expected.accelBias() == actual.accelBias());
+        BOOST_REQUIRE(expected.covariance() == actual.covariance());
+    }
+}
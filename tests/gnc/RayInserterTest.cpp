@@ -0,0 +1,86 @@
+#define BOOST_TEST_MODULE RayInserterTest
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+#include <octomap/OcTree.h>
+#include <octomap/octomap.h>
+
+#include <gnc/RayInserter.hpp>
+
+using maav::gnc::RayInserter;
+using octomap::OcTree;
+using octomap::OcTreeNode;
+using octomap::Pointcloud;
+using octomap::point3d;
+
+constexpr double RESOLUTION = 0.05;  // [m]
+constexpr double MAX_RANGE = 5;      // [m]
+
+/*
+ * A wall 3 m ahead with several points per voxel, none of them at a voxel's center, and a point
+ * beyond MAX_RANGE
+ */
+Pointcloud createCloud(double yaw)
+{
+    Pointcloud cloud;
+    const double c = std::cos(yaw);
+    const double s = std::sin(yaw);
+    for (int i = 0; i < 60; i++)
+    {
+        for (int j = 0; j < 30; j++)
+        {
+            const double x = 3 + 0.2 * std::sin(i * 0.3);
+            const double y = -0.9 + i * 0.0307;
+            const double z = -0.4 + j * 0.0293;
+            cloud.push_back(c * x - s * y, s * x + c * y, z);
+        }
+    }
+    cloud.push_back(c * 8 - s * 0.01, s * 8 + c * 0.01, 0.11);
+    return cloud;
+}
+
+/*
+ * Every leaf of one tree is in the other, with the same log odds
+ */
+void checkSameLeaves(const OcTree& actual, const OcTree& expected)
+{
+    BOOST_CHECK_EQUAL(actual.getNumLeafNodes(), expected.getNumLeafNodes());
+    for (auto it = expected.begin_leafs(); it != expected.end_leafs(); ++it)
+    {
+        const OcTreeNode* node = actual.search(it.getKey());
+        BOOST_REQUIRE(node);
+        BOOST_CHECK_EQUAL(node->getLogOdds(), it->getLogOdds());
+    }
+}
+
+/*
+ * Inserts the same clouds with RayInserter and with OcTree::insertPointCloud
+ */
+void checkInsert(size_t num_threads)
+{
+    OcTree expected(RESOLUTION);
+    OcTree actual(RESOLUTION);
+    RayInserter inserter(num_threads, MAX_RANGE);
+
+    // The clouds overlap, so later ones update voxels set by earlier ones
+    const point3d origins[] = {point3d(0, 0, 0), point3d(0.12, -0.07, 0.03)};
+    for (int i = 0; i < 3; i++)
+    {
+        const Pointcloud cloud = createCloud(i * 0.05);
+        const point3d& origin = origins[i % 2];
+        expected.insertPointCloud(cloud, origin, MAX_RANGE, true, true);
+        inserter.insert(actual, cloud, origin);
+    }
+    checkSameLeaves(actual, expected);
+
+    // The ray to the far point is cut at MAX_RANGE, and only clears space
+    BOOST_CHECK(actual.search(point3d(8, 0.01, 0.11)) == nullptr);
+    const OcTreeNode* cut = actual.search(point3d(4.81, 0.015, 0.075));
+    BOOST_REQUIRE(cut);
+    BOOST_CHECK(!actual.isNodeOccupied(cut));
+}
+
+BOOST_AUTO_TEST_CASE(SingleThreadTest) { checkInsert(0); }
+
+BOOST_AUTO_TEST_CASE(MultiThreadTest) { checkInsert(3); }
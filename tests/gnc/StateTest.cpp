@@ -3,7 +3,9 @@
  * Tests for both State and Kalman State
  */
 
+#include <array>
 #include <cmath>
+#include <random>
 #include <vector>
 
 #include <Eigen/Eigen>
@@ -48,6 +50,28 @@ BOOST_AUTO_TEST_CASE(StateModificationTest)
     BOOST_REQUIRE_EQUAL(base.position(), vec);
 }
 
+BOOST_AUTO_TEST_CASE(SqrtCovarianceCopyTest)
+{
+    // Only states in square root mode make room for the factor
+    BOOST_CHECK_LT(sizeof(State), 2 * sizeof(State::CovarianceMatrix));
+
+    State factored = State::zero(0);
+    const State::CovarianceMatrix L = 1e-2 * State::CovarianceMatrix::Identity();
+    factored.setSqrtCovariance(L);
+
+    State copy = factored;
+    BOOST_REQUIRE(copy.hasSqrtCovariance());
+    BOOST_CHECK_EQUAL(copy.sqrtCovariance(), L);
+    BOOST_CHECK_EQUAL(copy.covariance(), factored.covariance());
+
+    // A dense state drops the factor, and the next factored one takes its place again
+    copy = State::zero(1);
+    BOOST_CHECK(!copy.hasSqrtCovariance());
+    copy = factored;
+    BOOST_REQUIRE(copy.hasSqrtCovariance());
+    BOOST_CHECK_EQUAL(copy.sqrtCovariance(), L);
+}
+
 BOOST_AUTO_TEST_CASE(UnweightedGaussianTest)
 {
     std::array<State, State::N> states;
@@ -136,3 +160,146 @@ BOOST_AUTO_TEST_CASE(UnweightedGaussianTest)
     BOOST_CHECK_LE((computed_gaussian.accelBias() - mean_accel_bias).norm(), tol);
     BOOST_CHECK_LE((computed_gaussian.covariance() - output).norm(), tol);
 }
+
+namespace
+{
+/*
+ * Per-member formulation of the State arithmetic that the packed implementation replaced.
+ * Kept here as the reference the packed versions are checked against.
+ */
+State::ErrorStateVector reference_minus(const State& lhs, const State& rhs)
+{
+    State::ErrorStateVector e;
+    const Sophus::SO3d rhs_inv = rhs.attitude().inverse();
+    e.segment<3>(0) = (rhs_inv * lhs.attitude()).log();
+    e.segment<3>(3) = rhs_inv * (lhs.position() - rhs.position());
+    e.segment<3>(6) = rhs_inv * (lhs.velocity() - rhs.velocity());
+    e.segment<3>(9) = lhs.gyroBias() - rhs.gyroBias();
+    e.segment<3>(12) = lhs.accelBias() - rhs.accelBias();
+    return e;
+}
+
+void reference_plus(State& state, const State::ErrorStateVector& e)
+{
+    const Sophus::SO3d attitude_err = Sophus::SO3d::exp(e.segment<3>(0));
+    state.position() += state.attitude() * e.segment<3>(3);
+    state.velocity() += state.attitude() * e.segment<3>(6);
+    state.attitude() *= attitude_err;
+    state.gyroBias() += e.segment<3>(9);
+    state.accelBias() += e.segment<3>(12);
+}
+
+State reference_gaussian(const std::array<State, State::N>& points,
+    const State::Weights& m_weights, const State::Weights& c_weights)
+{
+    State mean = State::zero(points[0].timeUSec());
+    mean.attitude() = points[0].attitude();
+    for (size_t i = 0; i < State::N; i++)
+    {
+        mean.position() += points[i].position() * m_weights[i];
+        mean.velocity() += points[i].velocity() * m_weights[i];
+        mean.acceleration() += points[i].acceleration() * m_weights[i];
+        mean.angularVelocity() += points[i].angularVelocity() * m_weights[i];
+        mean.gyroBias() += points[i].gyroBias() * m_weights[i];
+        mean.accelBias() += points[i].accelBias() * m_weights[i];
+    }
+
+    State::CovarianceMatrix covariance = State::CovarianceMatrix::Zero();
+    for (size_t i = 0; i < State::N; i++)
+    {
+        State::ErrorStateVector r;
+        r.segment<3>(0) = (mean.attitude().inverse() * points[i].attitude()).log();
+        r.segment<3>(3) = points[i].position() - mean.position();
+        r.segment<3>(6) = points[i].velocity() - mean.velocity();
+        r.segment<3>(9) = points[i].gyroBias() - mean.gyroBias();
+        r.segment<3>(12) = points[i].accelBias() - mean.accelBias();
+        covariance += c_weights[i] * r * r.transpose();
+    }
+    mean.covariance() = covariance;
+    return mean;
+}
+
+State random_state(std::mt19937& gen, uint64_t time_usec)
+{
+    std::normal_distribution<double> dist(0.0, 1.0);
+    auto random_vector = [&]() { return Vector3d(dist(gen), dist(gen), dist(gen)); };
+
+    State state = State::zero(time_usec);
+    state.attitude() = Sophus::SO3d::exp(random_vector());
+    state.position() = 10 * random_vector();
+    state.velocity() = random_vector();
+    state.acceleration() = random_vector();
+    state.angularVelocity() = random_vector();
+    state.gyroBias() = 0.01 * random_vector();
+    state.accelBias() = 0.1 * random_vector();
+    return state;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(PackedArithmeticTest)
+{
+    constexpr double tol = 1e-12;
+    std::mt19937 gen(42);
+    std::normal_distribution<double> dist(0.0, 1.0);
+
+    for (size_t trial = 0; trial < 100; trial++)
+    {
+        const State a = random_state(gen, 100);
+        const State b = random_state(gen, 100);
+
+        BOOST_CHECK_LE(((a - b) - reference_minus(a, b)).norm(), tol);
+
+        State::ErrorStateVector e;
+        for (size_t i = 0; i < State::DoF; i++) e(i) = 0.5 * dist(gen);
+        State packed = a;
+        packed += e;
+        State reference = a;
+        reference_plus(reference, e);
+        BOOST_CHECK_LE((packed.attitude().matrix() - reference.attitude().matrix()).norm(), tol);
+        BOOST_CHECK_LE((packed.position() - reference.position()).norm(), tol);
+        BOOST_CHECK_LE((packed.velocity() - reference.velocity()).norm(), tol);
+        BOOST_CHECK_LE((packed.gyroBias() - reference.gyroBias()).norm(), tol);
+        BOOST_CHECK_LE((packed.accelBias() - reference.accelBias()).norm(), tol);
+    }
+
+    // Sigma points scattered around a random center, weighted like an unscented transform
+    constexpr double alpha = 0.1;
+    constexpr double beta = 2;
+    constexpr double kappa = 0;
+    constexpr double n = static_cast<double>(State::DoF);
+    const double lambda = alpha * alpha * (n + kappa) - n;
+    State::Weights m_weights;
+    State::Weights c_weights;
+    m_weights.fill(1 / (2 * (n + lambda)));
+    c_weights.fill(1 / (2 * (n + lambda)));
+    m_weights[0] = lambda / (n + lambda);
+    c_weights[0] = lambda / (n + lambda) + (1 - alpha * alpha + beta);
+
+    for (size_t trial = 0; trial < 20; trial++)
+    {
+        const State center = random_state(gen, 200);
+        std::array<State, State::N> points;
+        points.fill(center);
+        for (size_t i = 1; i < State::N; i++)
+        {
+            State::ErrorStateVector e;
+            for (size_t j = 0; j < State::DoF; j++) e(j) = 0.1 * dist(gen);
+            points[i] += e;
+            points[i].acceleration() += 0.1 * Vector3d(dist(gen), dist(gen), dist(gen));
+            points[i].angularVelocity() += 0.1 * Vector3d(dist(gen), dist(gen), dist(gen));
+        }
+
+        const State packed = State::compute_gaussian(points, m_weights, c_weights);
+        const State reference = reference_gaussian(points, m_weights, c_weights);
+
+        BOOST_CHECK_LE((packed.attitude().matrix() - reference.attitude().matrix()).norm(), tol);
+        BOOST_CHECK_LE((packed.position() - reference.position()).norm(), tol);
+        BOOST_CHECK_LE((packed.velocity() - reference.velocity()).norm(), tol);
+        BOOST_CHECK_LE((packed.acceleration() - reference.acceleration()).norm(), tol);
+        BOOST_CHECK_LE((packed.angularVelocity() - reference.angularVelocity()).norm(), tol);
+        BOOST_CHECK_LE((packed.gyroBias() - reference.gyroBias()).norm(), tol);
+        BOOST_CHECK_LE((packed.accelBias() - reference.accelBias()).norm(), tol);
+        BOOST_CHECK_LE((packed.covariance() - reference.covariance()).norm(),
+            tol * reference.covariance().norm());
+    }
+}
@@ -1,8 +1,10 @@
-
 #include <cmath>
 
 #include "TestHelpers.hpp"
 
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+
 double diff(const Sophus::SO3d& r1, const Sophus::SO3d& r2)
 {
     const Sophus::SO3d err = r1.inverse() * r2;
@@ -20,3 +22,69 @@ double diff(const Eigen::Vector3d& v1, const Eigen::Vector3d& v2)
     const Eigen::Vector3d err = v1 - v2;
     return err.norm();
 }
+
+YAML::Node estimatorConfig()
+{
+    return YAML::Load(
+        "history:\n"
+        "  size: 100\n"
+        "  tolerance: 1000\n"
+        "state:\n"
+        "  attitude: [1, 0, 0, 0]\n"
+        "  position: [0, 0, 0]\n"
+        "  velocity: [0, 0, 0]\n"
+        "  covariance: [0.001, 0.001, 0.001, 0.01, 0.01, 0.01, 0.01, 0.01, 0.01, 0.00001, "
+        "0.00001, 0.00001, 0.00001, 0.00001, 0.00001]\n"
+        "prediction:\n"
+        "  UT: {alpha: 0.05, beta: 2.0, kappa: 2}\n"
+        "  Q_i: [0.001, 0.001, 0.001, 0.005, 0.005, 0.005, 1e-8, 1e-8, 1e-8, 1e-8, 1e-8, 1e-8]\n"
+        "updates:\n"
+        "  imu_height: 0\n"
+        "  lidar:\n"
+        "    enabled: true\n"
+        "    enable_outliers: false\n"
+        "    UT: {alpha: 0.1, beta: 2.0, kappa: 0.0}\n"
+        "    R: [0.0001]\n"
+        "    extrinsics: [0, 0, 0, 0, 0, 0]\n"
+        "    lidar_bias: 0\n"
+        "  planefit:\n"
+        "    enabled: false\n"
+        "    enable_outliers: true\n"
+        "    UT: {alpha: 0.1, beta: 2.0, kappa: 0.0}\n"
+        "    R: [0.000001, 0.000001, 0.000001, 0.000001]\n"
+        "    extrinsics: [0, 0, 0, 0, 0, 0]\n"
+        "  global_update:\n"
+        "    enabled: false\n"
+        "    enable_outliers: false\n"
+        "    UT: {alpha: 0.1, beta: 2.0, kappa: 0.0}\n"
+        "    R: [0.003, 0.003, 0.003, 0.003, 0.003, 0.003]\n"
+        "    extrinsics: [0, 0, 0, 0, 0, 0]\n"
+        "  visual_odometry:\n"
+        "    enabled: false\n"
+        "    enable_outliers: false\n"
+        "    UT: {alpha: 0.1, beta: 2.0, kappa: 0.0}\n"
+        "    R: [0.0001, 0.0001, 0.0001, 0.0001, 0.0001, 0.0001]\n"
+        "    extrinsics: [0, 0, 0, 0, 0, 0]\n");
+}
+
+MeasurementSet createSet(uint64_t tick, MeasurementPool& pool, const Eigen::Vector3d& acceleration,
+    const Eigen::Vector3d& angular_rates)
+{
+    auto imu = pool.imu.acquire();
+    imu->time_usec = tick * IMU_PERIOD;
+    imu->acceleration = acceleration;
+    imu->angular_rates = angular_rates;
+    imu->magnetometer = Eigen::Vector3d::Zero();
+
+    MeasurementSet set;
+    set.imu = imu;
+    return set;
+}
+
+void addLidar(MeasurementSet& set, MeasurementPool& pool, double distance)
+{
+    auto lidar = pool.lidar.acquire();
+    lidar->setTime(set.imu->time_usec);
+    lidar->distance()(0) = distance;
+    set.lidar = lidar;
+}
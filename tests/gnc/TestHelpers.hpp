@@ -1,8 +1,19 @@
 #pragma once
 
+#include <cstdint>
+
+#include <yaml-cpp/yaml.h>
 #include <Eigen/Eigen>
 #include <sophus/so3.hpp>
 
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/measurements/MeasurementPool.hpp>
+
+/**
+ * Period of the simulated IMU in microseconds
+ */
+constexpr uint64_t IMU_PERIOD = 10000;
+
 /**
  * Returns the error in radians between two rotations
  */
@@ -17,3 +28,25 @@ double diff(const Eigen::Quaterniond& q1, const Eigen::Quaterniond& q2);
  * Returns the error (norm) between two vectors
  */
 double diff(const Eigen::Vector3d& v1, const Eigen::Vector3d& v2);
+
+/**
+ * Returns the estimator config the tests start from: a UKF over a history of 100 snapshots, with
+ * the lidar enabled without outlier rejection and every other sensor disabled. Tests override
+ * the keys they exercise.
+ */
+YAML::Node estimatorConfig();
+
+/**
+ * Returns a set with the IMU sample of tick, taken IMU_PERIOD * tick after start. The IMU reads
+ * a hover unless given other accelerations and angular rates.
+ */
+maav::gnc::measurements::MeasurementSet createSet(uint64_t tick,
+    maav::gnc::measurements::MeasurementPool& pool,
+    const Eigen::Vector3d& acceleration = Eigen::Vector3d(0, 0, -9.80665),
+    const Eigen::Vector3d& angular_rates = Eigen::Vector3d::Zero());
+
+/**
+ * Adds a lidar reading of distance to set, at the time of its IMU sample
+ */
+void addLidar(maav::gnc::measurements::MeasurementSet& set,
+    maav::gnc::measurements::MeasurementPool& pool, double distance);
@@ -12,6 +12,7 @@
 #include <sophus/so3.hpp>
 
 #include <gnc/State.hpp>
+#include <gnc/kalman/CholeskyUpdate.hpp>
 #include <gnc/kalman/UnscentedTransform.hpp>
 #include "TestHelpers.hpp"
 
@@ -132,4 +133,99 @@ BOOST_AUTO_TEST_CASE(SigmaPointsTest)
         compare_states(sig_pts[i], sigma_points.col(i));
     }
 }
+
+BOOST_AUTO_TEST_CASE(CholeskyUpdateTest)
+{
+    using Matrix = Eigen::Matrix<double, 4, 4>;
+    using Vector = Eigen::Matrix<double, 4, 1>;
+
+    Matrix A = Matrix::Random();
+    const Matrix P = A * A.transpose() + Matrix::Identity();
+    const Vector x = 0.5 * Vector::Random();
+
+    Matrix L = Eigen::LLT<Matrix>(P).matrixL();
+    BOOST_REQUIRE(choleskyUpdate(L, x));
+    BOOST_CHECK_LE((L * L.transpose() - (P + x * x.transpose())).norm(), 1e-9);
+
+    BOOST_REQUIRE(choleskyUpdate(L, x, true));
+    BOOST_CHECK_LE((L * L.transpose() - P).norm(), 1e-9);
+
+    // Downdating by more than the matrix holds must fail
+    Matrix L_small = Matrix::Identity();
+    BOOST_CHECK(!choleskyUpdate(L_small, Vector(2, 0, 0, 0), true));
+}
+
+State nonlinear(const State& state)
+{
+    State next = state;
+    next.position() += 0.1 * state.velocity() + Eigen::Vector3d(0, 0, 0.5) * state.position().x();
+    next.attitude() = state.attitude() * Sophus::SO3d::exp(0.2 * state.velocity());
+    return next;
+}
+
+BOOST_AUTO_TEST_CASE(SquareRootMatchesStandardTest)
+{
+    UnscentedTransform<State> standard(nonlinear, 0.1, 2, 0);
+    UnscentedTransform<State> square_root(nonlinear, 0.1, 2, 0);
+    square_root.set_square_root(true);
+
+    State state = State::zero(0);
+    State::CovarianceMatrix A = 0.01 * State::CovarianceMatrix::Random();
+    state.covariance() = A * A.transpose() + 1e-4 * State::CovarianceMatrix::Identity();
+
+    const State expected = standard(state);
+    const State actual = square_root(state);
+
+    BOOST_REQUIRE(!expected.hasSqrtCovariance());
+    BOOST_REQUIRE(actual.hasSqrtCovariance());
+
+    const State::CovarianceMatrix& L = actual.sqrtCovariance();
+    BOOST_CHECK_LE((L * L.transpose() - actual.covariance()).norm(), 1e-12);
+    BOOST_CHECK_LE((actual.covariance() - expected.covariance()).norm(),
+        1e-6 * expected.covariance().norm());
+
+    // Sigma points drawn from the factor match those drawn from an LLT of the covariance
+    State from_factor = actual;
+    State from_covariance = actual;
+    from_covariance.clearSqrtCovariance();
+    square_root(from_factor);
+    const State::ErrorStateVector offset_factor =
+        square_root.last_sigma_points()[1] - square_root.last_sigma_points()[0];
+    square_root(from_covariance);
+    const State::ErrorStateVector offset_covariance =
+        square_root.last_sigma_points()[1] - square_root.last_sigma_points()[0];
+    BOOST_CHECK_LE(std::abs(std::abs(offset_factor(0)) - std::abs(offset_covariance(0))), 1e-9);
+}
+
+struct NonlinearFunctor
+{
+    State operator()(const State& state) const { return nonlinear(state); }
+};
+
+struct NonlinearInPlace
+{
+    void operator()(const State& state, State& next) const { next.copyMean(nonlinear(state)); }
+};
+
+BOOST_AUTO_TEST_CASE(FunctorMatchesStdFunctionTest)
+{
+    UnscentedTransform<State> erased(nonlinear, 0.1, 2, 0);
+    UnscentedTransform<State, NonlinearFunctor> functor(NonlinearFunctor{}, 0.1, 2, 0);
+    UnscentedTransform<State, NonlinearInPlace> in_place(NonlinearInPlace{}, 0.1, 2, 0);
+
+    State state = State::zero(0);
+    State::CovarianceMatrix A = 0.01 * State::CovarianceMatrix::Random();
+    state.covariance() = A * A.transpose() + 1e-4 * State::CovarianceMatrix::Identity();
+
+    const State expected = erased(state);
+    constexpr double tol = 1e-12;
+    for (const State& actual : {functor(state), in_place(state)})
+    {
+        BOOST_CHECK_LE(diff(expected.attitude(), actual.attitude()), tol);
+        BOOST_CHECK_LE(diff(expected.position(), actual.position()), tol);
+        BOOST_CHECK_LE(diff(expected.velocity(), actual.velocity()), tol);
+        BOOST_CHECK_LE((expected.covariance() - actual.covariance()).norm(), tol);
+    }
+}
+
 // TODO: Add more complex transformations
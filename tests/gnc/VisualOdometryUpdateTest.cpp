@@ -0,0 +1,246 @@
+#define BOOST_TEST_MODULE VisualOdometryUpdateTest
+
+#include <memory>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Eigen>
+#include <boost/test/unit_test.hpp>
+
+#include <gnc/Estimator.hpp>
+#include "TestHelpers.hpp"
+
+using maav::gnc::Estimator;
+using maav::gnc::Metrics;
+using maav::gnc::measurements::MeasurementPool;
+using maav::gnc::measurements::MeasurementSet;
+using maav::gnc::measurements::VisualOdometryMeasurement;
+
+YAML::Node createConfig()
+{
+    YAML::Node config = estimatorConfig();
+    config["updates"]["lidar"]["enabled"] = false;
+    config["updates"]["visual_odometry"]["enabled"] = true;
+    return config;
+}
+
+// Visual odometry at 10 Hz
+constexpr uint64_t ODOMETRY_PERIOD = 10;
+
+/*
+ * The camera moved dx along x between the frames at base_time and time [us]
+ */
+std::shared_ptr<VisualOdometryMeasurement> createOdometry(
+    MeasurementPool& pool, uint64_t time, uint64_t base_time, double dx)
+{
+    auto odometry = pool.visual_odometry.acquire();
+    odometry->setTime(time);
+    odometry->setBaseTime(base_time);
+    odometry->pose() = Sophus::SE3d();
+    odometry->pose().translation() = {dx, 0, 0};
+    odometry->covariance().setIdentity();
+    return odometry;
+}
+
+/*
+ * The IMU feels nothing while the camera reports moving dx along x per reading, relative to the
+ * reading base_tick ticks earlier (0 for none)
+ */
+MeasurementSet createOdometrySet(
+    uint64_t tick, MeasurementPool& pool, double dx, uint64_t base_tick)
+{
+    MeasurementSet set = createSet(tick, pool);
+    if (base_tick > 0)
+    {
+        set.visual_odometry = createOdometry(pool, tick * IMU_PERIOD, base_tick * IMU_PERIOD, dx);
+    }
+    return set;
+}
+
+/*
+ * Camera moving at 1 m/s, which only the odometry sees
+ */
+void checkVelocity(const char* filter)
+{
+    YAML::Node config = createConfig();
+    config["filter"] = filter;
+    Estimator estimator(config);
+
+    Estimator::State state(0);
+    for (uint64_t tick = 1; tick <= 300; tick++)
+    {
+        const uint64_t base_tick = tick % ODOMETRY_PERIOD == 0 ? tick - ODOMETRY_PERIOD : 0;
+        const MeasurementSet set =
+            createOdometrySet(tick, estimator.measurementPool(), 0.1, base_tick);
+        state = estimator.add_measurement_set(set);
+    }
+
+    BOOST_CHECK_CLOSE(state.velocity().x(), 1, 10);
+    BOOST_CHECK_SMALL(state.velocity().y(), 0.01);
+    BOOST_CHECK_SMALL(state.velocity().z(), 0.01);
+    // The first readings are spent on picking up the velocity
+    BOOST_CHECK_GT(state.position().x(), 2.5);
+    BOOST_CHECK_LT(state.position().x(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(UkfVelocityTest) { checkVelocity("ukf"); }
+
+BOOST_AUTO_TEST_CASE(EskfVelocityTest) { checkVelocity("eskf"); }
+
+/*
+ * A reading is only fused against the corrected pose at its base, which an unknown base does not
+ * have
+ */
+BOOST_AUTO_TEST_CASE(UnknownBaseTest)
+{
+    Estimator estimator(createConfig());
+
+    double x = 0;
+    for (uint64_t tick = 1; tick <= 60; tick++)
+    {
+        // The reading at tick 20 moved from tick 15, which had none
+        uint64_t base_tick = 0;
+        if (tick == 20) base_tick = 15;
+        if (tick == 40) base_tick = 20;
+        const MeasurementSet set =
+            createOdometrySet(tick, estimator.measurementPool(), 1, base_tick);
+        x = estimator.add_measurement_set(set).position().x();
+
+        if (tick == 39) BOOST_CHECK_SMALL(x, 1e-6);
+    }
+    // The reading at tick 40 moved from the one at tick 20
+    BOOST_CHECK_GT(x, 0.5);
+}
+
+/*
+ * Late readings re-filter their base, and are predicted from the re-filtered pose
+ */
+BOOST_AUTO_TEST_CASE(ReplayTest)
+{
+    Estimator in_order(createConfig());
+    Estimator delayed(createConfig());
+
+    MeasurementSet late;
+    for (uint64_t tick = 1; tick <= 110; tick++)
+    {
+        const uint64_t base_tick = tick % ODOMETRY_PERIOD == 0 ? tick - ODOMETRY_PERIOD : 0;
+        in_order.add_measurement_set(
+            createOdometrySet(tick, in_order.measurementPool(), 0.1, base_tick));
+
+        // Every other reading arrives 5 ticks late
+        MeasurementSet set = createOdometrySet(tick, delayed.measurementPool(), 0.1, base_tick);
+        if (set.visual_odometry && tick % (2 * ODOMETRY_PERIOD) == 0)
+        {
+            late.visual_odometry = set.visual_odometry;
+            set.visual_odometry.reset();
+        }
+        if (tick % (2 * ODOMETRY_PERIOD) == 5 && late.visual_odometry)
+        {
+            delayed.queue_measurement_set(late);
+            late = MeasurementSet();
+        }
+        delayed.add_measurement_set(set);
+    }
+
+    // Ends 5 ticks after the last late reading, so every reading has been fused
+    const MeasurementSet set = createOdometrySet(111, in_order.measurementPool(), 0, 0);
+    const Estimator::State expected = in_order.add_measurement_set(set);
+    const MeasurementSet delayed_set = createOdometrySet(111, delayed.measurementPool(), 0, 0);
+    const Estimator::State& actual = delayed.add_measurement_set(delayed_set);
+    BOOST_CHECK_SMALL((actual.position() - expected.position()).norm(), 1e-9);
+    BOOST_CHECK_SMALL((actual.velocity() - expected.velocity()).norm(), 1e-9);
+}
+
+/*
+ * A replay reaching back over many readings still finds the base of each reading it revisits
+ */
+BOOST_AUTO_TEST_CASE(LongReplayTest)
+{
+    Estimator in_order(createConfig());
+    Estimator delayed(createConfig());
+    const uint64_t missing_before =
+        Metrics::instance().counter("update.visual_odometry.missing_base").value();
+
+    // Readings every other tick, with the one at tick 40 arriving 30 ticks (15 readings) late
+    constexpr uint64_t LATE_TICK = 40;
+    MeasurementSet late;
+    for (uint64_t tick = 1; tick <= 80; tick++)
+    {
+        const uint64_t base_tick = tick % 2 == 0 && tick > 2 ? tick - 2 : 0;
+        in_order.add_measurement_set(
+            createOdometrySet(tick, in_order.measurementPool(), 0.02, base_tick));
+
+        MeasurementSet set = createOdometrySet(tick, delayed.measurementPool(), 0.02, base_tick);
+        if (tick == LATE_TICK)
+        {
+            late.visual_odometry = set.visual_odometry;
+            set.visual_odometry.reset();
+        }
+        if (tick == LATE_TICK + 30) delayed.queue_measurement_set(late);
+        delayed.add_measurement_set(set);
+    }
+
+    const MeasurementSet set = createOdometrySet(81, in_order.measurementPool(), 0, 0);
+    const Estimator::State expected = in_order.add_measurement_set(set);
+    const MeasurementSet delayed_set = createOdometrySet(81, delayed.measurementPool(), 0, 0);
+    const Estimator::State& actual = delayed.add_measurement_set(delayed_set);
+    BOOST_CHECK_SMALL((actual.position() - expected.position()).norm(), 1e-9);
+    BOOST_CHECK_SMALL((actual.velocity() - expected.velocity()).norm(), 1e-9);
+
+    // Only the first reading of each estimator, at tick 4, and the reading at tick 42 before its
+    // base arrived had no base kept
+    BOOST_CHECK_EQUAL(
+        Metrics::instance().counter("update.visual_odometry.missing_base").value() -
+            missing_before,
+        3);
+}
+
+/*
+ * Frames within the tolerance of each other land on the same snapshot. A reading that moves on
+ * from the one already there is composed with it, so the next reading still finds its base.
+ */
+BOOST_AUTO_TEST_CASE(SameSnapshotTest)
+{
+    Estimator estimator(createConfig());
+    MeasurementPool& pool = estimator.measurementPool();
+
+    // Each frame is followed by another 400 us later, and each half of the motion is seen apart
+    constexpr uint64_t OFFSET = 400;
+    Estimator::State state(0);
+    for (uint64_t tick = 1; tick <= 300; tick++)
+    {
+        MeasurementSet set = createSet(tick, pool);
+        if (tick % ODOMETRY_PERIOD == 0)
+        {
+            const uint64_t time = tick * IMU_PERIOD;
+            const uint64_t base_time =
+                tick > ODOMETRY_PERIOD ? (tick - ODOMETRY_PERIOD) * IMU_PERIOD + OFFSET : 0;
+            set.visual_odometry = createOdometry(pool, time, base_time, 0.05);
+
+            MeasurementSet follow_up;
+            follow_up.visual_odometry = createOdometry(pool, time + OFFSET, time, 0.05);
+            estimator.queue_measurement_set(follow_up);
+        }
+        state = estimator.add_measurement_set(set);
+    }
+
+    BOOST_CHECK_CLOSE(state.velocity().x(), 1, 10);
+    BOOST_CHECK_GT(state.position().x(), 2.5);
+    BOOST_CHECK_LT(state.position().x(), 3);
+
+    const auto stats = estimator.queueStats().visual_odometry;
+    BOOST_CHECK_EQUAL(stats.queued, 60);
+    BOOST_CHECK_EQUAL(stats.merged, 60);
+    BOOST_CHECK_EQUAL(stats.dropped(), 0);
+
+    // A second reading from an unrelated base replaces the first, which is counted as dropped
+    MeasurementSet set = createSet(301, pool);
+    set.visual_odometry = createOdometry(pool, 301 * IMU_PERIOD, 291 * IMU_PERIOD, 0.1);
+    MeasurementSet other;
+    other.visual_odometry = createOdometry(pool, 301 * IMU_PERIOD + OFFSET, 295 * IMU_PERIOD, 0.1);
+    estimator.queue_measurement_set(other);
+    estimator.add_measurement_set(set);
+
+    const auto replaced_stats = estimator.queueStats().visual_odometry;
+    BOOST_CHECK_EQUAL(replaced_stats.merged, 61);
+    BOOST_CHECK_EQUAL(replaced_stats.dropped_replaced, 1);
+}
@@ -156,3 +156,41 @@ BOOST_AUTO_TEST_CASE(GlobalUpdateConversionTest)
     BOOST_CHECK_EQUAL(g1.attitude.data[2], q.y());
     BOOST_CHECK_EQUAL(g1.attitude.data[3], q.z());
 }
+
+BOOST_AUTO_TEST_CASE(StateLiteConversionTest)
+{
+    State state(1231231231231);
+    state.position() = {0.1, 0.2, 0.3};
+    state.velocity() = {0.2323, -0.3423, -0.4329};
+    state.attitude().setQuaternion({0, 0, 1, 0});
+    state.gyroBias() = {0.02, 0.002, -0.000923};
+    state.accelBias() = {-0.0032, 0.00023, 0.0423};
+    state.covariance() = State::CovarianceMatrix::Identity() * 0.25;
+    state.covariance()(2, 7) = 0.125;
+    state.covariance()(7, 2) = 0.125;
+
+    state_lite_t lite;
+    ConvertState(state, lite, true);
+    BOOST_CHECK_EQUAL(lite.covariance_size, 120);
+
+    State state2(0);
+    BOOST_CHECK(ConvertState(lite, state2));
+    BOOST_CHECK_EQUAL(state.timeUSec(), state2.timeUSec());
+    BOOST_CHECK_EQUAL(state.attitude().matrix(), state2.attitude().matrix());
+    BOOST_CHECK_EQUAL(state.position(), state2.position());
+    BOOST_CHECK_EQUAL(state.velocity(), state2.velocity());
+    BOOST_CHECK_EQUAL(state.gyroBias(), state2.gyroBias());
+    BOOST_CHECK_EQUAL(state.accelBias(), state2.accelBias());
+    BOOST_CHECK_EQUAL(state.covariance(), state2.covariance());
+
+    // Without the covariance only its size goes out, the storage stays for the next one
+    ConvertState(state, lite, false);
+    BOOST_CHECK_EQUAL(lite.covariance_size, 0);
+    BOOST_CHECK_EQUAL(lite.covariance.size(), 120u);
+
+    State state3(0);
+    state3.covariance().setIdentity();
+    BOOST_CHECK(!ConvertState(lite, state3));
+    BOOST_CHECK_EQUAL(state.position(), state3.position());
+    BOOST_CHECK_EQUAL(State::CovarianceMatrix::Identity(), state3.covariance());
+}
@@ -0,0 +1,127 @@
+#define BOOST_TEST_MODULE DepthProjectorTest
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <boost/test/unit_test.hpp>
+
+#include "vision/core/DepthProjector.hpp"
+
+using maav::vision::DepthProjector;
+
+// Odd sizes, so rows do not fill whole vector registers
+constexpr int WIDTH = 13;
+constexpr int HEIGHT = 7;
+constexpr float FX = 6.5;
+constexpr float FY = 7.25;
+constexpr float PPX = 6.2;
+constexpr float PPY = 3.4;
+constexpr float DEPTH_SCALE = 0.001;  // [m]
+
+/*
+ * Depth image with no depth on every fifth pixel, and on the whole of row 2
+ */
+std::vector<uint16_t> createDepth()
+{
+    std::vector<uint16_t> depth(WIDTH * HEIGHT);
+    for (int row = 0; row < HEIGHT; row++)
+    {
+        for (int col = 0; col < WIDTH; col++)
+        {
+            const int i = row * WIDTH + col;
+            depth[i] = (i % 5 == 0 || row == 2) ? 0 : static_cast<uint16_t>(500 + 37 * i);
+        }
+    }
+    return depth;
+}
+
+Eigen::Matrix4d createTransform()
+{
+    Eigen::Matrix4d transform = Eigen::Matrix4d::Identity();
+    transform.block<3, 3>(0, 0) =
+        Eigen::AngleAxisd(0.3, Eigen::Vector3d(1, 2, 3).normalized()).toRotationMatrix();
+    transform.block<3, 1>(0, 3) = Eigen::Vector3d(0.1, -0.2, 1.5);
+    return transform;
+}
+
+/*
+ * Lens with radial distortion, for the constructor taking rays
+ */
+Eigen::Vector2f distortedRay(int col, int row)
+{
+    const Eigen::Vector2f ray((col - PPX) / FX, (row - PPY) / FY);
+    return ray * (1 + 0.1f * ray.squaredNorm());
+}
+
+/*
+ * Projects every pixel with a depth on its own, along ray(col, row)
+ */
+template <class Ray>
+std::vector<Eigen::Vector3f> deproject(
+    const std::vector<uint16_t>& depth, const Eigen::Matrix4d& transform, Ray&& ray)
+{
+    std::vector<Eigen::Vector3f> points;
+    for (int row = 0; row < HEIGHT; row++)
+    {
+        for (int col = 0; col < WIDTH; col++)
+        {
+            const uint16_t d = depth[row * WIDTH + col];
+            if (d == 0) continue;
+            const double z = d * DEPTH_SCALE;
+            const Eigen::Vector2f xy = ray(col, row);
+            const Eigen::Vector4d point(xy.x() * z, xy.y() * z, z, 1);
+            points.push_back((transform * point).head<3>().cast<float>());
+        }
+    }
+    return points;
+}
+
+void checkProject(const DepthProjector& projector, const std::vector<Eigen::Vector3f>& expected)
+{
+    const std::vector<uint16_t> depth = createDepth();
+    std::vector<Eigen::Vector3f> points;
+    projector.project(depth.data(), DEPTH_SCALE, createTransform(),
+        [&points](float x, float y, float z) { points.emplace_back(x, y, z); });
+
+    // Pixels without a depth are skipped, and the rest come in row major order
+    const size_t no_depth = std::count(depth.begin(), depth.end(), 0);
+    BOOST_REQUIRE_EQUAL(points.size(), depth.size() - no_depth);
+    BOOST_REQUIRE_EQUAL(points.size(), expected.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        BOOST_CHECK_SMALL((points[i] - expected[i]).norm(), 1e-5f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PinholeTest)
+{
+    const DepthProjector projector(WIDTH, HEIGHT, FX, FY, PPX, PPY);
+    BOOST_CHECK_EQUAL(projector.width(), WIDTH);
+    BOOST_CHECK_EQUAL(projector.height(), HEIGHT);
+
+    const std::vector<Eigen::Vector3f> expected =
+        deproject(createDepth(), createTransform(), [](int col, int row) {
+            return Eigen::Vector2f((col - PPX) / FX, (row - PPY) / FY);
+        });
+    checkProject(projector, expected);
+}
+
+BOOST_AUTO_TEST_CASE(RayTest)
+{
+    Eigen::ArrayXf ray_x(WIDTH * HEIGHT);
+    Eigen::ArrayXf ray_y(WIDTH * HEIGHT);
+    for (int row = 0; row < HEIGHT; row++)
+    {
+        for (int col = 0; col < WIDTH; col++)
+        {
+            const Eigen::Vector2f ray = distortedRay(col, row);
+            ray_x[row * WIDTH + col] = ray.x();
+            ray_y[row * WIDTH + col] = ray.y();
+        }
+    }
+    const DepthProjector projector(WIDTH, HEIGHT, ray_x, ray_y);
+
+    checkProject(projector, deproject(createDepth(), createTransform(), distortedRay));
+}
@@ -0,0 +1,141 @@
+#define BOOST_TEST_MODULE OctomapReceiverTest
+
+#include <cstdint>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+#include <octomap/OcTree.h>
+#include <octomap/octomap.h>
+
+#include <common/messages/octomap_delta_t.hpp>
+#include <common/messages/octomap_t.hpp>
+#include "vision/core/OctomapReceiver.hpp"
+#include "vision/core/utilities.hpp"
+
+using maav::vision::OctomapReceiver;
+using maav::vision::octomapChangesToZcmType;
+using maav::vision::octomapToZcmType;
+using octomap::OcTree;
+using octomap::OcTreeKey;
+using octomap::OcTreeNode;
+
+constexpr double RESOLUTION = 0.1;  // [m]
+
+/*
+ * Marks the 8 voxels of the block whose lowest corner is at key, so the tree can prune them into
+ * their parent
+ */
+void occupyBlock(OcTree& tree, const OcTreeKey& key)
+{
+    for (uint16_t dx = 0; dx < 2; dx++)
+    {
+        for (uint16_t dy = 0; dy < 2; dy++)
+        {
+            for (uint16_t dz = 0; dz < 2; dz++)
+            {
+                tree.updateNode(OcTreeKey(key[0] + dx, key[1] + dy, key[2] + dz), true);
+            }
+        }
+    }
+}
+
+/*
+ * Misses the voxel until it is free. Change detection only picks up voxels that were created or
+ * changed between occupied and free.
+ */
+void freeVoxel(OcTree& tree, const OcTreeKey& key)
+{
+    while (tree.isNodeOccupied(tree.search(key)))
+    {
+        tree.updateNode(key, false);
+    }
+}
+
+/*
+ * Every leaf of one tree has the same log odds in the other, even if only one of them pruned it
+ */
+void checkOneWay(const OcTree& actual, const OcTree& expected)
+{
+    for (auto it = expected.begin_leafs(); it != expected.end_leafs(); ++it)
+    {
+        const OcTreeNode* node = actual.search(it.getCoordinate());
+        BOOST_REQUIRE(node);
+        BOOST_CHECK_EQUAL(node->getLogOdds(), it->getLogOdds());
+    }
+}
+
+void checkSameMap(const OcTree& actual, const OcTree& expected)
+{
+    checkOneWay(actual, expected);
+    checkOneWay(expected, actual);
+}
+
+BOOST_AUTO_TEST_CASE(KeyframeAndDeltaTest)
+{
+    auto sender = std::make_shared<OcTree>(RESOLUTION);
+    sender->enableChangeDetection(true);
+    OctomapReceiver receiver;
+
+    // Blocks start at even keys, so each fills one parent
+    const OcTreeKey kept_block(32768, 32768, 32768);
+    const OcTreeKey split_block(32780, 32768, 32768);
+    const OcTreeKey new_block(32768, 32790, 32768);
+
+    occupyBlock(*sender, kept_block);
+    occupyBlock(*sender, split_block);
+    sender->updateNode(octomap::point3d(1, 1, 1), true);
+    sender->updateNode(octomap::point3d(-1, 0.5, 0), false);
+    sender->prune();
+
+    octomap_delta_t early;
+    early.utime = 1;
+    early.base_utime = 0;
+    octomapChangesToZcmType(*sender, &early);
+    BOOST_CHECK(!receiver.receive(&early));
+    BOOST_CHECK(!receiver.map());
+
+    octomap_t keyframe;
+    keyframe.utime = 1;
+    octomapToZcmType(sender, &keyframe);
+    sender->resetChangeDetection();
+    BOOST_REQUIRE(receiver.receive(&keyframe));
+    BOOST_CHECK_EQUAL(receiver.utime(), 1);
+    checkSameMap(*receiver.map(), *sender);
+
+    // Held across the delta, as a reader on another thread would
+    const std::shared_ptr<OcTree> held = receiver.map();
+    const OcTree held_before(*held);
+
+    // Expands a pruned block, adds one that is pruned before it is sent and frees a voxel
+    freeVoxel(*sender, split_block);
+    occupyBlock(*sender, new_block);
+    freeVoxel(*sender, sender->coordToKey(octomap::point3d(1, 1, 1)));
+    sender->updateNode(octomap::point3d(0, -2, 0.5), true);
+    sender->prune();
+
+    octomap_delta_t delta;
+    delta.utime = 2;
+    delta.base_utime = 1;
+    octomapChangesToZcmType(*sender, &delta);
+    sender->resetChangeDetection();
+    BOOST_CHECK_EQUAL(delta.num_voxels, 11);
+    BOOST_REQUIRE(receiver.receive(&delta));
+    BOOST_CHECK_EQUAL(receiver.utime(), 2);
+    checkSameMap(*receiver.map(), *sender);
+
+    // Copy on write: the held map is the keyframe still
+    BOOST_CHECK(receiver.map() != held);
+    checkSameMap(*held, held_before);
+
+    // A delta on top of a map the receiver did not get is dropped
+    sender->updateNode(octomap::point3d(2, 2, 2), true);
+    octomap_delta_t skipped;
+    skipped.utime = 4;
+    skipped.base_utime = 3;
+    octomapChangesToZcmType(*sender, &skipped);
+    const std::shared_ptr<OcTree> last = receiver.map();
+    BOOST_CHECK(!receiver.receive(&skipped));
+    BOOST_CHECK_EQUAL(receiver.utime(), 2);
+    BOOST_CHECK(receiver.map() == last);
+    BOOST_CHECK(last->search(octomap::point3d(2, 2, 2)) == nullptr);
+}
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Dense>
+#include <zcm/zcm-cpp.hpp>
+
+#include <common/messages/MsgChannels.hpp>
+#include <common/messages/global_update_t.hpp>
+#include <common/messages/groundtruth_inertial_t.hpp>
+#include <common/messages/imu_t.hpp>
+#include <common/messages/lidar_t.hpp>
+#include <common/messages/plane_fit_t.hpp>
+#include <common/utils/GetOpt.hpp>
+#include <gnc/Estimator.hpp>
+#include <gnc/State.hpp>
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/utils/ZcmConversion.hpp>
+
+using maav::gnc::ConvertGroundTruthState;
+using maav::gnc::convertGlobalUpdate;
+using maav::gnc::convertImu;
+using maav::gnc::convertLidar;
+using maav::gnc::convertPlaneFit;
+using maav::gnc::Estimator;
+using maav::gnc::State;
+using maav::gnc::measurements::MeasurementSet;
+
+using namespace std;
+
+/*
+ *  Replays a recorded ZCM log through the UKF and the ESKF backends of the estimator and reports
+ *  how long each takes per IMU tick and how far each drifts from ground truth (when the log has
+ *  GT_INERTIAL_CHANNEL, e.g. from the simulator).
+ *
+ *  Both estimators are built from the same config, which also picks the sim or real sensor channels
+ *  the same way maav-estimator does. Only the 'filter' key is overridden.
+ *
+ *  ./tool-estimator-compare -c ../config/gnc/estimator-config.yaml -l flight.zcmlog -o out.csv
+ */
+
+namespace
+{
+// Ground truth is only compared against estimates this close in time [us]
+constexpr int64_t GT_TOLERANCE_USEC = 20000;
+
+struct LatencyStats
+{
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+LatencyStats computeStats(vector<double> samples)
+{
+    LatencyStats stats;
+    if (samples.empty()) return stats;
+
+    sort(samples.begin(), samples.end());
+    const auto percentile = [&](double p) {
+        return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1))];
+    };
+
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    stats.mean = sum / static_cast<double>(samples.size());
+    stats.p50 = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    stats.max = samples.back();
+    return stats;
+}
+
+/**
+ * @brief Running sum of squared position and attitude errors
+ */
+struct ErrorAccumulator
+{
+    double position_sq = 0;
+    double attitude_sq = 0;
+    size_t count = 0;
+
+    void add(const State& estimate, const State& reference)
+    {
+        position_sq += (estimate.position() - reference.position()).squaredNorm();
+        attitude_sq += (reference.attitude().inverse() * estimate.attitude()).log().squaredNorm();
+        count++;
+    }
+
+    double positionRms() const { return count ? sqrt(position_sq / count) : NAN; }
+    double attitudeRms() const { return count ? sqrt(attitude_sq / count) : NAN; }
+};
+
+/**
+ * @brief One estimator and what it has done so far
+ */
+struct Run
+{
+    Run(const YAML::Node& config, const string& filter) : estimator(withFilter(config, filter))
+    {
+    }
+
+    static YAML::Node withFilter(const YAML::Node& config, const string& filter)
+    {
+        YAML::Node copy = YAML::Clone(config);
+        copy["filter"] = filter;
+        return copy;
+    }
+
+    /**
+     * @return Time spent in the estimator [us]
+     */
+    double step(const MeasurementSet& set)
+    {
+        using Clock = chrono::steady_clock;
+        const auto start = Clock::now();
+        state = estimator.add_measurement_set(set);
+        const double latency =
+            chrono::duration<double, micro>(Clock::now() - start).count();
+        latencies.push_back(latency);
+        return latency;
+    }
+
+    Estimator estimator;
+    State state{0};
+    vector<double> latencies;
+    ErrorAccumulator error;
+};
+
+void printReport(const string& name, const Run& run)
+{
+    const LatencyStats stats = computeStats(run.latencies);
+    cout << name << '\n';
+    cout << "  Latency [us]   mean " << stats.mean << "  p50 " << stats.p50 << "  p99 " << stats.p99
+         << "  max " << stats.max << '\n';
+    if (run.error.count)
+    {
+        cout << "  RMS error      position " << run.error.positionRms() << " m  attitude "
+             << run.error.attitudeRms() << " rad\n";
+    }
+}
+
+template <class Message>
+bool decode(const zcm::LogEvent& event, Message& msg)
+{
+    return msg.decode(event.data, 0, event.datalen) >= 0;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    GetOpt gopt;
+    gopt.addBool('h', "help", false, "This message");
+    gopt.addString('c', "config", "", "Path to estimator config");
+    gopt.addString('l', "log", "", "Path to ZCM log");
+    gopt.addString('o', "output", "", "Optional CSV with per tick latencies and errors");
+
+    if (!gopt.parse(argc, argv, 1) || gopt.getBool("help") || !gopt.wasSpecified("config") ||
+        !gopt.wasSpecified("log"))
+    {
+        cout << "Usage: " << argv[0] << " [options]" << endl;
+        gopt.printHelp();
+        return 1;
+    }
+
+    YAML::Node config = YAML::LoadFile(gopt.getString("config"));
+
+    const string imu_channel =
+        config["sim_imu"].as<bool>() ? maav::SIM_IMU_CHANNEL : maav::IMU_CHANNEL;
+    const string lidar_channel = config["sim_lidar"].as<bool>() ? maav::SIM_HEIGHT_LIDAR_CHANNEL
+                                                                : maav::HEIGHT_LIDAR_CHANNEL;
+    const string plane_fit_channel =
+        config["sim_planefit"].as<bool>() ? maav::SIM_PLANE_FIT_CHANNEL : maav::PLANE_FIT_CHANNEL;
+    const string global_update_channel = config["sim_global_update"].as<bool>()
+                                             ? maav::SIM_GLOBAL_UPDATE_CHANNEL
+                                             : maav::GLOBAL_UPDATE_CHANNEL;
+
+    zcm::LogFile log(gopt.getString("log"), "r");
+    if (!log.good())
+    {
+        cerr << "Could not open " << gopt.getString("log") << endl;
+        return 1;
+    }
+
+    Run ukf(config, "ukf");
+    Run eskf(config, "eskf");
+    ErrorAccumulator difference;
+
+    ofstream csv;
+    if (gopt.wasSpecified("output"))
+    {
+        csv.open(gopt.getString("output"));
+        csv << "time_usec,ukf_latency_usec,eskf_latency_usec,ukf_x,ukf_y,ukf_z,eskf_x,eskf_y,eskf_"
+               "z,gt_x,gt_y,gt_z\n";
+        csv << setprecision(9);
+    }
+
+    MeasurementSet pending;
+    State ground_truth(0);
+    bool have_ground_truth = false;
+    size_t ticks = 0;
+
+    for (const zcm::LogEvent* event = log.readNextEvent(); event; event = log.readNextEvent())
+    {
+        const string& channel = event->channel;
+
+        // Sensor readings are held until the next IMU reading, as the live estimator loop does
+        if (channel == lidar_channel)
+        {
+            lidar_t msg;
+            if (decode(*event, msg)) pending.lidar = convertLidar(msg);
+        }
+        else if (channel == plane_fit_channel)
+        {
+            plane_fit_t msg;
+            if (decode(*event, msg)) pending.plane_fit = convertPlaneFit(msg);
+        }
+        else if (channel == global_update_channel)
+        {
+            global_update_t msg;
+            if (decode(*event, msg)) pending.global_update = convertGlobalUpdate(msg);
+        }
+        else if (channel == maav::GT_INERTIAL_CHANNEL)
+        {
+            groundtruth_inertial_t msg;
+            if (decode(*event, msg))
+            {
+                ground_truth = ConvertGroundTruthState(msg);
+                have_ground_truth = true;
+            }
+        }
+        else if (channel == imu_channel)
+        {
+            imu_t msg;
+            if (!decode(*event, msg)) continue;
+
+            pending.imu = convertImu(msg);
+            const double ukf_latency = ukf.step(pending);
+            const double eskf_latency = eskf.step(pending);
+            pending = MeasurementSet();
+            ticks++;
+
+            const uint64_t time = ukf.state.timeUSec();
+            const bool compare_gt =
+                have_ground_truth &&
+                abs(static_cast<int64_t>(ground_truth.timeUSec()) - static_cast<int64_t>(time)) <
+                    GT_TOLERANCE_USEC;
+            if (compare_gt)
+            {
+                ukf.error.add(ukf.state, ground_truth);
+                eskf.error.add(eskf.state, ground_truth);
+            }
+            difference.add(eskf.state, ukf.state);
+
+            if (csv.is_open())
+            {
+                const Eigen::Vector3d gt_position = compare_gt
+                                                        ? ground_truth.position()
+                                                        : Eigen::Vector3d::Constant(NAN);
+                csv << time << ',' << ukf_latency << ',' << eskf_latency << ','
+                    << ukf.state.position().x() << ',' << ukf.state.position().y() << ','
+                    << ukf.state.position().z() << ',' << eskf.state.position().x() << ','
+                    << eskf.state.position().y() << ',' << eskf.state.position().z() << ','
+                    << gt_position.x() << ',' << gt_position.y() << ',' << gt_position.z()
+                    << '\n';
+            }
+        }
+    }
+
+    cout << fixed << setprecision(3);
+    cout << "==========================\n";
+    cout << "IMU ticks: " << ticks << '\n';
+    printReport("UKF", ukf);
+    printReport("ESKF", eskf);
+    cout << "ESKF - UKF       RMS position " << difference.positionRms() << " m  attitude "
+         << difference.attitudeRms() << " rad\n";
+    if (ukf.error.count == 0)
+    {
+        cout << "No ground truth on " << maav::GT_INERTIAL_CHANNEL << '\n';
+    }
+    cout << "==========================" << endl;
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Dense>
+#include <zcm/zcm-cpp.hpp>
+
+#include <common/messages/MsgChannels.hpp>
+#include <common/messages/global_update_t.hpp>
+#include <common/messages/imu_t.hpp>
+#include <common/messages/lidar_t.hpp>
+#include <common/messages/plane_fit_t.hpp>
+#include <common/utils/GetOpt.hpp>
+#include <gnc/Estimator.hpp>
+#include <gnc/State.hpp>
+#include <gnc/measurements/Measurement.hpp>
+#include <gnc/utils/ZcmConversion.hpp>
+
+using maav::gnc::convertGlobalUpdate;
+using maav::gnc::convertImu;
+using maav::gnc::convertLidar;
+using maav::gnc::convertPlaneFit;
+using maav::gnc::EstimatorT;
+using maav::gnc::State;
+using maav::gnc::StateT;
+using maav::gnc::measurements::MeasurementSet;
+
+using namespace std;
+
+/*
+ *  Replays a recorded ZCM log through the double and the single precision (float) builds of the
+ *  estimator and reports how far the float trajectory drifts from the double one, and how long
+ *  each takes per IMU tick.
+ *
+ *  Both estimators are built from the same config, which also picks the sim or real sensor
+ *  channels the same way maav-estimator does. Exits with 2 if the position or attitude divergence
+ *  exceeds its threshold, so it can gate GNC_FLOAT_ESTIMATOR builds on recorded flights.
+ *
+ *  ./tool-estimator-precision -c ../config/gnc/estimator-config.yaml -l flight.zcmlog
+ */
+
+namespace
+{
+/**
+ * @brief Running RMS and maximum of a per tick error
+ */
+struct Divergence
+{
+    double sum_sq = 0;
+    double max = 0;
+    size_t count = 0;
+
+    void add(double error)
+    {
+        sum_sq += error * error;
+        max = std::max(max, error);
+        count++;
+    }
+
+    double rms() const { return count ? sqrt(sum_sq / static_cast<double>(count)) : NAN; }
+};
+
+/**
+ * @brief One estimator and how long it has taken so far
+ */
+template <class Scalar>
+struct Run
+{
+    explicit Run(const YAML::Node& config) : estimator(config) {}
+
+    /**
+     * @return Time spent in the estimator [us]
+     */
+    double step(const MeasurementSet& set)
+    {
+        using Clock = chrono::steady_clock;
+        const auto start = Clock::now();
+        const StateT<Scalar>& state = estimator.add_measurement_set(set);
+        const double latency = chrono::duration<double, micro>(Clock::now() - start).count();
+        latencies.push_back(latency);
+        last = state.template cast<double>();
+        return latency;
+    }
+
+    EstimatorT<Scalar> estimator;
+    State last{0};
+    vector<double> latencies;
+};
+
+double percentile(vector<double> samples, double p)
+{
+    if (samples.empty()) return NAN;
+    sort(samples.begin(), samples.end());
+    return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1))];
+}
+
+double mean(const vector<double>& samples)
+{
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    return samples.empty() ? NAN : sum / static_cast<double>(samples.size());
+}
+
+template <class Scalar>
+void printLatency(const string& name, const Run<Scalar>& run)
+{
+    cout << name << " latency [us]   mean " << mean(run.latencies) << "  p50 "
+         << percentile(run.latencies, 0.5) << "  p99 " << percentile(run.latencies, 0.99)
+         << '\n';
+}
+
+template <class Message>
+bool decode(const zcm::LogEvent& event, Message& msg)
+{
+    return msg.decode(event.data, 0, event.datalen) >= 0;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    GetOpt gopt;
+    gopt.addBool('h', "help", false, "This message");
+    gopt.addString('c', "config", "", "Path to estimator config");
+    gopt.addString('l', "log", "", "Path to ZCM log");
+    gopt.addString('o', "output", "", "Optional CSV with per tick divergence");
+    gopt.addDouble('p', "max-position", "0.01", "Largest allowed position divergence [m]");
+    gopt.addDouble('a', "max-attitude", "0.001", "Largest allowed attitude divergence [rad]");
+
+    if (!gopt.parse(argc, argv, 1) || gopt.getBool("help") || !gopt.wasSpecified("config") ||
+        !gopt.wasSpecified("log"))
+    {
+        cout << "Usage: " << argv[0] << " [options]" << endl;
+        gopt.printHelp();
+        return 1;
+    }
+
+    YAML::Node config = YAML::LoadFile(gopt.getString("config"));
+
+    const string imu_channel =
+        config["sim_imu"].as<bool>() ? maav::SIM_IMU_CHANNEL : maav::IMU_CHANNEL;
+    const string lidar_channel = config["sim_lidar"].as<bool>() ? maav::SIM_HEIGHT_LIDAR_CHANNEL
+                                                                : maav::HEIGHT_LIDAR_CHANNEL;
+    const string plane_fit_channel =
+        config["sim_planefit"].as<bool>() ? maav::SIM_PLANE_FIT_CHANNEL : maav::PLANE_FIT_CHANNEL;
+    const string global_update_channel = config["sim_global_update"].as<bool>()
+                                             ? maav::SIM_GLOBAL_UPDATE_CHANNEL
+                                             : maav::GLOBAL_UPDATE_CHANNEL;
+
+    zcm::LogFile log(gopt.getString("log"), "r");
+    if (!log.good())
+    {
+        cerr << "Could not open " << gopt.getString("log") << endl;
+        return 1;
+    }
+
+    Run<double> reference(config);
+    Run<float> single(config);
+    Divergence position;
+    Divergence velocity;
+    Divergence attitude;
+
+    ofstream csv;
+    if (gopt.wasSpecified("output"))
+    {
+        csv.open(gopt.getString("output"));
+        csv << "time_usec,double_latency_usec,float_latency_usec,position_m,velocity_mps,"
+               "attitude_rad\n";
+        csv << setprecision(9);
+    }
+
+    MeasurementSet pending;
+    size_t ticks = 0;
+
+    for (const zcm::LogEvent* event = log.readNextEvent(); event; event = log.readNextEvent())
+    {
+        const string& channel = event->channel;
+
+        // Sensor readings are held until the next IMU reading, as the live estimator loop does
+        if (channel == lidar_channel)
+        {
+            lidar_t msg;
+            if (decode(*event, msg)) pending.lidar = convertLidar(msg);
+        }
+        else if (channel == plane_fit_channel)
+        {
+            plane_fit_t msg;
+            if (decode(*event, msg)) pending.plane_fit = convertPlaneFit(msg);
+        }
+        else if (channel == global_update_channel)
+        {
+            global_update_t msg;
+            if (decode(*event, msg)) pending.global_update = convertGlobalUpdate(msg);
+        }
+        else if (channel == imu_channel)
+        {
+            imu_t msg;
+            if (!decode(*event, msg)) continue;
+
+            // Both estimators share the same readings, which are never modified
+            pending.imu = convertImu(msg);
+            const double double_latency = reference.step(pending);
+            const double float_latency = single.step(pending);
+            pending = MeasurementSet();
+            ticks++;
+
+            const State& expected = reference.last;
+            const State& actual = single.last;
+            const double position_error = (actual.position() - expected.position()).norm();
+            const double velocity_error = (actual.velocity() - expected.velocity()).norm();
+            const double attitude_error =
+                (expected.attitude().inverse() * actual.attitude()).log().norm();
+            position.add(position_error);
+            velocity.add(velocity_error);
+            attitude.add(attitude_error);
+
+            if (csv.is_open())
+            {
+                csv << expected.timeUSec() << ',' << double_latency << ',' << float_latency << ','
+                    << position_error << ',' << velocity_error << ',' << attitude_error << '\n';
+            }
+        }
+    }
+
+    const bool passed = position.max <= gopt.getDouble("max-position") &&
+                        attitude.max <= gopt.getDouble("max-attitude");
+
+    cout << scientific << setprecision(3);
+    cout << "==========================\n";
+    cout << "IMU ticks: " << ticks << '\n';
+    cout << "Float - double   position RMS " << position.rms() << " m  max " << position.max
+         << " m\n";
+    cout << "                 velocity RMS " << velocity.rms() << " m/s  max " << velocity.max
+         << " m/s\n";
+    cout << "                 attitude RMS " << attitude.rms() << " rad  max " << attitude.max
+         << " rad\n";
+    cout << fixed;
+    printLatency("Double", reference);
+    printLatency("Float ", single);
+    cout << (passed ? "PASSED" : "FAILED") << '\n';
+    cout << "==========================" << endl;
+
+    return passed ? 0 : 2;
+}
@@ -18,8 +18,10 @@
 #include <octomap/OcTree.h>
 
 #include <common/messages/MsgChannels.hpp>
+#include <common/messages/octomap_delta_t.hpp>
 #include <common/messages/octomap_t.hpp>
 #include <common/utils/GetOpt.hpp>
+#include <vision/core/OctomapReceiver.hpp>
 #include <vision/core/utilities.hpp>
 
 using std::atomic;
@@ -38,7 +40,7 @@ using std::chrono::milliseconds;
 using std::thread;
 using std::string;
 
-using maav::vision::zcmTypeToOctomap;
+using maav::vision::OctomapReceiver;
 
 
 /*
@@ -63,14 +65,22 @@ class Handler
 {
 public:
     explicit Handler(YAML::Node& config) : path {config["save-path"].as<string>()} {}
-    // Write the file to filename
     void handle(const zcm::ReceiveBuffer*, const std::string&,
         const octomap_t* message)
     {
-        auto octomap = zcmTypeToOctomap(message);
-        // Transform points from sensor to world
-        string filename = path + std::to_string(message->utime) + ".ot";
-        octomap->write(filename);
+        if (receiver.receive(message)) save();
+    }
+    void handleDelta(const zcm::ReceiveBuffer*, const std::string&,
+        const octomap_delta_t* message)
+    {
+        if (receiver.receive(message)) save();
+    }
+private:
+    // Write the file to filename
+    void save()
+    {
+        string filename = path + std::to_string(receiver.utime()) + ".ot";
+        receiver.map()->write(filename);
 
         if(single_save)
         {
@@ -79,8 +89,8 @@ public:
             cond_var.notify_one();
         }
     }
-private:
     string path;
+    OctomapReceiver receiver;
 };
 
 void sigHandler(int)
@@ -119,6 +129,8 @@ int main(int argc, char** argv)
     Handler handler(config);
     zcm.subscribe(maav::OCCUPANCY_MAP_CHANNEL,
         &Handler::handle, &handler);
+    zcm.subscribe(maav::OCCUPANCY_MAP_DELTA_CHANNEL,
+        &Handler::handleDelta, &handler);
     zcm.start();
 
     // Wait until the kill signal is received
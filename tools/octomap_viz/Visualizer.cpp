@@ -3,6 +3,7 @@
 #include <chrono>
 #include <csignal>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <iostream>
@@ -17,22 +18,49 @@
 #include <octovis/OcTreeDrawer.h>
 
 #include <common/messages/MsgChannels.hpp>
+#include <common/messages/octomap_delta_t.hpp>
 #include <common/messages/octomap_t.hpp>
 #include <common/utils/GetOpt.hpp>
-#include <common/utils/ZCMHandler.hpp>
-#include "vision/core/utilities.hpp"
+#include "vision/core/OctomapReceiver.hpp"
 #include "gnc/utils/ZcmConversion.hpp"
 
 
 using std::atomic_bool;
 using namespace std::chrono_literals;
 using maav::OCCUPANCY_MAP_CHANNEL;
-using maav::vision::zcmTypeToOctomap;
+using maav::OCCUPANCY_MAP_DELTA_CHANNEL;
+using maav::vision::OctomapReceiver;
 using octomap::OcTreeDrawer;
 using std::cerr;
 
 atomic_bool KILL = false;
 
+// Keeps the map up to date with full maps and the voxels changed in between
+class MapHandler
+{
+public:
+    template <class T>
+    void recv(const zcm::ReceiveBuffer*, const std::string&, const T* msg)
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (receiver_.receive(msg)) updated_ = true;
+    }
+
+    // Returns the map if it changed since the last call, nullptr otherwise
+    std::shared_ptr<octomap::OcTree> take()
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (!updated_) return nullptr;
+        updated_ = false;
+        return receiver_.map();
+    }
+
+private:
+    std::mutex mtx_;
+    OctomapReceiver receiver_;
+    bool updated_ = false;
+};
+
 void sigHandler(int);
 void setSigHandlers();
 
@@ -61,20 +89,19 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    ZCMHandler<octomap_t> map_handler;
+    MapHandler map_handler;
 
     zcm.start();
 
-    zcm.subscribe(OCCUPANCY_MAP_CHANNEL, &ZCMHandler<octomap_t>::recv, &map_handler);
+    zcm.subscribe(OCCUPANCY_MAP_CHANNEL, &MapHandler::recv<octomap_t>, &map_handler);
+    zcm.subscribe(OCCUPANCY_MAP_DELTA_CHANNEL, &MapHandler::recv<octomap_delta_t>, &map_handler);
     OcTreeDrawer drawer;
 
     while (!KILL)
     {
-        if (map_handler.ready())
+        const std::shared_ptr<octomap::OcTree> tree = map_handler.take();
+        if (tree)
         {
-            const auto msg = map_handler.msg();
-            map_handler.pop();
-            const std::shared_ptr<octomap::OcTree> tree = zcmTypeToOctomap(&msg);
             drawer.setOcTree(*tree);
             drawer.draw();
 
@@ -51,4 +51,15 @@ void DataDict::initializeDictionary_generated()
 	dict["GT_INERTIAL_acceleration"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"gt_acc_x", "gt_acc_y", "gt_acc_z"}));
 	dict["GT_IMU_accel_bias"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"gt_accel_bias_x", "gt_accel_bias_y", "gt_accel_bias_z"}));
 	dict["GT_IMU_gyro_bias"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"gt_gyro_bias_x", "gt_gyro_bias_y", "gt_gyro_bias_z"}));
+	dict["ESTIMATOR_NOISE_Q_gyro"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"Q_gyro_x", "Q_gyro_y", "Q_gyro_z"}));
+	dict["ESTIMATOR_NOISE_Q_accel"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"Q_accel_x", "Q_accel_y", "Q_accel_z"}));
+	dict["ESTIMATOR_NOISE_Q_gyro_bias"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"Q_gyro_bias_x", "Q_gyro_bias_y", "Q_gyro_bias_z"}));
+	dict["ESTIMATOR_NOISE_Q_accel_bias"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"Q_accel_bias_x", "Q_accel_bias_y", "Q_accel_bias_z"}));
+	dict["ESTIMATOR_NOISE_lidar_R"] = std::shared_ptr<AbstractData>(new AbstractData(1, {"R_lidar"}));
+	dict["ESTIMATOR_NOISE_plane_fit_attitude_R"] = std::shared_ptr<AbstractData>(new AbstractData(2, {"R_roll", "R_pitch"}));
+	dict["ESTIMATOR_NOISE_plane_fit_height_R"] = std::shared_ptr<AbstractData>(new AbstractData(2, {"R_z", "R_z_dot"}));
+	dict["ESTIMATOR_NOISE_global_update_position_R"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"R_x", "R_y", "R_z"}));
+	dict["ESTIMATOR_NOISE_global_update_attitude_R"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"R_roll", "R_pitch", "R_yaw"}));
+	dict["ESTIMATOR_NOISE_visual_odometry_translation_R"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"R_x", "R_y", "R_z"}));
+	dict["ESTIMATOR_NOISE_visual_odometry_rotation_R"] = std::shared_ptr<AbstractData>(new AbstractData(3, {"R_roll", "R_pitch", "R_yaw"}));
 }
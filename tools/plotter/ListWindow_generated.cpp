@@ -49,4 +49,15 @@ void ListWindow::addChannels_generated()
 	new ChannelListItem("GT_INERTIAL_acceleration", "GT_INERTIAL_acceleration:vector3_t", list_);
 	new ChannelListItem("GT_IMU_accel_bias", "GT_IMU_accel_bias:vector3_t", list_);
 	new ChannelListItem("GT_IMU_gyro_bias", "GT_IMU_gyro_bias:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_Q_gyro", "ESTIMATOR_NOISE_Q_gyro:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_Q_accel", "ESTIMATOR_NOISE_Q_accel:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_Q_gyro_bias", "ESTIMATOR_NOISE_Q_gyro_bias:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_Q_accel_bias", "ESTIMATOR_NOISE_Q_accel_bias:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_lidar_R", "ESTIMATOR_NOISE_lidar_R:vector1_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_plane_fit_attitude_R", "ESTIMATOR_NOISE_plane_fit_attitude_R:vector2_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_plane_fit_height_R", "ESTIMATOR_NOISE_plane_fit_height_R:vector2_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_global_update_position_R", "ESTIMATOR_NOISE_global_update_position_R:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_global_update_attitude_R", "ESTIMATOR_NOISE_global_update_attitude_R:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_visual_odometry_translation_R", "ESTIMATOR_NOISE_visual_odometry_translation_R:vector3_t", list_);
+	new ChannelListItem("ESTIMATOR_NOISE_visual_odometry_rotation_R", "ESTIMATOR_NOISE_visual_odometry_rotation_R:vector3_t", list_);
 }
@@ -0,0 +1,51 @@
+#include <QVBoxLayout>
+
+#include <common/messages/MsgChannels.hpp>
+
+#include "MetricsWindow.hpp"
+
+MetricsWindow::MetricsWindow(YAML::Node config)
+    : QWidget(), zcm_{config["zcm-url"].as<std::string>()}
+{
+    m_list = new QKeyValueListView(this);
+    QVBoxLayout *vl = new QVBoxLayout(this);
+    vl->addWidget(m_list);
+    vl->setMargin(0);
+    setLayout(vl);
+
+    setMinimumSize(400, 400);
+    setWindowTitle("GNC Metrics");
+
+    zcm_.subscribe(maav::GNC_METRICS_CHANNEL, &MetricsWindow::recv, this);
+    zcm_.start();
+}
+
+MetricsWindow::~MetricsWindow() { zcm_.stop(); }
+
+void MetricsWindow::recv(const zcm::ReceiveBuffer *, const std::string &, const gnc_metrics_t *msg)
+{
+    m_list->beginSetData();
+    ListMap &data = m_list->getData();
+    for (int32_t i = 0; i < msg->num_counters; i++)
+    {
+        const QString name = QString::fromStdString(msg->counter_names[i]);
+        const int64_t total = msg->counters[i];
+        data[name] = QString("%1 (+%2)").arg(total).arg(total - last_counters_.value(name, total));
+        last_counters_[name] = total;
+    }
+    for (int32_t i = 0; i < msg->num_gauges; i++)
+    {
+        data[QString::fromStdString(msg->gauge_names[i])] = QString("%1").arg(msg->gauges[i]);
+    }
+    for (int32_t i = 0; i < msg->num_histograms; i++)
+    {
+        data[QString::fromStdString(msg->histogram_names[i])] =
+            QString("n %1  p50 %2  p99 %3  max %4")
+                .arg(msg->histogram_count[i])
+                .arg(msg->histogram_p50[i])
+                .arg(msg->histogram_p99[i])
+                .arg(msg->histogram_max[i]);
+    }
+    m_list->endSetData();
+    m_list->listReload();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QtCore>
+#include <QtGui>
+
+#include <yaml-cpp/yaml.h>
+#include <common/messages/gnc_metrics_t.hpp>
+#include <zcm/zcm-cpp.hpp>
+
+#include "FlightInstruments.hpp"
+
+/**
+ * Table of the newest GNC metrics report. Counters show their total and how much they grew since
+ * the last report, histograms their count and p50 / p99 / max over the report's period.
+ */
+class MetricsWindow : public QWidget
+{
+public:
+    MetricsWindow(YAML::Node config);
+    virtual ~MetricsWindow();
+
+protected:
+    void recv(const zcm::ReceiveBuffer *, const std::string &, const gnc_metrics_t *msg);
+
+protected:
+    QKeyValueListView *m_list;
+
+    // Counter totals of the last report, to show the growth over a period
+    QMap<QString, int64_t> last_counters_;
+    zcm::ZCM zcm_;
+};
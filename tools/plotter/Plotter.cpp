@@ -11,6 +11,7 @@
 #include "FlightInstrumentsWindow.hpp"
 #include "LinePlotWindow.h"
 #include "ListWindow.h"
+#include "MetricsWindow.hpp"
 #include "ZcmLoop.hpp"
 
 int main(int argc, char *argv[])
@@ -54,6 +55,9 @@ int main(int argc, char *argv[])
     FlightInstrumentsWindow flight_instruments(config);
     flight_instruments.show();
 
+    MetricsWindow metrics_window(config);
+    metrics_window.show();
+
     std::thread zcm_loop = std::thread(&ZcmLoop::run, &loop);
     std::thread dict_loop = std::thread(&DataDict::run, dict);
 
@@ -26,6 +26,7 @@
 #include <common/messages/groundtruth_world_t.hpp>
 #include <common/messages/groundtruth_slamdrift_t.hpp>
 #include <common/messages/pid_error_t.hpp>
+#include <common/messages/estimator_noise_t.hpp>
 
 using namespace std::chrono;
 
@@ -53,6 +54,8 @@ void ZcmLoop::run()
 	zcm.subscribe(maav::GT_INERTIAL_CHANNEL, &ZCMHandler<groundtruth_inertial_t>::recv, &GT_INERTIAL_handler);
 	ZCMHandler<groundtruth_imu_t> GT_IMU_handler;
 	zcm.subscribe(maav::GT_IMU_CHANNEL, &ZCMHandler<groundtruth_imu_t>::recv, &GT_IMU_handler);
+	ZCMHandler<estimator_noise_t> ESTIMATOR_NOISE_handler;
+	zcm.subscribe(maav::ESTIMATOR_NOISE_CHANNEL, &ZCMHandler<estimator_noise_t>::recv, &ESTIMATOR_NOISE_handler);
 
 	zcm.start();
 
@@ -146,6 +149,21 @@ void ZcmLoop::run()
 			dict_->dict["GT_IMU_gyro_bias"]->addData(std::move(convertVector(time, GT_IMU_handler.msg().gyro_bias)));
 			GT_IMU_handler.pop();
 		}
+		while(ESTIMATOR_NOISE_handler.ready()) {
+			double time = elapsedTime(static_cast<double>(ESTIMATOR_NOISE_handler.msg().utime) / 1e6);
+			dict_->dict["ESTIMATOR_NOISE_Q_gyro"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().Q_gyro)));
+			dict_->dict["ESTIMATOR_NOISE_Q_accel"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().Q_accel)));
+			dict_->dict["ESTIMATOR_NOISE_Q_gyro_bias"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().Q_gyro_bias)));
+			dict_->dict["ESTIMATOR_NOISE_Q_accel_bias"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().Q_accel_bias)));
+			dict_->dict["ESTIMATOR_NOISE_lidar_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().lidar_R)));
+			dict_->dict["ESTIMATOR_NOISE_plane_fit_attitude_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().plane_fit_attitude_R)));
+			dict_->dict["ESTIMATOR_NOISE_plane_fit_height_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().plane_fit_height_R)));
+			dict_->dict["ESTIMATOR_NOISE_global_update_position_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().global_update_position_R)));
+			dict_->dict["ESTIMATOR_NOISE_global_update_attitude_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().global_update_attitude_R)));
+			dict_->dict["ESTIMATOR_NOISE_visual_odometry_translation_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().visual_odometry_translation_R)));
+			dict_->dict["ESTIMATOR_NOISE_visual_odometry_rotation_R"]->addData(std::move(convertVector(time, ESTIMATOR_NOISE_handler.msg().visual_odometry_rotation_R)));
+			ESTIMATOR_NOISE_handler.pop();
+		}
 		std::this_thread::sleep_for(33ms);
 	}
 
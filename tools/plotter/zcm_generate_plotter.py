@@ -15,7 +15,8 @@ zcm_types_channels = [
     ('groundtruth_imu_t', 'GT_IMU'),
     ('groundtruth_world_t', 'GT_WORLD'),
     ('groundtruth_slamdrift_t', 'GT_SLAMDRIFT'),
-    ('pid_error_t', 'PID_ERROR')
+    ('pid_error_t', 'PID_ERROR'),
+    ('estimator_noise_t', 'ESTIMATOR_NOISE')
 ]
 
 # CHANGE THIS TO CHANGE THE FREQUENCY OF UPDATES